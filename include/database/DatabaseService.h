@@ -1,16 +1,67 @@
 #pragma once
 
+#include "nut/DailyMetrics.h"
 #include "nut/UpsData.h"
 #include <pqxx/pqxx>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <optional>
+#include <string_view>
 #include <mutex>
 #include <memory>
 #include <map>
 #include <functional>
+#include <vector>
 
 namespace hms_nut {
 
+/**
+ * UpsMetricsRow - One ups_metrics row for a batch insert
+ */
+struct UpsMetricsRow {
+    std::string device_identifier;
+    UpsData data;  // data.timestamp is the row timestamp
+};
+
+/**
+ * RollupTier - Persisted aggregate resolution
+ */
+enum class RollupTier {
+    Minute,  // ups_metrics_1m
+    Hour     // ups_metrics_1h
+};
+
+/**
+ * RollupRow - Aggregate of one metric of one device over one bucket
+ */
+struct RollupRow {
+    std::string device_identifier;
+    std::string metric;  // Sensor id, e.g. "input_voltage"
+    std::chrono::system_clock::time_point bucket;  // Bucket start
+    uint32_t samples = 0;
+    double avg = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+/**
+ * ExportColumn - One ups_metrics column in a bulk export
+ */
+struct ExportColumn {
+    enum class Kind { Text, Number, Boolean };
+
+    const char* name;
+    Kind kind;
+};
+
+/**
+ * Receives one exported row in exportColumns() order (nullopt = NULL);
+ * return false to stop the export
+ */
+using ExportRowCallback = std::function<bool(const std::vector<std::optional<std::string_view>>& values)>;
+
 /**
  * DatabaseService - Singleton PostgreSQL database service
  *
@@ -41,11 +92,14 @@ public:
     void initialize(const std::string& connection_string);
 
     /**
-     * Check if connected to database
+     * Check if connected to database (lock-free)
+     *
+     * Reflects the last connect/reconnect/close and broken connections seen
+     * by queries; never waits for a running query.
      *
      * @return true if connected
      */
-    bool isConnected() const;
+    bool isConnected() const { return connected_.load(std::memory_order_acquire); }
 
     /**
      * Insert UPS metrics (1-hour aggregated data)
@@ -59,6 +113,46 @@ public:
      */
     bool insertUpsMetrics(const UpsData& data, const std::string& device_identifier);
 
+    /**
+     * Insert UPS metrics for many devices in one transaction
+     *
+     * Single multi-row INSERT with the same ON CONFLICT handling as
+     * insertUpsMetrics(). Rows for unknown devices are skipped (logged).
+     *
+     * @param rows Rows to insert (at most one per device and timestamp)
+     * @return true if the transaction committed (or nothing was left to insert)
+     */
+    bool insertUpsMetricsBatch(const std::vector<UpsMetricsRow>& rows);
+
+    /**
+     * Insert rollup aggregates in one transaction
+     *
+     * Upserts on (device_id, metric, bucket), merging with a row already
+     * there (summed samples, sample-weighted average, min of mins, max of
+     * maxes): a bucket written in parts - before and after a restart or an
+     * outage replay - keeps every sample. Rows for unknown devices are
+     * skipped (logged).
+     *
+     * @param tier Target table
+     * @param rows Aggregates to insert
+     * @return true if the transaction committed (or nothing was left to insert)
+     */
+    bool insertRollups(RollupTier tier, const std::vector<RollupRow>& rows);
+
+    /**
+     * Delete rollup rows older than the retention
+     *
+     * @param tier Target table
+     * @param retention_days Keep this many days (<= 0 keeps everything)
+     * @return true if the delete succeeded
+     */
+    bool pruneRollups(RollupTier tier, int retention_days);
+
+    /**
+     * Table name for a rollup tier
+     */
+    static const char* rollupTable(RollupTier tier);
+
     /**
      * Get device_id (primary key) from device_identifier (unique name)
      *
@@ -87,10 +181,56 @@ public:
                        double battery_level_end,
                        double load_at_event);
 
+    /**
+     * Upsert per-device daily statistics in one transaction
+     *
+     * Replaces the row for (device_id, day), so a day in progress can be
+     * written repeatedly. Rows for unknown devices are skipped (logged).
+     *
+     * @param rows Stats to write
+     * @return true if the transaction committed (or nothing was left to write)
+     */
+    bool upsertDailyStats(const std::vector<DailyStatsRow>& rows);
+
+    /**
+     * Read every device's statistics for one day (one row per device)
+     *
+     * @param date Day in YYYY-MM-DD format
+     * @param out Filled with the rows, ordered by device_id
+     * @return true if the query succeeded
+     */
+    bool queryDailyStats(const std::string& date, std::vector<DailyStatsRow>& out);
+
+    /**
+     * Query power events in a time range, oldest first
+     *
+     * @param from_ms Oldest event (inclusive, ms since epoch)
+     * @param to_ms Newest event (exclusive, ms since epoch)
+     * @param device_identifier Only this device (empty = all devices)
+     * @param out Filled with the events
+     * @param limit Maximum events returned
+     * @return true if the query succeeded
+     */
+    bool queryPowerEvents(int64_t from_ms, int64_t to_ms,
+                          const std::string& device_identifier,
+                          std::vector<PowerEventRow>& out,
+                          size_t limit = 1000);
+
+    /**
+     * Aggregate every device's ups_metrics rows and power events for a date
+     *
+     * Scans the whole day; prefer collector daily stats where available.
+     *
+     * @param date Date string in YYYY-MM-DD format
+     * @param out Filled with one entry per device (none if the day has no data)
+     * @return true if the query succeeded
+     */
+    bool queryDailyReport(const std::string& date, DailyMetrics& out);
+
     /**
      * Query daily aggregated metrics for all devices on a given date
      *
-     * Returns a formatted string with per-device stats:
+     * Returns queryDailyReport() rendered as text:
      * voltage ranges, load, battery, power failures, etc.
      *
      * @param date Date string in YYYY-MM-DD format
@@ -98,6 +238,57 @@ public:
      */
     std::string queryDailyMetrics(const std::string& date);
 
+    /**
+     * Stream one device's ups_metrics rows in timestamp order
+     *
+     * Runs on a dedicated connection through a server-side cursor, fetching
+     * `batch_rows` rows at a time: memory stays constant whatever the range,
+     * and the shared connection (collector inserts) is never held. Not
+     * retried - a failed export is reported to the caller.
+     *
+     * @param device_identifier PostgreSQL device identifier
+     * @param from Oldest row (inclusive)
+     * @param to Newest row (exclusive)
+     * @param on_row Row receiver (called on this thread)
+     * @param batch_rows Rows per FETCH
+     * @return true if every row was delivered or on_row stopped the export
+     */
+    bool streamUpsMetrics(const std::string& device_identifier,
+                          std::chrono::system_clock::time_point from,
+                          std::chrono::system_clock::time_point to,
+                          const ExportRowCallback& on_row,
+                          size_t batch_rows = 1000);
+
+    /**
+     * Columns produced by streamUpsMetrics(), timestamp first (ISO 8601 UTC)
+     */
+    static const std::vector<ExportColumn>& exportColumns();
+
+    /**
+     * Stream one metric of one device as (timestamp, value) points in time order
+     *
+     * Reads ups_metrics, or the avg_value of a rollup tier, through a
+     * server-side cursor on a dedicated connection like streamUpsMetrics().
+     * The connection comes from a small idle pool and goes back after a
+     * successful read, so consecutive reads (e.g. the targets of one Grafana
+     * query) do not each pay a connection setup. NULL values are skipped.
+     *
+     * @param device_identifier PostgreSQL device identifier
+     * @param metric Metric id (an ups_metrics column, e.g. "input_voltage")
+     * @param tier Rollup table to read, or nullopt for ups_metrics
+     * @param from_ms Oldest point (inclusive, ms since epoch)
+     * @param to_ms Newest point (exclusive, ms since epoch)
+     * @param on_point Point receiver (called on this thread)
+     * @param batch_rows Rows per FETCH
+     * @return true if every point was delivered
+     */
+    bool streamMetricSeries(const std::string& device_identifier,
+                            const std::string& metric,
+                            std::optional<RollupTier> tier,
+                            int64_t from_ms, int64_t to_ms,
+                            const std::function<void(int64_t timestamp_ms, double value)>& on_point,
+                            size_t batch_rows = 5000);
+
     /**
      * Close database connection
      */
@@ -128,10 +319,35 @@ private:
      */
     void loadDeviceIdCache();
 
+    /**
+     * Run the series cursor of streamMetricSeries() on a connection
+     *
+     * @throws std::exception on query errors
+     */
+    void readMetricSeries(pqxx::connection& conn, int device_id, const std::string& metric,
+                          std::optional<RollupTier> tier, int64_t from_ms, int64_t to_ms,
+                          const std::function<void(int64_t, double)>& on_point, size_t batch_rows);
+
+    /**
+     * Take an idle series read connection, or open a new one
+     */
+    std::unique_ptr<pqxx::connection> acquireReadConnection();
+
+    /**
+     * Return a read connection to the idle pool (closed beyond its size)
+     */
+    void releaseReadConnection(std::unique_ptr<pqxx::connection> conn);
+
     // Connection
     std::unique_ptr<pqxx::connection> conn_;
     std::string connection_string_;
     mutable std::mutex connection_mutex_;
+    std::atomic<bool> connected_{false};  // Mirrors conn_ && conn_->is_open()
+
+    // Idle dedicated connections for series reads
+    static constexpr size_t kMaxIdleReadConnections = 4;
+    std::vector<std::unique_ptr<pqxx::connection>> idle_read_connections_;
+    std::mutex read_pool_mutex_;
 
     // Device ID cache (device_identifier -> device_id)
     std::map<std::string, int> device_id_cache_;
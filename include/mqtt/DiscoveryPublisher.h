@@ -1,17 +1,35 @@
 #pragma once
 
 #include "mqtt/MqttClient.h"
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <json/json.h>
 
 namespace hms_nut {
 
+/**
+ * DiscoveryMessage - One pre-rendered, retained discovery config
+ */
+struct DiscoveryMessage {
+    std::string topic;    // homeassistant/{component}/{device}/{sensor}/config
+    std::string payload;  // Compact JSON, rendered once
+    uint64_t hash;        // FNV-1a of payload
+};
+
 /**
  * DiscoveryPublisher - Home Assistant MQTT Discovery publisher
  *
  * Publishes sensor discovery configurations for UPS devices
  * Follows Home Assistant MQTT Discovery protocol
+ *
+ * Config payloads are rendered once per device (from SensorSchema) and kept as
+ * immutable strings. When retained tracking is enabled, the publisher listens
+ * to its own config topics and remembers the hash of what the broker holds, so
+ * republishing skips configs the broker already has retained.
  */
 class DiscoveryPublisher {
 public:
@@ -33,12 +51,13 @@ public:
     /**
      * Publish all sensor discovery configurations
      *
-     * Should be called once on startup
-     * All messages are retained for Home Assistant
+     * All messages are retained for Home Assistant. Configs the broker already
+     * holds with identical content are skipped unless force is set.
      *
-     * @return true if all configs published successfully
+     * @param force Publish every config even if the broker already holds it
+     * @return true if all configs published (or skipped) successfully
      */
-    bool publishAll();
+    bool publishAll(bool force = false);
 
     /**
      * Remove device from Home Assistant (unpublish)
@@ -49,9 +68,36 @@ public:
      */
     bool removeDevice();
 
+    /**
+     * Subscribe to this device's config topics to learn what the broker retains
+     *
+     * Call once MQTT is connected (e.g., from setupSubscriptions). Retained
+     * configs are replayed by the broker on every (re)subscribe, so the view is
+     * rebuilt after reconnects; entries from older connections are ignored.
+     */
+    void enableRetainedTracking();
+
+    /**
+     * Check whether the broker already holds this exact config retained
+     *
+     * @param message Rendered discovery message
+     * @return true if republishing it would be redundant
+     */
+    bool isHeldByBroker(const DiscoveryMessage& message) const;
+
+    /**
+     * Get the pre-rendered discovery messages (publish order)
+     */
+    const std::vector<DiscoveryMessage>& getMessages() const { return messages_; }
+
+    /**
+     * Get MQTT device ID
+     */
+    const std::string& getDeviceId() const { return device_id_; }
+
 private:
     /**
-     * Publish single sensor discovery config
+     * Render sensor discovery config
      *
      * @param sensor_id Sensor identifier (e.g., "battery_charge")
      * @param name Friendly sensor name (e.g., "Battery Charge")
@@ -59,28 +105,43 @@ private:
      * @param device_class Device class (e.g., "battery", "voltage", "duration")
      * @param state_class State class ("measurement", "total", or empty)
      * @param icon Icon name (e.g., "mdi:battery", optional)
-     * @return true if published successfully
+     * @return Rendered discovery message
      */
-    bool publishSensorConfig(const std::string& sensor_id,
-                             const std::string& name,
-                             const std::string& unit_of_measurement,
-                             const std::string& device_class,
-                             const std::string& state_class = "measurement",
-                             const std::string& icon = "");
+    DiscoveryMessage renderSensorConfig(const std::string& sensor_id,
+                                        const std::string& name,
+                                        const std::string& unit_of_measurement,
+                                        const std::string& device_class,
+                                        const std::string& state_class,
+                                        const std::string& icon) const;
 
     /**
-     * Publish binary sensor discovery config
+     * Render binary sensor discovery config
      *
      * @param sensor_id Sensor identifier (e.g., "power_failure")
      * @param name Friendly sensor name (e.g., "Power Failure")
      * @param device_class Device class (e.g., "power", "problem")
      * @param icon Icon name (optional)
-     * @return true if published successfully
+     * @return Rendered discovery message
      */
-    bool publishBinarySensorConfig(const std::string& sensor_id,
-                                    const std::string& name,
-                                    const std::string& device_class,
-                                    const std::string& icon = "");
+    DiscoveryMessage renderBinarySensorConfig(const std::string& sensor_id,
+                                              const std::string& name,
+                                              const std::string& device_class,
+                                              const std::string& icon) const;
+
+    /**
+     * Render all configs from SensorSchema (called once by constructor)
+     */
+    void renderAll();
+
+    /**
+     * Serialize config JSON and wrap it as a discovery message
+     */
+    DiscoveryMessage makeMessage(std::string topic, const Json::Value& config) const;
+
+    /**
+     * Retained config arrived on a tracked topic
+     */
+    void onRetainedConfig(const std::string& topic, const std::string& payload);
 
     /**
      * Build device info JSON
@@ -94,6 +155,17 @@ private:
     std::string device_name_;
     std::string manufacturer_;
     std::string model_;
+
+    // Rendered once, immutable afterwards
+    std::vector<DiscoveryMessage> messages_;
+
+    // What the broker holds retained: topic -> (payload hash, connection epoch)
+    struct BrokerEntry {
+        uint64_t hash;
+        uint64_t epoch;
+    };
+    std::unordered_map<std::string, BrokerEntry> broker_state_;
+    mutable std::mutex broker_state_mutex_;
 };
 
 }  // namespace hms_nut
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "mqtt/DiscoveryPublisher.h"
+#include "mqtt/MqttClient.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * DiscoverySchedulerConfig - Pacing for fleet-wide discovery republish
+ */
+struct DiscoverySchedulerConfig {
+    int window_seconds = 10;     // Spread one full republish across this window
+    double max_rate = 100.0;     // Never exceed this many publishes per second
+    double min_rate = 5.0;       // Never go slower than this (small fleets finish fast)
+    int burst = 10;              // Token bucket capacity
+};
+
+/**
+ * DiscoveryRepublishProgress - Snapshot of scheduler progress
+ */
+struct DiscoveryRepublishProgress {
+    bool in_progress = false;
+    uint64_t runs_started = 0;
+    uint64_t runs_completed = 0;
+    uint64_t runs_aborted = 0;       // MQTT went away mid-run
+    uint64_t requests_coalesced = 0; // Requests merged into a running republish
+    size_t devices = 0;              // Registered publishers
+    size_t total = 0;                // Configs in the current/last run
+    size_t published = 0;
+    size_t skipped = 0;              // Already retained on broker
+    size_t failed = 0;
+    double rate = 0.0;               // Publishes per second in the current/last run
+    std::chrono::system_clock::time_point last_started;
+    std::chrono::system_clock::time_point last_completed;
+};
+
+/**
+ * DiscoveryScheduler - Rate-limited, fleet-wide discovery republish
+ *
+ * When Home Assistant restarts, every device must republish its discovery
+ * configs. Doing that synchronously on the Paho callback thread stalls inbound
+ * dispatch and sends thousands of retained QoS 1 messages back to back.
+ *
+ * The scheduler instead queues the request and publishes from its own thread
+ * through a token bucket, at total/window messages per second (clamped to
+ * [min_rate, max_rate]). Devices go in priority order (lower value first).
+ * Configs the broker already retains are skipped without spending a token.
+ */
+class DiscoveryScheduler {
+public:
+    /**
+     * Constructor
+     *
+     * @param mqtt_client Shared MQTT client
+     * @param config Pacing configuration
+     */
+    DiscoveryScheduler(std::shared_ptr<MqttClient> mqtt_client,
+                       const DiscoverySchedulerConfig& config = DiscoverySchedulerConfig());
+
+    /**
+     * Destructor - stops the worker thread
+     */
+    ~DiscoveryScheduler();
+
+    // Disable copy
+    DiscoveryScheduler(const DiscoveryScheduler&) = delete;
+    DiscoveryScheduler& operator=(const DiscoveryScheduler&) = delete;
+
+    /**
+     * Start the worker thread
+     */
+    void start();
+
+    /**
+     * Stop the worker thread (aborts a running republish)
+     */
+    void stop();
+
+    /**
+     * Register a device's discovery publisher
+     *
+     * @param publisher Discovery publisher
+     * @param priority Lower values republish first (e.g., 0 = critical UPS)
+     */
+    void registerPublisher(std::shared_ptr<DiscoveryPublisher> publisher, int priority = 0);
+
+    /**
+     * Unregister a device's discovery publisher
+     */
+    void unregisterPublisher(const std::shared_ptr<DiscoveryPublisher>& publisher);
+
+    /**
+     * Request a fleet-wide republish (non-blocking, safe from MQTT callbacks)
+     *
+     * Requests arriving while a republish is running are merged into it.
+     */
+    void requestRepublish();
+
+    /**
+     * Get progress metrics
+     */
+    DiscoveryRepublishProgress getProgress() const;
+
+private:
+    /**
+     * Worker thread main loop
+     */
+    void runLoop();
+
+    /**
+     * Execute one paced republish over all registered publishers
+     */
+    void runRepublish();
+
+    struct Entry {
+        std::shared_ptr<DiscoveryPublisher> publisher;
+        int priority;
+    };
+
+    std::shared_ptr<MqttClient> mqtt_client_;
+    DiscoverySchedulerConfig config_;
+
+    std::vector<Entry> publishers_;  // Kept sorted by priority (stable)
+    bool republish_requested_ = false;
+
+    DiscoveryRepublishProgress progress_;
+    mutable std::mutex mutex_;  // Guards publishers_, republish_requested_, progress_
+    std::condition_variable cv_;
+
+    std::thread worker_thread_;
+    std::atomic<bool> running_{false};
+};
+
+}  // namespace hms_nut
@@ -1,14 +1,47 @@
 #pragma once
 
+#include "mqtt/OfflineSpool.h"
+#include "mqtt/PublishQueue.h"
+#include "mqtt/TopicAliasTable.h"
 #include <mqtt/async_client.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <functional>
 #include <mutex>
 #include <memory>
 #include <map>
+#include <thread>
 
 namespace hms_nut {
 
+/**
+ * ConnectionState - MqttClient connection state machine
+ *
+ * Disconnected -> Connecting -> Connected <-> Reconnecting (Paho auto-reconnect)
+ * Connected -> Disconnecting -> Disconnected
+ */
+enum class ConnectionState : uint8_t {
+    Disconnected,
+    Connecting,
+    Connected,
+    Reconnecting,
+    Disconnecting
+};
+
+/**
+ * MqttV5Config - Optional MQTT v5 session features
+ */
+struct MqttV5Config {
+    bool enabled = false;
+    uint16_t max_topic_aliases = 100;    // Local cap, further limited by the broker's CONNACK
+    int telemetry_expiry_seconds = 300;  // Message Expiry for non-retained publishes (0 = never)
+    bool timestamp_property = true;      // Attach the sample time as user property "ts"
+};
+
 /**
  * MqttClient - Thread-safe MQTT client wrapper
  *
@@ -17,6 +50,17 @@ namespace hms_nut {
  * - Subscribing to multi-device UPS topics
  * - Auto-reconnect on connection loss
  * - Thread-safe operations (shared by multiple service threads)
+ * - Lock-free hot path: connection state is an atomic, the Paho client handle
+ *   is an atomically published shared_ptr (swapped on connect), and
+ *   connection_mutex_ only serializes connect()/disconnect()
+ * - Bounded outbound queue: publish() never blocks on the broker; a sender
+ *   thread drains the queue with at most max_in_flight unacknowledged messages
+ * - Optional disk spool: publishes made while disconnected are written to disk
+ *   and replayed at a controlled rate after reconnect
+ * - Optional split sessions: subscriptions get their own broker connection so
+ *   publish bursts and inbound deliveries don't queue behind each other
+ * - Optional MQTT v5: topic aliases for recurring state topics, message expiry
+ *   for non-retained telemetry and the sample timestamp as a user property
  */
 class MqttClient {
 public:
@@ -28,12 +72,23 @@ public:
      */
     using MessageCallback = std::function<void(const std::string& topic, const std::string& payload)>;
 
+    /**
+     * Message callback with the sample time
+     *
+     * @param timestamp_ms User property "ts" set by the publisher (ms since
+     *                     epoch), 0 if absent (MQTT 3.1.1 or not attached)
+     */
+    using TimedMessageCallback = std::function<void(const std::string& topic, const std::string& payload,
+                                                    int64_t timestamp_ms)>;
+
     /**
      * Constructor
      *
      * @param client_id MQTT client identifier (must be unique)
+     * @param queue_config Outbound queue limits
      */
-    explicit MqttClient(const std::string& client_id);
+    explicit MqttClient(const std::string& client_id,
+                        const PublishQueueConfig& queue_config = PublishQueueConfig());
 
     /**
      * Destructor - cleanup and disconnect
@@ -56,18 +111,82 @@ public:
                  const std::string& username,
                  const std::string& password);
 
+    /**
+     * Enable MQTT v5 features
+     *
+     * Call before connect(). With enabled = false the client stays on 3.1.1.
+     *
+     * @param config Topic alias, expiry and timestamp settings
+     */
+    void setMqttV5(const MqttV5Config& config);
+
+    /**
+     * Use a separate broker session for subscriptions
+     *
+     * Call before connect(). publish() keeps the main session and its
+     * in-flight window; subscribe()/unsubscribe() and message callbacks move
+     * to a second session ("<client_id>_sub_...") with its own window.
+     *
+     * @param enabled true = two sessions, false = one shared session
+     */
+    void setSplitSessions(bool enabled);
+
+    /**
+     * Check if subscriptions use their own session
+     */
+    bool hasSplitSessions() const { return split_sessions_; }
+
+    /**
+     * Check if the session carrying subscriptions is connected (lock-free)
+     *
+     * Same as isConnected() unless split sessions are enabled.
+     */
+    bool isSubscriberConnected() const;
+
+    /**
+     * Check if the client speaks MQTT v5
+     */
+    bool isMqttV5() const { return v5_.enabled; }
+
+    /**
+     * Get number of topic aliases assigned on the current connection
+     */
+    size_t getTopicAliasCount() const { return topic_aliases_.size(); }
+
     /**
      * Disconnect from broker
      */
     void disconnect();
 
     /**
-     * Check if connected
+     * Check if connected (lock-free)
      *
      * @return true if connected to broker
      */
     bool isConnected() const;
 
+    /**
+     * Get connection state (lock-free)
+     */
+    ConnectionState getConnectionState() const { return state_.load(); }
+
+    /**
+     * Connection state name (for logging / health)
+     */
+    static const char* connectionStateName(ConnectionState state);
+
+    /**
+     * Get connection epoch
+     *
+     * Incremented on every successful connect and reconnect of the session
+     * that receives subscriptions (the subscriber session with split
+     * sessions). State learned from the broker (e.g., retained messages) is
+     * only valid for the epoch it was observed in.
+     *
+     * @return Current connection epoch (0 = never connected)
+     */
+    uint64_t getConnectionEpoch() const { return connection_epoch_.load(); }
+
     /**
      * Subscribe to MQTT topic with callback
      *
@@ -80,6 +199,13 @@ public:
      */
     bool subscribe(const std::string& topic, MessageCallback callback, int qos = 1);
 
+    /**
+     * Subscribe to MQTT topic, receiving the sample time of each message
+     *
+     * Spooled messages replayed after an outage carry their original time.
+     */
+    bool subscribe(const std::string& topic, TimedMessageCallback callback, int qos = 1);
+
     /**
      * Subscribe to multiple topics with same callback
      *
@@ -91,6 +217,9 @@ public:
     bool subscribeMultiple(const std::vector<std::string>& topics,
                            MessageCallback callback,
                            int qos = 1);
+    bool subscribeMultiple(const std::vector<std::string>& topics,
+                           TimedMessageCallback callback,
+                           int qos = 1);
 
     /**
      * Unsubscribe from topic
@@ -103,14 +232,68 @@ public:
     /**
      * Publish to MQTT topic
      *
+     * Queues the message for the sender thread. Messages queued while
+     * disconnected are sent after (re)connect; a newer message for a topic
+     * still in the queue replaces the older one.
+     *
      * @param topic MQTT topic
      * @param payload Message payload (string)
      * @param qos Quality of Service (0, 1, or 2)
-     * @param retain Retain message flag
-     * @return true if published successfully
+     * @param retain Retain message flag (retained messages are sent first)
+     * @return true if queued, false if rejected (queue full or invalid)
      */
     bool publish(const std::string& topic, const std::string& payload, int qos = 1, bool retain = false);
 
+    /**
+     * Get outbound queue statistics
+     *
+     * @return Queue depth, bytes, and enqueue/coalesce/drop/sent counters
+     */
+    PublishQueueStats getQueueStats() const;
+
+    /**
+     * Get number of messages handed to Paho but not yet acknowledged
+     */
+    size_t getInFlight() const { return in_flight_.load(); }
+
+    /**
+     * Enable the disk spool for publishes made while disconnected
+     *
+     * Call before connect(). Messages spooled by a previous run are replayed
+     * after the first connection. While a replay is in progress, new
+     * publishes are spooled too so per-topic order is preserved.
+     *
+     * @param config Spool directory and limits
+     * @return true if the spool directory is usable
+     */
+    bool enableOfflineSpool(const OfflineSpoolConfig& config);
+
+    /**
+     * Get disk spool statistics
+     *
+     * @return Spool stats, or nullopt if the spool is not enabled
+     */
+    std::optional<OfflineSpoolStats> getSpoolStats() const;
+
+    /**
+     * Wait until the outbound queue is drained
+     *
+     * @param timeout Maximum time to wait
+     * @return true if queue and in-flight window are empty
+     */
+    bool flush(std::chrono::milliseconds timeout);
+
+    /**
+     * Check if topic matches pattern (supports wildcards)
+     *
+     * Allocation-free; called for every inbound message and callback.
+     *
+     * @param topic Actual topic
+     * @param pattern Pattern with wildcards (+, #)
+     * @return true if topic matches pattern
+     */
+    static bool topicMatches(std::string_view topic, std::string_view pattern);
+
     /**
      * Get broker address
      *
@@ -119,6 +302,73 @@ public:
     std::string getBrokerAddress() const { return broker_address_; }
 
 private:
+    // Paho in-flight window of the subscriber session (only SUBSCRIBE/UNSUBSCRIBE)
+    static constexpr int kSubscriberMaxInFlight = 16;
+
+    /**
+     * DeliveryListener - Releases an in-flight slot when Paho completes a publish
+     */
+    class DeliveryListener : public mqtt::iaction_listener {
+    public:
+        explicit DeliveryListener(MqttClient& owner) : owner_(owner) {}
+        void on_success(const mqtt::token&) override { owner_.onDeliveryComplete(true); }
+        void on_failure(const mqtt::token&) override { owner_.onDeliveryComplete(false); }
+
+    private:
+        MqttClient& owner_;
+    };
+
+    /**
+     * Create a Paho client for broker_address_ (v5 if enabled)
+     */
+    std::shared_ptr<mqtt::async_client> createClient(const std::string& full_client_id) const;
+
+    /**
+     * Connection options shared by both sessions
+     *
+     * @param max_inflight Paho in-flight window for this session
+     */
+    mqtt::connect_options connectOptions(int max_inflight) const;
+
+    /**
+     * Client handle that carries subscriptions (lock-free)
+     */
+    std::shared_ptr<mqtt::async_client> subscriberClient() const;
+
+    /**
+     * Sender thread - drains the outbound queue while connected
+     */
+    void senderLoop();
+
+    /**
+     * Claim an in-flight slot (lock-free)
+     *
+     * @return false if max_in_flight messages are already outstanding
+     */
+    bool tryReserveInFlight();
+
+    /**
+     * Give back an in-flight slot
+     */
+    void releaseInFlight();
+
+    /**
+     * Hand a message to Paho (caller holds an in-flight slot)
+     *
+     * @return true if Paho accepted it; the slot is released on failure
+     */
+    bool sendNow(const QueuedMessage& message);
+
+    /**
+     * Replay thread - feeds spooled messages into the queue after reconnect
+     */
+    void replayLoop();
+
+    /**
+     * Delivery completion (internal, called from Paho threads)
+     */
+    void onDeliveryComplete(bool success);
+
     /**
      * Message arrived callback (internal)
      */
@@ -130,37 +380,72 @@ private:
     void onConnectionLost(const std::string& cause);
 
     /**
-     * Reconnected callback (internal) — restores connected_ and re-subscribes
+     * Reconnected callback (internal) — restores Connected state and re-subscribes
      */
     void onReconnected(const std::string& cause);
 
     /**
-     * Check if topic matches pattern (supports wildcards)
-     *
-     * @param topic Actual topic
-     * @param pattern Pattern with wildcards
-     * @return true if topic matches pattern
+     * Subscriber session callbacks (split sessions only)
      */
-    bool topicMatches(const std::string& topic, const std::string& pattern) const;
+    void onSubscriberConnectionLost(const std::string& cause);
+    void onSubscriberReconnected(const std::string& cause);
 
-    // MQTT client
-    std::unique_ptr<mqtt::async_client> client_;
+    /**
+     * Re-issue every registered subscription on `client` (fire-and-forget)
+     */
+    void resubscribeAll(const std::shared_ptr<mqtt::async_client>& client);
+
+
+    // MQTT client - always accessed via std::atomic_load/std::atomic_store
+    std::shared_ptr<mqtt::async_client> client_;
     std::string client_id_;
 
     // Message callbacks (map: topic_pattern -> callback)
-    std::map<std::string, MessageCallback> message_callbacks_;
+    std::map<std::string, TimedMessageCallback> message_callbacks_;
     mutable std::mutex callbacks_mutex_;
 
     // Connection state
     std::string broker_address_;
     std::string username_;
     std::string password_;
-    bool connected_;
-    bool initial_connect_done_ = false;
-    mutable std::recursive_mutex connection_mutex_;  // Recursive to allow callback re-entry
+    std::atomic<ConnectionState> state_{ConnectionState::Disconnected};
+    std::atomic<bool> initial_connect_done_{false};
+    std::atomic<uint64_t> connection_epoch_{0};
+    std::mutex connection_mutex_;  // Serializes connect()/disconnect() only
 
     // Auto-reconnect enabled
     bool auto_reconnect_;
+
+    // Outbound queue (drained by sender_thread_)
+    PublishQueue publish_queue_;
+    mutable std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::thread sender_thread_;
+    bool sender_running_ = false;
+    std::atomic<size_t> in_flight_{0};
+    std::atomic<size_t> queued_{0};         // Mirrors publish_queue_.size() for the fast path
+    std::atomic<bool> sender_busy_{false};  // Sender holds a popped message not yet handed off
+    std::atomic<uint64_t> direct_{0};
+    std::atomic<uint64_t> sent_{0};
+    std::atomic<uint64_t> send_failed_{0};
+    DeliveryListener delivery_listener_{*this};
+
+    // Disk spool (optional, drained by replay_thread_)
+    std::unique_ptr<OfflineSpool> spool_;
+    mutable std::mutex spool_mutex_;
+    std::atomic<bool> spooling_{false};  // Spool has unreplayed messages - route publishes there
+    std::thread replay_thread_;
+
+    // Subscriber session (split sessions only, configured before connect)
+    bool split_sessions_ = false;
+    std::shared_ptr<mqtt::async_client> sub_client_;  // std::atomic_load/std::atomic_store
+    std::atomic<ConnectionState> sub_state_{ConnectionState::Disconnected};
+    std::atomic<bool> subscriber_connect_done_{false};
+
+    // MQTT v5 (configured before connect, read-only afterwards)
+    MqttV5Config v5_;
+    TopicAliasTable topic_aliases_;
+    std::atomic<uint16_t> alias_capacity_{0};  // min(broker Topic Alias Maximum, v5_.max_topic_aliases)
 };
 
 }  // namespace hms_nut
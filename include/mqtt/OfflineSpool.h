@@ -0,0 +1,175 @@
+#pragma once
+
+#include "mqtt/PublishQueue.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace hms_nut {
+
+/**
+ * OfflineSpoolConfig - Disk spool limits
+ */
+struct OfflineSpoolConfig {
+    std::string directory;                   // Spool directory (empty = disabled)
+    size_t segment_bytes = 1024 * 1024;      // Roll to a new segment file after this size
+    size_t max_bytes = 64 * 1024 * 1024;     // Total cap - oldest segments are deleted
+    double replay_rate = 50.0;               // Messages per second after reconnect
+
+    // Retained messages on topics ending with this suffix are compacted to
+    // their latest value (HA discovery configs). Retained state topics keep
+    // their full history so status transitions during an outage are not lost.
+    // Empty = compact every retained message.
+    std::string compact_suffix = "/config";
+};
+
+/**
+ * SpoolRecord - Message read back from the spool
+ */
+struct SpoolRecord {
+    QueuedMessage message;
+    int64_t timestamp_ms = 0;  // Wall-clock time the message was spooled
+};
+
+/**
+ * OfflineSpoolStats - Counters for monitoring
+ */
+struct OfflineSpoolStats {
+    size_t segments = 0;
+    size_t bytes = 0;           // On-disk size of all segments
+    size_t pending = 0;         // Records not yet replayed (including superseded ones)
+    uint64_t appended = 0;
+    uint64_t replayed = 0;
+    uint64_t compacted = 0;     // Compactable records skipped because a newer value exists
+    uint64_t dropped = 0;       // Records lost to the size cap
+    uint64_t errors = 0;        // Write errors and corrupt records
+};
+
+/**
+ * OfflineSpool - Segmented append-only disk spool for MQTT publishes (not thread-safe)
+ *
+ * Holds messages published while the broker is unreachable so a broker
+ * restart does not leave gaps in Home Assistant history or the collector's
+ * database. Segments are named spool-<first seq>.seg and hold
+ * length-prefixed, checksummed records in host byte order (the spool is a
+ * local cache, not an exchange format). A torn record at the tail of the
+ * last segment (crash mid-write) is truncated on open().
+ *
+ * Messages are replayed in full, in order, except compactable ones (retained
+ * discovery configs, see OfflineSpoolConfig::compact_suffix): only their
+ * latest version matters, so older copies are skipped on replay.
+ *
+ * MqttClient wraps this with its own mutex.
+ */
+class OfflineSpool {
+public:
+    explicit OfflineSpool(const OfflineSpoolConfig& config);
+    ~OfflineSpool();
+
+    // Disable copy
+    OfflineSpool(const OfflineSpool&) = delete;
+    OfflineSpool& operator=(const OfflineSpool&) = delete;
+
+    /**
+     * Create the directory and load segments left by a previous run
+     *
+     * @return true if the spool is usable
+     */
+    bool open();
+
+    /**
+     * Append a message
+     *
+     * @param message Message to spool
+     * @param timestamp_ms Wall-clock time in milliseconds since epoch
+     * @return true if written
+     */
+    bool append(const QueuedMessage& message, int64_t timestamp_ms);
+
+    /**
+     * Read the next record to replay
+     *
+     * Skips superseded retained records and deletes fully replayed segments.
+     *
+     * @return Record, or nullopt if everything has been replayed
+     */
+    std::optional<SpoolRecord> next();
+
+    /**
+     * Check if there is nothing left to replay
+     */
+    bool empty() const { return pending_ == 0; }
+
+    OfflineSpoolStats getStats() const;
+
+    const OfflineSpoolConfig& getConfig() const { return config_; }
+
+private:
+    struct Segment {
+        uint64_t first_seq;
+        std::string path;
+        size_t bytes;
+        size_t records;
+    };
+
+    /**
+     * Read one record at `offset` from `in`
+     *
+     * @return Record size on disk, 0 if incomplete, SIZE_MAX if corrupt
+     */
+    size_t readRecord(std::ifstream& in, size_t offset, uint64_t& seq, SpoolRecord& record);
+
+    /**
+     * Scan a segment on open() - rebuild index and counts, truncate torn tail
+     */
+    bool loadSegment(Segment& segment);
+
+    /**
+     * Start a new segment for writing
+     */
+    bool rollSegment();
+
+    /**
+     * Delete the oldest segment (size cap or fully replayed)
+     */
+    void removeFrontSegment();
+
+    /**
+     * Enforce max_bytes by deleting the oldest segments
+     */
+    void enforceCap();
+
+    std::string segmentPath(uint64_t first_seq) const;
+
+    /**
+     * Check if only the latest copy of this message needs replaying
+     */
+    bool isCompactable(const QueuedMessage& message) const;
+
+    OfflineSpoolConfig config_;
+    std::deque<Segment> segments_;
+    std::ofstream writer_;          // Appends to segments_.back()
+    std::ifstream reader_;          // Reads segments_.front()
+    size_t read_offset_ = 0;        // Byte offset in segments_.front()
+    size_t read_records_ = 0;       // Records consumed from segments_.front()
+    bool reader_open_ = false;
+
+    uint64_t next_seq_ = 1;
+    size_t pending_ = 0;
+    size_t total_bytes_ = 0;
+
+    // Newest seq per compactable topic - older records are skipped
+    std::unordered_map<std::string, uint64_t> latest_compactable_;
+
+    uint64_t appended_ = 0;
+    uint64_t replayed_ = 0;
+    uint64_t compacted_ = 0;
+    uint64_t dropped_ = 0;
+    uint64_t errors_ = 0;
+};
+
+}  // namespace hms_nut
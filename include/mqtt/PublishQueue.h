@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace hms_nut {
+
+/**
+ * OverflowPolicy - What to do when the outbound queue is full
+ */
+enum class OverflowPolicy {
+    DropOldest,  // Evict the oldest state message to make room (default)
+    DropNewest   // Reject the incoming message
+};
+
+/**
+ * PublishQueueConfig - Outbound queue limits
+ */
+struct PublishQueueConfig {
+    size_t max_messages = 10000;            // Queued messages (both lanes)
+    size_t max_bytes = 4 * 1024 * 1024;     // Queued topic + payload bytes
+    size_t max_in_flight = 64;              // Handed to Paho but not yet acknowledged
+    OverflowPolicy overflow = OverflowPolicy::DropOldest;
+
+    /**
+     * Parse overflow policy name ("drop_oldest" / "drop_newest")
+     */
+    static OverflowPolicy parseOverflowPolicy(const std::string& name);
+};
+
+/**
+ * QueuedMessage - Message waiting to be handed to the broker connection
+ */
+struct QueuedMessage {
+    std::string topic;
+    std::string payload;
+    int qos = 1;
+    bool retain = false;
+    int64_t timestamp_ms = 0;  // Sample time (ms since epoch), 0 = unknown
+
+    size_t bytes() const { return topic.size() + payload.size(); }
+};
+
+/**
+ * PublishQueueStats - Counters for monitoring
+ */
+struct PublishQueueStats {
+    size_t depth = 0;           // Messages queued (both lanes)
+    size_t priority_depth = 0;  // Retained/discovery messages queued
+    size_t bytes = 0;
+    uint64_t enqueued = 0;      // Accepted as new entries
+    uint64_t coalesced = 0;     // Replaced an older queued message for the same topic
+    uint64_t dropped = 0;       // Evicted or rejected because the queue was full
+    uint64_t direct = 0;        // Bypassed the queue on the fast path (filled in by MqttClient)
+    uint64_t sent = 0;          // Acknowledged by the broker (filled in by MqttClient)
+    uint64_t send_failed = 0;   // Publish failed after leaving the queue (filled in by MqttClient)
+    size_t in_flight = 0;       // Handed to Paho, awaiting completion (filled in by MqttClient)
+};
+
+/**
+ * PublishQueue - Bounded, per-topic coalescing outbound queue (not thread-safe)
+ *
+ * Two FIFO lanes: retained messages (discovery configs, retained state) drain
+ * before ordinary state messages. A newer message for a topic that is still
+ * queued replaces the older one in place, so a slow broker never sees stale
+ * intermediate states and memory is bounded by the number of distinct topics.
+ * When either cap is hit, the overflow policy decides what is dropped; state
+ * messages are always evicted before retained ones.
+ *
+ * MqttClient wraps this with its own mutex.
+ */
+class PublishQueue {
+public:
+    enum class PushResult { Queued, Coalesced, Dropped };
+
+    explicit PublishQueue(const PublishQueueConfig& config = PublishQueueConfig());
+
+    /**
+     * Queue a message (retain = priority lane)
+     *
+     * @param message Message to queue
+     * @return Queued, Coalesced (replaced older entry), or Dropped (full)
+     */
+    PushResult push(QueuedMessage message);
+
+    /**
+     * Take the next message (priority lane first)
+     *
+     * @return Message, or nullopt if empty
+     */
+    std::optional<QueuedMessage> pop();
+
+    bool empty() const { return index_.empty(); }
+    bool contains(const std::string& topic) const { return index_.count(topic) > 0; }
+    size_t size() const { return index_.size(); }
+    size_t bytes() const { return bytes_; }
+
+    PublishQueueStats getStats() const;
+
+    const PublishQueueConfig& getConfig() const { return config_; }
+
+    /**
+     * Drop everything (counters are kept)
+     */
+    void clear();
+
+private:
+    enum Lane { kPriority = 0, kNormal = 1, kLaneCount = 2 };
+
+    using List = std::list<QueuedMessage>;
+
+    struct Location {
+        Lane lane;
+        List::iterator it;
+    };
+
+    /**
+     * Remove the front of a lane
+     */
+    void evictFront(Lane lane);
+
+    /**
+     * Make room for `incoming` bytes in `lane` according to policy
+     *
+     * @return false if the incoming message must be rejected
+     */
+    bool makeRoom(Lane lane, size_t incoming);
+
+    PublishQueueConfig config_;
+    List lanes_[kLaneCount];
+    std::unordered_map<std::string, Location> index_;  // topic -> queued entry
+    size_t bytes_ = 0;
+
+    uint64_t enqueued_ = 0;
+    uint64_t coalesced_ = 0;
+    uint64_t dropped_ = 0;
+};
+
+}  // namespace hms_nut
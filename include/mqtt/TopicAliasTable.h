@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace hms_nut {
+
+/**
+ * TopicAliasTable - Client-to-broker MQTT v5 topic aliases for one connection
+ *
+ * Aliases are handed out first-come up to the broker's Topic Alias Maximum
+ * (from CONNACK) and never evicted - the recurring state topics are a fixed
+ * set, and remapping would cost a full topic each time. The table is reset
+ * on every (re)connect because aliases only live for one network connection.
+ *
+ * The first PUBLISH for an alias must carry the topic and the alias; later
+ * ones may send an empty topic. An alias only becomes usable once the
+ * establishing PUBLISH has been handed to Paho (markEstablished), so a
+ * concurrent publisher can never overtake it with an alias-only message -
+ * until then it sends the full topic without an alias.
+ *
+ * Thread-safe.
+ */
+class TopicAliasTable {
+public:
+    enum class Use {
+        None,       // Send the full topic, no alias
+        Establish,  // Send topic + alias, then call markEstablished()/markFailed()
+        Alias       // Send an empty topic + alias
+    };
+
+    struct Lookup {
+        Use use = Use::None;
+        uint16_t alias = 0;
+        uint64_t generation = 0;  // Connection the alias belongs to
+    };
+
+    explicit TopicAliasTable(uint16_t capacity = 0);
+
+    /**
+     * Forget all aliases (new connection)
+     *
+     * @param capacity Usable aliases (min of broker maximum and local limit, 0 = disabled)
+     */
+    void reset(uint16_t capacity);
+
+    /**
+     * Decide how to address a publish on `topic`
+     */
+    Lookup lookup(const std::string& topic);
+
+    /**
+     * Establishing PUBLISH was handed to the client - alias-only sends may follow
+     */
+    void markEstablished(const std::string& topic, const Lookup& lookup);
+
+    /**
+     * Establishing PUBLISH failed - the next publish tries again
+     */
+    void markFailed(const std::string& topic, const Lookup& lookup);
+
+    uint16_t capacity() const;
+    size_t size() const;
+
+private:
+    enum class State { Unsent, Pending, Established };
+
+    struct Entry {
+        uint16_t alias;
+        State state;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    uint16_t capacity_;
+    uint64_t generation_ = 0;
+};
+
+}  // namespace hms_nut
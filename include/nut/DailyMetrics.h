@@ -0,0 +1,101 @@
+#pragma once
+
+#include "nut/DailyStats.h"
+#include "nut/MetricRollup.h"
+#include <json/json.h>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * PowerEventRow - One power_events row
+ */
+struct PowerEventRow {
+    std::string device_identifier;
+    std::string event_type;  // "outage_start", "outage_end", "battery_low"
+    int64_t timestamp_ms = 0;
+    std::optional<double> battery_level_start;
+    std::optional<double> battery_level_end;
+    std::optional<double> load_at_event;
+};
+
+/**
+ * MetricSummary - One metric over one day
+ */
+struct MetricSummary {
+    uint64_t count = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double avg = 0.0;
+    std::optional<double> stddev;  // Unset with fewer than two values
+    int64_t min_ts_ms = 0;         // When min/max occurred (0 = unknown)
+    int64_t max_ts_ms = 0;
+};
+
+/**
+ * DeviceDailyMetrics - One device's day
+ */
+struct DeviceDailyMetrics {
+    std::string device_identifier;
+    std::string device_name;  // Empty if only the identifier is known
+    std::string location;
+    uint64_t readings = 0;    // ups_metrics rows, or values ingested (daily stats)
+    int64_t first_ts_ms = 0;
+    int64_t last_ts_ms = 0;
+    std::array<std::optional<MetricSummary>, kMetricCount> metrics;  // Unset = never reported
+    uint64_t status_readings = 0;
+    uint64_t on_battery_readings = 0;           // Power failure / OB readings
+    std::vector<std::string> statuses;          // Distinct ups_status values
+    std::vector<std::string> transfer_reasons;  // Distinct transfer reasons
+
+    const std::optional<MetricSummary>& metric(Metric m) const { return metrics[static_cast<size_t>(m)]; }
+
+    /**
+     * Convert a device's collector daily stats
+     */
+    static DeviceDailyMetrics fromDailyStats(const std::string& device_identifier, const DailyStats& stats);
+};
+
+/**
+ * DailyMetrics - Every device's metrics and the power events of one local day
+ *
+ * The typed form behind the daily report and the summary prompt: built
+ * once from collector daily stats or a ups_metrics aggregate, then rendered
+ * as text (LLM prompt, GET /reports/daily?format=text) or JSON.
+ */
+struct DailyMetrics {
+    std::string date;    // YYYY-MM-DD
+    std::string source;  // "daily_stats" or "ups_metrics"
+    std::vector<DeviceDailyMetrics> devices;
+    std::vector<PowerEventRow> power_events;
+
+    bool empty() const { return devices.empty(); }
+
+    /**
+     * Build from one day of collector daily stats (power events not included)
+     */
+    static DailyMetrics fromDailyStats(const std::string& date, const std::vector<DailyStatsRow>& rows);
+
+    /**
+     * Plain text report ("UPS Energy Report for <date>", one block per device)
+     */
+    std::string toText() const;
+
+    /**
+     * JSON report (also the on-disk cache format)
+     */
+    Json::Value toJson() const;
+
+    /**
+     * Parse toJson() output
+     *
+     * @return Metrics, or nullopt if the date is missing
+     */
+    static std::optional<DailyMetrics> fromJson(const Json::Value& json);
+};
+
+}  // namespace hms_nut
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "nut/MetricRollup.h"
+#include <json/json.h>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * RunningStats - Streaming mean/variance (Welford) with min/max and when they occurred
+ */
+struct RunningStats {
+    uint64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;  // Sum of squared deviations from the mean
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    int64_t min_ts_ms = 0;
+    int64_t max_ts_ms = 0;
+
+    void add(double value, int64_t ts_ms);
+
+    /**
+     * Combine with stats of another sample set (Chan et al. parallel update)
+     */
+    void merge(const RunningStats& other);
+
+    /**
+     * Sample variance (0 with fewer than two values)
+     */
+    double variance() const { return count > 1 ? m2 / static_cast<double>(count - 1) : 0.0; }
+    double stddev() const;
+};
+
+/**
+ * DailyStats - One device's statistics for one local calendar day
+ *
+ * Built from every ingested MQTT value, not from the saved ups_metrics rows.
+ */
+struct DailyStats {
+    static constexpr size_t kMaxDistinct = 16;  // Cap on statuses / transfer reasons kept
+
+    std::string date;  // YYYY-MM-DD, local time (same days as the summary)
+    int64_t first_ts_ms = 0;
+    int64_t last_ts_ms = 0;
+    uint64_t samples = 0;  // Values accumulated (metrics and status)
+    std::array<RunningStats, kMetricCount> metrics;
+    uint64_t status_samples = 0;
+    uint64_t on_battery_samples = 0;            // Status samples with the OB flag
+    std::vector<std::string> statuses;          // Distinct ups_status values, first-seen order
+    std::vector<std::string> transfer_reasons;  // Distinct, first-seen order
+
+    const RunningStats& metric(Metric m) const { return metrics[static_cast<size_t>(m)]; }
+
+    /**
+     * Combine with another partial day of the same device and date
+     */
+    void merge(const DailyStats& other);
+
+    /**
+     * Persisted form (ups_daily_stats.stats)
+     */
+    Json::Value toJson() const;
+
+    /**
+     * Parse the persisted form
+     *
+     * @return Stats, or nullopt if the date is missing
+     */
+    static std::optional<DailyStats> fromJson(const Json::Value& json);
+};
+
+/**
+ * DailyStatsRow - One device's day in ups_daily_stats
+ */
+struct DailyStatsRow {
+    std::string device_identifier;
+    DailyStats stats;  // stats.date is the row's day
+};
+
+/**
+ * True if a ups_status value carries the OB (on battery) flag, e.g. "OB DISCHRG"
+ */
+bool isOnBatteryStatus(std::string_view status);
+
+/**
+ * Local calendar date (YYYY-MM-DD) of a timestamp
+ */
+std::string localDate(int64_t ts_ms);
+
+/**
+ * Start of the local day after the one containing ts_ms (ms since epoch)
+ */
+int64_t localDayEnd(int64_t ts_ms);
+
+/**
+ * Bounds of a local calendar day [start_ms, end_ms)
+ *
+ * @param date Day in YYYY-MM-DD format
+ * @return false if the date does not parse
+ */
+bool localDayRange(const std::string& date, int64_t& start_ms, int64_t& end_ms);
+
+/**
+ * DailyAccumulator - Running DailyStats for one device (not thread-safe)
+ *
+ * Values go into the current day; a value past local midnight (or
+ * advance()) closes the day, which waits in takeClosed() for the saver.
+ * The last closed day stays readable through previous() so yesterday's
+ * summary needs no database read. Late values for that day (offline spool
+ * replay) update it and hand it to takeClosed() again.
+ */
+class DailyAccumulator {
+public:
+    void addMetric(Metric metric, double value, int64_t ts_ms);
+    void addStatus(std::string_view status, int64_t ts_ms);
+    void addTransferReason(std::string_view reason, int64_t ts_ms);
+
+    /**
+     * Close the current day if `now_ms` is past it
+     */
+    void advance(int64_t now_ms);
+
+    /**
+     * Merge stats restored from the database into the matching day
+     */
+    void seed(const DailyStats& stats);
+
+    /**
+     * Move closed days to `out` (and the last closed day again if late values changed it)
+     */
+    void takeClosed(std::vector<DailyStats>& out);
+
+    /**
+     * Day in progress (samples == 0 before the first value)
+     */
+    const DailyStats& current() const { return current_; }
+
+    /**
+     * Most recently closed day (samples == 0 if none)
+     */
+    const DailyStats& previous() const { return previous_; }
+
+private:
+    /**
+     * Make the day containing ts_ms current, closing the old one
+     */
+    void enter(int64_t ts_ms);
+
+    /**
+     * Count a value at ts_ms and return the day it belongs to
+     */
+    DailyStats& touch(int64_t ts_ms);
+
+    DailyStats current_;
+    DailyStats previous_;
+    int64_t day_start_ms_ = 0;  // current_ covers [day_start_ms_, day_end_ms_)
+    int64_t day_end_ms_ = 0;
+    int64_t previous_start_ms_ = 0;  // previous_ covers [previous_start_ms_, previous_end_ms_)
+    int64_t previous_end_ms_ = 0;
+    bool previous_dirty_ = false;     // Late values since previous_ was closed
+    std::vector<DailyStats> closed_;
+};
+
+}  // namespace hms_nut
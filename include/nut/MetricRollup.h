@@ -0,0 +1,171 @@
+#pragma once
+
+#include "nut/SensorSchema.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * Metric - High-rate numeric telemetry kept in the history tiers
+ *
+ * A subset of Sensor: the values that change every poll. Status and nominal
+ * values are in ups_metrics already and don't need rollups.
+ */
+enum class Metric : size_t {
+    BatteryCharge,
+    BatteryVoltage,
+    BatteryRuntime,
+    InputVoltage,
+    OutputVoltage,
+    LoadPercentage,
+    LoadWatts,
+    Temperature,
+    Count
+};
+
+constexpr size_t kMetricCount = static_cast<size_t>(Metric::Count);
+
+/**
+ * Sensor a metric is published as
+ */
+Sensor metricSensor(Metric metric);
+
+/**
+ * Metric id (same as the sensor id, e.g. "input_voltage")
+ */
+const char* metricName(Metric metric);
+
+/**
+ * Look up a metric by sensor id
+ *
+ * @return Metric or nullopt if the sensor is not a history metric
+ */
+std::optional<Metric> findMetric(std::string_view sensor_id);
+
+/**
+ * Parse a comma-separated list of metric ids (e.g. "input_voltage,load_percentage")
+ *
+ * @return Metrics in the given order (all metrics if csv is empty), or nullopt
+ *         if any id is not a history metric
+ */
+std::optional<std::vector<Metric>> parseMetricList(std::string_view csv);
+
+/**
+ * CollectorTierConfig - History tiers kept besides the ups_metrics rows
+ *
+ * raw:  in-memory SampleRing per device at poll resolution
+ * 1m:   ups_metrics_1m, per-metric avg/min/max per minute
+ * 1h:   ups_metrics_1h, merged from the minute buckets
+ * day:  ups_daily_stats, running per-device statistics for each local day
+ */
+struct CollectorTierConfig {
+    int raw_window_seconds = 3600;  // Raw ring time window (0 = raw tier disabled)
+    size_t raw_capacity = 720;      // Raw ring rows per device
+    bool persist_rollups = false;   // Write the 1m / 1h tables
+    int minute_retention_days = 14;
+    int hour_retention_days = 1825;
+    bool daily_stats = false;       // Per-device daily accumulators (ups_daily_stats)
+};
+
+/**
+ * SeriesTier - Storage a time series is read from
+ */
+enum class SeriesTier {
+    Raw,     // In-memory SampleRing
+    Minute,  // ups_metrics_1m (avg_value)
+    Hour,    // ups_metrics_1h (avg_value)
+    Stored   // ups_metrics rows (COLLECTOR_SAVE_INTERVAL)
+};
+
+/**
+ * Tier name for responses ("raw", "1m", "1h", "stored")
+ */
+const char* seriesTierName(SeriesTier tier);
+
+/**
+ * Pick the finest tier that still holds the whole range
+ *
+ * Raw when `from` is inside the raw window; otherwise the minute rollups
+ * while their retention covers `from` and the range has at most max_rows
+ * minutes; then the hour rollups; ups_metrics as the last resort (or
+ * when rollups are not persisted).
+ *
+ * @param config Collector tier configuration
+ * @param from_ms Range start (ms since epoch)
+ * @param to_ms Range end (ms since epoch)
+ * @param now_ms Current time (ms since epoch)
+ * @param max_rows Largest minute-tier read allowed
+ */
+SeriesTier chooseSeriesTier(const CollectorTierConfig& config, int64_t from_ms, int64_t to_ms,
+                            int64_t now_ms, size_t max_rows = 20000);
+
+/**
+ * MetricAggregate - count/sum/min/max of one metric over a bucket
+ */
+struct MetricAggregate {
+    uint32_t count = 0;
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void add(double value);
+    void merge(const MetricAggregate& other);
+    double avg() const { return count ? sum / count : 0.0; }
+};
+
+/**
+ * RollupBucket - All metrics of one device over [start_ms, start_ms + width)
+ */
+struct RollupBucket {
+    int64_t start_ms = 0;
+    std::array<MetricAggregate, kMetricCount> metrics;
+
+    bool empty() const;
+};
+
+/**
+ * RollupAccumulator - Builds 1-minute and 1-hour buckets for one device (not thread-safe)
+ *
+ * Values are folded into the open minute bucket. When a minute closes it is
+ * handed out and merged into the open hour bucket, so the hour tier never
+ * revisits raw samples. Buckets are aligned to wall-clock minutes/hours (UTC).
+ */
+class RollupAccumulator {
+public:
+    static constexpr int64_t kMinuteMs = 60 * 1000;
+    static constexpr int64_t kHourMs = 60 * kMinuteMs;
+
+    /**
+     * Add one value observed at ts_ms (ms since epoch)
+     */
+    void add(Metric metric, double value, int64_t ts_ms);
+
+    /**
+     * Close buckets whose interval ended at or before now_ms
+     */
+    void advance(int64_t now_ms);
+
+    /**
+     * Move closed buckets out (appended to minutes/hours)
+     */
+    void takeClosed(std::vector<RollupBucket>& minutes, std::vector<RollupBucket>& hours);
+
+private:
+    void closeMinute();
+    void closeHour();
+
+    RollupBucket minute_;
+    RollupBucket hour_;
+    bool minute_open_ = false;
+    bool hour_open_ = false;
+    std::vector<RollupBucket> closed_minutes_;
+    std::vector<RollupBucket> closed_hours_;
+};
+
+}  // namespace hms_nut
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "nut/MetricRollup.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * SampleSeries - Columnar copy of SampleRing rows
+ *
+ * columns[k] holds the values of metrics[k], parallel to timestamps.
+ */
+struct SampleSeries {
+    std::vector<Metric> metrics;
+    std::vector<int64_t> timestamps;
+    std::vector<std::vector<float>> columns;
+};
+
+/**
+ * SampleRing - Fixed-capacity raw history for one device (not thread-safe)
+ *
+ * Struct-of-arrays: one timestamp column and one float column per Metric,
+ * allocated once. Reading one field over a time range touches a single
+ * contiguous column instead of striding over whole samples.
+ *
+ * Sensors of one poll arrive as separate MQTT messages within milliseconds;
+ * values landing within kRowWindowMs of the newest row are merged into it.
+ * A new row starts with the previous row's values (carry-forward), so every
+ * row is a full device snapshot. Rows older than the window (relative to the
+ * newest row) or beyond capacity are dropped.
+ */
+class SampleRing {
+public:
+    static constexpr int64_t kRowWindowMs = 1000;
+
+    /**
+     * @param capacity Maximum rows (>= 1)
+     * @param window_ms Maximum age of the oldest row relative to the newest (0 = unlimited)
+     */
+    SampleRing(size_t capacity, int64_t window_ms);
+
+    /**
+     * Record one value observed at ts_ms (ms since epoch)
+     */
+    void record(Metric metric, float value, int64_t ts_ms);
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return timestamps_.size(); }
+
+    /**
+     * Row timestamp, i = 0 is the oldest row
+     */
+    int64_t timestamp(size_t i) const { return timestamps_[physical(i)]; }
+
+    /**
+     * Row value, NaN if the metric was never reported
+     */
+    float value(size_t i, Metric metric) const {
+        return columns_[static_cast<size_t>(metric)][physical(i)];
+    }
+
+    /**
+     * Index of the first row with timestamp >= since_ms (size() if none)
+     */
+    size_t lowerBound(int64_t since_ms) const;
+
+    /**
+     * Copy rows with timestamp >= since_ms, one column per requested metric
+     *
+     * Each column is copied as at most two contiguous runs (the ring may wrap).
+     * `out` keeps its capacity between calls.
+     */
+    void copySince(int64_t since_ms, const std::vector<Metric>& metrics, SampleSeries& out) const;
+
+private:
+    size_t physical(size_t i) const {
+        size_t p = start_ + i;
+        return p < timestamps_.size() ? p : p - timestamps_.size();
+    }
+
+    void pushRow(int64_t ts_ms);
+
+    int64_t window_ms_;
+    std::vector<int64_t> timestamps_;
+    std::array<std::vector<float>, kMetricCount> columns_;
+    size_t start_ = 0;  // Physical index of the oldest row
+    size_t size_ = 0;
+};
+
+}  // namespace hms_nut
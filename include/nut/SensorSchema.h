@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace hms_nut {
+
+/**
+ * Sensor - Every UPS sensor published under homeassistant/sensor/{device}/{sensor}/state
+ *
+ * Order matches the publish order of UpsData::toMqttMessages()
+ */
+enum class Sensor : size_t {
+    BatteryCharge,
+    BatteryVoltage,
+    BatteryRuntime,
+    BatteryNominalVoltage,
+    BatteryLowChargeThreshold,
+    BatteryWarningChargeThreshold,
+    InputVoltage,
+    InputNominalVoltage,
+    HighVoltageTransfer,
+    LowVoltageTransfer,
+    InputSensitivity,
+    LastTransferReason,
+    LoadPercentage,
+    LoadWatts,
+    UpsStatus,
+    PowerFailure,
+    UpsNominalPower,
+    BeeperStatus,
+    SelfTestResult,
+    FirmwareVersion,
+    DriverName,
+    DriverVersion,
+    DriverState,
+    Temperature,
+    OutputVoltage,
+    OutputNominalVoltage,
+    Count
+};
+
+constexpr size_t kSensorCount = static_cast<size_t>(Sensor::Count);
+
+/**
+ * SensorKind - Payload type of a sensor
+ */
+enum class SensorKind {
+    Numeric,  // Formatted with SensorInfo::precision decimals
+    Text,     // Published verbatim
+    Binary    // "1" / "0"
+};
+
+/**
+ * SensorInfo - Static description of one sensor
+ */
+struct SensorInfo {
+    const char* id;   // MQTT sensor id (topic level), e.g. "battery_charge"
+    SensorKind kind;
+    int precision;    // Max decimals for numeric payloads (trailing zeros trimmed)
+
+    // Home Assistant discovery metadata (empty string = omitted)
+    const char* name;          // Friendly name, e.g. "Battery Charge"
+    const char* unit;          // unit_of_measurement
+    const char* device_class;
+    const char* state_class;
+    const char* icon;
+
+    // Default publish policy (see PublishPolicy)
+    int qos;
+    bool retain;
+};
+
+/**
+ * PublishPolicy - MQTT QoS and retain flag for a sensor's state topic
+ */
+struct PublishPolicy {
+    int qos = 1;
+    bool retain = false;
+};
+
+/**
+ * SensorSchema - Single source of truth for the published sensor set
+ */
+class SensorSchema {
+public:
+    /**
+     * Get all sensors in publish order
+     */
+    static const std::array<SensorInfo, kSensorCount>& all();
+
+    /**
+     * Get info for one sensor
+     */
+    static const SensorInfo& get(Sensor sensor) {
+        return all()[static_cast<size_t>(sensor)];
+    }
+
+    /**
+     * Look up a sensor by its MQTT id
+     *
+     * @param id Sensor id (e.g., "input_voltage")
+     * @return Sensor or nullopt if unknown
+     */
+    static std::optional<Sensor> find(std::string_view id);
+
+    /**
+     * Get the current publish policy for a sensor
+     *
+     * Starts at the table defaults (QoS 0 telemetry, QoS 1 retained status and
+     * nominal values). Overrides are applied once at startup, before services
+     * start publishing - the table is not synchronized.
+     */
+    static PublishPolicy policy(Sensor sensor);
+
+    /**
+     * Override the publish policy for a sensor (QoS clamped to 0-2)
+     */
+    static void setPolicy(Sensor sensor, PublishPolicy policy);
+
+    /**
+     * Restore table defaults for all sensors
+     */
+    static void resetPolicies();
+
+    /**
+     * Apply overrides from JSON, e.g. {"input_voltage": {"qos": 1, "retain": true}}
+     *
+     * @param json JSON object keyed by sensor id (qos and retain are optional)
+     * @return false if the JSON is invalid or names an unknown sensor
+     */
+    static bool applyPolicyOverrides(const std::string& json);
+
+    /**
+     * Highest QoS any sensor is published at (subscribers use this)
+     */
+    static int maxQos();
+};
+
+}  // namespace hms_nut
@@ -9,6 +9,8 @@
 
 namespace hms_nut {
 
+class CompactWriter;
+
 struct MqttMessage {
     std::string topic;
     std::string payload;
@@ -78,6 +80,16 @@ struct UpsData {
     // Serialization
     std::string toJson() const;
     std::vector<MqttMessage> toMqttMessages() const;
+
+    // Fill `messages` in place, reusing existing elements and string capacity.
+    // Topics come from a per-device cache and numbers are formatted with
+    // std::to_chars at the precision in SensorSchema, so steady-state polls
+    // allocate nothing.
+    void toMqttMessages(std::vector<MqttMessage>& messages) const;
+
+    // Write the reported sensors as one map keyed by MQTT sensor id, with
+    // native numbers/booleans (no Json::Value or payload formatting).
+    void encodeSensors(CompactWriter& writer) const;
 };
 
 }  // namespace hms_nut
@@ -2,13 +2,24 @@
 
 #include "mqtt/MqttClient.h"
 #include "database/DatabaseService.h"
+#include "nut/DailyStats.h"
 #include "nut/UpsData.h"
+#include "nut/MetricRollup.h"
+#include "nut/SampleRing.h"
+#include "services/LiveStreamHub.h"
+#include "utils/CompactWriter.h"
+#include "utils/DeviceFilter.h"
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <map>
+#include <set>
+#include <shared_mutex>
 #include <chrono>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace hms_nut {
@@ -16,9 +27,23 @@ namespace hms_nut {
 /**
  * CollectorService - Thread 2: MQTT → PostgreSQL Collector
  *
- * Subscribes to MQTT topics from all UPS devices
+ * Subscribes to MQTT topics from all UPS devices (one pattern per configured
+ * ID, or a single wildcard with DeviceFilter admission when auto-discovery
+ * is enabled)
  * Aggregates metrics in memory
- * Persists to PostgreSQL at configurable intervals (default: 1 hour)
+ * Persists to PostgreSQL at configurable intervals (default: 1 hour), aligned
+ * to wall-clock boundaries (HH:00:00 for 1 hour) with all devices written in
+ * one batch per boundary
+ *
+ * Per-device state lives in a fixed array of cache-line aligned slots, each
+ * with its own lock. A device ID is interned to its slot index once; after
+ * that a sample only locks its own slot, so ingest for different devices runs
+ * in parallel. The saver copies a slot under its lock and writes to the
+ * database without holding it.
+ *
+ * Numeric telemetry also feeds the history tiers (CollectorTierConfig): a raw
+ * ring in memory and 1-minute / 1-hour aggregates flushed by the saver on
+ * minute boundaries, each tier with its own retention.
  */
 class CollectorService {
 public:
@@ -27,11 +52,16 @@ public:
      *
      * @param mqtt_client Shared MQTT client
      * @param db_service Database service (singleton)
-     * @param save_interval_seconds Save interval in seconds (default: 3600 = 1 hour)
+     * @param save_interval_seconds Save interval in seconds (default: 3600 = 1 hour),
+     *                              aligned to multiples of the interval since the epoch (UTC)
+     * @param max_devices Device slots (samples from further devices are dropped)
      */
     CollectorService(std::shared_ptr<MqttClient> mqtt_client,
                      DatabaseService& db_service,
-                     int save_interval_seconds = 3600);
+                     int save_interval_seconds = 3600,
+                     size_t max_devices = kDefaultMaxDevices);
+
+    static constexpr size_t kDefaultMaxDevices = 1024;
 
     /**
      * Destructor - stops service if running
@@ -67,18 +97,135 @@ public:
     std::chrono::system_clock::time_point getLastSaveTime() const;
 
     /**
-     * Get number of devices being monitored
+     * Get number of devices being monitored (lock-free)
      *
      * @return Device count
      */
     int getDeviceCount() const;
 
+    /**
+     * Get the MQTT device IDs seen so far, in first-seen order
+     */
+    std::vector<std::string> getDeviceIds() const;
+
+    /**
+     * Get number of samples received (lock-free)
+     */
+    uint64_t getMessageCount() const { return messages_received_.load(std::memory_order_relaxed); }
+
+    /**
+     * Collect from any device on homeassistant/sensor/+/+/state
+     *
+     * Call before setupSubscriptions(). Devices are admitted by the filter;
+     * configured device IDs are always admitted.
+     *
+     * @param config Allow/deny patterns and discovery requirement
+     */
+    void enableAutoDiscovery(DeviceFilterConfig config);
+
+    /**
+     * Configure the history tiers
+     *
+     * Call before start() and setupSubscriptions() - slots created earlier
+     * keep the previous settings.
+     *
+     * @param config Raw window and rollup retention
+     */
+    void configureTiers(const CollectorTierConfig& config);
+
+    /**
+     * Get the history tier configuration
+     */
+    const CollectorTierConfig& getTierConfig() const { return tiers_; }
+
+    /**
+     * Copy a device's raw history from memory
+     *
+     * The slot lock is held only for the column copies.
+     *
+     * @param device_id MQTT device ID or DB identifier
+     * @param since_ms Oldest row to return (ms since epoch)
+     * @param metrics Columns to copy
+     * @param out Filled with the rows
+     * @return false if the device is unknown or the raw tier is disabled
+     */
+    bool getHistory(std::string_view device_id, int64_t since_ms,
+                    const std::vector<Metric>& metrics, SampleSeries& out) const;
+
+    /**
+     * Copy every device's in-memory statistics for a day
+     *
+     * Serves the day in progress and the most recently closed day per
+     * device, one slot lock at a time - O(devices), no database access.
+     *
+     * @param date Day in YYYY-MM-DD format (local time)
+     * @param out Filled with one row per device that has stats for the day
+     * @return false if daily stats are disabled
+     */
+    bool getDailyStats(const std::string& date, std::vector<DailyStatsRow>& out) const;
+
+    /**
+     * Encode the current state of every device
+     *
+     * Written straight from the slots, one slot lock at a time:
+     * {"count": N, "devices": [{"device", "identifier", "sensors": {...}}]}
+     *
+     * @param writer Output encoder (JSON, CBOR or MessagePack)
+     */
+    void encodeSnapshots(CompactWriter& writer) const;
+
+    /**
+     * Report ingested values to a live stream
+     *
+     * Call before setupSubscriptions() - the hub is read by the ingest path
+     * without synchronization.
+     *
+     * @param hub Live state stream (nullptr to disable)
+     */
+    void setLiveStream(std::shared_ptr<LiveStreamHub> hub) { live_stream_ = std::move(hub); }
+
+    /**
+     * Get the auto-discovery filter (nullptr if disabled)
+     */
+    const DeviceFilter* getDeviceFilter() const { return device_filter_.get(); }
+
     /**
      * Setup MQTT subscriptions (call this BEFORE starting Drogon)
      */
     void setupSubscriptions();
 
 private:
+    /**
+     * DeviceSlot - State for one device
+     *
+     * mqtt_device_id and device_identifier are written once before the slot
+     * is published through slot_count_ and read without the lock afterwards.
+     */
+    struct alignas(64) DeviceSlot {
+        std::mutex mutex;
+        std::string mqtt_device_id;
+        std::string device_identifier;
+        UpsData data;                     // Guarded by mutex
+        std::unique_ptr<SampleRing> raw;  // Guarded by mutex (nullptr = raw tier disabled)
+        RollupAccumulator rollup;         // Guarded by mutex
+        DailyAccumulator daily;           // Guarded by mutex
+    };
+
+    /**
+     * Intern a device ID to its slot, creating the slot on first sight
+     *
+     * @param mqtt_device_id Device ID from the topic
+     * @return Slot, or nullptr if all slots are taken
+     */
+    DeviceSlot* findOrCreateSlot(std::string_view mqtt_device_id);
+
+    /**
+     * Look up an existing slot by MQTT device ID or DB identifier
+     *
+     * @return Slot, or nullptr if the device has not been seen
+     */
+    DeviceSlot* findSlot(std::string_view device_id) const;
+
     /**
      * MQTT message callback
      *
@@ -86,16 +233,39 @@ private:
      *
      * @param topic MQTT topic
      * @param payload Message payload
+     * @param sample_ts_ms Sample time from the publisher (0 = use arrival time)
      */
-    void onMqttMessage(const std::string& topic, const std::string& payload);
+    void onMqttMessage(const std::string& topic, const std::string& payload, int64_t sample_ts_ms);
 
     /**
-     * Save device data to PostgreSQL
+     * Discovery config callback (auto-discovery with require_discovery)
      *
-     * @param device_identifier Device identifier
+     * @param topic homeassistant/sensor/{device_id}/{sensor_name}/config
+     */
+    void onDiscoveryConfig(const std::string& topic);
+
+    /**
+     * Save every device to PostgreSQL in one batch (slot locks NOT held during the insert)
+     *
+     * @param bucket Row timestamp (the interval boundary)
      * @return true if saved successfully
      */
-    bool saveDeviceData(const std::string& device_identifier);
+    bool saveAllDevices(std::chrono::system_clock::time_point bucket);
+
+    /**
+     * Close due rollup buckets on every slot and write them (saver thread only)
+     *
+     * @param now Current boundary; retention is enforced on hour boundaries
+     */
+    void flushRollups(std::chrono::system_clock::time_point now);
+
+    /**
+     * Close finished days and upsert them with the days in progress
+     * (saver thread, or stop() once it has exited)
+     *
+     * @param now Current boundary
+     */
+    void flushDailyStats(std::chrono::system_clock::time_point now);
 
     /**
      * Background thread for scheduled saves
@@ -108,9 +278,9 @@ private:
      * Topic format: homeassistant/sensor/{device_id}/{sensor_name}/state
      *
      * @param topic MQTT topic
-     * @return Pair of (device_id, sensor_name)
+     * @return Pair of (device_id, sensor_name), views into `topic`; empty if malformed
      */
-    std::pair<std::string, std::string> parseTopic(const std::string& topic) const;
+    static std::pair<std::string_view, std::string_view> parseTopic(std::string_view topic);
 
     // Dependencies
     std::shared_ptr<MqttClient> mqtt_client_;
@@ -118,19 +288,44 @@ private:
 
     // Configuration
     int save_interval_seconds_;
+    std::unique_ptr<DeviceFilter> device_filter_;  // Auto-discovery (nullptr = configured IDs only)
+    std::shared_ptr<LiveStreamHub> live_stream_;   // Live state deltas (nullptr = disabled)
+    CollectorTierConfig tiers_;
+
+    // Rollup rows not yet written (kept for retry after a DB failure, saver thread only)
+    static constexpr size_t kMaxPendingRollupRows = 100000;
+    static constexpr size_t kMaxPendingDailyRows = 10000;
+    std::vector<RollupRow> pending_minute_rows_;
+    std::vector<RollupRow> pending_hour_rows_;
+    std::vector<DailyStatsRow> pending_daily_rows_;  // Closed days not yet written
+
+    // Today's stats read back at start(), seeded into slots as devices appear (guarded by index_mutex_)
+    std::map<std::string, DailyStats, std::less<>> restored_daily_;
+
+    // Device slots [0, slot_count_) are live; the array never reallocates
+    const size_t max_devices_;
+    std::unique_ptr<DeviceSlot[]> slots_;
+    std::atomic<size_t> slot_count_{0};
+
+    // Interning: MQTT device ID -> slot, DB identifier -> slot (several MQTT
+    // IDs mapped to one DB identifier share a slot)
+    std::map<std::string, size_t, std::less<>> slot_index_;
+    std::map<std::string, size_t, std::less<>> db_slot_index_;
+    mutable std::shared_mutex index_mutex_;
+    std::atomic<bool> slots_full_logged_{false};
 
-    // In-memory data buffer
-    // Key: device_identifier (e.g., "apc_back_ups_xs_1000m")
-    // Value: Accumulated UpsData
-    std::map<std::string, UpsData> device_data_;
-    mutable std::mutex data_mutex_;
+    // MQTT device IDs turned away with the table full, answered under the
+    // shared lock from then on; past the cap every new ID is turned away there
+    static constexpr size_t kMaxRejectedIds = 1024;
+    std::set<std::string, std::less<>> rejected_ids_;  // Guarded by index_mutex_
 
-    // Last save timestamps per device
-    std::map<std::string, std::chrono::system_clock::time_point> last_save_times_;
+    std::atomic<uint64_t> messages_received_{0};
 
     // Thread management
     std::thread saver_thread_;
     std::atomic<bool> running_;
+    std::mutex saver_mutex_;
+    std::condition_variable saver_cv_;  // Wakes the saver early on stop()
 
     // Status tracking
     std::chrono::system_clock::time_point last_save_time_;
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "nut/DailyMetrics.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace hms_nut {
+
+/**
+ * DailyReport - One day's metrics with both renderings done up front
+ */
+struct DailyReport {
+    DailyMetrics metrics;
+    std::string json;  // metrics.toJson(), compact
+    std::string text;  // metrics.toText()
+};
+
+/**
+ * DailyReportService - Builds daily reports and caches finished days
+ *
+ * A past day never changes once it has data, so its report is built once,
+ * kept in memory (newest days win when the cache is full) and written to
+ * <cache_dir>/<date>.json so a restart does not rebuild it. A cached report
+ * is returned as a shared pointer to the pre-rendered bodies - no query and
+ * no formatting per request. Today and days without data are rebuilt on
+ * every call.
+ *
+ * Thread-safe. Two concurrent misses for the same day may both build it.
+ */
+class DailyReportService {
+public:
+    /**
+     * Fills the metrics for a date; false = source unavailable (not cached)
+     */
+    using Builder = std::function<bool(const std::string& date, DailyMetrics& out)>;
+
+    /**
+     * Constructor
+     *
+     * @param builder Metrics source (collector daily stats or ups_metrics)
+     * @param cache_dir Directory for cached days (empty = memory only)
+     * @param max_cached_days Days kept in memory
+     */
+    explicit DailyReportService(Builder builder,
+                                std::string cache_dir = "",
+                                size_t max_cached_days = kDefaultMaxCachedDays);
+
+    static constexpr size_t kDefaultMaxCachedDays = 400;
+
+    DailyReportService(const DailyReportService&) = delete;
+    DailyReportService& operator=(const DailyReportService&) = delete;
+
+    /**
+     * Get the report for a day, relative to the current local date
+     *
+     * @param date Day in YYYY-MM-DD format
+     * @return Report, or nullptr if the builder failed
+     */
+    std::shared_ptr<const DailyReport> get(const std::string& date);
+
+    /**
+     * Get the report for a day
+     *
+     * @param date Day in YYYY-MM-DD format
+     * @param today Current local date; only days before it are cached
+     * @return Report, or nullptr if the builder failed
+     */
+    std::shared_ptr<const DailyReport> get(const std::string& date, const std::string& today);
+
+    /**
+     * Get a report only if it is held in memory (no build, no disk read)
+     *
+     * For callers that must not block: a miss is then resolved with get()
+     * on a worker thread.
+     *
+     * @param date Day in YYYY-MM-DD format
+     * @param today Current local date
+     * @return Cached report, or nullptr
+     */
+    std::shared_ptr<const DailyReport> getCached(const std::string& date, const std::string& today);
+
+    /**
+     * Number of days held in memory
+     */
+    size_t cachedDays() const;
+
+    uint64_t getHits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t getMisses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    /**
+     * Render both bodies of a report
+     */
+    static std::shared_ptr<const DailyReport> render(DailyMetrics metrics);
+
+    /**
+     * Read a cached day from disk
+     *
+     * @return Report, or nullptr if not cached or unreadable
+     */
+    std::shared_ptr<const DailyReport> load(const std::string& date) const;
+
+    /**
+     * Write a day to disk (temp file + rename, so readers never see a partial file)
+     */
+    void store(const DailyReport& report) const;
+
+    /**
+     * Add a day to the memory cache, evicting the oldest day when full
+     */
+    void remember(const std::string& date, std::shared_ptr<const DailyReport> report);
+
+    Builder builder_;
+    std::string cache_dir_;  // Empty = memory only
+    size_t max_cached_days_;
+
+    std::map<std::string, std::shared_ptr<const DailyReport>> cache_;  // Guarded by mutex_
+    mutable std::mutex mutex_;
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace hms_nut
@@ -2,24 +2,42 @@
 
 #include "mqtt/MqttClient.h"
 #include "database/DatabaseService.h"
+#include "services/DailyReportService.h"
+#include "services/SummaryJobQueue.h"
 #include "llm_client.h"
 #include <memory>
 #include <thread>
 #include <atomic>
 #include <string>
 #include <chrono>
+#include <mutex>
+#include <optional>
+#include <functional>
+#include <vector>
 
 namespace hms_nut {
 
 /**
  * DailySummaryService - Daily UPS energy summary via LLM
  *
- * At a configurable hour each morning (default 7 AM), queries PostgreSQL
- * for yesterday's UPS metrics across all devices, sends the data to an
- * LLM for a natural language summary, and publishes the result to MQTT.
+ * At a configurable hour each morning (default 7 AM), gathers yesterday's
+ * UPS metrics across all devices, sends the data to an LLM for a natural
+ * language summary, and publishes the result to MQTT. The metrics are the
+ * text rendering of the day's report (DailyReportService), so the prompt
+ * reuses a cached report; without a report source they come from a
+ * full-day aggregate over ups_metrics.
+ *
+ * On-demand summaries (POST /summary) are queued as jobs and run on a
+ * dedicated worker thread; runs never overlap with each other or with the
+ * daily timer.
  */
 class DailySummaryService {
 public:
+    /**
+     * Returns the report for a date (nullptr = not available)
+     */
+    using ReportSource = std::function<std::shared_ptr<const DailyReport>(const std::string& date)>;
+
     /**
      * Constructor
      *
@@ -58,9 +76,18 @@ public:
     /// Publish HA MQTT discovery config for the summary sensor
     void publishDiscovery();
 
-    /// Manually trigger summary generation for a specific date (YYYY-MM-DD)
+    /// Manually trigger summary generation for a specific date (YYYY-MM-DD), blocking
     bool generateSummary(const std::string& date);
 
+    /// Queue summary generation for a date (joins a queued/running job for the same date)
+    SummaryJobQueue::Submission submitSummary(const std::string& date);
+
+    /// Look up a queued, running or recently finished summary job
+    std::optional<SummaryJob> getSummaryJob(const std::string& id) const;
+
+    /// Read metrics from daily reports instead of aggregating ups_metrics (call before start())
+    void setReportSource(ReportSource source) { report_source_ = std::move(source); }
+
 private:
     /// Background loop that checks the clock and triggers daily summary
     void timerLoop();
@@ -68,10 +95,14 @@ private:
     /// Build the full prompt from template + metrics
     std::string buildPrompt(const std::string& metrics);
 
+    /// Generate, publish and record one summary (serialized by generate_mutex_)
+    bool runSummary(const std::string& date, std::string& summary, std::string& error);
+
     // Dependencies
     std::shared_ptr<MqttClient> mqtt_client_;
     DatabaseService& db_service_;
     std::unique_ptr<hms::LLMClient> llm_client_;
+    ReportSource report_source_;  // Empty = queryDailyMetrics only
 
     // Configuration
     int summary_hour_;
@@ -85,6 +116,10 @@ private:
     mutable std::mutex state_mutex_;
     std::chrono::system_clock::time_point last_summary_time_;
     std::string last_summary_;
+    std::mutex generate_mutex_;  // One DB aggregate + LLM call at a time
+
+    // On-demand summaries (declared last: its worker uses the members above)
+    SummaryJobQueue jobs_;
 };
 
 }  // namespace hms_nut
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "database/DatabaseService.h"
+#include "utils/GzipStream.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * ExportFormat - Bulk export encodings
+ */
+enum class ExportFormat {
+    Csv,    // Header line, RFC 4180 quoting, empty field = NULL
+    Ndjson  // One JSON object per line, NULL columns omitted
+};
+
+/**
+ * Parse "csv" / "ndjson"
+ */
+std::optional<ExportFormat> parseExportFormat(std::string_view name);
+
+/**
+ * ExportEncoder - Formats exported rows, optionally gzipped
+ *
+ * Rows accumulate as text; takeChunk() hands out what is ready
+ * (compressed when gzip is on), so the caller controls the buffer size.
+ */
+class ExportEncoder {
+public:
+    ExportEncoder(ExportFormat format, std::vector<ExportColumn> columns, bool gzip);
+
+    /**
+     * Append one row (values in column order, nullopt = NULL)
+     */
+    void row(const std::vector<std::optional<std::string_view>>& values);
+
+    /**
+     * Append an error line ("# error: ..." / {"error": ...})
+     */
+    void error(std::string_view message);
+
+    /**
+     * Text bytes buffered since the last takeChunk()
+     */
+    size_t buffered() const { return text_.size(); }
+
+    /**
+     * Move the ready output to `out`
+     *
+     * @param last End of the export (writes the gzip trailer)
+     */
+    void takeChunk(std::string& out, bool last = false);
+
+private:
+    ExportFormat format_;
+    std::vector<ExportColumn> columns_;
+    std::unique_ptr<GzipStream> gzip_;  // nullptr = plain
+    std::string text_;
+};
+
+/**
+ * ExportSink - Destination of one export's encoded output
+ */
+class ExportSink {
+public:
+    virtual ~ExportSink() = default;
+
+    /**
+     * Deliver a chunk, waiting while the consumer is behind
+     *
+     * @return false once the consumer is gone or the sink was cancelled
+     */
+    virtual bool write(std::string chunk) = 0;
+
+    /**
+     * Mark the end of the data
+     */
+    virtual void close() = 0;
+
+    /**
+     * Consumer or service is gone - pending and later writes fail
+     */
+    virtual void cancel() = 0;
+};
+
+/**
+ * ExportPipe - Bounded byte pipe from an export thread to the HTTP response
+ *
+ * The producer blocks while max_bytes are waiting, so a slow client slows
+ * the database cursor down instead of growing memory.
+ */
+class ExportPipe : public ExportSink {
+public:
+    explicit ExportPipe(size_t max_bytes);
+
+    /**
+     * Queue a chunk, waiting while the pipe is full
+     *
+     * @return false once the reader has cancelled
+     */
+    bool write(std::string chunk) override;
+
+    /**
+     * Mark the end of the data
+     */
+    void close() override;
+
+    /**
+     * Copy up to `size` bytes, waiting for data
+     *
+     * @return Bytes copied; 0 at the end of the data or after cancel()
+     */
+    size_t read(char* buffer, size_t size);
+
+    /**
+     * Reader is gone - pending and later writes are discarded
+     */
+    void cancel() override;
+
+private:
+    const size_t max_bytes_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> chunks_;
+    size_t offset_ = 0;  // Bytes of chunks_.front() already read
+    size_t bytes_ = 0;   // Unread bytes queued
+    bool closed_ = false;
+    bool cancelled_ = false;
+};
+
+/**
+ * PushExportSink - Hands chunks to a transport that never blocks
+ *
+ * For transports that buffer whatever they are given (e.g. an async HTTP
+ * response stream): write() waits while the transport reports more than
+ * max_unsent bytes not yet sent, so a slow client slows the cursor down
+ * instead of growing the transport's buffer. A client that stays above the
+ * mark for stall_timeout is given up on.
+ */
+class PushExportSink : public ExportSink {
+public:
+    using Send = std::function<bool(const std::string& chunk)>;  // false = client gone
+    using Close = std::function<void()>;
+    using Backlog = std::function<size_t()>;  // Bytes accepted but not yet sent
+
+    PushExportSink(Send send, Close close, Backlog backlog, size_t max_unsent,
+                   std::chrono::milliseconds stall_timeout);
+
+    bool write(std::string chunk) override;
+    void close() override;
+    void cancel() override;
+
+private:
+    Send send_;
+    Close close_;
+    Backlog backlog_;
+    const size_t max_unsent_;
+    const std::chrono::milliseconds stall_timeout_;
+    std::mutex mutex_;
+    std::condition_variable cv_;  // Wakes a paced write() on cancel()
+    bool cancelled_ = false;
+};
+
+/**
+ * ExportRequest - One bulk export
+ */
+struct ExportRequest {
+    std::string device_identifier;
+    std::chrono::system_clock::time_point from;
+    std::chrono::system_clock::time_point to;
+    ExportFormat format = ExportFormat::Csv;
+    bool gzip = false;
+};
+
+/**
+ * ExportConfig - Limits for bulk exports
+ */
+struct ExportConfig {
+    size_t max_concurrent = 2;           // Further exports are refused
+    size_t buffer_bytes = 256 * 1024;    // Per-export pipe size
+    size_t chunk_bytes = 32 * 1024;      // Text encoded before handing a chunk to the pipe
+    size_t batch_rows = 1000;            // Rows per cursor FETCH
+    std::chrono::milliseconds stall_timeout{60000};  // PushExportSink: give up on a client not reading
+};
+
+/**
+ * ExportService - Streams ups_metrics exports on worker threads
+ *
+ * Each export runs the row source (a server-side cursor) on its own thread,
+ * encodes rows as they arrive and writes chunks into an ExportSink: a
+ * bounded ExportPipe that a reader drains, or a sink opened on the worker
+ * that pushes to the client itself. Memory per export is bounded by the
+ * sink's buffer plus one chunk, whatever the time range.
+ */
+class ExportService {
+public:
+    /**
+     * Produces the rows of a request; returns false on failure
+     */
+    using RowSource = std::function<bool(const ExportRequest& request, size_t batch_rows,
+                                         const ExportRowCallback& on_row)>;
+
+    /**
+     * Prepares an export on its worker thread (lookups, response headers);
+     * returns the sink to write to, or nullptr if the request was answered
+     * otherwise and nothing should be produced
+     */
+    using Opener = std::function<std::shared_ptr<ExportSink>(const ExportRequest& request)>;
+
+    /**
+     * @param source Row producer (DatabaseService::streamUpsMetrics in production)
+     * @param columns Column layout of the produced rows
+     * @param config Limits
+     */
+    ExportService(RowSource source, std::vector<ExportColumn> columns, ExportConfig config = {});
+    ~ExportService();
+
+    ExportService(const ExportService&) = delete;
+    ExportService& operator=(const ExportService&) = delete;
+
+    /**
+     * Start an export
+     *
+     * @return Pipe to read the encoded output from, or nullptr if
+     *         max_concurrent exports are running or the service is stopped
+     */
+    std::shared_ptr<ExportPipe> begin(ExportRequest request);
+
+    /**
+     * Start an export that opens its own sink on the worker thread
+     *
+     * @return false if max_concurrent exports are running or the service
+     *         is stopped (the opener is not called)
+     */
+    bool begin(ExportRequest request, Opener open);
+
+    /**
+     * Cancel running exports and wait for their threads
+     */
+    void stop();
+
+    /**
+     * Exports currently running
+     */
+    size_t active() const { return active_.load(std::memory_order_relaxed); }
+
+    const ExportConfig& getConfig() const { return config_; }
+
+private:
+    struct Job {
+        std::shared_ptr<ExportSink> sink;  // Set once opened; guarded by mutex_
+        std::atomic<bool> done{false};
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::shared_ptr<Job> job;
+    };
+
+    void run(const ExportRequest& request, const Opener& open, Job& job);
+
+    /**
+     * Join finished workers (mutex_ held)
+     */
+    void reapWorkers();
+
+    RowSource source_;
+    const std::vector<ExportColumn> columns_;
+    const ExportConfig config_;
+
+    std::mutex mutex_;
+    std::list<Worker> workers_;
+    std::atomic<size_t> active_{0};
+    bool stopped_ = false;
+};
+
+}  // namespace hms_nut
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "database/DatabaseService.h"
+#include "nut/MetricRollup.h"
+#include "utils/Lttb.h"
+#include <json/json.h>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * SeriesRead - One metric series read from the history tiers
+ */
+struct SeriesRead {
+    enum class Status {
+        Ok,
+        UnknownDevice,  // Not seen by the collector / not in ups_devices
+        Unavailable,    // Database not connected
+        Failed          // Query error
+    };
+
+    Status status = Status::Ok;
+    SeriesTier tier = SeriesTier::Stored;
+    size_t source_points = 0;                    // Points read before downsampling
+    std::vector<LttbDownsampler::Point> points;  // Downsampled, time order
+};
+
+/**
+ * GrafanaResult - Outcome of a datasource request
+ */
+enum class GrafanaResult {
+    Ok,
+    BadRequest,   // Malformed body, range or target
+    Unavailable,  // Database not connected
+    Failed        // Storage error
+};
+
+/**
+ * GrafanaDatasource - Grafana JSON (SimpleJSON) datasource protocol
+ *
+ * Targets are "<device>.<metric>" (e.g. "apc_bx.input_voltage"). /query
+ * reads each target through the SeriesReader, which picks the tier
+ * (in-memory ring for recent ranges, rollups for older ones) and
+ * downsamples to the panel's maxDataPoints. /annotations returns
+ * power_events rows. Storage is injected so the protocol handling has no
+ * HTTP or database dependency.
+ */
+class GrafanaDatasource {
+public:
+    using DeviceLister = std::function<std::vector<std::string>()>;
+    using SeriesReader = std::function<SeriesRead(const std::string& device, Metric metric,
+                                                  int64_t from_ms, int64_t to_ms, size_t max_points)>;
+    using EventReader = std::function<bool(const std::string& device, int64_t from_ms, int64_t to_ms,
+                                           std::vector<PowerEventRow>& out)>;
+
+    static constexpr size_t kDefaultPoints = 500;
+    static constexpr size_t kMaxPoints = 10000;
+
+    /**
+     * @param devices Known device IDs (for /search)
+     * @param series Tiered, downsampled series reads (for /query)
+     * @param events Power events in a range, device "" = all (for /annotations)
+     */
+    GrafanaDatasource(DeviceLister devices, SeriesReader series, EventReader events);
+
+    /**
+     * POST /search - metric names matching {"target": "<substring>"}
+     *
+     * @return JSON array of target strings
+     */
+    Json::Value search(const Json::Value& request) const;
+
+    /**
+     * POST /query - time series for each visible target
+     *
+     * @param request {"range": {"from", "to"}, "maxDataPoints", "targets": [{"target", "refId"}]}
+     * @param response [{"target", "datapoints": [[value, ms], ...]}]
+     * @param error Message when the result is not Ok
+     */
+    GrafanaResult query(const Json::Value& request, Json::Value& response, std::string& error) const;
+
+    /**
+     * POST /annotations - power events in the range
+     *
+     * annotation.query optionally names one device.
+     *
+     * @param request {"range": {"from", "to"}, "annotation": {"name", "query", ...}}
+     * @param response [{"annotation", "time", "title", "tags", "text"}]
+     * @param error Message when the result is not Ok
+     */
+    GrafanaResult annotations(const Json::Value& request, Json::Value& response, std::string& error) const;
+
+    /**
+     * Split "<device>.<metric>" at the last dot
+     *
+     * @return Device and metric, or nullopt if the metric is not a history metric
+     */
+    static std::optional<std::pair<std::string, Metric>> parseTarget(std::string_view target);
+
+private:
+    DeviceLister devices_;
+    SeriesReader series_;
+    EventReader events_;
+};
+
+}  // namespace hms_nut
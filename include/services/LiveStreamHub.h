@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace hms_nut {
+
+/**
+ * LiveStreamConfig - Limits for the live state stream
+ */
+struct LiveStreamConfig {
+    size_t max_clients = 64;         // Further subscribers are refused
+    size_t max_queued_frames = 256;  // Undelivered frames kept per client
+    size_t max_unsent_bytes = 1 << 20;  // Written but not yet sent; above this the client is not drained
+    std::chrono::milliseconds stall_timeout{60000};  // Disconnect a client held above max_unsent_bytes this long
+    std::chrono::milliseconds heartbeat{15000};  // Keepalive comment on idle streams
+};
+
+/**
+ * LiveStreamHub - Fans out per-device state deltas to Server-Sent Events clients
+ *
+ * The collector reports every ingested sensor value. A value that differs
+ * from the last one seen for that device/sensor is serialized once into an
+ * SSE frame, and the same immutable frame is queued for every matching
+ * client; a single sender thread hands the queued frames to each client's
+ * sink.
+ *
+ * Backpressure: a sink write only hands the frame to the transport, so each
+ * client may also report how many bytes it has accepted but not yet sent.
+ * While that exceeds max_unsent_bytes the client is not drained and frames
+ * stay in its hub queue, which holds at most max_queued_frames. On overflow
+ * the oldest frames are dropped and the next delivery starts with a "resync"
+ * event carrying the drop count, so the client can refetch the full state.
+ * A client that stays above the mark for stall_timeout is disconnected, as
+ * is one whose sink reports failure (client gone); destroying the sink
+ * closes the stream.
+ *
+ * New clients start with a "snapshot" event of the latest values.
+ */
+class LiveStreamHub {
+public:
+    using Frame = std::shared_ptr<const std::string>;
+
+    /**
+     * Writes one frame to a client; returns false once the client is gone
+     * (called only from the sender thread)
+     */
+    using Sink = std::function<bool(const std::string& frame)>;
+
+    /**
+     * Bytes a client's sink has accepted but not yet sent
+     * (called only from the sender thread)
+     */
+    using Backlog = std::function<size_t()>;
+
+    struct Stats {
+        size_t clients = 0;
+        uint64_t frames_published = 0;  // Distinct frames serialized
+        uint64_t frames_dropped = 0;    // Client queue overflows
+        uint64_t clients_closed = 0;    // Sinks removed after a failed write or a stall
+        uint64_t clients_stalled = 0;   // Of those, disconnected above max_unsent_bytes
+    };
+
+    explicit LiveStreamHub(LiveStreamConfig config = {});
+    ~LiveStreamHub();
+
+    LiveStreamHub(const LiveStreamHub&) = delete;
+    LiveStreamHub& operator=(const LiveStreamHub&) = delete;
+
+    /**
+     * Start the sender thread
+     */
+    void start();
+
+    /**
+     * Stop the sender thread and drop all clients
+     */
+    void stop();
+
+    /**
+     * Subscribe a client
+     *
+     * @param sink Frame writer for this client
+     * @param device_filter Only this device's deltas (empty = all devices)
+     * @param backlog Unsent bytes of this client (empty = writes complete immediately)
+     * @return Client id, or 0 if max_clients is reached or the hub is stopped
+     */
+    uint64_t addClient(Sink sink, std::string device_filter = "", Backlog backlog = nullptr);
+
+    /**
+     * Unsubscribe a client (the sink is destroyed)
+     */
+    void removeClient(uint64_t id);
+
+    /**
+     * Report an ingested sensor value; unchanged values are not broadcast
+     *
+     * @param device MQTT device ID
+     * @param sensor Sensor ID
+     * @param value Raw MQTT payload
+     * @param timestamp_ms Ingest time (ms since epoch)
+     */
+    void publish(std::string_view device, std::string_view sensor,
+                 std::string_view value, int64_t timestamp_ms);
+
+    Stats getStats() const;
+
+private:
+    struct Client {
+        Sink sink;
+        Backlog backlog;
+        std::string device_filter;
+        std::deque<Frame> queue;  // Guarded by mutex_
+        uint64_t dropped = 0;     // Frames dropped since the last delivery
+        std::chrono::steady_clock::time_point held_since{};  // Above max_unsent_bytes (sender thread only)
+    };
+
+    void senderLoop();
+
+    /**
+     * Queue a frame for one client, dropping its oldest on overflow (mutex_ held)
+     */
+    void enqueue(Client& client, const Frame& frame);
+
+    /**
+     * Serialize the latest values as a "snapshot" event (mutex_ held)
+     */
+    std::string buildSnapshot(const std::string& device_filter) const;
+
+    const LiveStreamConfig config_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<uint64_t, std::shared_ptr<Client>> clients_;
+    // device -> sensor -> last payload
+    std::map<std::string, std::map<std::string, std::string, std::less<>>, std::less<>> last_values_;
+    uint64_t next_client_id_ = 1;
+    bool pending_ = false;  // Some client queue is non-empty
+    bool running_ = false;
+    std::thread sender_;
+
+    std::atomic<uint64_t> frames_published_{0};
+    std::atomic<uint64_t> frames_dropped_{0};
+    std::atomic<uint64_t> clients_closed_{0};
+    std::atomic<uint64_t> clients_stalled_{0};
+};
+
+}  // namespace hms_nut
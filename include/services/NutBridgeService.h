@@ -3,6 +3,8 @@
 #include "nut/NutClient.h"
 #include "mqtt/MqttClient.h"
 #include "mqtt/DiscoveryPublisher.h"
+#include "mqtt/DiscoveryScheduler.h"
+#include "nut/UpsData.h"
 #include <memory>
 #include <thread>
 #include <atomic>
@@ -74,9 +76,22 @@ public:
     /**
      * Republish MQTT discovery messages
      *
+     * Configs the broker already holds retained (same content) are skipped
+     *
+     * @param force Publish every config regardless of broker state
      * @return true if republish succeeded
      */
-    bool republishDiscovery();
+    bool republishDiscovery(bool force = false);
+
+    /**
+     * Route Home Assistant restart republishes through a shared scheduler
+     *
+     * Without a scheduler, republish runs synchronously on the MQTT callback thread.
+     *
+     * @param scheduler Fleet-wide discovery scheduler
+     * @param priority Lower values republish first
+     */
+    void setDiscoveryScheduler(std::shared_ptr<DiscoveryScheduler> scheduler, int priority = 0);
 
     /**
      * Setup MQTT subscriptions (call this BEFORE starting Drogon)
@@ -99,13 +114,17 @@ private:
     // Dependencies
     std::shared_ptr<MqttClient> mqtt_client_;
     std::unique_ptr<NutClient> nut_client_;
-    std::unique_ptr<DiscoveryPublisher> discovery_publisher_;
+    std::shared_ptr<DiscoveryPublisher> discovery_publisher_;
+    std::shared_ptr<DiscoveryScheduler> discovery_scheduler_;
 
     // Configuration
     std::string device_id_;
     std::string device_name_;
     int poll_interval_seconds_;
 
+    // Outgoing state messages, reused across polls (only touched by worker thread)
+    std::vector<MqttMessage> mqtt_messages_;
+
     // Thread management
     std::thread worker_thread_;
     std::atomic<bool> running_;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "services/GrafanaDatasource.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace hms_nut {
+
+/**
+ * SeriesCache - Recently read rollup series
+ *
+ * A rollup read only depends on which buckets fall inside the range, so a
+ * range rounded to bucket boundaries (alignRange) names the same result for
+ * every dashboard refresh and panel inside that bucket. Entries expire after
+ * ttl - the newest bucket may still receive a late flush - and the least
+ * recently used entry is evicted when max_entries is reached.
+ *
+ * Thread-safe.
+ */
+class SeriesCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Key {
+        SeriesTier tier = SeriesTier::Minute;
+        std::string device;
+        Metric metric = Metric::InputVoltage;
+        int64_t from_ms = 0;  // Bucket-aligned
+        int64_t to_ms = 0;    // Bucket-aligned
+        size_t max_points = 0;
+
+        bool operator<(const Key& other) const {
+            return std::tie(tier, device, metric, from_ms, to_ms, max_points) <
+                   std::tie(other.tier, other.device, other.metric, other.from_ms, other.to_ms, other.max_points);
+        }
+    };
+
+    explicit SeriesCache(std::chrono::milliseconds ttl = std::chrono::seconds(30), size_t max_entries = 256);
+
+    /**
+     * Range selecting the same rollup buckets as [from_ms, to_ms): both ends
+     * rounded up to the tier's bucket width (unchanged for non-rollup tiers)
+     */
+    static std::pair<int64_t, int64_t> alignRange(SeriesTier tier, int64_t from_ms, int64_t to_ms);
+
+    /**
+     * Cached read, or nullopt if missing or expired
+     */
+    std::optional<SeriesRead> get(const Key& key, Clock::time_point now = Clock::now());
+
+    /**
+     * Remember a successful read
+     */
+    void put(const Key& key, SeriesRead read, Clock::time_point now = Clock::now());
+
+    size_t size() const;
+    uint64_t getHits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t getMisses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        SeriesRead read;
+        Clock::time_point expires;
+        std::list<Key>::iterator lru;  // Position in lru_
+    };
+
+    const std::chrono::milliseconds ttl_;
+    const size_t max_entries_;
+
+    mutable std::mutex mutex_;
+    std::map<Key, Entry> entries_;
+    std::list<Key> lru_;  // Most recently used first
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace hms_nut
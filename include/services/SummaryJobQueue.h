@@ -0,0 +1,113 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace hms_nut {
+
+/**
+ * SummaryJob - One requested summary run
+ */
+struct SummaryJob {
+    enum class State { Queued, Running, Succeeded, Failed };
+
+    std::string id;
+    std::string date;  // YYYY-MM-DD
+    State state = State::Queued;
+    std::string result;  // Summary text when Succeeded
+    std::string error;   // Reason when Failed
+    std::chrono::system_clock::time_point created;
+    std::chrono::system_clock::time_point started;
+    std::chrono::system_clock::time_point finished;
+
+    bool done() const { return state == State::Succeeded || state == State::Failed; }
+
+    static const char* stateName(State state);
+};
+
+/**
+ * SummaryJobQueue - Runs summary requests on a dedicated worker thread
+ *
+ * Callers get a job id immediately and poll for the result, so a summary
+ * (a day-long DB aggregate plus an LLM call that can take minutes) never
+ * runs on the caller's thread. A request for a date that is already queued
+ * or running joins that job instead of starting another. Finished jobs are
+ * kept for lookup up to a fixed count.
+ */
+class SummaryJobQueue {
+public:
+    /**
+     * Work for one job: fills `result` (or `error`) and returns success
+     */
+    using Runner = std::function<bool(const std::string& date, std::string& result, std::string& error)>;
+
+    struct Submission {
+        std::optional<SummaryJob> job;  // nullopt if the queue is full
+        bool deduplicated = false;      // Joined an existing queued/running job
+    };
+
+    /**
+     * @param runner Work function (runs on the worker thread)
+     * @param max_pending Queued jobs accepted before submit() refuses
+     * @param max_finished Finished jobs kept for get()
+     */
+    explicit SummaryJobQueue(Runner runner, size_t max_pending = 16, size_t max_finished = 64);
+    ~SummaryJobQueue();
+
+    SummaryJobQueue(const SummaryJobQueue&) = delete;
+    SummaryJobQueue& operator=(const SummaryJobQueue&) = delete;
+
+    /**
+     * Start the worker thread
+     */
+    void start();
+
+    /**
+     * Stop the worker after the running job; queued jobs are failed as cancelled
+     */
+    void stop();
+
+    /**
+     * Queue a summary for a date, or join the queued/running job for it
+     */
+    Submission submit(const std::string& date);
+
+    /**
+     * Look up a job by id
+     */
+    std::optional<SummaryJob> get(const std::string& id) const;
+
+private:
+    void workerLoop();
+
+    /**
+     * Drop the oldest finished jobs beyond max_finished_ (mutex_ held)
+     */
+    void trimFinished();
+
+    Runner runner_;
+    const size_t max_pending_;
+    const size_t max_finished_;
+    const std::string id_prefix_;  // Per-process, so ids from before a restart don't alias
+    uint64_t next_id_ = 1;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<std::string, SummaryJob> jobs_;
+    std::deque<std::string> pending_;   // Queued job ids, FIFO
+    std::deque<std::string> finished_;  // Finished job ids, oldest first
+    std::map<std::string, std::string> active_by_date_;  // Date -> queued/running job id
+
+    std::thread worker_;
+    bool running_ = false;
+};
+
+}  // namespace hms_nut
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * WireFormat - Response encodings for bulk endpoints
+ */
+enum class WireFormat {
+    Json,
+    Cbor,        // RFC 8949
+    MessagePack
+};
+
+/**
+ * Pick a format from an HTTP Accept header
+ *
+ * Honours q-values; among equal weights the header order wins. An empty
+ * header or wildcard selects JSON.
+ *
+ * @param accept Accept header value
+ * @return Format, or nullopt if nothing acceptable is offered (406)
+ */
+std::optional<WireFormat> negotiateWireFormat(std::string_view accept);
+
+/**
+ * Content-Type for a format
+ */
+const char* wireFormatContentType(WireFormat format);
+
+/**
+ * CompactWriter - Streaming encoder for JSON, CBOR and MessagePack
+ *
+ * Appends directly to a caller-owned buffer, without building a document
+ * tree. Maps and arrays take their entry count up front (both binary
+ * formats use definite lengths); in a map, call key() before each value.
+ * Non-finite numbers are written as null.
+ */
+class CompactWriter {
+public:
+    CompactWriter(WireFormat format, std::string& out);
+
+    WireFormat format() const { return format_; }
+
+    void beginMap(size_t entries);
+    void endMap();
+    void beginArray(size_t entries);
+    void endArray();
+
+    void key(std::string_view name);
+    void string(std::string_view value);
+    void integer(int64_t value);
+    void number(double value);
+    void boolean(bool value);
+    void null();
+
+private:
+    /**
+     * JSON separator before a key or value
+     */
+    void separate();
+
+    /**
+     * CBOR initial byte plus argument
+     */
+    void cborHead(uint8_t major, uint64_t value);
+
+    void appendBigEndian(uint64_t value, int bytes);
+
+    WireFormat format_;
+    std::string& out_;
+    std::vector<bool> first_;  // JSON: no element written yet at each nesting level
+    bool after_key_ = false;   // JSON: next value follows a key
+};
+
+}  // namespace hms_nut
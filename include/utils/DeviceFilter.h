@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * DeviceFilterConfig - Which devices a wildcard subscription admits
+ */
+struct DeviceFilterConfig {
+    std::vector<std::string> always_admit;  // Configured device IDs (UPS_DEVICE_IDS), never filtered
+    std::vector<std::string> allow;         // Glob patterns ('*', '?'); empty = allow all
+    std::vector<std::string> deny;          // Glob patterns, checked before allow
+    bool require_discovery = false;         // Also require a UPS discovery config from the device
+
+    /**
+     * Parse a comma-separated pattern list (whitespace trimmed, empties skipped)
+     */
+    static std::vector<std::string> parsePatterns(const std::string& csv);
+};
+
+/**
+ * DeviceFilter - Admission control for devices seen on a wildcard subscription
+ *
+ * With homeassistant/sensor/+/+/state every sensor on the broker reaches the
+ * collector, so the per-message check has to be cheap: decisions are cached
+ * per device ID and looked up with a string_view under a shared lock, so
+ * rejecting an unrelated sensor costs one map lookup and no allocation.
+ *
+ * Decision order: always_admit -> deny -> allow -> discovery config.
+ *
+ * Thread-safe.
+ */
+class DeviceFilter {
+public:
+    enum class Decision {
+        Admit,
+        Reject,
+        Pending  // Passes the patterns, waiting for a discovery config
+    };
+
+    explicit DeviceFilter(DeviceFilterConfig config);
+
+    /**
+     * Decide whether messages from `device_id` are collected
+     */
+    Decision evaluate(std::string_view device_id);
+
+    /**
+     * Shorthand for evaluate() == Admit (counts rejections)
+     */
+    bool admit(std::string_view device_id);
+
+    /**
+     * Record a discovery config seen for device/sensor
+     *
+     * @return true if this admitted a previously pending device
+     */
+    bool onDiscoveryConfig(std::string_view device_id, std::string_view sensor_id);
+
+    /**
+     * Sensors whose discovery config marks a device as a UPS
+     */
+    static bool isUpsMarkerSensor(std::string_view sensor_id);
+
+    /**
+     * Glob match supporting '*' (any run) and '?' (one character)
+     */
+    static bool globMatch(std::string_view pattern, std::string_view text);
+
+    const DeviceFilterConfig& getConfig() const { return config_; }
+
+    /**
+     * Messages dropped by admit()
+     */
+    uint64_t getRejectedCount() const { return rejected_.load(); }
+
+private:
+    // Unrelated device IDs on a busy broker are bounded in practice; clear
+    // the cache if that assumption breaks rather than grow without limit
+    static constexpr size_t kMaxCachedDecisions = 4096;
+
+    Decision decide(std::string_view device_id) const;
+
+    DeviceFilterConfig config_;
+    mutable std::shared_mutex mutex_;
+    std::map<std::string, Decision, std::less<>> cache_;
+    std::set<std::string, std::less<>> discovered_;
+    std::atomic<uint64_t> rejected_{0};
+};
+
+}  // namespace hms_nut
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace hms_nut {
+
+/**
+ * GzipStream - Incremental gzip compression (zlib deflate)
+ *
+ * Compresses data as it is produced, so a response can be gzipped chunk by
+ * chunk without holding the whole body. Memory use is zlib's fixed window
+ * plus whatever the caller drains from `out`.
+ */
+class GzipStream {
+public:
+    /**
+     * @param level zlib compression level (1 = fastest, 9 = smallest)
+     */
+    explicit GzipStream(int level = 6);
+    ~GzipStream();
+
+    GzipStream(const GzipStream&) = delete;
+    GzipStream& operator=(const GzipStream&) = delete;
+
+    /**
+     * Compress `input`, appending whatever output is ready to `out`
+     */
+    void write(std::string_view input, std::string& out);
+
+    /**
+     * Flush the remaining output and the gzip trailer to `out`
+     */
+    void finish(std::string& out);
+
+private:
+    struct State;
+    std::unique_ptr<State> state_;
+    bool finished_ = false;
+};
+
+}  // namespace hms_nut
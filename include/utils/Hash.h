@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace hms_nut {
+
+/**
+ * 64-bit FNV-1a hash
+ *
+ * Cheap content fingerprint for payload deduplication (not cryptographic)
+ */
+inline uint64_t fnv1a64(std::string_view data) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+}  // namespace hms_nut
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * LttbDownsampler - Largest-Triangle-Three-Buckets downsampling in one pass
+ *
+ * Reduces a time series to at most `threshold` points while keeping its
+ * visual shape (peaks and dips survive, flat stretches collapse). Points
+ * must arrive in timestamp order.
+ *
+ * [from_ms, to_ms) is cut into threshold - 2 equal time buckets. The first
+ * and last points are always kept; each non-empty bucket contributes the
+ * point forming the largest triangle with the previously kept point and the
+ * average of the next non-empty bucket. Only two buckets are held at a
+ * time, so memory does not grow with the input. Series of at most
+ * `threshold` points are passed through unchanged.
+ */
+class LttbDownsampler {
+public:
+    struct Point {
+        int64_t timestamp_ms;
+        double value;
+    };
+
+    /**
+     * @param from_ms Range start (bucket layout)
+     * @param to_ms Range end (bucket layout)
+     * @param threshold Max output points (at least 3)
+     */
+    LttbDownsampler(int64_t from_ms, int64_t to_ms, size_t threshold);
+
+    /**
+     * Feed the next point
+     */
+    void add(int64_t timestamp_ms, double value);
+
+    /**
+     * Flush the last buckets and return the kept points
+     */
+    std::vector<Point> finish();
+
+    /**
+     * Points fed so far
+     */
+    size_t inputCount() const { return input_count_; }
+
+private:
+    void stream(const Point& point);
+    void place(const Point& point);
+    size_t bucketIndex(int64_t timestamp_ms) const;
+    static Point average(const std::vector<Point>& bucket);
+
+    /**
+     * Keep the point of `bucket` with the largest triangle (last kept, point, next)
+     */
+    void select(const std::vector<Point>& bucket, const Point& next);
+
+    const int64_t from_ms_;
+    const size_t threshold_;
+    const double bucket_width_;
+    size_t input_count_ = 0;
+
+    std::vector<Point> out_;
+    std::vector<Point> pending_;  // Until more than threshold_ points arrive
+    bool streaming_ = false;
+
+    bool have_held_ = false;
+    Point held_{};                // Newest point - the series' last point at finish()
+    std::vector<Point> current_;  // Bucket being decided
+    size_t current_index_ = 0;
+    std::vector<Point> next_;     // Following non-empty bucket
+    size_t next_index_ = 0;
+};
+
+}  // namespace hms_nut
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * Counter - Monotonic event count (lock-free, one relaxed atomic add)
+ */
+class Counter {
+public:
+    void inc(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * Gauge - Value that goes up and down (lock-free)
+ */
+class Gauge {
+public:
+    void set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * Histogram - Fixed-bucket latency distribution (lock-free)
+ *
+ * Bounds are set once at registration and kept in nanoseconds, so observe()
+ * is a short integer scan plus two relaxed atomic adds. Buckets are stored
+ * per-interval and made cumulative when rendered.
+ */
+class Histogram {
+public:
+    /**
+     * @param bounds_seconds Bucket upper bounds in seconds, ascending (+Inf is implicit)
+     */
+    explicit Histogram(const std::vector<double>& bounds_seconds);
+
+    void observe(std::chrono::nanoseconds duration);
+
+    struct Snapshot {
+        std::vector<uint64_t> cumulative;  // One per bound, then +Inf
+        uint64_t count = 0;
+        double sum_seconds = 0.0;
+    };
+
+    Snapshot snapshot() const;
+    const std::vector<double>& bounds() const { return bounds_seconds_; }
+
+    /**
+     * Default bounds for in-process latencies: 100 µs .. 10 s
+     */
+    static const std::vector<double>& latencyBounds();
+
+private:
+    std::vector<double> bounds_seconds_;
+    std::vector<int64_t> bounds_ns_;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;  // bounds + 1 (+Inf)
+    std::atomic<uint64_t> sum_ns_{0};
+};
+
+/**
+ * ScopedTimer - Observes the lifetime of the scope into a histogram
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { histogram_.observe(std::chrono::steady_clock::now() - start_); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * MetricsRegistry - Process-wide metrics rendered in the Prometheus text format
+ *
+ * Registration takes a lock and returns a reference that stays valid for the
+ * life of the process; hot paths keep the reference and only touch atomics.
+ * Registering the same name and labels again returns the existing metric.
+ *
+ * Values already tracked elsewhere (queue stats, device counts) are exported
+ * through callbacks sampled at scrape time instead of being mirrored.
+ */
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    /**
+     * @param name Metric name (counters should end in _total)
+     * @param help One-line description
+     * @param labels Label set without braces, e.g. `tier="1m"` (empty = none)
+     */
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    Histogram& histogram(const std::string& name, const std::string& help,
+                         const std::vector<double>& bounds_seconds = Histogram::latencyBounds(),
+                         const std::string& labels = "");
+
+    /**
+     * Export a value computed at scrape time (replaces an earlier callback for the same series)
+     */
+    void counterCallback(const std::string& name, const std::string& help,
+                         std::function<double()> read, const std::string& labels = "");
+    void gaugeCallback(const std::string& name, const std::string& help,
+                       std::function<double()> read, const std::string& labels = "");
+
+    /**
+     * Render every metric (text exposition format 0.0.4)
+     */
+    std::string render() const;
+
+    static constexpr const char* kContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+private:
+    MetricsRegistry() = default;
+
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Series {
+        std::string labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+        std::function<double()> read;
+    };
+
+    struct Family {
+        Type type;
+        std::string help;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    /**
+     * Find or create a series (throws std::logic_error if the name has another type)
+     */
+    Series& series(const std::string& name, const std::string& help, Type type, const std::string& labels);
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Family> families_;  // Sorted for stable output
+};
+
+}  // namespace hms_nut
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+namespace hms_nut {
+
+/**
+ * ParseError - Reason a numeric value could not be parsed
+ */
+enum class ParseError {
+    None,        // Parsed successfully
+    Empty,       // Empty or whitespace-only input
+    Invalid,     // No leading number (e.g., "unavailable", "nan" from ESP32)
+    OutOfRange   // Number does not fit the target type
+};
+
+/**
+ * ParseResult - Value plus explicit error (no exceptions)
+ */
+template <typename T>
+struct ParseResult {
+    T value{};
+    ParseError error = ParseError::None;
+
+    bool ok() const { return error == ParseError::None; }
+    explicit operator bool() const { return ok(); }
+
+    std::optional<T> toOptional() const {
+        return ok() ? std::optional<T>(value) : std::nullopt;
+    }
+};
+
+/**
+ * NumberParser - Exception-free, locale-independent numeric parsing
+ *
+ * Built on std::from_chars. Shared by UpsData::fromNutVariables (NUT values)
+ * and UpsData::updateFieldFromMqtt (MQTT payloads), so invalid payloads such
+ * as "unavailable" or "" are rejected without throwing.
+ *
+ * Accepts the same shapes std::stod/std::stoi did: leading whitespace, an
+ * optional '+' sign, and trailing characters after the number ("13.7 V").
+ */
+class NumberParser {
+public:
+    /**
+     * Parse a floating point value
+     *
+     * @param str Input text
+     * @return Parsed value or error
+     */
+    static ParseResult<double> parseDouble(std::string_view str);
+
+    /**
+     * Parse an integer value
+     *
+     * Fractional input is truncated at the decimal point ("2400.0" -> 2400)
+     *
+     * @param str Input text
+     * @return Parsed value or error
+     */
+    static ParseResult<int> parseInt(std::string_view str);
+
+    /**
+     * Human-readable error name (for logging)
+     */
+    static const char* errorName(ParseError error);
+};
+
+}  // namespace hms_nut
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <json/json.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * ComponentStatus - One component's entry in the status snapshot
+ */
+struct ComponentStatus {
+    std::string state;     // Shown under "components" (empty = not listed)
+    bool healthy = true;   // Counts towards the overall status
+    Json::Value details;   // Object whose keys are merged into the /health response
+};
+
+/**
+ * StatusSnapshot - Immutable status of every component at one point in time
+ */
+struct StatusSnapshot {
+    std::vector<std::pair<std::string, ComponentStatus>> components;  // Registration order
+    bool healthy = true;
+    std::chrono::system_clock::time_point taken;
+    std::chrono::steady_clock::time_point taken_steady;
+};
+
+/**
+ * StatusBoard - Cached service status for /health
+ *
+ * Each component registers a sampler that reads its own status (taking
+ * whatever locks it needs). A background thread runs all samplers every
+ * interval and swaps in a new immutable snapshot; readers only load the
+ * shared_ptr, so an HTTP handler never waits on a service's locks. A sampler
+ * that hangs shows up as a snapshot that stops getting younger.
+ */
+class StatusBoard {
+public:
+    using Sampler = std::function<ComponentStatus()>;
+
+    StatusBoard() = default;
+    ~StatusBoard();
+
+    StatusBoard(const StatusBoard&) = delete;
+    StatusBoard& operator=(const StatusBoard&) = delete;
+
+    /**
+     * Register a component (call before start())
+     *
+     * @param name Component name (key under "components")
+     * @param sampler Reads the component's status; exceptions mark it unhealthy
+     */
+    void addComponent(const std::string& name, Sampler sampler);
+
+    /**
+     * Take the first snapshot synchronously, then refresh every interval
+     */
+    void start(std::chrono::milliseconds interval);
+
+    /**
+     * Stop the refresh thread
+     */
+    void stop();
+
+    /**
+     * Run every sampler and publish a new snapshot
+     */
+    void refresh();
+
+    /**
+     * Latest snapshot (lock-free; nullptr before the first refresh)
+     */
+    std::shared_ptr<const StatusSnapshot> snapshot() const { return std::atomic_load(&snapshot_); }
+
+    /**
+     * Refresh interval (zero before start())
+     */
+    std::chrono::milliseconds getInterval() const { return interval_; }
+
+private:
+    void refreshLoop();
+
+    std::vector<std::pair<std::string, Sampler>> samplers_;
+    std::shared_ptr<const StatusSnapshot> snapshot_;
+    std::chrono::milliseconds interval_{0};
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;  // Wakes the refresh thread on stop()
+};
+
+}  // namespace hms_nut
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hms_nut {
+
+/**
+ * TaskQueue - Fixed worker threads running queued tasks in FIFO order
+ *
+ * Keeps blocking work (database reads, report builds) off the HTTP event
+ * loops: a handler submits a task that replies through its callback when
+ * done. submit() never blocks; beyond max_pending queued tasks it refuses,
+ * so a burst is answered with 503s instead of growing an unbounded backlog.
+ */
+class TaskQueue {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @param name Used in log lines
+     * @param workers Worker threads (at least 1)
+     * @param max_pending Tasks waiting for a worker before submit() refuses
+     */
+    TaskQueue(std::string name, size_t workers = 2, size_t max_pending = 64);
+    ~TaskQueue();
+
+    TaskQueue(const TaskQueue&) = delete;
+    TaskQueue& operator=(const TaskQueue&) = delete;
+
+    /**
+     * Start the worker threads
+     */
+    void start();
+
+    /**
+     * Finish the running tasks and stop; queued tasks are discarded
+     */
+    void stop();
+
+    /**
+     * Queue a task
+     *
+     * @return false if max_pending tasks are waiting or the queue is stopped
+     */
+    bool submit(Task task);
+
+    /**
+     * Tasks waiting for a worker
+     */
+    size_t pending() const;
+
+private:
+    void workerLoop();
+
+    const std::string name_;
+    const size_t workers_count_;
+    const size_t max_pending_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Task> tasks_;
+    std::vector<std::thread> workers_;
+    bool running_ = false;
+};
+
+}  // namespace hms_nut
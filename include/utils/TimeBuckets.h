@@ -0,0 +1,109 @@
+#pragma once
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace hms_nut {
+
+/**
+ * Wall-clock bucket alignment (UTC, relative to the Unix epoch)
+ *
+ * An interval of 3600 s gives HH:00:00 boundaries, 60 s gives HH:MM:00.
+ * Intervals <= 0 are treated as 1 s.
+ */
+inline std::chrono::system_clock::time_point alignDown(std::chrono::system_clock::time_point t,
+                                                       int64_t interval_seconds) {
+    using namespace std::chrono;
+    int64_t step = interval_seconds > 0 ? interval_seconds : 1;
+    int64_t secs = duration_cast<seconds>(t.time_since_epoch()).count();
+    int64_t rem = secs % step;
+    if (rem < 0) {
+        rem += step;  // Pre-epoch times round toward -inf
+    }
+    return system_clock::time_point(seconds(secs - rem));
+}
+
+/**
+ * First bucket boundary strictly after `t`
+ */
+inline std::chrono::system_clock::time_point nextBoundary(std::chrono::system_clock::time_point t,
+                                                          int64_t interval_seconds) {
+    return alignDown(t, interval_seconds) +
+           std::chrono::seconds(interval_seconds > 0 ? interval_seconds : 1);
+}
+
+/**
+ * Parse a UTC timestamp from a query parameter
+ *
+ * Accepts milliseconds since the epoch ("1773482400000"), a date
+ * ("2026-03-14", midnight UTC) or a date and time ("2026-03-14T10:30:00",
+ * optional fraction as sent by Grafana, ".866", and optional trailing "Z").
+ *
+ * @return Time point, or nullopt if the text matches none of the forms
+ */
+inline std::optional<std::chrono::system_clock::time_point> parseUtcTimestamp(std::string_view text) {
+    using namespace std::chrono;
+    auto number = [&text](size_t pos, size_t len, int& out) {
+        if (pos + len > text.size()) {
+            return false;
+        }
+        auto [ptr, ec] = std::from_chars(text.data() + pos, text.data() + pos + len, out);
+        return ec == std::errc() && ptr == text.data() + pos + len;
+    };
+
+    if (text.empty()) {
+        return std::nullopt;
+    }
+    int64_t ms = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), ms);
+    if (ec == std::errc() && end == text.data() + text.size()) {
+        return system_clock::time_point(milliseconds(ms));
+    }
+
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0, millis = 0;
+    if (text.size() < 10 || !number(0, 4, year) || text[4] != '-' || !number(5, 2, month) ||
+        text[7] != '-' || !number(8, 2, day)) {
+        return std::nullopt;
+    }
+    if (text.size() > 10) {
+        std::string_view rest = text.substr(10);
+        if (rest.back() == 'Z') {
+            rest.remove_suffix(1);
+        }
+        if (rest.size() > 9 && rest[9] == '.') {
+            // Fraction: keep milliseconds, ignore finer digits
+            std::string_view fraction = rest.substr(10);
+            if (fraction.empty() || fraction.size() > 9 ||
+                fraction.find_first_not_of("0123456789") != std::string_view::npos) {
+                return std::nullopt;
+            }
+            for (size_t i = 0; i < 3; ++i) {
+                millis = millis * 10 + (i < fraction.size() ? fraction[i] - '0' : 0);
+            }
+            rest = rest.substr(0, 9);
+        }
+        if (rest.size() != 9 || rest[0] != 'T' || rest[3] != ':' || rest[6] != ':' ||
+            !number(11, 2, hour) || !number(14, 2, minute) || !number(17, 2, second)) {
+            return std::nullopt;
+        }
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return std::nullopt;
+    }
+
+    // Days since the epoch for a proleptic Gregorian date (H. Hinnant's days_from_civil)
+    int y = year - (month <= 2 ? 1 : 0);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = static_cast<int64_t>(era) * 146097 + doe - 719468;
+
+    return system_clock::time_point(seconds(days * 86400 + hour * 3600 + minute * 60 + second) +
+                                    milliseconds(millis));
+}
+
+}  // namespace hms_nut
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+
+namespace hms_nut {
+
+/**
+ * TokenBucket - Classic token bucket rate limiter (not thread-safe)
+ *
+ * Tokens refill continuously at `rate` per second up to `capacity` (burst).
+ * Time is passed in explicitly so callers (and tests) control the clock.
+ */
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Constructor
+     *
+     * @param rate Tokens added per second (must be > 0)
+     * @param capacity Maximum tokens (burst size, >= 1)
+     * @param now Start time (bucket starts full)
+     */
+    TokenBucket(double rate, double capacity, Clock::time_point now = Clock::now());
+
+    /**
+     * Take one token if available
+     *
+     * @param now Current time
+     * @return true if a token was taken
+     */
+    bool tryAcquire(Clock::time_point now);
+
+    /**
+     * Time until the next token is available (zero if one is available now)
+     */
+    Clock::duration timeUntilAvailable(Clock::time_point now);
+
+    /**
+     * Change the refill rate (tokens already accrued are kept)
+     */
+    void setRate(double rate, Clock::time_point now);
+
+    double getRate() const { return rate_; }
+
+private:
+    void refill(Clock::time_point now);
+
+    double rate_;
+    double capacity_;
+    double tokens_;
+    Clock::time_point last_refill_;
+};
+
+}  // namespace hms_nut
@@ -1,12 +1,40 @@
 #include "database/DatabaseService.h"
+#include "utils/Metrics.h"
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <tuple>
 
 namespace hms_nut {
 
+namespace {
+    // UTC "YYYY-MM-DD HH:MM:SS" for PostgreSQL
+    std::string formatTimestamp(std::chrono::system_clock::time_point tp) {
+        auto time_t_val = std::chrono::system_clock::to_time_t(tp);
+        std::ostringstream oss;
+        oss << std::put_time(std::gmtime(&time_t_val), "%Y-%m-%d %H:%M:%S");
+        return oss.str();
+    }
+
+    struct DbMetrics {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        Histogram& operation = registry.histogram(
+            "hms_nut_db_operation_seconds", "Time per database operation attempt");
+        Counter& retries = registry.counter(
+            "hms_nut_db_retries_total", "Database operation attempts after the first");
+        Counter& failures = registry.counter(
+            "hms_nut_db_failures_total", "Database operations that failed every attempt");
+    };
+
+    DbMetrics& metrics() {
+        static DbMetrics m;
+        return m;
+    }
+}
+
 DatabaseService& DatabaseService::getInstance() {
     static DatabaseService instance;
     return instance;
@@ -25,6 +53,7 @@ void DatabaseService::initialize(const std::string& connection_string) {
 
     try {
         conn_ = std::make_unique<pqxx::connection>(connection_string);
+        connected_ = conn_->is_open();
 
         if (conn_->is_open()) {
             std::cout << "✅ DB: Connected to " << conn_->dbname() << std::endl;
@@ -38,14 +67,10 @@ void DatabaseService::initialize(const std::string& connection_string) {
     } catch (const std::exception& e) {
         std::cerr << "❌ DB: Connection error: " << e.what() << std::endl;
         conn_ = nullptr;
+        connected_ = false;
     }
 }
 
-bool DatabaseService::isConnected() const {
-    std::lock_guard<std::mutex> lock(connection_mutex_);
-    return conn_ && conn_->is_open();
-}
-
 bool DatabaseService::reconnect() {
     std::lock_guard<std::mutex> lock(connection_mutex_);
 
@@ -53,12 +78,14 @@ bool DatabaseService::reconnect() {
 
     try {
         // Close existing connection
+        connected_ = false;
         if (conn_) {
             conn_.reset();
         }
 
         // Create new connection
         conn_ = std::make_unique<pqxx::connection>(connection_string_);
+        connected_ = conn_->is_open();
 
         if (conn_->is_open()) {
             std::cout << "✅ DB: Reconnected successfully" << std::endl;
@@ -71,13 +98,19 @@ bool DatabaseService::reconnect() {
     } catch (const std::exception& e) {
         std::cerr << "❌ DB: Reconnection error: " << e.what() << std::endl;
         conn_ = nullptr;
+        connected_ = false;
         return false;
     }
 }
 
 void DatabaseService::close() {
+    {
+        std::lock_guard<std::mutex> lock(read_pool_mutex_);
+        idle_read_connections_.clear();
+    }
     std::lock_guard<std::mutex> lock(connection_mutex_);
 
+    connected_ = false;
     if (conn_) {
         try {
             std::cout << "💾 DB: Closing connection..." << std::endl;
@@ -89,7 +122,11 @@ void DatabaseService::close() {
 }
 
 bool DatabaseService::executeWithRetry(std::function<bool()> operation, int max_retries) {
+    DbMetrics& m = metrics();
     for (int attempt = 0; attempt < max_retries; ++attempt) {
+        if (attempt > 0) {
+            m.retries.inc();
+        }
         try {
             if (!isConnected()) {
                 if (!reconnect()) {
@@ -99,11 +136,13 @@ bool DatabaseService::executeWithRetry(std::function<bool()> operation, int max_
             }
 
             // Execute operation
+            ScopedTimer timer(m.operation);
             if (operation()) {
                 return true;
             }
 
         } catch (const pqxx::broken_connection& e) {
+            connected_ = false;
             std::cerr << "❌ DB: Connection broken: " << e.what() << std::endl;
             reconnect();
 
@@ -117,6 +156,7 @@ bool DatabaseService::executeWithRetry(std::function<bool()> operation, int max_
         }
     }
 
+    m.failures.inc();
     std::cerr << "❌ DB: Operation failed after " << max_retries << " attempts" << std::endl;
     return false;
 }
@@ -195,20 +235,32 @@ std::optional<int> DatabaseService::getDeviceId(const std::string& device_identi
 }
 
 bool DatabaseService::insertUpsMetrics(const UpsData& data, const std::string& device_identifier) {
-    // Get device_id
-    auto device_id_opt = getDeviceId(device_identifier);
-    if (!device_id_opt) {
-        std::cerr << "❌ DB: Device not found: " << device_identifier << std::endl;
-        return false;
-    }
+    return insertUpsMetricsBatch({UpsMetricsRow{device_identifier, data}});
+}
 
-    int device_id = *device_id_opt;
+bool DatabaseService::insertUpsMetricsBatch(const std::vector<UpsMetricsRow>& rows) {
+    // Resolve device IDs and timestamps before taking the connection
+    struct ResolvedRow {
+        int device_id;
+        std::string timestamp;
+        const UpsMetricsRow* row;
+    };
+    std::vector<ResolvedRow> resolved;
+    resolved.reserve(rows.size());
+
+    for (const auto& row : rows) {
+        auto device_id_opt = getDeviceId(row.device_identifier);
+        if (!device_id_opt) {
+            std::cerr << "❌ DB: Device not found: " << row.device_identifier << std::endl;
+            continue;
+        }
 
-    // Format timestamp for PostgreSQL
-    auto time_t_val = std::chrono::system_clock::to_time_t(data.timestamp);
-    std::ostringstream oss;
-    oss << std::put_time(std::gmtime(&time_t_val), "%Y-%m-%d %H:%M:%S");
-    std::string timestamp_str = oss.str();
+        resolved.push_back({*device_id_opt, formatTimestamp(row.data.timestamp), &row});
+    }
+
+    if (resolved.empty()) {
+        return rows.empty();
+    }
 
     return executeWithRetry([&]() -> bool {
         std::lock_guard<std::mutex> lock(connection_mutex_);
@@ -226,9 +278,7 @@ bool DatabaseService::insertUpsMetrics(const UpsData& data, const std::string& d
                   << "load_percentage, load_watts, ups_status, power_failure, "
                   << "last_transfer_reason, self_test_result, driver_state, "
                   << "beeper_status, temperature, output_voltage, output_nominal_voltage) "
-                  << "VALUES ("
-                  << device_id << ", "
-                  << txn.quote(timestamp_str) << ", ";
+                  << "VALUES ";
 
             // Helper to add optional values
             auto addOptional = [&](const auto& opt) {
@@ -240,51 +290,51 @@ bool DatabaseService::insertUpsMetrics(const UpsData& data, const std::string& d
                 query << ", ";
             };
 
-            auto addOptionalString = [&](const auto& opt) {
-                if (opt) {
-                    query << txn.quote(*opt);
+            for (size_t i = 0; i < resolved.size(); ++i) {
+                const UpsData& data = resolved[i].row->data;
+
+                query << (i == 0 ? "(" : ", (")
+                      << resolved[i].device_id << ", "
+                      << txn.quote(resolved[i].timestamp) << ", ";
+
+                // Battery metrics
+                addOptional(data.battery_charge);
+                addOptional(data.battery_voltage);
+                addOptional(data.battery_runtime);
+                addOptional(data.battery_low_threshold);
+                addOptional(data.battery_warning_threshold);
+
+                // Input metrics
+                addOptional(data.input_voltage);
+                addOptional(data.input_nominal_voltage);
+                addOptional(data.high_voltage_transfer);
+                addOptional(data.low_voltage_transfer);
+                addOptional(data.input_sensitivity);
+
+                // Load & status
+                addOptional(data.load_percentage);
+                addOptional(data.load_watts);
+                addOptional(data.ups_status);
+                addOptional(data.power_failure);
+
+                // Other metrics
+                addOptional(data.last_transfer_reason);
+                addOptional(data.self_test_result);
+                addOptional(data.driver_state);
+                addOptional(data.beeper_status);
+                addOptional(data.temperature);
+                addOptional(data.output_voltage);
+
+                // Last field (no trailing comma)
+                if (data.output_nominal_voltage) {
+                    query << txn.quote(*data.output_nominal_voltage);
                 } else {
                     query << "NULL";
                 }
-                query << ", ";
-            };
-
-            // Battery metrics
-            addOptional(data.battery_charge);
-            addOptional(data.battery_voltage);
-            addOptional(data.battery_runtime);
-            addOptional(data.battery_low_threshold);
-            addOptional(data.battery_warning_threshold);
-
-            // Input metrics
-            addOptional(data.input_voltage);
-            addOptional(data.input_nominal_voltage);
-            addOptional(data.high_voltage_transfer);
-            addOptional(data.low_voltage_transfer);
-            addOptionalString(data.input_sensitivity);
-
-            // Load & status
-            addOptional(data.load_percentage);
-            addOptional(data.load_watts);
-            addOptionalString(data.ups_status);
-            addOptional(data.power_failure);
-
-            // Other metrics
-            addOptionalString(data.last_transfer_reason);
-            addOptionalString(data.self_test_result);
-            addOptionalString(data.driver_state);
-            addOptionalString(data.beeper_status);
-            addOptional(data.temperature);
-            addOptional(data.output_voltage);
-
-            // Last field (no trailing comma)
-            if (data.output_nominal_voltage) {
-                query << txn.quote(*data.output_nominal_voltage);
-            } else {
-                query << "NULL";
+                query << ")";
             }
 
-            query << ") ON CONFLICT (device_id, timestamp) DO UPDATE SET "
+            query << " ON CONFLICT (device_id, timestamp) DO UPDATE SET "
                   << "battery_charge = EXCLUDED.battery_charge, "
                   << "battery_voltage = EXCLUDED.battery_voltage, "
                   << "battery_runtime = EXCLUDED.battery_runtime, "
@@ -297,167 +347,606 @@ bool DatabaseService::insertUpsMetrics(const UpsData& data, const std::string& d
             txn.exec(query.str());
             txn.commit();
 
-            std::cout << "💾 DB: Inserted metrics for " << device_identifier
-                      << " at " << timestamp_str << std::endl;
+            if (resolved.size() == 1) {
+                std::cout << "💾 DB: Inserted metrics for " << resolved[0].row->device_identifier
+                          << " at " << resolved[0].timestamp << std::endl;
+            } else {
+                std::cout << "💾 DB: Inserted metrics for " << resolved.size()
+                          << " devices in one batch" << std::endl;
+            }
 
             return true;
 
         } catch (const std::exception& e) {
-            std::cerr << "❌ DB: insertUpsMetrics error: " << e.what() << std::endl;
+            std::cerr << "❌ DB: insertUpsMetricsBatch error: " << e.what() << std::endl;
+            return false;
+        }
+    });
+}
+
+bool DatabaseService::queryDailyReport(const std::string& date, DailyMetrics& out) {
+    out = DailyMetrics{};
+    out.date = date;
+    out.source = "ups_metrics";
+
+    return executeWithRetry([&]() -> bool {
+        std::lock_guard<std::mutex> lock(connection_mutex_);
+
+        try {
+            pqxx::read_transaction txn(*conn_);
+
+            // Five aggregates per metric column, in Metric order
+            std::ostringstream query;
+            query << "SELECT d.device_name, d.device_identifier, d.location, "
+                  << "COUNT(*), "
+                  << "(EXTRACT(EPOCH FROM MIN(m.timestamp)) * 1000)::bigint, "
+                  << "(EXTRACT(EPOCH FROM MAX(m.timestamp)) * 1000)::bigint, "
+                  << "COUNT(m.ups_status), "
+                  << "COUNT(*) FILTER (WHERE m.power_failure = true), "
+                  << "COALESCE(JSON_AGG(DISTINCT m.ups_status) "
+                  << "FILTER (WHERE m.ups_status <> ''), '[]')::text, "
+                  << "COALESCE(JSON_AGG(DISTINCT m.last_transfer_reason) "
+                  << "FILTER (WHERE m.last_transfer_reason <> ''), '[]')::text";
+            for (size_t i = 0; i < kMetricCount; ++i) {
+                std::string column = "m." + txn.quote_name(metricName(static_cast<Metric>(i)));
+                query << ", COUNT(" << column << ")"
+                      << ", MIN(" << column << ")::float8"
+                      << ", MAX(" << column << ")::float8"
+                      << ", AVG(" << column << ")::float8"
+                      << ", STDDEV_SAMP(" << column << ")::float8";
+            }
+            query << " FROM ups_metrics m "
+                  << "JOIN ups_devices d ON m.device_id = d.device_id "
+                  << "WHERE m.timestamp::date = " << txn.quote(date) << " "
+                  << "GROUP BY d.device_id, d.device_name, d.device_identifier, d.location "
+                  << "ORDER BY d.device_id";
+
+            pqxx::result res = txn.exec(query.str());
+
+            Json::CharReaderBuilder builder;
+            std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+            auto readStrings = [&](const pqxx::field& field) {
+                std::vector<std::string> values;
+                std::string_view text = field.view();
+                Json::Value json;
+                std::string errors;
+                if (reader->parse(text.data(), text.data() + text.size(), &json, &errors)) {
+                    for (const auto& value : json) {
+                        values.push_back(value.asString());
+                    }
+                }
+                return values;
+            };
+
+            constexpr int kFirstMetricColumn = 10;
+            out.devices.clear();  // A retry starts over
+            out.power_events.clear();
+            for (const auto& row : res) {
+                DeviceDailyMetrics device;
+                device.device_name = row[0].as<std::string>("");
+                device.device_identifier = row[1].as<std::string>();
+                device.location = row[2].as<std::string>("");
+                device.readings = row[3].as<uint64_t>();
+                device.first_ts_ms = row[4].as<int64_t>();
+                device.last_ts_ms = row[5].as<int64_t>();
+                device.status_readings = row[6].as<uint64_t>();
+                device.on_battery_readings = row[7].as<uint64_t>();
+                device.statuses = readStrings(row[8]);
+                device.transfer_reasons = readStrings(row[9]);
+
+                for (size_t i = 0; i < kMetricCount; ++i) {
+                    int column = kFirstMetricColumn + static_cast<int>(i) * 5;
+                    uint64_t count = row[column].as<uint64_t>();
+                    if (count == 0) {
+                        continue;
+                    }
+                    MetricSummary summary;
+                    summary.count = count;
+                    summary.min = row[column + 1].as<double>();
+                    summary.max = row[column + 2].as<double>();
+                    summary.avg = row[column + 3].as<double>();
+                    if (!row[column + 4].is_null()) {
+                        summary.stddev = row[column + 4].as<double>();
+                    }
+                    device.metrics[i] = summary;
+                }
+                out.devices.push_back(std::move(device));
+            }
+
+            if (!out.devices.empty()) {
+                std::string events_query =
+                    "SELECT d.device_identifier, pe.event_type, "
+                    "(EXTRACT(EPOCH FROM pe.event_timestamp) * 1000)::bigint, "
+                    "pe.battery_level_start::float8, pe.battery_level_end::float8, pe.load_at_event::float8 "
+                    "FROM power_events pe "
+                    "JOIN ups_devices d ON pe.device_id = d.device_id "
+                    "WHERE pe.event_timestamp::date = " + txn.quote(date) + " "
+                    "ORDER BY pe.event_timestamp";
+
+                auto optionalDouble = [](const pqxx::field& field) {
+                    return field.is_null() ? std::nullopt : std::optional<double>(field.as<double>());
+                };
+                for (const auto& ev : txn.exec(events_query)) {
+                    PowerEventRow event;
+                    event.device_identifier = ev[0].as<std::string>();
+                    event.event_type = ev[1].as<std::string>();
+                    event.timestamp_ms = ev[2].as<int64_t>();
+                    event.battery_level_start = optionalDouble(ev[3]);
+                    event.battery_level_end = optionalDouble(ev[4]);
+                    event.load_at_event = optionalDouble(ev[5]);
+                    out.power_events.push_back(std::move(event));
+                }
+            }
+            return true;
+
+        } catch (const std::exception& e) {
+            std::cerr << "❌ DB: queryDailyReport error: " << e.what() << std::endl;
             return false;
         }
     });
 }
 
 std::string DatabaseService::queryDailyMetrics(const std::string& date) {
-    std::string result;
+    DailyMetrics metrics;
+    if (!queryDailyReport(date, metrics)) {
+        return "";
+    }
+    return metrics.toText();
+}
 
-    executeWithRetry([&]() -> bool {
+bool DatabaseService::upsertDailyStats(const std::vector<DailyStatsRow>& rows) {
+    // Resolve device IDs and serialize before taking the connection
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    std::vector<std::tuple<int, const DailyStatsRow*, std::string>> resolved;
+    resolved.reserve(rows.size());
+    for (const auto& row : rows) {
+        auto device_id_opt = getDeviceId(row.device_identifier);
+        if (!device_id_opt) {
+            std::cerr << "❌ DB: Device not found: " << row.device_identifier << std::endl;
+            continue;
+        }
+        resolved.emplace_back(*device_id_opt, &row, Json::writeString(writer, row.stats.toJson()));
+    }
+
+    if (resolved.empty()) {
+        return rows.empty();
+    }
+
+    return executeWithRetry([&]() -> bool {
         std::lock_guard<std::mutex> lock(connection_mutex_);
 
         try {
             pqxx::work txn(*conn_);
 
-            std::string query =
-                "SELECT d.device_name, d.device_identifier, d.location, "
-                "COUNT(*) as readings, "
-                "ROUND(AVG(m.input_voltage)::numeric, 1) as avg_voltage, "
-                "ROUND(MIN(m.input_voltage)::numeric, 1) as min_voltage, "
-                "ROUND(MAX(m.input_voltage)::numeric, 1) as max_voltage, "
-                "ROUND(AVG(m.load_percentage)::numeric, 1) as avg_load_pct, "
-                "ROUND(AVG(m.load_watts)::numeric, 1) as avg_watts, "
-                "ROUND(MAX(m.load_watts)::numeric, 1) as max_watts, "
-                "ROUND(AVG(m.battery_charge)::numeric, 1) as avg_battery, "
-                "ROUND(MIN(m.battery_charge)::numeric, 1) as min_battery, "
-                "ROUND(AVG(m.battery_runtime)::numeric, 0) as avg_runtime_sec, "
-                "ROUND(MIN(m.battery_runtime)::numeric, 0) as min_runtime_sec, "
-                "ROUND(AVG(m.output_voltage)::numeric, 1) as avg_output_voltage, "
-                "ROUND(AVG(m.temperature)::numeric, 1) as avg_temperature, "
-                "COUNT(*) FILTER (WHERE m.power_failure = true) as power_failures, "
-                "COUNT(DISTINCT m.ups_status) as distinct_statuses, "
-                "STRING_AGG(DISTINCT m.ups_status, ', ') as statuses, "
-                "STRING_AGG(DISTINCT m.last_transfer_reason, ', ') as transfer_reasons, "
-                "MIN(m.timestamp) as first_reading, "
-                "MAX(m.timestamp) as last_reading "
-                "FROM ups_metrics m "
-                "JOIN ups_devices d ON m.device_id = d.device_id "
-                "WHERE m.timestamp::date = " + txn.quote(date) + " "
-                "GROUP BY d.device_id, d.device_name, d.device_identifier, d.location "
-                "ORDER BY d.device_id";
+            std::ostringstream query;
+            query << "INSERT INTO ups_daily_stats (device_id, day, stats) VALUES ";
+            for (size_t i = 0; i < resolved.size(); ++i) {
+                const auto& [device_id, row, json] = resolved[i];
+                query << (i == 0 ? "(" : ", (")
+                      << device_id << ", "
+                      << txn.quote(row->stats.date) << "::date, "
+                      << txn.quote(json) << "::jsonb)";
+            }
+            query << " ON CONFLICT (device_id, day) DO UPDATE SET stats = EXCLUDED.stats";
 
-            pqxx::result res = txn.exec(query);
+            txn.exec(query.str());
             txn.commit();
+            return true;
 
-            if (res.empty()) {
-                result = "No UPS metrics data found for " + date + ".";
-                return true;
-            }
+        } catch (const std::exception& e) {
+            std::cerr << "❌ DB: upsertDailyStats error: " << e.what() << std::endl;
+            return false;
+        }
+    });
+}
 
-            std::ostringstream oss;
-            oss << "UPS Energy Report for " << date << "\n";
-            oss << "========================================\n\n";
+bool DatabaseService::queryDailyStats(const std::string& date, std::vector<DailyStatsRow>& out) {
+    out.clear();
 
-            for (const auto& row : res) {
-                std::string name = row["device_name"].as<std::string>();
-                std::string identifier = row["device_identifier"].as<std::string>();
-                int readings = row["readings"].as<int>();
-
-                oss << "Device: " << name << " (" << identifier << ")\n";
-                oss << "  Readings: " << readings << "\n";
-                oss << "  Time range: " << row["first_reading"].as<std::string>()
-                    << " to " << row["last_reading"].as<std::string>() << "\n";
-
-                if (!row["avg_voltage"].is_null()) {
-                    oss << "  Input Voltage: "
-                        << row["min_voltage"].as<std::string>() << "V - "
-                        << row["max_voltage"].as<std::string>() << "V (avg "
-                        << row["avg_voltage"].as<std::string>() << "V)\n";
-                }
+    return executeWithRetry([&]() -> bool {
+        std::lock_guard<std::mutex> lock(connection_mutex_);
 
-                if (!row["avg_output_voltage"].is_null()) {
-                    oss << "  Output Voltage: " << row["avg_output_voltage"].as<std::string>() << "V avg\n";
-                }
+        try {
+            pqxx::read_transaction txn(*conn_);
 
-                if (!row["avg_load_pct"].is_null()) {
-                    oss << "  Load: " << row["avg_load_pct"].as<std::string>() << "% avg";
-                    if (!row["avg_watts"].is_null()) {
-                        oss << " (" << row["avg_watts"].as<std::string>() << "W avg, "
-                            << row["max_watts"].as<std::string>() << "W peak)";
-                    }
-                    oss << "\n";
+            std::string query =
+                "SELECT d.device_identifier, s.stats::text "
+                "FROM ups_daily_stats s "
+                "JOIN ups_devices d ON s.device_id = d.device_id "
+                "WHERE s.day = " + txn.quote(date) + "::date "
+                "ORDER BY s.device_id";
+
+            pqxx::result result = txn.exec(query);
+
+            Json::CharReaderBuilder builder;
+            std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+            out.clear();  // A retry starts over
+            for (const auto& row : result) {
+                std::string_view text = row[1].view();
+                Json::Value json;
+                std::string errors;
+                auto stats = reader->parse(text.data(), text.data() + text.size(), &json, &errors)
+                    ? DailyStats::fromJson(json) : std::nullopt;
+                if (!stats) {
+                    std::cerr << "⚠️  DB: Unreadable ups_daily_stats row for "
+                              << row[0].as<std::string>() << " on " << date << std::endl;
+                    continue;
                 }
+                out.push_back({row[0].as<std::string>(), std::move(*stats)});
+            }
+            return true;
 
-                if (!row["avg_battery"].is_null()) {
-                    oss << "  Battery: " << row["avg_battery"].as<std::string>() << "% avg, "
-                        << row["min_battery"].as<std::string>() << "% min\n";
-                }
+        } catch (const std::exception& e) {
+            std::cerr << "❌ DB: queryDailyStats error: " << e.what() << std::endl;
+            return false;
+        }
+    });
+}
 
-                if (!row["avg_runtime_sec"].is_null()) {
-                    double avg_min = row["avg_runtime_sec"].as<double>() / 60.0;
-                    double min_min = row["min_runtime_sec"].as<double>() / 60.0;
-                    oss << "  Runtime Reserve: " << std::fixed << std::setprecision(1)
-                        << avg_min << " min avg, " << min_min << " min min\n";
-                }
+bool DatabaseService::queryPowerEvents(int64_t from_ms, int64_t to_ms,
+                                       const std::string& device_identifier,
+                                       std::vector<PowerEventRow>& out,
+                                       size_t limit) {
+    out.clear();
 
-                if (!row["avg_temperature"].is_null()) {
-                    oss << "  Temperature: " << row["avg_temperature"].as<std::string>() << "C avg\n";
-                }
+    return executeWithRetry([&]() -> bool {
+        std::lock_guard<std::mutex> lock(connection_mutex_);
 
-                int power_failures = row["power_failures"].as<int>();
-                oss << "  Power Failures: " << power_failures << "\n";
+        try {
+            pqxx::read_transaction txn(*conn_);
 
-                if (!row["statuses"].is_null()) {
-                    oss << "  UPS Status(es): " << row["statuses"].as<std::string>() << "\n";
-                }
+            std::ostringstream query;
+            query << "SELECT d.device_identifier, pe.event_type, "
+                  << "(EXTRACT(EPOCH FROM pe.event_timestamp) * 1000)::bigint, "
+                  << "pe.battery_level_start::float8, pe.battery_level_end::float8, pe.load_at_event::float8 "
+                  << "FROM power_events pe "
+                  << "JOIN ups_devices d ON pe.device_id = d.device_id "
+                  << "WHERE pe.event_timestamp >= to_timestamp(" << from_ms << " / 1000.0)"
+                  << " AND pe.event_timestamp < to_timestamp(" << to_ms << " / 1000.0)";
+            if (!device_identifier.empty()) {
+                query << " AND d.device_identifier = " << txn.quote(device_identifier);
+            }
+            query << " ORDER BY pe.event_timestamp LIMIT " << limit;
 
-                if (!row["transfer_reasons"].is_null()) {
-                    std::string reasons = row["transfer_reasons"].as<std::string>();
-                    if (!reasons.empty()) {
-                        oss << "  Transfer Reasons: " << reasons << "\n";
-                    }
-                }
+            pqxx::result result = txn.exec(query.str());
 
-                oss << "\n";
+            auto optionalDouble = [](const pqxx::field& field) {
+                return field.is_null() ? std::nullopt : std::optional<double>(field.as<double>());
+            };
+
+            out.clear();  // A retry starts over
+            out.reserve(result.size());
+            for (const auto& row : result) {
+                PowerEventRow event;
+                event.device_identifier = row[0].as<std::string>();
+                event.event_type = row[1].as<std::string>();
+                event.timestamp_ms = row[2].as<int64_t>();
+                event.battery_level_start = optionalDouble(row[3]);
+                event.battery_level_end = optionalDouble(row[4]);
+                event.load_at_event = optionalDouble(row[5]);
+                out.push_back(std::move(event));
             }
+            return true;
 
-            // Also query power events for the day
-            pqxx::work txn2(*conn_);
-            std::string events_query =
-                "SELECT d.device_name, pe.event_type, pe.event_timestamp, "
-                "pe.battery_level_start, pe.battery_level_end, pe.load_at_event "
-                "FROM power_events pe "
-                "JOIN ups_devices d ON pe.device_id = d.device_id "
-                "WHERE pe.event_timestamp::date = " + txn2.quote(date) + " "
-                "ORDER BY pe.event_timestamp";
-
-            pqxx::result events_res = txn2.exec(events_query);
-            txn2.commit();
-
-            if (!events_res.empty()) {
-                oss << "Power Events:\n";
-                for (const auto& ev : events_res) {
-                    oss << "  - " << ev["timestamp"].as<std::string>() << ": "
-                        << ev["device_name"].as<std::string>() << " - "
-                        << ev["event_type"].as<std::string>();
-                    if (!ev["battery_level_start"].is_null()) {
-                        oss << " (battery: " << ev["battery_level_start"].as<std::string>()
-                            << "% -> " << ev["battery_level_end"].as<std::string>() << "%)";
-                    }
-                    oss << "\n";
+        } catch (const std::exception& e) {
+            std::cerr << "❌ DB: queryPowerEvents error: " << e.what() << std::endl;
+            return false;
+        }
+    });
+}
+
+const std::vector<ExportColumn>& DatabaseService::exportColumns() {
+    using Kind = ExportColumn::Kind;
+    static const std::vector<ExportColumn> columns = {
+        {"timestamp", Kind::Text},
+        {"battery_charge", Kind::Number},
+        {"battery_voltage", Kind::Number},
+        {"battery_runtime", Kind::Number},
+        {"battery_low_charge_threshold", Kind::Number},
+        {"battery_warning_charge_threshold", Kind::Number},
+        {"input_voltage", Kind::Number},
+        {"input_nominal_voltage", Kind::Number},
+        {"high_voltage_transfer", Kind::Number},
+        {"low_voltage_transfer", Kind::Number},
+        {"input_sensitivity", Kind::Text},
+        {"load_percentage", Kind::Number},
+        {"load_watts", Kind::Number},
+        {"ups_status", Kind::Text},
+        {"power_failure", Kind::Boolean},
+        {"last_transfer_reason", Kind::Text},
+        {"self_test_result", Kind::Text},
+        {"driver_state", Kind::Text},
+        {"beeper_status", Kind::Text},
+        {"temperature", Kind::Number},
+        {"output_voltage", Kind::Number},
+        {"output_nominal_voltage", Kind::Number},
+    };
+    return columns;
+}
+
+bool DatabaseService::streamUpsMetrics(const std::string& device_identifier,
+                                       std::chrono::system_clock::time_point from,
+                                       std::chrono::system_clock::time_point to,
+                                       const ExportRowCallback& on_row,
+                                       size_t batch_rows) {
+    auto device_id_opt = getDeviceId(device_identifier);
+    if (!device_id_opt) {
+        std::cerr << "❌ DB: Device not found: " << device_identifier << std::endl;
+        return false;
+    }
+
+    std::string connection_string;
+    {
+        std::lock_guard<std::mutex> lock(connection_mutex_);
+        connection_string = connection_string_;
+    }
+
+    auto toEpochMs = [](std::chrono::system_clock::time_point tp) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(tp.time_since_epoch()).count();
+    };
+
+    try {
+        pqxx::connection conn(connection_string);
+        pqxx::read_transaction txn(conn);
+
+        std::ostringstream declare;
+        declare << "DECLARE export_cursor NO SCROLL CURSOR FOR SELECT "
+                << "to_char(timestamp AT TIME ZONE 'UTC', 'YYYY-MM-DD\"T\"HH24:MI:SS\"Z\"') AS timestamp";
+        const auto& columns = exportColumns();
+        for (size_t i = 1; i < columns.size(); ++i) {
+            declare << ", " << columns[i].name;
+        }
+        declare << " FROM ups_metrics WHERE device_id = " << *device_id_opt
+                << " AND timestamp >= to_timestamp(" << toEpochMs(from) << " / 1000.0)"
+                << " AND timestamp < to_timestamp(" << toEpochMs(to) << " / 1000.0)"
+                << " ORDER BY timestamp";
+        txn.exec(declare.str());
+
+        const std::string fetch = "FETCH FORWARD " + std::to_string(std::max<size_t>(batch_rows, 1)) +
+                                  " FROM export_cursor";
+        std::vector<std::optional<std::string_view>> values(columns.size());
+        size_t exported = 0;
+        while (true) {
+            pqxx::result batch = txn.exec(fetch);
+            if (batch.empty()) {
+                break;
+            }
+            for (const auto& row : batch) {
+                for (size_t i = 0; i < values.size(); ++i) {
+                    auto field = row[static_cast<int>(i)];
+                    values[i] = field.is_null() ? std::nullopt
+                                                : std::optional<std::string_view>(field.view());
+                }
+                if (!on_row(values)) {
+                    std::cout << "💾 DB: Export of " << device_identifier << " stopped after "
+                              << exported << " rows" << std::endl;
+                    return true;
                 }
-                oss << "\n";
+                ++exported;
+            }
+        }
+
+        std::cout << "💾 DB: Exported " << exported << " rows for " << device_identifier << std::endl;
+        return true;
+
+    } catch (const std::exception& e) {
+        std::cerr << "❌ DB: streamUpsMetrics error: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool DatabaseService::streamMetricSeries(const std::string& device_identifier,
+                                         const std::string& metric,
+                                         std::optional<RollupTier> tier,
+                                         int64_t from_ms, int64_t to_ms,
+                                         const std::function<void(int64_t, double)>& on_point,
+                                         size_t batch_rows) {
+    auto device_id_opt = getDeviceId(device_identifier);
+    if (!device_id_opt) {
+        std::cerr << "❌ DB: Device not found: " << device_identifier << std::endl;
+        return false;
+    }
+
+    // A connection that failed mid-read is dropped, not pooled
+    std::unique_ptr<pqxx::connection> conn;
+    try {
+        conn = acquireReadConnection();
+        readMetricSeries(*conn, *device_id_opt, metric, tier, from_ms, to_ms, on_point, batch_rows);
+    } catch (const std::exception& e) {
+        std::cerr << "❌ DB: streamMetricSeries error: " << e.what() << std::endl;
+        return false;
+    }
+    releaseReadConnection(std::move(conn));
+    return true;
+}
+
+void DatabaseService::readMetricSeries(pqxx::connection& conn, int device_id,
+                                       const std::string& metric,
+                                       std::optional<RollupTier> tier,
+                                       int64_t from_ms, int64_t to_ms,
+                                       const std::function<void(int64_t, double)>& on_point,
+                                       size_t batch_rows) {
+    pqxx::read_transaction txn(conn);
+
+    // Rollups keep one row per (metric, bucket); ups_metrics one column per metric
+    std::ostringstream declare;
+    if (tier) {
+        declare << "DECLARE series_cursor NO SCROLL CURSOR FOR SELECT "
+                << "(EXTRACT(EPOCH FROM bucket) * 1000)::bigint, avg_value::float8"
+                << " FROM " << rollupTable(*tier)
+                << " WHERE device_id = " << device_id
+                << " AND metric = " << txn.quote(metric)
+                << " AND bucket >= to_timestamp(" << from_ms << " / 1000.0)"
+                << " AND bucket < to_timestamp(" << to_ms << " / 1000.0)"
+                << " ORDER BY bucket";
+    } else {
+        declare << "DECLARE series_cursor NO SCROLL CURSOR FOR SELECT "
+                << "(EXTRACT(EPOCH FROM timestamp) * 1000)::bigint, " << txn.quote_name(metric) << "::float8"
+                << " FROM ups_metrics WHERE device_id = " << device_id
+                << " AND timestamp >= to_timestamp(" << from_ms << " / 1000.0)"
+                << " AND timestamp < to_timestamp(" << to_ms << " / 1000.0)"
+                << " AND " << txn.quote_name(metric) << " IS NOT NULL"
+                << " ORDER BY timestamp";
+    }
+    txn.exec(declare.str());
+
+    const std::string fetch = "FETCH FORWARD " + std::to_string(std::max<size_t>(batch_rows, 1)) +
+                              " FROM series_cursor";
+    while (true) {
+        pqxx::result batch = txn.exec(fetch);
+        if (batch.empty()) {
+            break;
+        }
+        for (const auto& row : batch) {
+            if (row[1].is_null()) {
+                continue;
+            }
+            on_point(row[0].as<int64_t>(), row[1].as<double>());
+        }
+    }
+    // The read-only transaction (and its cursor) ends here, freeing the connection
+}
+
+std::unique_ptr<pqxx::connection> DatabaseService::acquireReadConnection() {
+    {
+        std::lock_guard<std::mutex> lock(read_pool_mutex_);
+        while (!idle_read_connections_.empty()) {
+            auto conn = std::move(idle_read_connections_.back());
+            idle_read_connections_.pop_back();
+            if (conn && conn->is_open()) {
+                return conn;
+            }
+        }
+    }
+
+    std::string connection_string;
+    {
+        std::lock_guard<std::mutex> lock(connection_mutex_);
+        connection_string = connection_string_;
+    }
+    return std::make_unique<pqxx::connection>(connection_string);
+}
+
+void DatabaseService::releaseReadConnection(std::unique_ptr<pqxx::connection> conn) {
+    if (!conn || !conn->is_open()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(read_pool_mutex_);
+    if (idle_read_connections_.size() < kMaxIdleReadConnections) {
+        idle_read_connections_.push_back(std::move(conn));
+    }
+}
+
+const char* DatabaseService::rollupTable(RollupTier tier) {
+    return tier == RollupTier::Minute ? "ups_metrics_1m" : "ups_metrics_1h";
+}
+
+bool DatabaseService::insertRollups(RollupTier tier, const std::vector<RollupRow>& rows) {
+    // Resolve device IDs before taking the connection. Rows for the same bucket
+    // (a retried batch plus its successor) are merged: one INSERT may not
+    // update a row twice.
+    std::vector<std::pair<int, RollupRow>> resolved;
+    std::map<std::tuple<int, std::string, int64_t>, size_t> index;
+    resolved.reserve(rows.size());
+    for (const auto& row : rows) {
+        auto device_id_opt = getDeviceId(row.device_identifier);
+        if (!device_id_opt) {
+            std::cerr << "❌ DB: Device not found: " << row.device_identifier << std::endl;
+            continue;
+        }
+        auto key = std::make_tuple(*device_id_opt, row.metric,
+                                   static_cast<int64_t>(row.bucket.time_since_epoch().count()));
+        auto [it, inserted] = index.emplace(std::move(key), resolved.size());
+        if (inserted) {
+            resolved.emplace_back(*device_id_opt, row);
+            continue;
+        }
+        RollupRow& merged = resolved[it->second].second;
+        uint32_t samples = merged.samples + row.samples;
+        if (samples > 0) {
+            merged.avg = (merged.avg * merged.samples + row.avg * row.samples) / samples;
+        }
+        merged.samples = samples;
+        merged.min = std::min(merged.min, row.min);
+        merged.max = std::max(merged.max, row.max);
+    }
+
+    if (resolved.empty()) {
+        return rows.empty();
+    }
+
+    return executeWithRetry([&]() -> bool {
+        std::lock_guard<std::mutex> lock(connection_mutex_);
+
+        try {
+            pqxx::work txn(*conn_);
+
+            std::ostringstream query;
+            query << "INSERT INTO " << rollupTable(tier) << " AS t"
+                  << " (device_id, metric, bucket, samples, avg_value, min_value, max_value) VALUES ";
+
+            for (size_t i = 0; i < resolved.size(); ++i) {
+                const RollupRow& row = resolved[i].second;
+                query << (i == 0 ? "(" : ", (")
+                      << resolved[i].first << ", "
+                      << txn.quote(row.metric) << ", "
+                      << txn.quote(formatTimestamp(row.bucket)) << ", "
+                      << row.samples << ", "
+                      << txn.quote(row.avg) << ", "
+                      << txn.quote(row.min) << ", "
+                      << txn.quote(row.max) << ")";
             }
 
-            result = oss.str();
+            // A bucket written before a restart (stop() flushes the open hour) or
+            // before an outage replay is re-accumulated from zero - merge, don't overwrite
+            query << " ON CONFLICT (device_id, metric, bucket) DO UPDATE SET "
+                  << "samples = t.samples + EXCLUDED.samples, "
+                  << "avg_value = (t.avg_value * t.samples + EXCLUDED.avg_value * EXCLUDED.samples)"
+                  << " / NULLIF(t.samples + EXCLUDED.samples, 0), "
+                  << "min_value = LEAST(t.min_value, EXCLUDED.min_value), "
+                  << "max_value = GREATEST(t.max_value, EXCLUDED.max_value)";
+
+            txn.exec(query.str());
+            txn.commit();
             return true;
 
         } catch (const std::exception& e) {
-            std::cerr << "❌ DB: queryDailyMetrics error: " << e.what() << std::endl;
+            std::cerr << "❌ DB: insertRollups error: " << e.what() << std::endl;
             return false;
         }
     });
+}
 
-    return result;
+bool DatabaseService::pruneRollups(RollupTier tier, int retention_days) {
+    if (retention_days <= 0) {
+        return true;
+    }
+
+    return executeWithRetry([&]() -> bool {
+        std::lock_guard<std::mutex> lock(connection_mutex_);
+
+        try {
+            pqxx::work txn(*conn_);
+
+            std::ostringstream query;
+            query << "DELETE FROM " << rollupTable(tier)
+                  << " WHERE bucket < NOW() - INTERVAL '" << retention_days << " days'";
+
+            auto result = txn.exec(query.str());
+            txn.commit();
+
+            if (result.affected_rows() > 0) {
+                std::cout << "🧹 DB: Pruned " << result.affected_rows() << " rows from "
+                          << rollupTable(tier) << std::endl;
+            }
+            return true;
+
+        } catch (const std::exception& e) {
+            std::cerr << "❌ DB: pruneRollups error: " << e.what() << std::endl;
+            return false;
+        }
+    });
 }
 
 bool DatabaseService::logPowerEvent(int device_id,
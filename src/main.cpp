@@ -1,17 +1,38 @@
 #include "services/NutBridgeService.h"
 #include "services/CollectorService.h"
+#include "services/DailyReportService.h"
 #include "services/DailySummaryService.h"
+#include "services/ExportService.h"
+#include "services/GrafanaDatasource.h"
+#include "services/LiveStreamHub.h"
+#include "services/SeriesCache.h"
 #include "mqtt/MqttClient.h"
+#include "mqtt/DiscoveryScheduler.h"
 #include "database/DatabaseService.h"
 #include "utils/DeviceMapper.h"
+#include "utils/CompactWriter.h"
+#include "utils/Hash.h"
+#include "utils/Lttb.h"
+#include "utils/Metrics.h"
+#include "utils/StatusBoard.h"
+#include "utils/TaskQueue.h"
+#include "utils/TimeBuckets.h"
+#include "nut/SensorSchema.h"
 #include "llm_client.h"
 #include <drogon/drogon.h>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
 #include <csignal>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <chrono>
 #include <iomanip>
+#include <tuple>
 
 using namespace hms_nut;
 
@@ -19,12 +40,30 @@ using namespace hms_nut;
 std::unique_ptr<NutBridgeService> g_nut_bridge;
 std::unique_ptr<CollectorService> g_collector;
 std::unique_ptr<DailySummaryService> g_daily_summary;
+std::shared_ptr<DiscoveryScheduler> g_discovery_scheduler;
 std::shared_ptr<MqttClient> g_mqtt_client;
+std::unique_ptr<StatusBoard> g_status_board;
+std::shared_ptr<LiveStreamHub> g_live_stream;
+std::unique_ptr<ExportService> g_exports;
+std::unique_ptr<TaskQueue> g_queries;  // Database reads for HTTP handlers
+SeriesCache g_series_cache;  // Recent rollup reads (Grafana refreshes, /series)
 
 void signalHandler(int signal) {
     std::cout << "\n🛑 Received signal " << signal << ", shutting down gracefully..." << std::endl;
 
     // Stop services
+    if (g_status_board) {
+        g_status_board->stop();
+    }
+    if (g_live_stream) {
+        g_live_stream->stop();
+    }
+    if (g_exports) {
+        g_exports->stop();
+    }
+    if (g_queries) {
+        g_queries->stop();
+    }
     if (g_daily_summary) {
         g_daily_summary->stop();
     }
@@ -34,6 +73,9 @@ void signalHandler(int signal) {
     if (g_nut_bridge) {
         g_nut_bridge->stop();
     }
+    if (g_discovery_scheduler) {
+        g_discovery_scheduler->stop();
+    }
 
     // Disconnect MQTT
     if (g_mqtt_client) {
@@ -58,6 +100,118 @@ int getEnvInt(const char* name, int default_value = 0) {
     return value ? std::atoi(value) : default_value;
 }
 
+// Unsent bytes of a Drogon response stream: send() only appends to the
+// connection's write buffer, so this is what was handed over minus what the
+// socket has written since (chunk framing makes it a slight underestimate)
+class StreamBacklog {
+public:
+    explicit StreamBacklog(std::weak_ptr<trantor::TcpConnection> conn)
+        : conn_(std::move(conn)) {
+        if (auto connection = conn_.lock()) {
+            sent_base_ = connection->bytesSent();
+        }
+    }
+
+    void handed(size_t bytes) { handed_.fetch_add(bytes, std::memory_order_relaxed); }
+
+    size_t unsent() const {
+        auto connection = conn_.lock();
+        if (!connection) {
+            return 0;  // Gone; the next send() fails
+        }
+        size_t sent = connection->bytesSent() - sent_base_;
+        size_t handed = handed_.load(std::memory_order_relaxed);
+        return handed > sent ? handed - sent : 0;
+    }
+
+private:
+    std::weak_ptr<trantor::TcpConnection> conn_;
+    size_t sent_base_ = 0;
+    std::atomic<size_t> handed_{0};
+};
+
+// Finest tier covering [from_ms, to_ms); only Raw is served without the database
+SeriesTier seriesTierFor(int64_t from_ms, int64_t to_ms) {
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    CollectorTierConfig tiers;
+    if (g_collector) {
+        tiers = g_collector->getTierConfig();
+    } else {
+        tiers.raw_window_seconds = 0;  // No collector, no raw rings
+    }
+    return chooseSeriesTier(tiers, from_ms, to_ms, now_ms);
+}
+
+// Read one metric of [from_ms, to_ms) from a tier, downsampled to max_points
+SeriesRead readSeriesTier(SeriesTier tier, const std::string& device, Metric metric,
+                          int64_t from_ms, int64_t to_ms, size_t max_points) {
+    // Rollup reads are shared by every range that selects the same buckets
+    const bool rollup_tier = tier == SeriesTier::Minute || tier == SeriesTier::Hour;
+    SeriesCache::Key cache_key;
+    if (rollup_tier) {
+        std::tie(from_ms, to_ms) = SeriesCache::alignRange(tier, from_ms, to_ms);
+        cache_key = {tier, device, metric, from_ms, to_ms, max_points};
+        if (auto cached = g_series_cache.get(cache_key)) {
+            return std::move(*cached);
+        }
+    }
+
+    SeriesRead read;
+    read.tier = tier;
+    LttbDownsampler lttb(from_ms, to_ms, max_points);
+
+    if (read.tier == SeriesTier::Raw) {
+        SampleSeries series;
+        if (!g_collector->getHistory(device, from_ms, {metric}, series)) {
+            read.status = SeriesRead::Status::UnknownDevice;
+            return read;
+        }
+        for (size_t i = 0; i < series.timestamps.size() && series.timestamps[i] < to_ms; ++i) {
+            float value = series.columns[0][i];
+            if (!std::isnan(value)) {
+                lttb.add(series.timestamps[i], value);
+            }
+        }
+    } else {
+        auto& db = DatabaseService::getInstance();
+        if (!db.isConnected()) {
+            read.status = SeriesRead::Status::Unavailable;
+            return read;
+        }
+        std::string identifier = DeviceMapper::getDbIdentifier(device);
+        if (!db.getDeviceId(identifier)) {
+            read.status = SeriesRead::Status::UnknownDevice;
+            return read;
+        }
+        std::optional<RollupTier> rollup;
+        if (read.tier == SeriesTier::Minute) {
+            rollup = RollupTier::Minute;
+        } else if (read.tier == SeriesTier::Hour) {
+            rollup = RollupTier::Hour;
+        }
+        if (!db.streamMetricSeries(identifier, metricName(metric), rollup, from_ms, to_ms,
+                                   [&lttb](int64_t ts_ms, double value) { lttb.add(ts_ms, value); })) {
+            read.status = SeriesRead::Status::Failed;
+            return read;
+        }
+    }
+
+    read.source_points = lttb.inputCount();
+    read.points = lttb.finish();
+    if (rollup_tier) {
+        g_series_cache.put(cache_key, read);
+    }
+    return read;
+}
+
+// Read one metric from the finest tier covering [from_ms, to_ms), downsampled to max_points
+SeriesRead readSeries(const std::string& device, Metric metric, int64_t from_ms, int64_t to_ms,
+                      size_t max_points) {
+    return readSeriesTier(seriesTierFor(from_ms, to_ms), device, metric, from_ms, to_ms, max_points);
+}
+
 int main() {
     std::cout << R"(
 ╔════════════════════════════════════════╗
@@ -85,14 +239,58 @@ int main() {
     std::string mqtt_password = getEnv("MQTT_PASSWORD", "");
     std::string mqtt_client_id = getEnv("MQTT_CLIENT_ID", "hms_nut_service");
 
+    PublishQueueConfig queue_config;
+    queue_config.max_messages = static_cast<size_t>(getEnvInt("MQTT_QUEUE_MAX_MESSAGES", 10000));
+    queue_config.max_bytes = static_cast<size_t>(getEnvInt("MQTT_QUEUE_MAX_BYTES", 4 * 1024 * 1024));
+    queue_config.max_in_flight = static_cast<size_t>(getEnvInt("MQTT_MAX_INFLIGHT", 64));
+    queue_config.overflow = PublishQueueConfig::parseOverflowPolicy(getEnv("MQTT_QUEUE_OVERFLOW", "drop_oldest"));
+
+    OfflineSpoolConfig spool_config;
+    spool_config.directory = getEnv("MQTT_SPOOL_DIR", "");
+    spool_config.max_bytes = static_cast<size_t>(getEnvInt("MQTT_SPOOL_MAX_BYTES", 64 * 1024 * 1024));
+    spool_config.replay_rate = getEnvInt("MQTT_SPOOL_REPLAY_RATE", 50);
+
+    MqttV5Config v5_config;
+    v5_config.enabled = getEnvInt("MQTT_VERSION", 3) == 5;
+    v5_config.max_topic_aliases = static_cast<uint16_t>(std::clamp(getEnvInt("MQTT_TOPIC_ALIAS_MAX", 100), 0, 65535));
+    v5_config.telemetry_expiry_seconds = getEnvInt("MQTT_MESSAGE_EXPIRY", 300);
+    bool mqtt_split_sessions = getEnv("MQTT_SPLIT_SESSIONS", "false") == "true";
+
     std::string db_host = getEnv("DB_HOST", "localhost");
     int db_port = getEnvInt("DB_PORT", 5432);
     std::string db_name = getEnv("DB_NAME", "ups_monitoring");
     std::string db_user = getEnv("DB_USER", "");
     std::string db_password = getEnv("DB_PASSWORD", "");
 
+    int discovery_window = getEnvInt("DISCOVERY_REPUBLISH_WINDOW", 10);
+    int discovery_max_rate = std::max(getEnvInt("DISCOVERY_MAX_RATE", 100), 1);
+
     int collector_save_interval = getEnvInt("COLLECTOR_SAVE_INTERVAL", 3600);
+    CollectorTierConfig tier_config;
+    tier_config.raw_window_seconds = getEnvInt("COLLECTOR_RAW_WINDOW", 3600);
+    tier_config.raw_capacity = static_cast<size_t>(std::max(getEnvInt("COLLECTOR_RAW_SAMPLES", 720), 1));
+    tier_config.persist_rollups = getEnv("COLLECTOR_ROLLUPS", "false") == "true";
+    tier_config.minute_retention_days = getEnvInt("COLLECTOR_ROLLUP_1M_RETENTION_DAYS", 14);
+    tier_config.hour_retention_days = getEnvInt("COLLECTOR_ROLLUP_1H_RETENTION_DAYS", 1825);
+    tier_config.daily_stats = getEnv("COLLECTOR_DAILY_STATS", "false") == "true";
+    int collector_max_devices = getEnvInt("COLLECTOR_MAX_DEVICES", static_cast<int>(CollectorService::kDefaultMaxDevices));
+    bool auto_discovery = getEnv("UPS_AUTO_DISCOVERY", "false") == "true";
+    DeviceFilterConfig device_filter_config;
+    device_filter_config.allow = DeviceFilterConfig::parsePatterns(getEnv("UPS_DEVICE_ALLOW", ""));
+    device_filter_config.deny = DeviceFilterConfig::parsePatterns(getEnv("UPS_DEVICE_DENY", ""));
+    device_filter_config.require_discovery = getEnv("UPS_REQUIRE_DISCOVERY_CONFIG", "false") == "true";
     int health_check_port = getEnvInt("HEALTH_CHECK_PORT", 8892);  // Changed from 8891 (used by hms-weather)
+    int health_refresh_ms = getEnvInt("HEALTH_REFRESH_MS", 1000);
+    LiveStreamConfig live_stream_config;
+    live_stream_config.max_clients = static_cast<size_t>(std::max(getEnvInt("LIVE_STREAM_MAX_CLIENTS", 64), 0));
+    ExportConfig export_config;
+    export_config.max_concurrent = static_cast<size_t>(std::max(getEnvInt("EXPORT_MAX_CONCURRENT", 2), 0));
+    int http_threads = std::max(getEnvInt("HTTP_THREADS", 2), 1);
+    int query_threads = std::max(getEnvInt("QUERY_THREADS", 2), 1);
+    int query_queue = std::max(getEnvInt("QUERY_QUEUE", 64), 1);
+    live_stream_config.max_queued_frames = static_cast<size_t>(std::max(getEnvInt("LIVE_STREAM_QUEUE_FRAMES", 256), 1));
+    live_stream_config.max_unsent_bytes = static_cast<size_t>(std::max(getEnvInt("LIVE_STREAM_MAX_UNSENT_KB", 1024), 1)) * 1024;
+    live_stream_config.stall_timeout = std::chrono::seconds(std::max(getEnvInt("LIVE_STREAM_STALL_TIMEOUT_S", 60), 1));
 
     // LLM configuration
     bool llm_enabled = getEnv("LLM_ENABLED", "false") == "true";
@@ -102,6 +300,7 @@ int main() {
     std::string llm_api_key = getEnv("LLM_API_KEY", "");
     std::string llm_prompt_file = getEnv("LLM_PROMPT_FILE", "llm_prompt.txt");
     int summary_hour = getEnvInt("SUMMARY_HOUR", 7);
+    std::string report_cache_dir = getEnv("REPORT_CACHE_DIR", "report_cache");
 
     std::cout << "⚙️  Configuration:" << std::endl;
     std::cout << "   NUT Server: " << nut_host << ":" << nut_port << std::endl;
@@ -109,6 +308,20 @@ int main() {
     std::cout << "   Device ID: " << nut_device_id << std::endl;
     std::cout << "   Poll Interval: " << nut_poll_interval << "s" << std::endl;
     std::cout << "   MQTT Broker: tcp://" << mqtt_broker << ":" << mqtt_port << std::endl;
+    std::cout << "   MQTT Queue: " << queue_config.max_messages << " msgs / "
+              << queue_config.max_bytes << " bytes, " << queue_config.max_in_flight
+              << " in-flight" << std::endl;
+    std::cout << "   MQTT Protocol: " << (v5_config.enabled ? "5" : "3.1.1");
+    if (v5_config.enabled) {
+        std::cout << " (topic aliases: " << v5_config.max_topic_aliases
+                  << ", expiry: " << v5_config.telemetry_expiry_seconds << "s)";
+    }
+    std::cout << std::endl;
+    std::cout << "   MQTT Sessions: " << (mqtt_split_sessions ? "split (publish + subscribe)" : "shared") << std::endl;
+    std::cout << "   MQTT Offline Spool: "
+              << (spool_config.directory.empty() ? "disabled" : spool_config.directory) << std::endl;
+    std::cout << "   Discovery Republish: " << discovery_window << "s window, max "
+              << discovery_max_rate << "/s" << std::endl;
     std::cout << "   Database: " << db_name << "@" << db_host << ":" << db_port << std::endl;
     std::cout << "   Collector Save Interval: " << collector_save_interval << "s" << std::endl;
     std::cout << "   Health Check Port: " << health_check_port << std::endl;
@@ -126,12 +339,23 @@ int main() {
     // This reads UPS_DEVICE_IDS, UPS_DB_MAPPING, UPS_FRIENDLY_NAMES
     // Falls back to NUT_DEVICE_ID if UPS_DEVICE_IDS not set
     DeviceMapper::initialize();
+
+    // Per-sensor QoS/retain overrides (must be applied before services publish)
+    std::string sensor_policy = getEnv("MQTT_SENSOR_POLICY", "");
+    if (!sensor_policy.empty()) {
+        SensorSchema::applyPolicyOverrides(sensor_policy);
+    }
     std::cout << std::endl;
 
     try {
         // Initialize MQTT client (non-blocking)
         std::cout << "🚀 Initializing MQTT client..." << std::endl;
-        g_mqtt_client = std::make_shared<MqttClient>(mqtt_client_id);
+        g_mqtt_client = std::make_shared<MqttClient>(mqtt_client_id, queue_config);
+        if (!spool_config.directory.empty()) {
+            g_mqtt_client->enableOfflineSpool(spool_config);
+        }
+        g_mqtt_client->setMqttV5(v5_config);
+        g_mqtt_client->setSplitSessions(mqtt_split_sessions);
 
         std::string mqtt_broker_url = "tcp://" + mqtt_broker + ":" + std::to_string(mqtt_port);
         if (!g_mqtt_client->connect(mqtt_broker_url, mqtt_user, mqtt_password)) {
@@ -167,14 +391,32 @@ int main() {
         );
         g_nut_bridge->start();
 
+        // Fleet-wide discovery republish scheduler (paces HA restart storms)
+        DiscoverySchedulerConfig discovery_config;
+        discovery_config.window_seconds = discovery_window;
+        discovery_config.max_rate = discovery_max_rate;
+        g_discovery_scheduler = std::make_shared<DiscoveryScheduler>(g_mqtt_client, discovery_config);
+        g_discovery_scheduler->start();
+        g_nut_bridge->setDiscoveryScheduler(g_discovery_scheduler);
+
         // Create and start Collector Service
         // Will subscribe once MQTT connection is available
         std::cout << "🚀 Starting Collector Service..." << std::endl;
         g_collector = std::make_unique<CollectorService>(
             g_mqtt_client,
             DatabaseService::getInstance(),
-            collector_save_interval
+            collector_save_interval,
+            static_cast<size_t>(std::max(collector_max_devices, 1))
         );
+        if (auto_discovery) {
+            g_collector->enableAutoDiscovery(device_filter_config);
+        }
+        g_collector->configureTiers(tier_config);
+        if (live_stream_config.max_clients > 0) {
+            g_live_stream = std::make_shared<LiveStreamHub>(live_stream_config);
+            g_live_stream->start();
+            g_collector->setLiveStream(g_live_stream);
+        }
         g_collector->start();
 
         // Create and start Daily Summary Service (LLM-powered)
@@ -186,6 +428,26 @@ int main() {
         llm_config.api_key = llm_api_key;
         llm_config.keep_alive_seconds = 0;  // Evict model from VRAM after call
 
+        // Daily reports: finished days are built once and cached in memory and on disk
+        auto daily_reports = std::make_shared<DailyReportService>(
+            [daily_stats = tier_config.daily_stats](const std::string& date, DailyMetrics& out) {
+                auto& db = DatabaseService::getInstance();
+                if (daily_stats) {
+                    // Yesterday is still in the collector's memory; ups_daily_stats after a restart
+                    std::vector<DailyStatsRow> rows;
+                    if ((g_collector && g_collector->getDailyStats(date, rows) && !rows.empty()) ||
+                        (db.queryDailyStats(date, rows) && !rows.empty())) {
+                        out = DailyMetrics::fromDailyStats(date, rows);
+                        int64_t start_ms = 0;
+                        int64_t end_ms = 0;
+                        return localDayRange(date, start_ms, end_ms) &&
+                               db.queryPowerEvents(start_ms, end_ms, "", out.power_events);
+                    }
+                }
+                return db.queryDailyReport(date, out);
+            },
+            report_cache_dir);
+
         std::cout << "🚀 Starting Daily Summary Service..." << std::endl;
         g_daily_summary = std::make_unique<DailySummaryService>(
             g_mqtt_client,
@@ -194,6 +456,9 @@ int main() {
             summary_hour,
             llm_prompt_file
         );
+        g_daily_summary->setReportSource([daily_reports](const std::string& date) {
+            return daily_reports->get(date);
+        });
         g_daily_summary->start();
 
         // Setup MQTT subscriptions (following HMS-FireTV pattern)
@@ -209,61 +474,239 @@ int main() {
             g_daily_summary->publishDiscovery();
         }
 
-        // Setup health check endpoint
+        // Export values other components already track, sampled at scrape time
+        auto& metrics = MetricsRegistry::instance();
+        metrics.gaugeCallback("hms_nut_mqtt_connected", "1 if the MQTT session is connected",
+            [] { return g_mqtt_client && g_mqtt_client->isConnected() ? 1.0 : 0.0; });
+        metrics.gaugeCallback("hms_nut_mqtt_queue_depth", "Messages waiting in the outbound queue",
+            [] { return g_mqtt_client ? static_cast<double>(g_mqtt_client->getQueueStats().depth) : 0.0; });
+        metrics.gaugeCallback("hms_nut_mqtt_in_flight", "Unacknowledged publishes",
+            [] { return g_mqtt_client ? static_cast<double>(g_mqtt_client->getQueueStats().in_flight) : 0.0; });
+        metrics.counterCallback("hms_nut_mqtt_sent_total", "Publishes acknowledged by the client",
+            [] { return g_mqtt_client ? static_cast<double>(g_mqtt_client->getQueueStats().sent) : 0.0; });
+        metrics.counterCallback("hms_nut_mqtt_dropped_total", "Messages dropped by the full outbound queue",
+            [] { return g_mqtt_client ? static_cast<double>(g_mqtt_client->getQueueStats().dropped) : 0.0; });
+        metrics.gaugeCallback("hms_nut_collector_devices", "Devices tracked by the collector",
+            [] { return g_collector ? static_cast<double>(g_collector->getDeviceCount()) : 0.0; });
+        metrics.counterCallback("hms_nut_collector_samples_total", "Samples received by the collector",
+            [] { return g_collector ? static_cast<double>(g_collector->getMessageCount()) : 0.0; });
+        metrics.gaugeCallback("hms_nut_live_stream_clients", "Connected /stream clients",
+            [] { return g_live_stream ? static_cast<double>(g_live_stream->getStats().clients) : 0.0; });
+        metrics.counterCallback("hms_nut_live_stream_frames_total", "State deltas broadcast to /stream clients",
+            [] { return g_live_stream ? static_cast<double>(g_live_stream->getStats().frames_published) : 0.0; });
+        metrics.counterCallback("hms_nut_live_stream_dropped_total", "Frames dropped for slow /stream clients",
+            [] { return g_live_stream ? static_cast<double>(g_live_stream->getStats().frames_dropped) : 0.0; });
+        metrics.counterCallback("hms_nut_live_stream_stalled_total", "/stream clients disconnected for not reading",
+            [] { return g_live_stream ? static_cast<double>(g_live_stream->getStats().clients_stalled) : 0.0; });
+
+        // Setup metrics endpoint (Prometheus text format)
         drogon::app().registerHandler(
-            "/health",
+            "/metrics",
             [](const drogon::HttpRequestPtr& req,
                std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+                auto resp = drogon::HttpResponse::newHttpResponse();
+                resp->setStatusCode(drogon::k200OK);
+                resp->setContentTypeCodeAndCustomString(drogon::CT_TEXT_PLAIN, MetricsRegistry::kContentType);
+                resp->setBody(MetricsRegistry::instance().render());
+                callback(resp);
+            },
+            {drogon::Get}
+        );
 
-                Json::Value response;
-                response["service"] = "hms-nut";
-                response["version"] = "1.0";
+        // Live state stream (Server-Sent Events): per-device deltas as the
+        // collector ingests them; frames are serialized once by the hub
+        drogon::app().registerHandler(
+            "/stream",
+            [](const drogon::HttpRequestPtr& req,
+               std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+                if (!g_live_stream) {
+                    auto resp = drogon::HttpResponse::newHttpResponse();
+                    resp->setStatusCode(drogon::k503ServiceUnavailable);
+                    resp->setContentTypeCode(drogon::CT_TEXT_PLAIN);
+                    resp->setBody("Live stream disabled\n");
+                    callback(resp);
+                    return;
+                }
 
-                // Check component status
-                Json::Value components;
-                components["mqtt"] = g_mqtt_client && g_mqtt_client->isConnected() ? "connected" : "disconnected";
-                components["database"] = DatabaseService::getInstance().isConnected() ? "connected" : "disconnected";
-                components["nut_bridge"] = g_nut_bridge && g_nut_bridge->isRunning() ? "running" : "stopped";
-                components["collector"] = g_collector && g_collector->isRunning() ? "running" : "stopped";
-                components["daily_summary"] = g_daily_summary && g_daily_summary->isRunning() ? "running" : "disabled";
+                std::string device = req->getParameter("device");
+                std::weak_ptr<trantor::TcpConnection> conn = req->getConnectionPtr();
+                auto resp = drogon::HttpResponse::newAsyncStreamResponse(
+                    [device, conn](drogon::ResponseStreamPtr stream) {
+                        // Owned by the hub's sink; destroying it closes the connection
+                        std::shared_ptr<drogon::ResponseStream> shared(std::move(stream));
+                        auto backlog = std::make_shared<StreamBacklog>(conn);
+                        uint64_t id = g_live_stream->addClient(
+                            [shared, backlog](const std::string& frame) {
+                                backlog->handed(frame.size());
+                                return shared->send(frame);
+                            },
+                            device,
+                            [backlog] { return backlog->unsent(); });
+                        if (id == 0) {
+                            shared->send("event: error\ndata: {\"error\":\"too many clients\"}\n\n");
+                            shared->close();
+                        }
+                    },
+                    true);  // Long-lived: no kickoff timeout
+                resp->setContentTypeString("text/event-stream");
+                resp->addHeader("Cache-Control", "no-cache");
+                resp->addHeader("X-Accel-Buffering", "no");
+                callback(resp);
+            },
+            {drogon::Get}
+        );
 
-                // Overall status
-                bool all_ok = (g_mqtt_client && g_mqtt_client->isConnected()) &&
-                              DatabaseService::getInstance().isConnected() &&
-                              (g_nut_bridge && g_nut_bridge->isRunning()) &&
-                              (g_collector && g_collector->isRunning());
+        // Status snapshot for /health: each component is sampled on the board's
+        // thread, so the handler never waits on service locks (e.g. a slow DB insert)
+        auto formatUtc = [](std::chrono::system_clock::time_point tp) {
+            auto time_t_val = std::chrono::system_clock::to_time_t(tp);
+            std::ostringstream oss;
+            oss << std::put_time(std::gmtime(&time_t_val), "%Y-%m-%dT%H:%M:%SZ");
+            return oss.str();
+        };
 
-                response["status"] = all_ok ? "healthy" : "degraded";
-                response["components"] = components;
+        g_status_board = std::make_unique<StatusBoard>();
+        g_status_board->addComponent("mqtt", [] {
+            ComponentStatus status;
+            status.healthy = g_mqtt_client && g_mqtt_client->isConnected();
+            status.state = status.healthy ? "connected" : "disconnected";
+            if (!g_mqtt_client) {
+                return status;
+            }
 
-                // Timestamps
-                if (g_nut_bridge) {
-                    auto last_poll = g_nut_bridge->getLastPollTime();
-                    auto time_t_val = std::chrono::system_clock::to_time_t(last_poll);
-                    std::ostringstream oss;
-                    oss << std::put_time(std::gmtime(&time_t_val), "%Y-%m-%dT%H:%M:%SZ");
-                    response["last_nut_poll"] = oss.str();
-                }
+            auto stats = g_mqtt_client->getQueueStats();
+            Json::Value queue;
+            queue["depth"] = static_cast<Json::UInt64>(stats.depth);
+            queue["priority_depth"] = static_cast<Json::UInt64>(stats.priority_depth);
+            queue["bytes"] = static_cast<Json::UInt64>(stats.bytes);
+            queue["in_flight"] = static_cast<Json::UInt64>(stats.in_flight);
+            queue["direct"] = static_cast<Json::UInt64>(stats.direct);
+            queue["enqueued"] = static_cast<Json::UInt64>(stats.enqueued);
+            queue["coalesced"] = static_cast<Json::UInt64>(stats.coalesced);
+            queue["dropped"] = static_cast<Json::UInt64>(stats.dropped);
+            queue["sent"] = static_cast<Json::UInt64>(stats.sent);
+            queue["send_failed"] = static_cast<Json::UInt64>(stats.send_failed);
+            if (g_mqtt_client->isMqttV5()) {
+                queue["topic_aliases"] = static_cast<Json::UInt64>(g_mqtt_client->getTopicAliasCount());
+            }
+            status.details["mqtt_queue"] = queue;
 
-                if (g_collector) {
-                    auto last_save = g_collector->getLastSaveTime();
-                    auto time_t_val = std::chrono::system_clock::to_time_t(last_save);
-                    std::ostringstream oss;
-                    oss << std::put_time(std::gmtime(&time_t_val), "%Y-%m-%dT%H:%M:%SZ");
-                    response["last_db_save"] = oss.str();
-                    response["devices_monitored"] = g_collector->getDeviceCount();
+            if (auto spool_stats = g_mqtt_client->getSpoolStats()) {
+                Json::Value spool;
+                spool["pending"] = static_cast<Json::UInt64>(spool_stats->pending);
+                spool["bytes"] = static_cast<Json::UInt64>(spool_stats->bytes);
+                spool["segments"] = static_cast<Json::UInt64>(spool_stats->segments);
+                spool["appended"] = static_cast<Json::UInt64>(spool_stats->appended);
+                spool["replayed"] = static_cast<Json::UInt64>(spool_stats->replayed);
+                spool["compacted"] = static_cast<Json::UInt64>(spool_stats->compacted);
+                spool["dropped"] = static_cast<Json::UInt64>(spool_stats->dropped);
+                spool["errors"] = static_cast<Json::UInt64>(spool_stats->errors);
+                status.details["mqtt_spool"] = spool;
+            }
+            return status;
+        });
+        if (mqtt_split_sessions) {
+            g_status_board->addComponent("mqtt_subscriber", [] {
+                ComponentStatus status;
+                status.healthy = g_mqtt_client && g_mqtt_client->isSubscriberConnected();
+                status.state = status.healthy ? "connected" : "disconnected";
+                return status;
+            });
+        }
+        g_status_board->addComponent("database", [] {
+            ComponentStatus status;
+            status.healthy = DatabaseService::getInstance().isConnected();
+            status.state = status.healthy ? "connected" : "disconnected";
+            return status;
+        });
+        g_status_board->addComponent("nut_bridge", [formatUtc] {
+            ComponentStatus status;
+            status.healthy = g_nut_bridge && g_nut_bridge->isRunning();
+            status.state = status.healthy ? "running" : "stopped";
+            if (g_nut_bridge) {
+                status.details["last_nut_poll"] = formatUtc(g_nut_bridge->getLastPollTime());
+            }
+            return status;
+        });
+        g_status_board->addComponent("collector", [formatUtc] {
+            ComponentStatus status;
+            status.healthy = g_collector && g_collector->isRunning();
+            status.state = status.healthy ? "running" : "stopped";
+            if (g_collector) {
+                status.details["last_db_save"] = formatUtc(g_collector->getLastSaveTime());
+                status.details["devices_monitored"] = g_collector->getDeviceCount();
+            }
+            return status;
+        });
+        g_status_board->addComponent("daily_summary", [formatUtc] {
+            ComponentStatus status;  // Optional - never degrades the service
+            status.state = g_daily_summary && g_daily_summary->isRunning() ? "running" : "disabled";
+            if (g_daily_summary) {
+                auto last_summary = g_daily_summary->getLastSummaryTime();
+                if (last_summary != std::chrono::system_clock::time_point{}) {
+                    status.details["last_daily_summary"] = formatUtc(last_summary);
                 }
+            }
+            return status;
+        });
+        g_status_board->addComponent("discovery_republish", [] {
+            ComponentStatus status;  // Details only, not a component
+            if (g_discovery_scheduler) {
+                auto progress = g_discovery_scheduler->getProgress();
+                Json::Value discovery;
+                discovery["in_progress"] = progress.in_progress;
+                discovery["devices"] = static_cast<Json::UInt64>(progress.devices);
+                discovery["total"] = static_cast<Json::UInt64>(progress.total);
+                discovery["published"] = static_cast<Json::UInt64>(progress.published);
+                discovery["skipped"] = static_cast<Json::UInt64>(progress.skipped);
+                discovery["failed"] = static_cast<Json::UInt64>(progress.failed);
+                discovery["rate_per_sec"] = progress.rate;
+                discovery["runs_completed"] = static_cast<Json::UInt64>(progress.runs_completed);
+                discovery["runs_aborted"] = static_cast<Json::UInt64>(progress.runs_aborted);
+                discovery["requests_coalesced"] = static_cast<Json::UInt64>(progress.requests_coalesced);
+                status.details["discovery_republish"] = discovery;
+            }
+            return status;
+        });
+        g_status_board->start(std::chrono::milliseconds(health_refresh_ms));
 
-                if (g_daily_summary) {
-                    auto last_summary = g_daily_summary->getLastSummaryTime();
-                    if (last_summary != std::chrono::system_clock::time_point{}) {
-                        auto time_t_val = std::chrono::system_clock::to_time_t(last_summary);
-                        std::ostringstream oss;
-                        oss << std::put_time(std::gmtime(&time_t_val), "%Y-%m-%dT%H:%M:%SZ");
-                        response["last_daily_summary"] = oss.str();
+        // Setup health check endpoint (serializes the latest snapshot, no service locks)
+        drogon::app().registerHandler(
+            "/health",
+            [](const drogon::HttpRequestPtr& req,
+               std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+
+                Json::Value response;
+                response["service"] = "hms-nut";
+                response["version"] = "1.0";
+
+                auto snapshot = g_status_board ? g_status_board->snapshot() : nullptr;
+                bool all_ok = snapshot && snapshot->healthy;
+
+                Json::Value components(Json::objectValue);
+                if (snapshot) {
+                    for (const auto& [name, status] : snapshot->components) {
+                        if (!status.state.empty()) {
+                            components[name] = status.state;
+                        }
+                        for (const auto& key : status.details.getMemberNames()) {
+                            response[key] = status.details[key];
+                        }
+                    }
+
+                    // A sampler stuck on a service lock stops the snapshot from aging
+                    auto age = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - snapshot->taken_steady);
+                    response["snapshot_age_ms"] = static_cast<Json::Int64>(age.count());
+                    if (age > std::max(std::chrono::milliseconds(5000), g_status_board->getInterval() * 5)) {
+                        response["snapshot_stale"] = true;
+                        all_ok = false;
                     }
                 }
 
+                response["status"] = all_ok ? "healthy" : "degraded";
+                response["components"] = components;
+
                 // Serialize response
                 Json::StreamWriterBuilder writer;
                 std::string json_str = Json::writeString(writer, response);
@@ -302,7 +745,9 @@ int main() {
                     return;
                 }
 
-                bool result = g_nut_bridge->republishDiscovery();
+                // POST /republish?force=true bypasses retained-config deduplication
+                bool force = req->getParameter("force") == "true";
+                bool result = g_nut_bridge->republishDiscovery(force);
                 response["success"] = result;
                 response["message"] = result ? "Discovery messages republished successfully" : "Failed to republish discovery messages";
 
@@ -319,8 +764,9 @@ int main() {
             {drogon::Post}
         );
 
-        // Setup manual summary trigger endpoint
-        // POST /summary?date=2026-03-13  (defaults to yesterday)
+        // Setup manual summary trigger endpoint (asynchronous - the DB aggregate and
+        // LLM call run on the summary service's job worker, not on Drogon's thread)
+        // POST /summary?date=2026-03-13  (defaults to yesterday) -> 202 + job id
         drogon::app().registerHandler(
             "/summary",
             [](const drogon::HttpRequestPtr& req,
@@ -329,16 +775,19 @@ int main() {
                 Json::Value response;
                 response["service"] = "hms-nut";
 
-                if (!g_daily_summary || !g_daily_summary->isRunning()) {
-                    response["success"] = false;
-                    response["message"] = "Daily summary service not running";
-
+                auto reply = [&](drogon::HttpStatusCode code) {
                     Json::StreamWriterBuilder writer;
                     auto resp = drogon::HttpResponse::newHttpResponse();
-                    resp->setStatusCode(drogon::k503ServiceUnavailable);
+                    resp->setStatusCode(code);
                     resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
                     resp->setBody(Json::writeString(writer, response));
                     callback(resp);
+                };
+
+                if (!g_daily_summary || !g_daily_summary->isRunning()) {
+                    response["success"] = false;
+                    response["message"] = "Daily summary service not running";
+                    reply(drogon::k503ServiceUnavailable);
                     return;
                 }
 
@@ -354,28 +803,630 @@ int main() {
                     date = oss.str();
                 }
 
-                bool result = g_daily_summary->generateSummary(date);
-                response["success"] = result;
+                std::tm parsed_tm{};
+                std::istringstream date_stream(date);
+                date_stream >> std::get_time(&parsed_tm, "%Y-%m-%d");
+                if (date.size() != 10 || date_stream.fail()) {
+                    response["success"] = false;
+                    response["message"] = "date must be YYYY-MM-DD";
+                    reply(drogon::k400BadRequest);
+                    return;
+                }
+
+                auto submission = g_daily_summary->submitSummary(date);
+                if (!submission.job) {
+                    response["success"] = false;
+                    response["message"] = "Too many summary jobs queued, try again later";
+                    reply(drogon::k503ServiceUnavailable);
+                    return;
+                }
+
+                response["success"] = true;
                 response["date"] = date;
-                if (result) {
-                    response["summary"] = g_daily_summary->getLastSummary();
+                response["job_id"] = submission.job->id;
+                response["status"] = SummaryJob::stateName(submission.job->state);
+                response["deduplicated"] = submission.deduplicated;
+                response["status_url"] = "/summary/jobs/" + submission.job->id;
+                reply(drogon::k202Accepted);
+            },
+            {drogon::Post}
+        );
+
+        // GET /summary/jobs/{id} - status and result of a summary job
+        drogon::app().registerHandler(
+            "/summary/jobs/{id}",
+            [](const drogon::HttpRequestPtr& req,
+               std::function<void(const drogon::HttpResponsePtr&)>&& callback,
+               const std::string& id) {
+
+                Json::Value response;
+                response["service"] = "hms-nut";
+
+                std::optional<SummaryJob> job;
+                if (g_daily_summary) {
+                    job = g_daily_summary->getSummaryJob(id);
+                }
+
+                auto formatUtc = [](std::chrono::system_clock::time_point tp) {
+                    auto time_t_val = std::chrono::system_clock::to_time_t(tp);
+                    std::ostringstream oss;
+                    oss << std::put_time(std::gmtime(&time_t_val), "%Y-%m-%dT%H:%M:%SZ");
+                    return oss.str();
+                };
+
+                if (job) {
+                    response["success"] = true;
+                    response["job_id"] = job->id;
+                    response["date"] = job->date;
+                    response["status"] = SummaryJob::stateName(job->state);
+                    response["created"] = formatUtc(job->created);
+                    if (job->state != SummaryJob::State::Queued) {
+                        response["started"] = formatUtc(job->started);
+                    }
+                    if (job->done()) {
+                        response["finished"] = formatUtc(job->finished);
+                    }
+                    if (job->state == SummaryJob::State::Succeeded) {
+                        response["summary"] = job->result;
+                    } else if (job->state == SummaryJob::State::Failed) {
+                        response["message"] = job->error;
+                    }
                 } else {
-                    response["message"] = "Summary generation failed";
+                    response["success"] = false;
+                    response["message"] = "Unknown summary job: " + id;
                 }
 
                 Json::StreamWriterBuilder writer;
                 auto resp = drogon::HttpResponse::newHttpResponse();
-                resp->setStatusCode(result ? drogon::k200OK : drogon::k500InternalServerError);
+                resp->setStatusCode(job ? drogon::k200OK : drogon::k404NotFound);
                 resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
                 resp->setBody(Json::writeString(writer, response));
                 callback(resp);
             },
-            {drogon::Post}
+            {drogon::Get}
+        );
+
+        // Setup fleet snapshot endpoint: every device's current state in one response,
+        // JSON, CBOR or MessagePack by Accept header, with ETag revalidation
+        drogon::app().registerHandler(
+            "/devices",
+            [](const drogon::HttpRequestPtr& req,
+               std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+                auto format = negotiateWireFormat(req->getHeader("Accept"));
+                if (!format || !g_collector) {
+                    auto resp = drogon::HttpResponse::newHttpResponse();
+                    resp->setStatusCode(format ? drogon::k503ServiceUnavailable : drogon::k406NotAcceptable);
+                    resp->setContentTypeCode(drogon::CT_TEXT_PLAIN);
+                    resp->setBody(format ? "Collector not running\n"
+                                         : "Supported: application/json, application/cbor, application/msgpack\n");
+                    callback(resp);
+                    return;
+                }
+
+                std::string body;
+                body.reserve(static_cast<size_t>(g_collector->getDeviceCount()) * 512 + 64);
+                CompactWriter writer(*format, body);
+                g_collector->encodeSnapshots(writer);
+
+                // Content hash: identical fleet state => identical tag (per format)
+                std::ostringstream tag;
+                tag << "\"" << std::hex << std::setw(16) << std::setfill('0') << fnv1a64(body) << "\"";
+                std::string etag = tag.str();
+
+                bool not_modified = false;
+                std::string_view if_none_match = req->getHeader("If-None-Match");
+                while (!if_none_match.empty() && !not_modified) {
+                    size_t comma = if_none_match.find(',');
+                    std::string_view candidate = if_none_match.substr(0, comma);
+                    if_none_match = comma == std::string_view::npos ? std::string_view()
+                                                                    : if_none_match.substr(comma + 1);
+                    while (!candidate.empty() && candidate.front() == ' ') candidate.remove_prefix(1);
+                    while (!candidate.empty() && candidate.back() == ' ') candidate.remove_suffix(1);
+                    if (candidate.substr(0, 2) == "W/") candidate.remove_prefix(2);
+                    not_modified = candidate == "*" || candidate == etag;
+                }
+
+                auto resp = drogon::HttpResponse::newHttpResponse();
+                resp->addHeader("ETag", etag);
+                resp->addHeader("Vary", "Accept");
+                resp->addHeader("Cache-Control", "no-cache");
+                if (not_modified) {
+                    resp->setStatusCode(drogon::k304NotModified);
+                } else {
+                    resp->setStatusCode(drogon::k200OK);
+                    resp->setContentTypeString(wireFormatContentType(*format));
+                    resp->setBody(std::move(body));
+                }
+                callback(resp);
+            },
+            {drogon::Get}
+        );
+
+        // Setup bulk export endpoint: ups_metrics rows streamed from a server-side
+        // cursor by an export worker that writes the chunked response itself
+        // GET /export?device=<id>&from=<time>&to=<time>&format=csv|ndjson
+        g_exports = std::make_unique<ExportService>(
+            [](const ExportRequest& request, size_t batch_rows, const ExportRowCallback& on_row) {
+                return DatabaseService::getInstance().streamUpsMetrics(
+                    request.device_identifier, request.from, request.to, on_row, batch_rows);
+            },
+            DatabaseService::exportColumns(),
+            export_config);
+        drogon::app().registerHandler(
+            "/export",
+            [](const drogon::HttpRequestPtr& req,
+               std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+                // Shared with the export worker, which answers everything past validation
+                auto respond = std::make_shared<std::function<void(const drogon::HttpResponsePtr&)>>(std::move(callback));
+                auto reply = [respond](drogon::HttpStatusCode code, const std::string& message) {
+                    auto resp = drogon::HttpResponse::newHttpResponse();
+                    resp->setStatusCode(code);
+                    resp->setContentTypeCode(drogon::CT_TEXT_PLAIN);
+                    resp->setBody(message + "\n");
+                    (*respond)(resp);
+                };
+
+                ExportRequest request;
+                std::string device = req->getParameter("device");
+                auto format = parseExportFormat(req->getParameter("format").empty() ? "csv" : req->getParameter("format"));
+                auto from = parseUtcTimestamp(req->getParameter("from"));
+                auto to = parseUtcTimestamp(req->getParameter("to"));
+                if (device.empty() || !format || !from || !to || *from >= *to) {
+                    reply(drogon::k400BadRequest,
+                          "Usage: /export?device=<id>&from=<time>&to=<time>&format=csv|ndjson "
+                          "(time: ms since epoch, YYYY-MM-DD or YYYY-MM-DDTHH:MM:SSZ; from < to)");
+                    return;
+                }
+                request.device_identifier = DeviceMapper::getDbIdentifier(device);
+                request.from = *from;
+                request.to = *to;
+                request.format = *format;
+                request.gzip = req->getHeader("Accept-Encoding").find("gzip") != std::string::npos;
+
+                if (!DatabaseService::getInstance().isConnected()) {
+                    reply(drogon::k503ServiceUnavailable, "Database not connected");
+                    return;
+                }
+
+                // The device lookup, the response and every chunk happen on the
+                // export worker; this loop only queues the request
+                std::weak_ptr<trantor::TcpConnection> conn = req->getConnectionPtr();
+                bool started = g_exports && g_exports->begin(std::move(request),
+                    [device, conn, respond, reply](const ExportRequest& request) -> std::shared_ptr<ExportSink> {
+                        if (!DatabaseService::getInstance().getDeviceId(request.device_identifier)) {
+                            reply(drogon::k404NotFound, "Unknown device: " + device);
+                            return nullptr;
+                        }
+
+                        // Drogon hands the stream over on its loop once the headers are out
+                        struct Opened {
+                            std::mutex mutex;
+                            std::condition_variable cv;
+                            drogon::ResponseStreamPtr stream;
+                        };
+                        auto opened = std::make_shared<Opened>();
+                        auto resp = drogon::HttpResponse::newAsyncStreamResponse(
+                            [opened](drogon::ResponseStreamPtr stream) {
+                                std::lock_guard<std::mutex> lock(opened->mutex);
+                                opened->stream = std::move(stream);
+                                opened->cv.notify_all();
+                            });
+                        resp->setContentTypeString(request.format == ExportFormat::Csv
+                            ? "text/csv; charset=utf-8" : "application/x-ndjson");
+                        resp->addHeader("Content-Disposition", "attachment; filename=\"" + request.device_identifier +
+                                        (request.format == ExportFormat::Csv ? ".csv" : ".ndjson") + "\"");
+                        if (request.gzip) {
+                            resp->addHeader("Content-Encoding", "gzip");
+                        }
+                        resp->addHeader("Vary", "Accept-Encoding");
+                        (*respond)(resp);
+
+                        std::shared_ptr<drogon::ResponseStream> stream;
+                        {
+                            std::unique_lock<std::mutex> lock(opened->mutex);
+                            if (!opened->cv.wait_for(lock, std::chrono::seconds(30), [&] { return opened->stream != nullptr; })) {
+                                return nullptr;  // Client left before the headers went out
+                            }
+                            stream = std::move(opened->stream);
+                        }
+
+                        auto backlog = std::make_shared<StreamBacklog>(conn);
+                        const ExportConfig& limits = g_exports->getConfig();
+                        return std::make_shared<PushExportSink>(
+                            [stream, backlog](const std::string& chunk) {
+                                backlog->handed(chunk.size());
+                                return stream->send(chunk);
+                            },
+                            [stream] { stream->close(); },
+                            [backlog] { return backlog->unsent(); },
+                            limits.buffer_bytes, limits.stall_timeout);
+                    });
+                if (!started) {
+                    reply(drogon::k503ServiceUnavailable, "Too many exports running, retry later");
+                }
+            },
+            {drogon::Get}
+        );
+
+        // Setup in-memory history endpoint (raw tier, no database access)
+        // GET /devices/{id}/history?since=<ms since epoch>&fields=input_voltage,load_percentage
+        drogon::app().registerHandler(
+            "/devices/{id}/history",
+            [](const drogon::HttpRequestPtr& req,
+               std::function<void(const drogon::HttpResponsePtr&)>&& callback,
+               const std::string& id) {
+
+                Json::Value response;
+                Json::StreamWriterBuilder writer;
+                writer["indentation"] = "";
+                writer["precision"] = 6;  // Samples are floats
+
+                auto reply = [&](drogon::HttpStatusCode code, const std::string& message) {
+                    response["success"] = false;
+                    response["message"] = message;
+                    auto resp = drogon::HttpResponse::newHttpResponse();
+                    resp->setStatusCode(code);
+                    resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+                    resp->setBody(Json::writeString(writer, response));
+                    callback(resp);
+                };
+
+                if (!g_collector || g_collector->getTierConfig().raw_window_seconds <= 0) {
+                    reply(drogon::k503ServiceUnavailable, "Raw history disabled (COLLECTOR_RAW_WINDOW=0)");
+                    return;
+                }
+
+                int64_t since_ms = 0;
+                const std::string& since = req->getParameter("since");
+                if (!since.empty()) {
+                    auto [end, ec] = std::from_chars(since.data(), since.data() + since.size(), since_ms);
+                    if (ec != std::errc() || end != since.data() + since.size()) {
+                        reply(drogon::k400BadRequest, "since must be milliseconds since the epoch");
+                        return;
+                    }
+                }
+
+                auto metrics = parseMetricList(req->getParameter("fields"));
+                if (!metrics) {
+                    reply(drogon::k400BadRequest, "Unknown field in fields");
+                    return;
+                }
+
+                SampleSeries series;
+                if (!g_collector->getHistory(id, since_ms, *metrics, series)) {
+                    reply(drogon::k404NotFound, "Unknown device: " + id);
+                    return;
+                }
+
+                response["device"] = id;
+                response["since"] = static_cast<Json::Int64>(since_ms);
+                response["count"] = static_cast<Json::UInt64>(series.timestamps.size());
+
+                Json::Value timestamps(Json::arrayValue);
+                for (int64_t ts : series.timestamps) {
+                    timestamps.append(static_cast<Json::Int64>(ts));
+                }
+                response["timestamps"] = std::move(timestamps);
+
+                // Columnar like the ring: one array per field, null = not reported yet
+                Json::Value fields(Json::objectValue);
+                for (size_t k = 0; k < series.metrics.size(); ++k) {
+                    Json::Value column(Json::arrayValue);
+                    for (float value : series.columns[k]) {
+                        column.append(std::isnan(value) ? Json::Value() : Json::Value(value));
+                    }
+                    fields[metricName(series.metrics[k])] = std::move(column);
+                }
+                response["fields"] = std::move(fields);
+
+                auto resp = drogon::HttpResponse::newHttpResponse();
+                resp->setStatusCode(drogon::k200OK);
+                resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+                resp->setBody(Json::writeString(writer, response));
+                callback(resp);
+            },
+            {drogon::Get}
+        );
+
+        // Database reads behind HTTP endpoints run here, never on a Drogon IO loop
+        g_queries = std::make_unique<TaskQueue>("Queries", static_cast<size_t>(query_threads),
+                                                static_cast<size_t>(query_queue));
+        g_queries->start();
+
+        // Setup downsampled series endpoint: finest tier covering the range, LTTB to `points`
+        // GET /devices/{id}/series?field=input_voltage&from=<time>&to=<time>&points=500
+        drogon::app().registerHandler(
+            "/devices/{id}/series",
+            [](const drogon::HttpRequestPtr& req,
+               std::function<void(const drogon::HttpResponsePtr&)>&& callback,
+               const std::string& id) {
+
+                Json::Value response;
+                Json::StreamWriterBuilder writer;
+                writer["indentation"] = "";
+                writer["precision"] = 6;
+
+                auto reply = [&](drogon::HttpStatusCode code, const std::string& message) {
+                    response["success"] = false;
+                    response["message"] = message;
+                    auto resp = drogon::HttpResponse::newHttpResponse();
+                    resp->setStatusCode(code);
+                    resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+                    resp->setBody(Json::writeString(writer, response));
+                    callback(resp);
+                };
+
+                auto toEpochMs = [](std::chrono::system_clock::time_point tp) {
+                    return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                        tp.time_since_epoch()).count());
+                };
+
+                auto metric = findMetric(req->getParameter("field"));
+                auto now = std::chrono::system_clock::now();
+                const std::string& from_param = req->getParameter("from");
+                const std::string& to_param = req->getParameter("to");
+                auto from = from_param.empty() ? std::optional(now - std::chrono::hours(24)) : parseUtcTimestamp(from_param);
+                auto to = to_param.empty() ? std::optional(now) : parseUtcTimestamp(to_param);
+
+                size_t points = 500;
+                const std::string& points_param = req->getParameter("points");
+                if (!points_param.empty()) {
+                    auto [end, ec] = std::from_chars(points_param.data(), points_param.data() + points_param.size(), points);
+                    if (ec != std::errc() || end != points_param.data() + points_param.size()) {
+                        points = 0;
+                    }
+                }
+
+                if (!metric || !from || !to || *from >= *to || points < 3 || points > 10000) {
+                    reply(drogon::k400BadRequest,
+                          "Usage: /devices/{id}/series?field=<metric>&from=<time>&to=<time>&points=3..10000 "
+                          "(time: ms since epoch, YYYY-MM-DD or YYYY-MM-DDTHH:MM:SSZ; from < to)");
+                    return;
+                }
+
+                int64_t from_ms = toEpochMs(*from);
+                int64_t to_ms = toEpochMs(*to);
+                auto finish = [callback, writer, id, field = *metric, from_ms, to_ms](const SeriesRead& read) {
+                    Json::Value response;
+                    auto fail = [&](drogon::HttpStatusCode code, const std::string& message) {
+                        response["success"] = false;
+                        response["message"] = message;
+                        auto resp = drogon::HttpResponse::newHttpResponse();
+                        resp->setStatusCode(code);
+                        resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+                        resp->setBody(Json::writeString(writer, response));
+                        callback(resp);
+                    };
+                    switch (read.status) {
+                        case SeriesRead::Status::Ok:
+                            break;
+                        case SeriesRead::Status::UnknownDevice:
+                            fail(drogon::k404NotFound, "Unknown device: " + id);
+                            return;
+                        case SeriesRead::Status::Unavailable:
+                            fail(drogon::k503ServiceUnavailable, "Database not connected");
+                            return;
+                        case SeriesRead::Status::Failed:
+                            fail(drogon::k500InternalServerError, "Series query failed");
+                            return;
+                    }
+
+                    response["device"] = id;
+                    response["field"] = metricName(field);
+                    response["tier"] = seriesTierName(read.tier);
+                    response["from"] = static_cast<Json::Int64>(from_ms);
+                    response["to"] = static_cast<Json::Int64>(to_ms);
+                    response["source_points"] = static_cast<Json::UInt64>(read.source_points);
+                    response["points"] = static_cast<Json::UInt64>(read.points.size());
+
+                    Json::Value timestamps(Json::arrayValue);
+                    Json::Value values(Json::arrayValue);
+                    for (const auto& point : read.points) {
+                        timestamps.append(static_cast<Json::Int64>(point.timestamp_ms));
+                        values.append(point.value);
+                    }
+                    response["timestamps"] = std::move(timestamps);
+                    response["values"] = std::move(values);
+
+                    auto resp = drogon::HttpResponse::newHttpResponse();
+                    resp->setStatusCode(drogon::k200OK);
+                    resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+                    resp->setBody(Json::writeString(writer, response));
+                    callback(resp);
+                };
+
+                // Raw rings are in memory; every other tier is a database read
+                SeriesTier tier = seriesTierFor(from_ms, to_ms);
+                if (tier == SeriesTier::Raw) {
+                    finish(readSeriesTier(tier, id, *metric, from_ms, to_ms, points));
+                    return;
+                }
+                bool queued = g_queries && g_queries->submit(
+                    [finish, tier, id, field = *metric, from_ms, to_ms, points] {
+                        finish(readSeriesTier(tier, id, field, from_ms, to_ms, points));
+                    });
+                if (!queued) {
+                    reply(drogon::k503ServiceUnavailable, "Too many queries queued, retry later");
+                }
+            },
+            {drogon::Get}
+        );
+
+        // Setup Grafana JSON datasource (datasource URL: http://<host>:<port>/grafana)
+        // Series come from the ring / rollup tiers, annotations from power_events
+        auto grafana = std::make_shared<GrafanaDatasource>(
+            []() { return g_collector ? g_collector->getDeviceIds() : std::vector<std::string>{}; },
+            readSeries,
+            [](const std::string& device, int64_t from_ms, int64_t to_ms, std::vector<PowerEventRow>& out) {
+                auto& db = DatabaseService::getInstance();
+                if (!db.isConnected()) {
+                    return false;
+                }
+                std::string identifier = device.empty() ? device : DeviceMapper::getDbIdentifier(device);
+                return db.queryPowerEvents(from_ms, to_ms, identifier, out);
+            });
+
+        // Connection test ("Save & test")
+        drogon::app().registerHandler(
+            "/grafana",
+            [](const drogon::HttpRequestPtr&,
+               std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+                auto resp = drogon::HttpResponse::newHttpResponse();
+                resp->setStatusCode(drogon::k200OK);
+                resp->setContentTypeCode(drogon::CT_TEXT_PLAIN);
+                resp->setBody("OK\n");
+                callback(resp);
+            },
+            {drogon::Get}
+        );
+
+        auto grafanaHandler = [grafana](const std::string& method) {
+            return [grafana, method](const drogon::HttpRequestPtr& req,
+                                     std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+                Json::StreamWriterBuilder writer;
+                writer["indentation"] = "";
+                writer["precision"] = 6;
+
+                auto finish = [callback, writer](GrafanaResult result, Json::Value response, const std::string& error) {
+                    auto resp = drogon::HttpResponse::newHttpResponse();
+                    switch (result) {
+                        case GrafanaResult::Ok:
+                            resp->setStatusCode(drogon::k200OK);
+                            break;
+                        case GrafanaResult::BadRequest:
+                            resp->setStatusCode(drogon::k400BadRequest);
+                            break;
+                        case GrafanaResult::Unavailable:
+                            resp->setStatusCode(drogon::k503ServiceUnavailable);
+                            break;
+                        case GrafanaResult::Failed:
+                            resp->setStatusCode(drogon::k500InternalServerError);
+                            break;
+                    }
+                    if (result != GrafanaResult::Ok) {
+                        response = Json::Value();
+                        response["message"] = error;  // Shown by Grafana in the panel
+                    }
+                    resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+                    resp->setBody(Json::writeString(writer, response));
+                    callback(resp);
+                };
+
+                auto body = req->getJsonObject();
+                if (!body) {
+                    finish(GrafanaResult::BadRequest, Json::Value(), "Request body must be JSON");
+                    return;
+                }
+                if (method == "search") {
+                    finish(GrafanaResult::Ok, grafana->search(*body), "");
+                    return;
+                }
+
+                // Query targets and annotations read the database: run them on a
+                // query worker, one target after another on the same pooled connection
+                bool queued = g_queries && g_queries->submit([grafana, method, finish, request = *body] {
+                    Json::Value response;
+                    std::string error;
+                    GrafanaResult result = method == "query"
+                        ? grafana->query(request, response, error)
+                        : grafana->annotations(request, response, error);
+                    finish(result, std::move(response), error);
+                });
+                if (!queued) {
+                    finish(GrafanaResult::Unavailable, Json::Value(), "Too many queries queued, retry later");
+                }
+            };
+        };
+        drogon::app().registerHandler("/grafana/search", grafanaHandler("search"), {drogon::Post});
+        drogon::app().registerHandler("/grafana/query", grafanaHandler("query"), {drogon::Post});
+        drogon::app().registerHandler("/grafana/annotations", grafanaHandler("annotations"), {drogon::Post});
+
+        // Setup daily report endpoint: past days come pre-rendered from the report cache
+        // GET /reports/daily?date=YYYY-MM-DD&format=json|text (default: yesterday, json)
+        drogon::app().registerHandler(
+            "/reports/daily",
+            [daily_reports](const drogon::HttpRequestPtr& req,
+                            std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
+
+                auto reply = [&](drogon::HttpStatusCode code, const std::string& message) {
+                    Json::Value response;
+                    response["success"] = false;
+                    response["message"] = message;
+                    Json::StreamWriterBuilder writer;
+                    writer["indentation"] = "";
+                    auto resp = drogon::HttpResponse::newHttpResponse();
+                    resp->setStatusCode(code);
+                    resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+                    resp->setBody(Json::writeString(writer, response));
+                    callback(resp);
+                };
+
+                auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                std::string today = localDate(now_ms);
+                std::string date = req->getParameter("date");
+                if (date.empty()) {
+                    date = localDate(now_ms - 24 * 3600 * 1000LL);
+                }
+                const std::string& format = req->getParameter("format");
+
+                int64_t start_ms = 0;
+                int64_t end_ms = 0;
+                if (!localDayRange(date, start_ms, end_ms) ||
+                    (!format.empty() && format != "json" && format != "text")) {
+                    reply(drogon::k400BadRequest, "Usage: /reports/daily?date=YYYY-MM-DD&format=json|text");
+                    return;
+                }
+
+                auto send = [callback, date, today, text = format == "text"](
+                                const std::shared_ptr<const DailyReport>& report) {
+                    auto resp = drogon::HttpResponse::newHttpResponse();
+                    if (!report) {
+                        Json::Value response;
+                        response["success"] = false;
+                        response["message"] = "Daily metrics unavailable for " + date;
+                        Json::StreamWriterBuilder writer;
+                        writer["indentation"] = "";
+                        resp->setStatusCode(drogon::k503ServiceUnavailable);
+                        resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+                        resp->setBody(Json::writeString(writer, response));
+                        callback(resp);
+                        return;
+                    }
+
+                    resp->setStatusCode(drogon::k200OK);
+                    if (text) {
+                        resp->setContentTypeCode(drogon::CT_TEXT_PLAIN);
+                        resp->setBody(report->text);
+                    } else {
+                        resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+                        resp->setBody(report->json);
+                    }
+                    // A finished day with data never changes; today's report grows until midnight
+                    bool final_day = date < today && !report->metrics.empty();
+                    resp->addHeader("Cache-Control", final_day ? "public, max-age=86400" : "no-cache");
+                    callback(resp);
+                };
+
+                // Cached days are answered here; building one queries the database
+                if (auto cached = daily_reports->getCached(date, today)) {
+                    send(cached);
+                    return;
+                }
+                bool queued = g_queries && g_queries->submit([daily_reports, send, date, today] {
+                    send(daily_reports->get(date, today));
+                });
+                if (!queued) {
+                    reply(drogon::k503ServiceUnavailable, "Too many queries queued, retry later");
+                }
+            },
+            {drogon::Get}
         );
 
         // Configure Drogon
         drogon::app().addListener("0.0.0.0", health_check_port);
-        drogon::app().setThreadNum(1);  // Minimal threads for health check
+        // Exports and database reads run on workers, so the loops only parse and reply
+        drogon::app().setThreadNum(static_cast<size_t>(http_threads));
         drogon::app().setLogLevel(trantor::Logger::kWarn);  // Reduce verbosity
 
         std::cout << "✅ HMS-NUT started successfully" << std::endl;
@@ -1,4 +1,6 @@
 #include "mqtt/DiscoveryPublisher.h"
+#include "nut/SensorSchema.h"
+#include "utils/Hash.h"
 #include <iostream>
 
 namespace hms_nut {
@@ -13,6 +15,7 @@ DiscoveryPublisher::DiscoveryPublisher(std::shared_ptr<MqttClient> mqtt_client,
       device_name_(device_name),
       manufacturer_(manufacturer),
       model_(model) {
+    renderAll();
 }
 
 Json::Value DiscoveryPublisher::buildDeviceInfo() const {
@@ -25,15 +28,24 @@ Json::Value DiscoveryPublisher::buildDeviceInfo() const {
     return device;
 }
 
-bool DiscoveryPublisher::publishSensorConfig(const std::string& sensor_id,
-                                              const std::string& name,
-                                              const std::string& unit_of_measurement,
-                                              const std::string& device_class,
-                                              const std::string& state_class,
-                                              const std::string& icon) {
-    // Build discovery topic
-    std::string topic = "homeassistant/sensor/" + device_id_ + "/" + sensor_id + "/config";
+DiscoveryMessage DiscoveryPublisher::makeMessage(std::string topic, const Json::Value& config) const {
+    // Serialize to JSON string
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";  // Compact JSON
+
+    DiscoveryMessage message;
+    message.topic = std::move(topic);
+    message.payload = Json::writeString(writer, config);
+    message.hash = fnv1a64(message.payload);
+    return message;
+}
 
+DiscoveryMessage DiscoveryPublisher::renderSensorConfig(const std::string& sensor_id,
+                                                        const std::string& name,
+                                                        const std::string& unit_of_measurement,
+                                                        const std::string& device_class,
+                                                        const std::string& state_class,
+                                                        const std::string& icon) const {
     // Build config JSON
     Json::Value config;
     config["name"] = name;
@@ -57,22 +69,13 @@ bool DiscoveryPublisher::publishSensorConfig(const std::string& sensor_id,
         config["icon"] = icon;
     }
 
-    // Serialize to JSON string
-    Json::StreamWriterBuilder writer;
-    writer["indentation"] = "";  // Compact JSON
-    std::string payload = Json::writeString(writer, config);
-
-    // Publish (retained, QoS 1)
-    return mqtt_client_->publish(topic, payload, 1, true);
+    return makeMessage("homeassistant/sensor/" + device_id_ + "/" + sensor_id + "/config", config);
 }
 
-bool DiscoveryPublisher::publishBinarySensorConfig(const std::string& sensor_id,
-                                                    const std::string& name,
-                                                    const std::string& device_class,
-                                                    const std::string& icon) {
-    // Build discovery topic
-    std::string topic = "homeassistant/binary_sensor/" + device_id_ + "/" + sensor_id + "/config";
-
+DiscoveryMessage DiscoveryPublisher::renderBinarySensorConfig(const std::string& sensor_id,
+                                                              const std::string& name,
+                                                              const std::string& device_class,
+                                                              const std::string& icon) const {
     // Build config JSON
     Json::Value config;
     config["name"] = name;
@@ -90,61 +93,78 @@ bool DiscoveryPublisher::publishBinarySensorConfig(const std::string& sensor_id,
         config["icon"] = icon;
     }
 
-    // Serialize to JSON string
-    Json::StreamWriterBuilder writer;
-    writer["indentation"] = "";
-    std::string payload = Json::writeString(writer, config);
+    return makeMessage("homeassistant/binary_sensor/" + device_id_ + "/" + sensor_id + "/config", config);
+}
+
+void DiscoveryPublisher::renderAll() {
+    messages_.clear();
+    messages_.reserve(kSensorCount);
+
+    for (const auto& sensor : SensorSchema::all()) {
+        if (sensor.kind == SensorKind::Binary) {
+            messages_.push_back(renderBinarySensorConfig(sensor.id, sensor.name, sensor.device_class, sensor.icon));
+        } else {
+            messages_.push_back(renderSensorConfig(sensor.id, sensor.name, sensor.unit,
+                                                   sensor.device_class, sensor.state_class, sensor.icon));
+        }
+    }
+}
+
+void DiscoveryPublisher::enableRetainedTracking() {
+    auto callback = [this](const std::string& topic, const std::string& payload) {
+        onRetainedConfig(topic, payload);
+    };
 
-    // Publish (retained, QoS 1)
-    return mqtt_client_->publish(topic, payload, 1, true);
+    mqtt_client_->subscribe("homeassistant/sensor/" + device_id_ + "/+/config", callback, 1);
+    mqtt_client_->subscribe("homeassistant/binary_sensor/" + device_id_ + "/+/config", callback, 1);
 }
 
-bool DiscoveryPublisher::publishAll() {
+void DiscoveryPublisher::onRetainedConfig(const std::string& topic, const std::string& payload) {
+    std::lock_guard<std::mutex> lock(broker_state_mutex_);
+
+    if (payload.empty()) {
+        // Empty retained message = config deleted on the broker
+        broker_state_.erase(topic);
+        return;
+    }
+
+    broker_state_[topic] = {fnv1a64(payload), mqtt_client_->getConnectionEpoch()};
+}
+
+bool DiscoveryPublisher::isHeldByBroker(const DiscoveryMessage& message) const {
+    std::lock_guard<std::mutex> lock(broker_state_mutex_);
+
+    auto it = broker_state_.find(message.topic);
+    if (it == broker_state_.end()) {
+        return false;
+    }
+
+    // Only trust what we saw on the current connection - the broker may have
+    // restarted (and lost its retained store) while we were disconnected
+    return it->second.hash == message.hash &&
+           it->second.epoch == mqtt_client_->getConnectionEpoch();
+}
+
+bool DiscoveryPublisher::publishAll(bool force) {
     std::cout << "📡 Discovery: Publishing all sensor configs for " << device_name_ << std::endl;
 
     bool all_success = true;
+    int skipped = 0;
+
+    for (const auto& message : messages_) {
+        if (!force && isHeldByBroker(message)) {
+            ++skipped;
+            continue;
+        }
+
+        // Publish (retained, QoS 1)
+        all_success &= mqtt_client_->publish(message.topic, message.payload, 1, true);
+    }
 
-    // Battery metrics
-    all_success &= publishSensorConfig("battery_charge", "Battery Charge", "%", "battery", "measurement");
-    all_success &= publishSensorConfig("battery_voltage", "Battery Voltage", "V", "voltage", "measurement");
-    all_success &= publishSensorConfig("battery_runtime", "Battery Runtime", "min", "duration", "measurement", "mdi:timer-outline");
-    all_success &= publishSensorConfig("battery_nominal_voltage", "Battery Nominal Voltage", "V", "voltage", "measurement");
-    all_success &= publishSensorConfig("battery_low_charge_threshold", "Battery Low Charge Threshold", "%", "battery", "measurement");
-    all_success &= publishSensorConfig("battery_warning_charge_threshold", "Battery Warning Charge Threshold", "%", "battery", "measurement");
-
-    // Input metrics
-    all_success &= publishSensorConfig("input_voltage", "Input Voltage", "V", "voltage", "measurement");
-    all_success &= publishSensorConfig("input_nominal_voltage", "Input Nominal Voltage", "V", "voltage", "measurement");
-    all_success &= publishSensorConfig("high_voltage_transfer", "High Voltage Transfer", "V", "voltage", "measurement");
-    all_success &= publishSensorConfig("low_voltage_transfer", "Low Voltage Transfer", "V", "voltage", "measurement");
-    all_success &= publishSensorConfig("input_sensitivity", "Input Sensitivity", "", "", "", "mdi:tune");
-    all_success &= publishSensorConfig("last_transfer_reason", "Last Transfer Reason", "", "", "", "mdi:information-outline");
-
-    // Load & status
-    all_success &= publishSensorConfig("load_percentage", "Load", "%", "power_factor", "measurement", "mdi:gauge");
-    all_success &= publishSensorConfig("load_watts", "Load Power", "W", "power", "measurement");
-    all_success &= publishSensorConfig("ups_status", "UPS Status", "", "", "", "mdi:information");
-
-    // Binary sensors
-    all_success &= publishBinarySensorConfig("power_failure", "Power Failure", "power", "mdi:power-plug-off");
-
-    // UPS info
-    all_success &= publishSensorConfig("ups_nominal_power", "Nominal Power", "W", "power", "measurement");
-    all_success &= publishSensorConfig("beeper_status", "Beeper Status", "", "", "", "mdi:volume-high");
-    all_success &= publishSensorConfig("self_test_result", "Self Test Result", "", "", "", "mdi:clipboard-check");
-    all_success &= publishSensorConfig("firmware_version", "Firmware Version", "", "", "", "mdi:chip");
-
-    // Driver info
-    all_success &= publishSensorConfig("driver_name", "Driver Name", "", "", "", "mdi:application");
-    all_success &= publishSensorConfig("driver_version", "Driver Version", "", "", "", "mdi:tag");
-    all_success &= publishSensorConfig("driver_state", "Driver State", "", "", "", "mdi:state-machine");
-
-    // Temperature (if available)
-    all_success &= publishSensorConfig("temperature", "Temperature", "°C", "temperature", "measurement");
-
-    // Output voltage
-    all_success &= publishSensorConfig("output_voltage", "Output Voltage", "V", "voltage", "measurement");
-    all_success &= publishSensorConfig("output_nominal_voltage", "Output Nominal Voltage", "V", "voltage", "measurement");
+    if (skipped > 0) {
+        std::cout << "📡 Discovery: Skipped " << skipped << "/" << messages_.size()
+                  << " configs already retained on broker" << std::endl;
+    }
 
     if (all_success) {
         std::cout << "✅ Discovery: All sensor configs published successfully" << std::endl;
@@ -160,27 +180,18 @@ bool DiscoveryPublisher::removeDevice() {
 
     bool all_success = true;
 
-    // List of all sensor IDs
-    std::vector<std::string> sensor_ids = {
-        "battery_charge", "battery_voltage", "battery_runtime",
-        "battery_nominal_voltage", "battery_low_charge_threshold", "battery_warning_charge_threshold",
-        "input_voltage", "input_nominal_voltage", "high_voltage_transfer", "low_voltage_transfer",
-        "input_sensitivity", "last_transfer_reason",
-        "load_percentage", "load_watts", "ups_status",
-        "ups_nominal_power", "beeper_status", "self_test_result", "firmware_version",
-        "driver_name", "driver_version", "driver_state",
-        "temperature", "output_voltage", "output_nominal_voltage"
-    };
-
-    // Regular sensors
-    for (const auto& sensor_id : sensor_ids) {
-        std::string topic = "homeassistant/sensor/" + device_id_ + "/" + sensor_id + "/config";
-        all_success &= mqtt_client_->publish(topic, "", 1, true);  // Empty retained message
+    for (const auto& message : messages_) {
+        all_success &= mqtt_client_->publish(message.topic, "", 1, true);  // Empty retained message
     }
 
-    // Binary sensors
-    std::string binary_topic = "homeassistant/binary_sensor/" + device_id_ + "/power_failure/config";
-    all_success &= mqtt_client_->publish(binary_topic, "", 1, true);
+    // Clear retained state left by sensors whose publish policy retains
+    for (size_t i = 0; i < kSensorCount; ++i) {
+        Sensor sensor = static_cast<Sensor>(i);
+        if (SensorSchema::policy(sensor).retain) {
+            std::string topic = "homeassistant/sensor/" + device_id_ + "/" + SensorSchema::get(sensor).id + "/state";
+            all_success &= mqtt_client_->publish(topic, "", 1, true);
+        }
+    }
 
     if (all_success) {
         std::cout << "✅ Discovery: Device removed from Home Assistant" << std::endl;
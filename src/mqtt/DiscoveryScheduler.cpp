@@ -0,0 +1,194 @@
+#include "mqtt/DiscoveryScheduler.h"
+#include "utils/TokenBucket.h"
+#include <algorithm>
+#include <iostream>
+
+namespace hms_nut {
+
+DiscoveryScheduler::DiscoveryScheduler(std::shared_ptr<MqttClient> mqtt_client,
+                                       const DiscoverySchedulerConfig& config)
+    : mqtt_client_(mqtt_client),
+      config_(config) {
+    std::cout << "📡 Discovery Scheduler: Initialized (window: " << config_.window_seconds
+              << "s, max rate: " << config_.max_rate << "/s)" << std::endl;
+}
+
+DiscoveryScheduler::~DiscoveryScheduler() {
+    stop();
+}
+
+void DiscoveryScheduler::start() {
+    if (running_) {
+        return;
+    }
+
+    running_ = true;
+    worker_thread_ = std::thread(&DiscoveryScheduler::runLoop, this);
+}
+
+void DiscoveryScheduler::stop() {
+    if (!running_) {
+        return;
+    }
+
+    running_ = false;
+    cv_.notify_all();
+
+    if (worker_thread_.joinable()) {
+        worker_thread_.join();
+    }
+}
+
+void DiscoveryScheduler::registerPublisher(std::shared_ptr<DiscoveryPublisher> publisher, int priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    publishers_.push_back({std::move(publisher), priority});
+    std::stable_sort(publishers_.begin(), publishers_.end(),
+                     [](const Entry& a, const Entry& b) { return a.priority < b.priority; });
+    progress_.devices = publishers_.size();
+}
+
+void DiscoveryScheduler::unregisterPublisher(const std::shared_ptr<DiscoveryPublisher>& publisher) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    publishers_.erase(std::remove_if(publishers_.begin(), publishers_.end(),
+                                     [&](const Entry& e) { return e.publisher == publisher; }),
+                      publishers_.end());
+    progress_.devices = publishers_.size();
+}
+
+void DiscoveryScheduler::requestRepublish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (progress_.in_progress || republish_requested_) {
+            ++progress_.requests_coalesced;
+            return;
+        }
+        republish_requested_ = true;
+    }
+    cv_.notify_all();
+}
+
+DiscoveryRepublishProgress DiscoveryScheduler::getProgress() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return progress_;
+}
+
+void DiscoveryScheduler::runLoop() {
+    std::cout << "🔄 Discovery Scheduler: Worker thread started" << std::endl;
+
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return republish_requested_ || !running_; });
+            if (!running_) {
+                break;
+            }
+            republish_requested_ = false;
+        }
+
+        runRepublish();
+    }
+
+    std::cout << "🔄 Discovery Scheduler: Worker thread stopped" << std::endl;
+}
+
+void DiscoveryScheduler::runRepublish() {
+    // Snapshot the work list: (publisher, config index) in priority order
+    std::vector<std::pair<std::shared_ptr<DiscoveryPublisher>, size_t>> work;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : publishers_) {
+            for (size_t i = 0; i < entry.publisher->getMessages().size(); ++i) {
+                work.emplace_back(entry.publisher, i);
+            }
+        }
+    }
+
+    double window = std::max(config_.window_seconds, 1);
+    // max_rate wins over min_rate if misconfigured (std::clamp needs lo <= hi)
+    double hi = config_.max_rate;
+    double lo = std::min(config_.min_rate, hi);
+    double rate = std::clamp(work.size() / window, lo, hi);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        progress_.in_progress = true;
+        ++progress_.runs_started;
+        progress_.total = work.size();
+        progress_.published = 0;
+        progress_.skipped = 0;
+        progress_.failed = 0;
+        progress_.rate = rate;
+        progress_.last_started = std::chrono::system_clock::now();
+    }
+
+    std::cout << "📡 Discovery Scheduler: Republishing " << work.size() << " configs at "
+              << rate << "/s" << std::endl;
+
+    TokenBucket bucket(rate, config_.burst);
+    bool aborted = false;
+
+    for (const auto& [publisher, index] : work) {
+        if (!running_ || !mqtt_client_->isConnected()) {
+            aborted = true;
+            break;
+        }
+
+        const DiscoveryMessage& message = publisher->getMessages()[index];
+
+        // Already retained on the broker - no token needed
+        if (publisher->isHeldByBroker(message)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++progress_.skipped;
+            continue;
+        }
+
+        // Wait for a token (wakes early on stop)
+        while (running_) {
+            auto now = TokenBucket::Clock::now();
+            auto wait = bucket.timeUntilAvailable(now);
+            if (wait == TokenBucket::Clock::duration::zero() && bucket.tryAcquire(now)) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, wait, [this] { return !running_; });
+        }
+        if (!running_) {
+            aborted = true;
+            break;
+        }
+
+        bool ok = mqtt_client_->publish(message.topic, message.payload, 1, true);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (ok) {
+            ++progress_.published;
+        } else {
+            ++progress_.failed;
+        }
+    }
+
+    DiscoveryRepublishProgress done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        progress_.in_progress = false;
+        if (aborted) {
+            ++progress_.runs_aborted;
+        } else {
+            ++progress_.runs_completed;
+            progress_.last_completed = std::chrono::system_clock::now();
+        }
+        done = progress_;
+    }
+
+    if (aborted) {
+        std::cerr << "⚠️  Discovery Scheduler: Republish aborted after " << done.published
+                  << "/" << done.total << " configs (MQTT disconnected or stopping)" << std::endl;
+    } else {
+        std::cout << "✅ Discovery Scheduler: Republish complete (" << done.published << " published, "
+                  << done.skipped << " skipped, " << done.failed << " failed)" << std::endl;
+    }
+}
+
+}  // namespace hms_nut
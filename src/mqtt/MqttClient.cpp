@@ -1,25 +1,83 @@
 #include "mqtt/MqttClient.h"
+#include "utils/TokenBucket.h"
+#include "utils/Metrics.h"
 #include <iostream>
-#include <sstream>
 #include <algorithm>
+#include <charconv>
+#include <string_view>
 
 namespace hms_nut {
 
-MqttClient::MqttClient(const std::string& client_id)
+namespace {
+    struct MqttMetrics {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        Histogram& publish = registry.histogram(
+            "hms_nut_mqtt_publish_seconds", "Time to hand one message to the MQTT client");
+        Histogram& dispatch = registry.histogram(
+            "hms_nut_mqtt_dispatch_seconds", "Time spent in subscription callbacks per message");
+        Counter& received = registry.counter(
+            "hms_nut_mqtt_messages_received_total", "Messages received on subscribed topics");
+        Counter& publish_errors = registry.counter(
+            "hms_nut_mqtt_publish_errors_total", "Messages the MQTT client refused");
+    };
+
+    MqttMetrics& metrics() {
+        static MqttMetrics m;
+        return m;
+    }
+
+    /**
+     * Sample time from the "ts" user property (MQTT v5), 0 if absent or malformed
+     */
+    int64_t sampleTimestamp(const mqtt::message& msg) {
+        const mqtt::properties& props = msg.get_properties();
+        size_t count = props.count(mqtt::property::USER_PROPERTY);
+        for (size_t i = 0; i < count; ++i) {
+            auto [key, value] = mqtt::get<mqtt::string_pair>(props, mqtt::property::USER_PROPERTY, i);
+            if (key != "ts") {
+                continue;
+            }
+            int64_t ts_ms = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), ts_ms);
+            return (ec == std::errc() && end == value.data() + value.size() && ts_ms > 0) ? ts_ms : 0;
+        }
+        return 0;
+    }
+}
+
+MqttClient::MqttClient(const std::string& client_id, const PublishQueueConfig& queue_config)
     : client_id_(client_id),
-      connected_(false),
-      auto_reconnect_(true) {
-    std::cout << "📡 MQTT: Initialized with client_id: " << client_id << std::endl;
+      auto_reconnect_(true),
+      publish_queue_(queue_config) {
+    sender_running_ = true;
+    sender_thread_ = std::thread(&MqttClient::senderLoop, this);
+
+    std::cout << "📡 MQTT: Initialized with client_id: " << client_id
+              << " (queue: " << queue_config.max_messages << " msgs / "
+              << queue_config.max_bytes << " bytes, in-flight: "
+              << queue_config.max_in_flight << ")" << std::endl;
 }
 
 MqttClient::~MqttClient() {
     disconnect();
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        sender_running_ = false;
+    }
+    queue_cv_.notify_all();
+    if (sender_thread_.joinable()) {
+        sender_thread_.join();
+    }
+    if (replay_thread_.joinable()) {
+        replay_thread_.join();
+    }
 }
 
 bool MqttClient::connect(const std::string& broker_address,
                          const std::string& username,
                          const std::string& password) {
-    std::lock_guard<std::recursive_mutex> lock(connection_mutex_);
+    std::lock_guard<std::mutex> lock(connection_mutex_);
 
     broker_address_ = broker_address;
     username_ = username;
@@ -29,74 +87,216 @@ bool MqttClient::connect(const std::string& broker_address,
 
     try {
         // Create client with unique ID + timestamp
-        std::string full_client_id = client_id_ + "_" + std::to_string(std::time(nullptr));
-        client_ = std::make_unique<mqtt::async_client>(broker_address, full_client_id);
+        std::string stamp = std::to_string(std::time(nullptr));
+        auto client = createClient(client_id_ + "_" + stamp);
 
         // Set callbacks
-        client_->set_message_callback([this](mqtt::const_message_ptr msg) {
+        client->set_message_callback([this](mqtt::const_message_ptr msg) {
             onMessageArrived(msg);
         });
 
-        client_->set_connection_lost_handler([this](const std::string& cause) {
+        client->set_connection_lost_handler([this](const std::string& cause) {
             onConnectionLost(cause);
         });
 
-        client_->set_connected_handler([this](const std::string& cause) {
-            if (initial_connect_done_) {
+        client->set_connected_handler([this](const std::string& cause) {
+            if (initial_connect_done_.load()) {
                 onReconnected(cause);
             }
         });
 
-        // Connection options
-        mqtt::connect_options connOpts;
-        connOpts.set_keep_alive_interval(60);  // 60 seconds keep-alive
-        connOpts.set_clean_session(true);
-        connOpts.set_user_name(username);
-        connOpts.set_password(password);
+        // Publish the new handle - threads still using the previous one keep
+        // it alive until they are done
+        state_ = ConnectionState::Connecting;
+        std::atomic_store(&client_, client);
 
-        // Enable auto-reconnect with exponential backoff
-        // Min delay: 1 second, Max delay: 64 seconds
-        connOpts.set_automatic_reconnect(1, 64);
+        // Paho's own window matches ours so it never buffers beyond the cap
+        mqtt::connect_options connOpts =
+            connectOptions(static_cast<int>(publish_queue_.getConfig().max_in_flight));
 
         // Connect (blocking)
-        mqtt::token_ptr conntok = client_->connect(connOpts);
+        mqtt::token_ptr conntok = client->connect(connOpts);
         conntok->wait();  // Wait for connection
 
-        connected_ = true;
+        if (v5_.enabled) {
+            // Broker grants aliases in CONNACK; absent means none allowed
+            const auto& props = conntok->get_connect_response().get_properties();
+            uint16_t broker_max = props.contains(mqtt::property::TOPIC_ALIAS_MAXIMUM)
+                ? mqtt::get<uint16_t>(props, mqtt::property::TOPIC_ALIAS_MAXIMUM)
+                : 0;
+            alias_capacity_ = std::min(broker_max, v5_.max_topic_aliases);
+            topic_aliases_.reset(alias_capacity_.load());
+            std::cout << "📡 MQTT: v5 session, topic aliases: " << alias_capacity_.load()
+                      << " (broker max " << broker_max << ")" << std::endl;
+        }
+
+        in_flight_ = 0;  // New session - nothing outstanding
+        if (!split_sessions_) {
+            ++connection_epoch_;  // Split: retained state is tracked on the subscriber session
+        }
         initial_connect_done_ = true;
+        state_ = ConnectionState::Connected;
         std::cout << "✅ MQTT: Connected successfully" << std::endl;
 
-        return true;
+        queue_cv_.notify_all();  // Start draining anything queued while offline
 
     } catch (const mqtt::exception& e) {
         std::cerr << "❌ MQTT: Connection failed: " << e.what() << std::endl;
-        connected_ = false;
+        state_ = ConnectionState::Disconnected;
+        return false;
+    }
+
+    if (!split_sessions_) {
+        return true;
+    }
+
+    // Second session for inbound traffic - publish bursts and retained
+    // deliveries no longer queue behind each other on one socket
+    try {
+        auto subscriber = createClient(client_id_ + "_sub_" + std::to_string(std::time(nullptr)));
+
+        subscriber->set_message_callback([this](mqtt::const_message_ptr msg) {
+            onMessageArrived(msg);
+        });
+
+        subscriber->set_connection_lost_handler([this](const std::string& cause) {
+            onSubscriberConnectionLost(cause);
+        });
+
+        subscriber->set_connected_handler([this](const std::string& cause) {
+            if (subscriber_connect_done_.load()) {
+                onSubscriberReconnected(cause);
+            }
+        });
+
+        sub_state_ = ConnectionState::Connecting;
+        std::atomic_store(&sub_client_, subscriber);
+
+        subscriber->connect(connectOptions(kSubscriberMaxInFlight))->wait();
+
+        subscriber_connect_done_ = true;
+        sub_state_ = ConnectionState::Connected;
+        ++connection_epoch_;  // Retained state arrives on this session
+        std::cout << "✅ MQTT: Subscriber session connected" << std::endl;
+        return true;
+
+    } catch (const mqtt::exception& e) {
+        std::cerr << "❌ MQTT: Subscriber session failed: " << e.what() << std::endl;
+        sub_state_ = ConnectionState::Disconnected;
         return false;
     }
 }
 
+std::shared_ptr<mqtt::async_client> MqttClient::createClient(const std::string& full_client_id) const {
+    if (v5_.enabled) {
+        return std::make_shared<mqtt::async_client>(broker_address_, full_client_id,
+                                                    mqtt::create_options(MQTTVERSION_5));
+    }
+    return std::make_shared<mqtt::async_client>(broker_address_, full_client_id);
+}
+
+mqtt::connect_options MqttClient::connectOptions(int max_inflight) const {
+    mqtt::connect_options connOpts;
+    connOpts.set_keep_alive_interval(60);  // 60 seconds keep-alive
+    if (v5_.enabled) {
+        connOpts.set_mqtt_version(MQTTVERSION_5);
+        connOpts.set_clean_start(true);
+    } else {
+        connOpts.set_clean_session(true);
+    }
+    connOpts.set_user_name(username_);
+    connOpts.set_password(password_);
+
+    // Enable auto-reconnect with exponential backoff
+    // Min delay: 1 second, Max delay: 64 seconds
+    connOpts.set_automatic_reconnect(1, 64);
+
+    connOpts.set_max_inflight(max_inflight);
+    return connOpts;
+}
+
 void MqttClient::disconnect() {
-    std::lock_guard<std::recursive_mutex> lock(connection_mutex_);
+    // Give queued messages a chance to go out before the session ends
+    if (isConnected()) {
+        if (!flush(std::chrono::seconds(2))) {
+            std::cerr << "⚠️  MQTT: Disconnecting with " << getQueueStats().depth
+                      << " messages still queued" << std::endl;
+        }
+    }
 
-    if (client_ && connected_) {
+    std::lock_guard<std::mutex> lock(connection_mutex_);
+
+    auto client = std::atomic_load(&client_);
+    if (client && state_.load() == ConnectionState::Connected) {
+        state_ = ConnectionState::Disconnecting;
         try {
             std::cout << "📡 MQTT: Disconnecting..." << std::endl;
-            client_->disconnect()->wait();
-            connected_ = false;
+            client->disconnect()->wait();
             std::cout << "📡 MQTT: Disconnected" << std::endl;
         } catch (const mqtt::exception& e) {
             std::cerr << "❌ MQTT: Disconnect error: " << e.what() << std::endl;
         }
+        state_ = ConnectionState::Disconnected;
+    }
+
+    auto subscriber = std::atomic_load(&sub_client_);
+    if (subscriber && sub_state_.load() == ConnectionState::Connected) {
+        sub_state_ = ConnectionState::Disconnecting;
+        try {
+            subscriber->disconnect()->wait();
+            std::cout << "📡 MQTT: Subscriber session disconnected" << std::endl;
+        } catch (const mqtt::exception& e) {
+            std::cerr << "❌ MQTT: Subscriber disconnect error: " << e.what() << std::endl;
+        }
+        sub_state_ = ConnectionState::Disconnected;
+    }
+}
+
+void MqttClient::setSplitSessions(bool enabled) {
+    std::lock_guard<std::mutex> lock(connection_mutex_);
+    split_sessions_ = enabled;
+}
+
+bool MqttClient::isSubscriberConnected() const {
+    if (!split_sessions_) {
+        return isConnected();
     }
+    return sub_state_.load(std::memory_order_acquire) == ConnectionState::Connected;
+}
+
+std::shared_ptr<mqtt::async_client> MqttClient::subscriberClient() const {
+    return split_sessions_ ? std::atomic_load(&sub_client_) : std::atomic_load(&client_);
+}
+
+void MqttClient::setMqttV5(const MqttV5Config& config) {
+    std::lock_guard<std::mutex> lock(connection_mutex_);
+    v5_ = config;
 }
 
 bool MqttClient::isConnected() const {
-    std::lock_guard<std::recursive_mutex> lock(connection_mutex_);
-    return connected_ && client_ && client_->is_connected();
+    return state_.load(std::memory_order_acquire) == ConnectionState::Connected;
+}
+
+const char* MqttClient::connectionStateName(ConnectionState state) {
+    switch (state) {
+        case ConnectionState::Disconnected: return "disconnected";
+        case ConnectionState::Connecting: return "connecting";
+        case ConnectionState::Connected: return "connected";
+        case ConnectionState::Reconnecting: return "reconnecting";
+        case ConnectionState::Disconnecting: return "disconnecting";
+    }
+    return "unknown";
 }
 
 bool MqttClient::subscribe(const std::string& topic, MessageCallback callback, int qos) {
-    if (!isConnected()) {
+    return subscribe(topic, TimedMessageCallback(
+        [callback = std::move(callback)](const std::string& t, const std::string& payload, int64_t) {
+            callback(t, payload);
+        }), qos);
+}
+
+bool MqttClient::subscribe(const std::string& topic, TimedMessageCallback callback, int qos) {
+    if (!isSubscriberConnected()) {
         std::cerr << "❌ MQTT: Not connected, cannot subscribe" << std::endl;
         return false;
     }
@@ -104,17 +304,8 @@ bool MqttClient::subscribe(const std::string& topic, MessageCallback callback, i
     try {
         std::cout << "📡 MQTT: Subscribing to: " << topic << " (QoS " << qos << ")" << std::endl;
 
-        // Get client pointer (release lock before waiting to prevent deadlock)
-        mqtt::async_client* client_ptr = nullptr;
-        {
-            std::unique_lock<std::recursive_mutex> lock(connection_mutex_, std::try_to_lock);
-            if (!lock.owns_lock()) {
-                std::cerr << "⚠️  MQTT: Mutex busy, cannot subscribe now" << std::endl;
-                return false;
-            }
-            client_ptr = client_.get();
-        }
-        // Mutex released here - prevents deadlock if callback tries to publish
+        // Lock-free snapshot of the client handle (safe from Paho callbacks)
+        auto client = subscriberClient();
 
         // Subscribe asynchronously without waiting (truly non-blocking)
         // Store callback immediately - SUBACK will arrive async
@@ -123,9 +314,9 @@ bool MqttClient::subscribe(const std::string& topic, MessageCallback callback, i
             message_callbacks_[topic] = callback;
         }
 
-        if (client_ptr) {
+        if (client) {
             // Initiate async subscribe - don't wait for SUBACK
-            client_ptr->subscribe(topic, qos);
+            client->subscribe(topic, qos);
             std::cout << "✅ MQTT: Subscription initiated for " << topic << " (async)" << std::endl;
         }
 
@@ -140,6 +331,15 @@ bool MqttClient::subscribe(const std::string& topic, MessageCallback callback, i
 bool MqttClient::subscribeMultiple(const std::vector<std::string>& topics,
                                     MessageCallback callback,
                                     int qos) {
+    return subscribeMultiple(topics, TimedMessageCallback(
+        [callback = std::move(callback)](const std::string& t, const std::string& payload, int64_t) {
+            callback(t, payload);
+        }), qos);
+}
+
+bool MqttClient::subscribeMultiple(const std::vector<std::string>& topics,
+                                    TimedMessageCallback callback,
+                                    int qos) {
     bool all_success = true;
 
     for (const auto& topic : topics) {
@@ -153,15 +353,15 @@ bool MqttClient::subscribeMultiple(const std::vector<std::string>& topics,
 }
 
 bool MqttClient::unsubscribe(const std::string& topic) {
-    if (!isConnected()) {
+    if (!isSubscriberConnected()) {
         std::cerr << "❌ MQTT: Not connected, cannot unsubscribe" << std::endl;
         return false;
     }
 
     try {
-        {
-            std::lock_guard<std::recursive_mutex> lock(connection_mutex_);
-            client_->unsubscribe(topic)->wait();
+        auto client = subscriberClient();
+        if (client) {
+            client->unsubscribe(topic)->wait();
         }
 
         // Remove callback
@@ -183,94 +383,379 @@ bool MqttClient::publish(const std::string& topic,
                          const std::string& payload,
                          int qos,
                          bool retain) {
-    if (!isConnected()) {
-        std::cerr << "❌ MQTT: Not connected, cannot publish" << std::endl;
+    if (topic.empty()) {
+        std::cerr << "❌ MQTT: Cannot publish to empty topic" << std::endl;
+        return false;
+    }
+
+    QueuedMessage message{topic, payload, qos, retain,
+                          std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::system_clock::now().time_since_epoch()).count()};
+
+    // Broker unreachable (or an earlier outage is still being replayed) -
+    // write to disk so nothing is lost and replay order stays intact
+    if (spool_ && (spooling_.load() || !isConnected())) {
+        std::lock_guard<std::mutex> lock(spool_mutex_);
+        if (spooling_.load() || !isConnected()) {
+            bool spooled = spool_->append(message, message.timestamp_ms);
+            if (spooled) {
+                spooling_ = true;
+                queue_cv_.notify_all();
+            } else {
+                std::cerr << "❌ MQTT: Failed to spool message for " << topic << std::endl;
+            }
+            return spooled;
+        }
+    }
+
+    // Fast path: connected, nothing queued ahead and a free in-flight slot -
+    // hand the message straight to Paho without taking any lock
+    PublishQueue::PushResult result = PublishQueue::PushResult::Queued;
+    bool sent_direct = false;
+    if (isConnected() && queued_.load() == 0 && !sender_busy_.load() && tryReserveInFlight()) {
+        sent_direct = sendNow(message);
+        if (sent_direct) {
+            ++direct_;
+        }
+    }
+
+    if (!sent_direct) {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        result = publish_queue_.push(std::move(message));
+        queued_ = publish_queue_.size();
+    }
+
+    if (result == PublishQueue::PushResult::Dropped) {
+        // Log occasionally - a slow broker can produce thousands of these
+        static std::atomic<int> drop_counter{0};
+        int drops = ++drop_counter;
+        if (drops == 1 || drops % 100 == 0) {
+            std::cerr << "⚠️  MQTT: Outbound queue full, dropped " << drops
+                      << " messages (latest: " << topic << ")" << std::endl;
+        }
+        return false;
+    }
+
+    if (!sent_direct) {
+        queue_cv_.notify_all();
+    }
+
+    // Simplified logging for state messages (too verbose otherwise)
+    if (topic.find("/state") != std::string::npos) {
+        // Only log occasionally for state messages
+        static std::atomic<int> log_counter{0};
+        int count = ++log_counter;
+        if (count % 50 == 0) {  // Log every 50th message
+            std::cout << "📤 MQTT: Published " << count << " messages..." << std::endl;
+        }
+    } else {
+        std::cout << "📤 MQTT: Published to " << topic
+                  << " (" << payload.length() << " bytes)"
+                  << (retain ? " [retained]" : "") << std::endl;
+    }
+
+    return true;
+}
+
+PublishQueueStats MqttClient::getQueueStats() const {
+    PublishQueueStats stats;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stats = publish_queue_.getStats();
+    }
+    stats.direct = direct_.load();
+    stats.sent = sent_.load();
+    stats.send_failed = send_failed_.load();
+    stats.in_flight = in_flight_.load();
+    return stats;
+}
+
+bool MqttClient::flush(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    return queue_cv_.wait_for(lock, timeout, [this]() {
+        return publish_queue_.empty() && in_flight_.load() == 0;
+    });
+}
+
+bool MqttClient::tryReserveInFlight() {
+    const size_t max_in_flight = std::max<size_t>(1, publish_queue_.getConfig().max_in_flight);
+    size_t current = in_flight_.load();
+    while (current < max_in_flight) {
+        if (in_flight_.compare_exchange_weak(current, current + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MqttClient::releaseInFlight() {
+    // Saturating decrement - in_flight_ is reset on reconnect and late
+    // completions from the previous session may still arrive
+    size_t current = in_flight_.load();
+    while (current > 0 && !in_flight_.compare_exchange_weak(current, current - 1)) {
+    }
+}
+
+bool MqttClient::sendNow(const QueuedMessage& message) {
+    auto client = std::atomic_load(&client_);
+    if (!client) {
+        releaseInFlight();
         return false;
     }
 
+    TopicAliasTable::Lookup alias;
     try {
-        mqtt::message_ptr pubmsg = mqtt::make_message(topic, payload);
-        pubmsg->set_qos(qos);
-        pubmsg->set_retained(retain);
+        mqtt::message_ptr pubmsg;
+        if (v5_.enabled) {
+            mqtt::properties props;
+
+            // Only the recurring per-sensor state topics are worth an alias
+            static constexpr std::string_view kStateSuffix = "/state";
+            if (message.topic.size() > kStateSuffix.size() &&
+                message.topic.compare(message.topic.size() - kStateSuffix.size(),
+                                      kStateSuffix.size(), kStateSuffix) == 0) {
+                alias = topic_aliases_.lookup(message.topic);
+            }
+            if (alias.use != TopicAliasTable::Use::None) {
+                props.add(mqtt::property(mqtt::property::TOPIC_ALIAS, alias.alias));
+            }
+            if (!message.retain && v5_.telemetry_expiry_seconds > 0) {
+                props.add(mqtt::property(mqtt::property::MESSAGE_EXPIRY_INTERVAL,
+                                         v5_.telemetry_expiry_seconds));
+            }
+            if (v5_.timestamp_property && message.timestamp_ms > 0) {
+                props.add(mqtt::property(mqtt::property::USER_PROPERTY, "ts",
+                                         std::to_string(message.timestamp_ms)));
+            }
 
+            pubmsg = mqtt::make_message(
+                alias.use == TopicAliasTable::Use::Alias ? std::string() : message.topic,
+                message.payload);
+            pubmsg->set_properties(props);
+        } else {
+            pubmsg = mqtt::make_message(message.topic, message.payload);
+        }
+        pubmsg->set_qos(message.qos);
+        pubmsg->set_retained(message.retain);
         {
-            std::lock_guard<std::recursive_mutex> lock(connection_mutex_);
-            // Publish asynchronously without waiting (don't block while holding lock)
-            client_->publish(pubmsg);
+            ScopedTimer timer(metrics().publish);
+            client->publish(pubmsg, nullptr, delivery_listener_);
+        }
+        if (alias.use == TopicAliasTable::Use::Establish) {
+            topic_aliases_.markEstablished(message.topic, alias);
         }
+        return true;
+    } catch (const mqtt::exception& e) {
+        if (alias.use == TopicAliasTable::Use::Establish) {
+            topic_aliases_.markFailed(message.topic, alias);
+        }
+        releaseInFlight();
+        metrics().publish_errors.inc();
+        std::cerr << "❌ MQTT: Publish failed: " << e.what() << std::endl;
+        return false;
+    }
+}
 
-        // Simplified logging for state messages (too verbose otherwise)
-        if (topic.find("/state") != std::string::npos) {
-            // Only log occasionally for state messages
-            static int log_counter = 0;
-            if (++log_counter % 50 == 0) {  // Log every 50th message
-                std::cout << "📤 MQTT: Published " << log_counter << " messages..." << std::endl;
+void MqttClient::senderLoop() {
+    const size_t max_in_flight = std::max<size_t>(1, publish_queue_.getConfig().max_in_flight);
+
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+
+    while (sender_running_) {
+        auto ready = [&]() {
+            return !publish_queue_.empty() && in_flight_.load() < max_in_flight && isConnected();
+        };
+
+        // Timed wait: connection state changes inside Paho are not always signalled
+        queue_cv_.wait_for(lock, std::chrono::milliseconds(250), [&]() {
+            return !sender_running_ || ready();
+        });
+        if (!sender_running_ || !ready() || !tryReserveInFlight()) {
+            continue;
+        }
+
+        // Mark busy before queued_ can drop to 0: publish() reads queued_ then
+        // sender_busy_, so it must never see an empty queue while the popped
+        // (older) message is still on its way to Paho
+        sender_busy_ = true;
+        QueuedMessage message = std::move(*publish_queue_.pop());
+        queued_ = publish_queue_.size();
+        queue_cv_.notify_all();  // Wake flush() waiters
+        lock.unlock();
+
+        bool handed_off = sendNow(message);
+
+        lock.lock();
+        sender_busy_ = false;
+
+        if (!handed_off) {
+            // Connection dropped between pop and publish - put it back unless a
+            // newer value for the topic has been queued meanwhile
+            if (!isConnected() && !publish_queue_.contains(message.topic)) {
+                publish_queue_.push(std::move(message));
+                queued_ = publish_queue_.size();
+            } else {
+                ++send_failed_;
             }
-        } else {
-            std::cout << "📤 MQTT: Published to " << topic
-                      << " (" << payload.length() << " bytes)"
-                      << (retain ? " [retained]" : "") << std::endl;
         }
+    }
+}
 
+bool MqttClient::enableOfflineSpool(const OfflineSpoolConfig& config) {
+    if (spool_) {
         return true;
+    }
 
-    } catch (const mqtt::exception& e) {
-        std::cerr << "❌ MQTT: Publish failed: " << e.what() << std::endl;
+    auto spool = std::make_unique<OfflineSpool>(config);
+    if (!spool->open()) {
+        std::cerr << "❌ MQTT: Offline spool disabled - cannot use " << config.directory << std::endl;
         return false;
     }
+
+    {
+        std::lock_guard<std::mutex> lock(spool_mutex_);
+        spooling_ = !spool->empty();
+        spool_ = std::move(spool);
+    }
+    replay_thread_ = std::thread(&MqttClient::replayLoop, this);
+
+    std::cout << "💾 MQTT: Offline spool enabled at " << config.directory
+              << " (max " << config.max_bytes << " bytes, replay "
+              << config.replay_rate << " msg/s)" << std::endl;
+    return true;
+}
+
+std::optional<OfflineSpoolStats> MqttClient::getSpoolStats() const {
+    if (!spool_) {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(spool_mutex_);
+    return spool_->getStats();
 }
 
-bool MqttClient::topicMatches(const std::string& topic, const std::string& pattern) const {
-    // Split topic and pattern by '/'
-    auto split = [](const std::string& str) -> std::vector<std::string> {
-        std::vector<std::string> parts;
-        std::stringstream ss(str);
-        std::string part;
-        while (std::getline(ss, part, '/')) {
-            parts.push_back(part);
+void MqttClient::replayLoop() {
+    const double rate = std::max(1.0, spool_->getConfig().replay_rate);
+    TokenBucket bucket(rate, std::max(1.0, rate / 10.0));
+    uint64_t replayed_this_run = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait_for(lock, std::chrono::milliseconds(250), [this]() {
+                return !sender_running_ || (spooling_.load() && isConnected());
+            });
+            if (!sender_running_) {
+                break;
+            }
+            if (!spooling_.load() || !isConnected()) {
+                continue;
+            }
         }
-        return parts;
-    };
 
-    auto topic_parts = split(topic);
-    auto pattern_parts = split(pattern);
+        auto now = TokenBucket::Clock::now();
+        if (!bucket.tryAcquire(now)) {
+            std::this_thread::sleep_for(std::min<TokenBucket::Clock::duration>(
+                bucket.timeUntilAvailable(now), std::chrono::milliseconds(250)));
+            continue;
+        }
 
-    // Check if pattern has '#' wildcard (multi-level)
-    bool has_multilevel = !pattern_parts.empty() && pattern_parts.back() == "#";
+        std::optional<SpoolRecord> record;
+        {
+            std::lock_guard<std::mutex> lock(spool_mutex_);
+            record = spool_->next();
+            if (!record) {
+                // Caught up - publishes go straight to the queue again
+                spooling_ = false;
+                if (replayed_this_run > 0) {
+                    std::cout << "✅ MQTT: Offline spool replay complete (" << replayed_this_run
+                              << " messages)" << std::endl;
+                    replayed_this_run = 0;
+                }
+                continue;
+            }
+        }
 
-    if (has_multilevel) {
-        // Match up to '#'
-        if (topic_parts.size() < pattern_parts.size() - 1) {
-            return false;
+        if (replayed_this_run == 0) {
+            std::cout << "🔄 MQTT: Replaying offline spool..." << std::endl;
         }
-        pattern_parts.pop_back();  // Remove '#'
-    } else {
-        // Exact level count match required
-        if (topic_parts.size() != pattern_parts.size()) {
-            return false;
+        ++replayed_this_run;
+
+        // Wait for any earlier value of this topic to leave the queue, so
+        // coalescing does not collapse the history being replayed
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        queue_cv_.wait(lock, [&]() {
+            return !sender_running_ || !publish_queue_.contains(record->message.topic);
+        });
+        if (!sender_running_) {
+            break;
         }
+        record->message.timestamp_ms = record->timestamp_ms;
+        publish_queue_.push(std::move(record->message));
+        queued_ = publish_queue_.size();
+        queue_cv_.notify_all();
     }
+}
 
-    // Match each level
-    for (size_t i = 0; i < pattern_parts.size(); ++i) {
-        const auto& pattern_level = pattern_parts[i];
-        const auto& topic_level = topic_parts[i];
+void MqttClient::onDeliveryComplete(bool success) {
+    releaseInFlight();
 
-        if (pattern_level == "+") {
-            // Single-level wildcard - matches any value
-            continue;
-        } else if (pattern_level != topic_level) {
-            // Exact match required
+    if (success) {
+        ++sent_;
+    } else {
+        ++send_failed_;
+    }
+
+    {
+        // Pairs with the predicate checks in senderLoop()/flush()
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+    }
+    queue_cv_.notify_all();
+}
+
+bool MqttClient::topicMatches(std::string_view topic, std::string_view pattern) {
+    // Walk both strings level by level - no allocation on the message path
+    size_t t = 0;
+    size_t p = 0;
+
+    while (true) {
+        size_t p_end = pattern.find('/', p);
+        std::string_view pattern_level = pattern.substr(p, p_end == std::string_view::npos ? p_end : p_end - p);
+
+        if (pattern_level == "#") {
+            // Multi-level wildcard - matches the rest (and the parent level)
+            return true;
+        }
+
+        size_t t_end = topic.find('/', t);
+        std::string_view topic_level = topic.substr(t, t_end == std::string_view::npos ? t_end : t_end - t);
+
+        if (pattern_level != "+" && pattern_level != topic_level) {
             return false;
         }
-    }
 
-    return true;
+        bool pattern_done = p_end == std::string_view::npos;
+        bool topic_done = t_end == std::string_view::npos;
+        if (pattern_done || topic_done) {
+            if (pattern_done && topic_done) {
+                return true;
+            }
+            // "a/#" also matches "a"
+            return topic_done && pattern.substr(p_end + 1) == "#";
+        }
+
+        p = p_end + 1;
+        t = t_end + 1;
+    }
 }
 
 void MqttClient::onMessageArrived(mqtt::const_message_ptr msg) {
-    std::string topic = msg->get_topic();
+    const std::string& topic = msg->get_topic();
     std::string payload = msg->to_string();
+    int64_t timestamp_ms = sampleTimestamp(*msg);
+
+    MqttMetrics& m = metrics();
+    m.received.inc();
+    ScopedTimer timer(m.dispatch);
 
     // Find matching callbacks
     std::lock_guard<std::mutex> lock(callbacks_mutex_);
@@ -278,7 +763,7 @@ void MqttClient::onMessageArrived(mqtt::const_message_ptr msg) {
     for (const auto& [pattern, callback] : message_callbacks_) {
         if (topicMatches(topic, pattern)) {
             try {
-                callback(topic, payload);
+                callback(topic, payload, timestamp_ms);
             } catch (const std::exception& e) {
                 std::cerr << "❌ MQTT: Callback error for topic " << topic
                           << ": " << e.what() << std::endl;
@@ -288,8 +773,7 @@ void MqttClient::onMessageArrived(mqtt::const_message_ptr msg) {
 }
 
 void MqttClient::onConnectionLost(const std::string& cause) {
-    std::lock_guard<std::recursive_mutex> lock(connection_mutex_);
-    connected_ = false;
+    state_ = auto_reconnect_ ? ConnectionState::Reconnecting : ConnectionState::Disconnected;
 
     std::cerr << "⚠️  MQTT: Connection lost: " << cause << std::endl;
 
@@ -299,17 +783,47 @@ void MqttClient::onConnectionLost(const std::string& cause) {
 }
 
 void MqttClient::onReconnected(const std::string& cause) {
-    {
-        std::lock_guard<std::recursive_mutex> lock(connection_mutex_);
-        connected_ = true;
+    in_flight_ = 0;  // Clean session - Paho dropped the old window
+    if (v5_.enabled) {
+        // Aliases die with the network connection. Paho does not hand the
+        // CONNACK to this handler, so keep the capacity from the first connect.
+        topic_aliases_.reset(alias_capacity_.load());
+    }
+    if (!split_sessions_) {
+        // Split: the subscriber session (and the retained state seen on it) is unaffected
+        ++connection_epoch_;
     }
+    state_ = ConnectionState::Connected;
     std::cout << "✅ MQTT: Reconnected: " << cause << std::endl;
+    queue_cv_.notify_all();
+
+    if (!split_sessions_) {
+        resubscribeAll(std::atomic_load(&client_));
+    }
+}
 
+void MqttClient::onSubscriberConnectionLost(const std::string& cause) {
+    sub_state_ = auto_reconnect_ ? ConnectionState::Reconnecting : ConnectionState::Disconnected;
+    std::cerr << "⚠️  MQTT: Subscriber session lost: " << cause << std::endl;
+}
+
+void MqttClient::onSubscriberReconnected(const std::string& cause) {
+    ++connection_epoch_;
+    sub_state_ = ConnectionState::Connected;
+    std::cout << "✅ MQTT: Subscriber session reconnected: " << cause << std::endl;
+    resubscribeAll(std::atomic_load(&sub_client_));
+}
+
+void MqttClient::resubscribeAll(const std::shared_ptr<mqtt::async_client>& client) {
     // Re-subscribe without waiting — async fire-and-forget avoids paho thread deadlocks
+    if (!client) {
+        return;
+    }
+
     std::lock_guard<std::mutex> lock(callbacks_mutex_);
     for (const auto& [topic, callback] : message_callbacks_) {
         try {
-            client_->subscribe(topic, 1);  // No ->wait()
+            client->subscribe(topic, 1);  // No ->wait()
             std::cout << "✅ MQTT: Re-subscribed to " << topic << std::endl;
         } catch (const mqtt::exception& e) {
             std::cerr << "❌ MQTT: Re-subscribe failed for " << topic << ": " << e.what() << std::endl;
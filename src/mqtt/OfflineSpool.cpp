@@ -0,0 +1,374 @@
+#include "mqtt/OfflineSpool.h"
+#include "utils/Hash.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace hms_nut {
+
+namespace {
+    // Record: [u32 body_len][u32 checksum][body]
+    // Body:   [u64 seq][i64 timestamp_ms][u8 qos][u8 retain][u16 topic_len][topic][payload]
+    constexpr size_t kHeaderSize = 8;
+    constexpr size_t kFixedBodySize = 8 + 8 + 1 + 1 + 2;
+    constexpr size_t kMaxBodySize = 16 * 1024 * 1024;
+    constexpr size_t kCorrupt = std::numeric_limits<size_t>::max();
+
+    constexpr const char* kPrefix = "spool-";
+    constexpr const char* kSuffix = ".seg";
+
+    template <typename T>
+    void putRaw(std::string& out, T value) {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.append(bytes, sizeof(T));
+    }
+
+    template <typename T>
+    T getRaw(const char* data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    uint32_t checksum(std::string_view body) {
+        return static_cast<uint32_t>(fnv1a64(body));
+    }
+}
+
+OfflineSpool::OfflineSpool(const OfflineSpoolConfig& config)
+    : config_(config) {
+    // At least two segments must fit under the cap so the oldest can be dropped
+    config_.max_bytes = std::max<size_t>(config_.max_bytes, 8192);
+    config_.segment_bytes = std::clamp<size_t>(config_.segment_bytes, 4096, config_.max_bytes / 2);
+}
+
+OfflineSpool::~OfflineSpool() {
+    if (writer_.is_open()) {
+        writer_.close();
+    }
+}
+
+std::string OfflineSpool::segmentPath(uint64_t first_seq) const {
+    std::string seq = std::to_string(first_seq);
+    // Zero-pad so a directory listing sorts in replay order
+    return (fs::path(config_.directory) /
+            (kPrefix + std::string(20 - std::min<size_t>(20, seq.size()), '0') + seq + kSuffix)).string();
+}
+
+bool OfflineSpool::isCompactable(const QueuedMessage& message) const {
+    const std::string& suffix = config_.compact_suffix;
+    return message.retain &&
+           message.topic.size() >= suffix.size() &&
+           message.topic.compare(message.topic.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool OfflineSpool::open() {
+    std::error_code ec;
+    fs::create_directories(config_.directory, ec);
+    if (ec) {
+        std::cerr << "❌ Spool: Cannot create " << config_.directory << ": " << ec.message() << std::endl;
+        return false;
+    }
+
+    std::vector<Segment> found;
+    for (const auto& entry : fs::directory_iterator(config_.directory, ec)) {
+        std::string name = entry.path().filename().string();
+        size_t prefix_len = std::strlen(kPrefix);
+        size_t suffix_len = std::strlen(kSuffix);
+        if (name.size() <= prefix_len + suffix_len ||
+            name.compare(0, prefix_len, kPrefix) != 0 ||
+            name.compare(name.size() - suffix_len, suffix_len, kSuffix) != 0) {
+            continue;
+        }
+
+        uint64_t first_seq = 0;
+        const char* begin = name.data() + prefix_len;
+        const char* end = name.data() + name.size() - suffix_len;
+        auto [ptr, parse_ec] = std::from_chars(begin, end, first_seq);
+        if (parse_ec != std::errc() || ptr != end) {
+            continue;
+        }
+        found.push_back({first_seq, entry.path().string(), 0, 0});
+    }
+
+    std::sort(found.begin(), found.end(), [](const Segment& a, const Segment& b) {
+        return a.first_seq < b.first_seq;
+    });
+
+    for (auto& segment : found) {
+        if (!loadSegment(segment) || segment.records == 0) {
+            fs::remove(segment.path, ec);
+            continue;
+        }
+        next_seq_ = std::max(next_seq_, segment.first_seq + segment.records);
+        pending_ += segment.records;
+        total_bytes_ += segment.bytes;
+        segments_.push_back(segment);
+    }
+
+    if (!segments_.empty()) {
+        // Keep filling the last segment
+        writer_.open(segments_.back().path, std::ios::binary | std::ios::app);
+        std::cout << "💾 Spool: Found " << pending_ << " spooled messages in "
+                  << segments_.size() << " segments" << std::endl;
+    }
+
+    enforceCap();
+    return true;
+}
+
+bool OfflineSpool::loadSegment(Segment& segment) {
+    std::ifstream in(segment.path, std::ios::binary);
+    if (!in) {
+        ++errors_;
+        return false;
+    }
+
+    std::error_code ec;
+    size_t file_size = static_cast<size_t>(fs::file_size(segment.path, ec));
+    size_t offset = 0;
+
+    while (offset < file_size) {
+        uint64_t seq = 0;
+        SpoolRecord record;
+        size_t size = readRecord(in, offset, seq, record);
+        if (size == 0 || size == kCorrupt) {
+            // Torn write from a crash - drop the tail
+            std::cerr << "⚠️  Spool: Truncating " << segment.path << " at byte " << offset << std::endl;
+            ++errors_;
+            in.close();
+            fs::resize_file(segment.path, offset, ec);
+            break;
+        }
+
+        if (isCompactable(record.message)) {
+            uint64_t& latest = latest_compactable_[record.message.topic];
+            latest = std::max(latest, seq);
+        }
+        next_seq_ = std::max(next_seq_, seq + 1);
+        offset += size;
+        ++segment.records;
+    }
+
+    segment.bytes = offset;
+    return true;
+}
+
+size_t OfflineSpool::readRecord(std::ifstream& in, size_t offset, uint64_t& seq, SpoolRecord& record) {
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(offset));
+
+    char header[kHeaderSize];
+    in.read(header, kHeaderSize);
+    if (static_cast<size_t>(in.gcount()) < kHeaderSize) {
+        return 0;
+    }
+
+    uint32_t body_len = getRaw<uint32_t>(header);
+    uint32_t expected = getRaw<uint32_t>(header + 4);
+    if (body_len < kFixedBodySize || body_len > kMaxBodySize) {
+        return kCorrupt;
+    }
+
+    std::string body(body_len, '\0');
+    in.read(body.data(), body_len);
+    if (static_cast<size_t>(in.gcount()) < body_len) {
+        return 0;
+    }
+    if (checksum(body) != expected) {
+        return kCorrupt;
+    }
+
+    const char* p = body.data();
+    seq = getRaw<uint64_t>(p);
+    record.timestamp_ms = getRaw<int64_t>(p + 8);
+    record.message.qos = static_cast<uint8_t>(p[16]);
+    record.message.retain = p[17] != 0;
+    uint16_t topic_len = getRaw<uint16_t>(p + 18);
+    if (kFixedBodySize + topic_len > body_len) {
+        return kCorrupt;
+    }
+    record.message.topic.assign(p + kFixedBodySize, topic_len);
+    record.message.payload.assign(p + kFixedBodySize + topic_len, body_len - kFixedBodySize - topic_len);
+
+    return kHeaderSize + body_len;
+}
+
+bool OfflineSpool::rollSegment() {
+    if (writer_.is_open()) {
+        writer_.close();
+    }
+
+    Segment segment{next_seq_, segmentPath(next_seq_), 0, 0};
+    writer_.open(segment.path, std::ios::binary | std::ios::trunc);
+    if (!writer_) {
+        std::cerr << "❌ Spool: Cannot open segment " << segment.path << std::endl;
+        ++errors_;
+        return false;
+    }
+
+    segments_.push_back(segment);
+    return true;
+}
+
+bool OfflineSpool::append(const QueuedMessage& message, int64_t timestamp_ms) {
+    if (message.topic.size() > std::numeric_limits<uint16_t>::max() ||
+        kFixedBodySize + message.bytes() > kMaxBodySize) {
+        ++errors_;
+        return false;
+    }
+
+    if (segments_.empty() || !writer_.is_open() || segments_.back().bytes >= config_.segment_bytes) {
+        if (!rollSegment()) {
+            return false;
+        }
+    }
+
+    uint64_t seq = next_seq_;
+
+    std::string body;
+    body.reserve(kFixedBodySize + message.bytes());
+    putRaw<uint64_t>(body, seq);
+    putRaw<int64_t>(body, timestamp_ms);
+    putRaw<uint8_t>(body, static_cast<uint8_t>(message.qos));
+    putRaw<uint8_t>(body, message.retain ? 1 : 0);
+    putRaw<uint16_t>(body, static_cast<uint16_t>(message.topic.size()));
+    body += message.topic;
+    body += message.payload;
+
+    std::string record;
+    record.reserve(kHeaderSize + body.size());
+    putRaw<uint32_t>(record, static_cast<uint32_t>(body.size()));
+    putRaw<uint32_t>(record, checksum(body));
+    record += body;
+
+    writer_.write(record.data(), static_cast<std::streamsize>(record.size()));
+    writer_.flush();
+    if (!writer_) {
+        ++errors_;
+        writer_.close();  // Next append starts a fresh segment
+        return false;
+    }
+
+    ++next_seq_;
+    Segment& segment = segments_.back();
+    segment.bytes += record.size();
+    ++segment.records;
+    total_bytes_ += record.size();
+    ++pending_;
+    ++appended_;
+
+    if (isCompactable(message)) {
+        latest_compactable_[message.topic] = seq;
+    }
+
+    enforceCap();
+    return true;
+}
+
+std::optional<SpoolRecord> OfflineSpool::next() {
+    while (!segments_.empty()) {
+        Segment& front = segments_.front();
+
+        if (!reader_open_) {
+            reader_.open(front.path, std::ios::binary);
+            reader_open_ = static_cast<bool>(reader_);
+        }
+
+        uint64_t seq = 0;
+        SpoolRecord record;
+        size_t size = 0;
+        if (reader_open_ && read_offset_ < front.bytes) {
+            size = readRecord(reader_, read_offset_, seq, record);
+        }
+
+        if (size == 0 || size == kCorrupt) {
+            // Segment exhausted (or unreadable) - whatever is left is lost
+            size_t remaining = front.records - read_records_;
+            if (remaining > 0) {
+                std::cerr << "⚠️  Spool: Skipping " << remaining << " unreadable records in "
+                          << front.path << std::endl;
+                ++errors_;
+                pending_ -= std::min(pending_, remaining);
+            }
+            removeFrontSegment();
+            continue;
+        }
+
+        read_offset_ += size;
+        ++read_records_;
+        --pending_;
+
+        if (isCompactable(record.message)) {
+            auto it = latest_compactable_.find(record.message.topic);
+            if (it != latest_compactable_.end()) {
+                if (it->second != seq) {
+                    ++compacted_;  // A newer value follows
+                    continue;
+                }
+                latest_compactable_.erase(it);
+            }
+        }
+
+        ++replayed_;
+        return record;
+    }
+
+    return std::nullopt;
+}
+
+void OfflineSpool::removeFrontSegment() {
+    if (segments_.empty()) {
+        return;
+    }
+
+    if (reader_open_) {
+        reader_.close();
+        reader_open_ = false;
+    }
+    if (segments_.size() == 1 && writer_.is_open()) {
+        writer_.close();
+    }
+
+    std::error_code ec;
+    fs::remove(segments_.front().path, ec);
+
+    total_bytes_ -= std::min(total_bytes_, segments_.front().bytes);
+    segments_.pop_front();
+    read_offset_ = 0;
+    read_records_ = 0;
+}
+
+void OfflineSpool::enforceCap() {
+    while (total_bytes_ > config_.max_bytes && segments_.size() > 1) {
+        size_t lost = segments_.front().records - read_records_;
+        dropped_ += lost;
+        pending_ -= std::min(pending_, lost);
+
+        std::cerr << "⚠️  Spool: Size cap reached, dropping " << lost
+                  << " oldest messages" << std::endl;
+        removeFrontSegment();
+    }
+}
+
+OfflineSpoolStats OfflineSpool::getStats() const {
+    OfflineSpoolStats stats;
+    stats.segments = segments_.size();
+    stats.bytes = total_bytes_;
+    stats.pending = pending_;
+    stats.appended = appended_;
+    stats.replayed = replayed_;
+    stats.compacted = compacted_;
+    stats.dropped = dropped_;
+    stats.errors = errors_;
+    return stats;
+}
+
+}  // namespace hms_nut
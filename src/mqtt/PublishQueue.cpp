@@ -0,0 +1,126 @@
+#include "mqtt/PublishQueue.h"
+
+namespace hms_nut {
+
+OverflowPolicy PublishQueueConfig::parseOverflowPolicy(const std::string& name) {
+    if (name == "drop_newest") {
+        return OverflowPolicy::DropNewest;
+    }
+    return OverflowPolicy::DropOldest;
+}
+
+PublishQueue::PublishQueue(const PublishQueueConfig& config)
+    : config_(config) {
+}
+
+void PublishQueue::evictFront(Lane lane) {
+    auto& list = lanes_[lane];
+    if (list.empty()) {
+        return;
+    }
+
+    bytes_ -= list.front().bytes();
+    index_.erase(list.front().topic);
+    list.pop_front();
+    ++dropped_;
+}
+
+bool PublishQueue::makeRoom(Lane lane, size_t incoming) {
+    if (incoming > config_.max_bytes) {
+        return false;  // Can never fit
+    }
+
+    auto full = [&]() {
+        return index_.size() + 1 > config_.max_messages || bytes_ + incoming > config_.max_bytes;
+    };
+
+    while (full()) {
+        // State messages are always sacrificed before retained ones
+        if (!lanes_[kNormal].empty() &&
+            (config_.overflow == OverflowPolicy::DropOldest || lane == kPriority)) {
+            evictFront(kNormal);
+        } else if (lane == kPriority && config_.overflow == OverflowPolicy::DropOldest &&
+                   !lanes_[kPriority].empty()) {
+            evictFront(kPriority);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+PublishQueue::PushResult PublishQueue::push(QueuedMessage message) {
+    Lane lane = message.retain ? kPriority : kNormal;
+
+    auto existing = index_.find(message.topic);
+    if (existing != index_.end()) {
+        Location& loc = existing->second;
+        if (loc.lane == lane) {
+            // Newest state wins - replace in place, keep queue position
+            bytes_ -= loc.it->bytes();
+            bytes_ += message.bytes();
+            *loc.it = std::move(message);
+            ++coalesced_;
+
+            // Replacement may have grown the payload past the byte cap
+            while (bytes_ > config_.max_bytes && !lanes_[kNormal].empty() &&
+                   &lanes_[kNormal].front() != &*loc.it) {
+                evictFront(kNormal);
+            }
+            return PushResult::Coalesced;
+        }
+
+        // Retain flag changed - drop the stale entry from the other lane
+        bytes_ -= loc.it->bytes();
+        lanes_[loc.lane].erase(loc.it);
+        index_.erase(existing);
+        ++coalesced_;
+    }
+
+    if (!makeRoom(lane, message.bytes())) {
+        ++dropped_;
+        return PushResult::Dropped;
+    }
+
+    bytes_ += message.bytes();
+    auto& list = lanes_[lane];
+    list.push_back(std::move(message));
+    index_[list.back().topic] = {lane, std::prev(list.end())};
+    ++enqueued_;
+
+    return PushResult::Queued;
+}
+
+std::optional<QueuedMessage> PublishQueue::pop() {
+    for (auto& list : lanes_) {
+        if (!list.empty()) {
+            QueuedMessage message = std::move(list.front());
+            list.pop_front();
+            index_.erase(message.topic);
+            bytes_ -= message.bytes();
+            return message;
+        }
+    }
+    return std::nullopt;
+}
+
+PublishQueueStats PublishQueue::getStats() const {
+    PublishQueueStats stats;
+    stats.depth = index_.size();
+    stats.priority_depth = lanes_[kPriority].size();
+    stats.bytes = bytes_;
+    stats.enqueued = enqueued_;
+    stats.coalesced = coalesced_;
+    stats.dropped = dropped_;
+    return stats;
+}
+
+void PublishQueue::clear() {
+    for (auto& list : lanes_) {
+        list.clear();
+    }
+    index_.clear();
+    bytes_ = 0;
+}
+
+}  // namespace hms_nut
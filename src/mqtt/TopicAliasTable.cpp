@@ -0,0 +1,81 @@
+#include "mqtt/TopicAliasTable.h"
+
+namespace hms_nut {
+
+TopicAliasTable::TopicAliasTable(uint16_t capacity)
+    : capacity_(capacity) {
+}
+
+void TopicAliasTable::reset(uint16_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    capacity_ = capacity;
+    ++generation_;
+}
+
+TopicAliasTable::Lookup TopicAliasTable::lookup(const std::string& topic) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Lookup result;
+    result.generation = generation_;
+
+    auto it = entries_.find(topic);
+    if (it == entries_.end()) {
+        if (entries_.size() >= capacity_) {
+            return result;  // Out of aliases (or broker does not support them)
+        }
+        uint16_t alias = static_cast<uint16_t>(entries_.size() + 1);  // Aliases start at 1
+        it = entries_.emplace(topic, Entry{alias, State::Unsent}).first;
+    }
+
+    Entry& entry = it->second;
+    result.alias = entry.alias;
+
+    switch (entry.state) {
+        case State::Established:
+            result.use = Use::Alias;
+            break;
+        case State::Unsent:
+            entry.state = State::Pending;
+            result.use = Use::Establish;
+            break;
+        case State::Pending:
+            result.use = Use::None;  // Another thread is establishing it
+            break;
+    }
+    return result;
+}
+
+void TopicAliasTable::markEstablished(const std::string& topic, const Lookup& lookup) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (lookup.generation != generation_) {
+        return;  // Connection changed meanwhile
+    }
+    auto it = entries_.find(topic);
+    if (it != entries_.end() && it->second.alias == lookup.alias) {
+        it->second.state = State::Established;
+    }
+}
+
+void TopicAliasTable::markFailed(const std::string& topic, const Lookup& lookup) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (lookup.generation != generation_) {
+        return;
+    }
+    auto it = entries_.find(topic);
+    if (it != entries_.end() && it->second.alias == lookup.alias) {
+        it->second.state = State::Unsent;
+    }
+}
+
+uint16_t TopicAliasTable::capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+}
+
+size_t TopicAliasTable::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+}  // namespace hms_nut
@@ -0,0 +1,306 @@
+#include "nut/DailyMetrics.h"
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+namespace hms_nut {
+
+namespace {
+    /**
+     * Local wall-clock time of a timestamp, e.g. "14:05"
+     */
+    std::string clockTime(int64_t ts_ms, const char* format = "%H:%M") {
+        std::time_t t = static_cast<std::time_t>(ts_ms / 1000);
+        std::tm local_tm;
+        localtime_r(&t, &local_tm);
+        std::ostringstream oss;
+        oss << std::put_time(&local_tm, format);
+        return oss.str();
+    }
+
+    std::string join(const std::vector<std::string>& values) {
+        std::string joined;
+        for (const auto& value : values) {
+            joined += (joined.empty() ? "" : ", ") + value;
+        }
+        return joined;
+    }
+
+    Json::Value stringArray(const std::vector<std::string>& values) {
+        Json::Value array(Json::arrayValue);
+        for (const auto& value : values) {
+            array.append(value);
+        }
+        return array;
+    }
+
+    std::vector<std::string> readStrings(const Json::Value& array) {
+        std::vector<std::string> values;
+        for (const auto& value : array) {
+            values.push_back(value.asString());
+        }
+        return values;
+    }
+
+    std::optional<double> readOptional(const Json::Value& json, const char* key) {
+        return json[key].isNumeric() ? std::optional<double>(json[key].asDouble()) : std::nullopt;
+    }
+}
+
+DeviceDailyMetrics DeviceDailyMetrics::fromDailyStats(const std::string& device_identifier,
+                                                      const DailyStats& stats) {
+    DeviceDailyMetrics device;
+    device.device_identifier = device_identifier;
+    device.readings = stats.samples;
+    device.first_ts_ms = stats.first_ts_ms;
+    device.last_ts_ms = stats.last_ts_ms;
+    for (size_t m = 0; m < kMetricCount; ++m) {
+        const RunningStats& running = stats.metrics[m];
+        if (running.count == 0) {
+            continue;
+        }
+        MetricSummary summary;
+        summary.count = running.count;
+        summary.min = running.min;
+        summary.max = running.max;
+        summary.avg = running.mean;
+        if (running.count > 1) {
+            summary.stddev = running.stddev();
+        }
+        summary.min_ts_ms = running.min_ts_ms;
+        summary.max_ts_ms = running.max_ts_ms;
+        device.metrics[m] = summary;
+    }
+    device.status_readings = stats.status_samples;
+    device.on_battery_readings = stats.on_battery_samples;
+    device.statuses = stats.statuses;
+    device.transfer_reasons = stats.transfer_reasons;
+    return device;
+}
+
+DailyMetrics DailyMetrics::fromDailyStats(const std::string& date, const std::vector<DailyStatsRow>& rows) {
+    DailyMetrics metrics;
+    metrics.date = date;
+    metrics.source = "daily_stats";
+    metrics.devices.reserve(rows.size());
+    for (const auto& row : rows) {
+        metrics.devices.push_back(DeviceDailyMetrics::fromDailyStats(row.device_identifier, row.stats));
+    }
+    return metrics;
+}
+
+std::string DailyMetrics::toText() const {
+    if (devices.empty()) {
+        return "No UPS metrics data found for " + date + ".";
+    }
+
+    // " (at HH:MM)" when the time of an extreme is known
+    auto at = [](int64_t ts_ms) {
+        return ts_ms != 0 ? " (at " + clockTime(ts_ms) + ")" : std::string();
+    };
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    oss << "UPS Energy Report for " << date << "\n";
+    oss << "========================================\n\n";
+
+    for (const auto& device : devices) {
+        const auto& input = device.metric(Metric::InputVoltage);
+        const auto& output = device.metric(Metric::OutputVoltage);
+        const auto& load = device.metric(Metric::LoadPercentage);
+        const auto& watts = device.metric(Metric::LoadWatts);
+        const auto& battery = device.metric(Metric::BatteryCharge);
+        const auto& runtime = device.metric(Metric::BatteryRuntime);
+        const auto& temperature = device.metric(Metric::Temperature);
+
+        oss << "Device: ";
+        if (device.device_name.empty() || device.device_name == device.device_identifier) {
+            oss << device.device_identifier << "\n";
+        } else {
+            oss << device.device_name << " (" << device.device_identifier << ")\n";
+        }
+        oss << "  Readings: " << device.readings << "\n";
+        if (device.first_ts_ms != 0) {
+            oss << "  Time range: " << clockTime(device.first_ts_ms) << " to "
+                << clockTime(device.last_ts_ms) << "\n";
+        }
+
+        if (input) {
+            oss << "  Input Voltage: " << input->min << "V" << at(input->min_ts_ms) << " - "
+                << input->max << "V" << at(input->max_ts_ms) << " (avg " << input->avg << "V";
+            if (input->stddev) {
+                oss << ", stddev " << *input->stddev << "V";
+            }
+            oss << ")\n";
+        }
+        if (output) {
+            oss << "  Output Voltage: " << output->avg << "V avg\n";
+        }
+        if (load) {
+            oss << "  Load: " << load->avg << "% avg";
+            if (watts) {
+                oss << " (" << watts->avg << "W avg, " << watts->max << "W peak"
+                    << (watts->max_ts_ms != 0 ? " at " + clockTime(watts->max_ts_ms) : "") << ")";
+            }
+            oss << "\n";
+        }
+        if (battery) {
+            oss << "  Battery: " << battery->avg << "% avg, " << battery->min << "% min\n";
+        }
+        if (runtime) {
+            oss << "  Runtime Reserve: " << runtime->avg / 60.0 << " min avg, "
+                << runtime->min / 60.0 << " min min\n";
+        }
+        if (temperature) {
+            oss << "  Temperature: " << temperature->avg << "C avg\n";
+        }
+
+        oss << "  Power Failures: " << device.on_battery_readings << " of "
+            << device.status_readings << " status readings on battery\n";
+        if (!device.statuses.empty()) {
+            oss << "  UPS Status(es): " << join(device.statuses) << "\n";
+        }
+        if (!device.transfer_reasons.empty()) {
+            oss << "  Transfer Reasons: " << join(device.transfer_reasons) << "\n";
+        }
+        oss << "\n";
+    }
+
+    if (!power_events.empty()) {
+        oss << "Power Events:\n";
+        for (const auto& event : power_events) {
+            oss << "  - " << clockTime(event.timestamp_ms, "%H:%M:%S") << ": "
+                << event.device_identifier << " - " << event.event_type;
+            if (event.battery_level_start) {
+                oss << " (battery: " << *event.battery_level_start << "% -> "
+                    << event.battery_level_end.value_or(*event.battery_level_start) << "%)";
+            }
+            oss << "\n";
+        }
+        oss << "\n";
+    }
+
+    return oss.str();
+}
+
+Json::Value DailyMetrics::toJson() const {
+    Json::Value root;
+    root["date"] = date;
+    root["source"] = source;
+
+    Json::Value devices_json(Json::arrayValue);
+    for (const auto& device : devices) {
+        Json::Value entry;
+        entry["device"] = device.device_identifier;
+        entry["name"] = device.device_name;
+        entry["location"] = device.location;
+        entry["readings"] = static_cast<Json::UInt64>(device.readings);
+        entry["first"] = static_cast<Json::Int64>(device.first_ts_ms);
+        entry["last"] = static_cast<Json::Int64>(device.last_ts_ms);
+
+        Json::Value metrics_json(Json::objectValue);
+        for (size_t m = 0; m < kMetricCount; ++m) {
+            const auto& summary = device.metrics[m];
+            if (!summary) {
+                continue;
+            }
+            Json::Value metric;
+            metric["n"] = static_cast<Json::UInt64>(summary->count);
+            metric["min"] = summary->min;
+            metric["max"] = summary->max;
+            metric["avg"] = summary->avg;
+            if (summary->stddev) {
+                metric["stddev"] = *summary->stddev;
+            }
+            if (summary->min_ts_ms != 0) {
+                metric["min_ts"] = static_cast<Json::Int64>(summary->min_ts_ms);
+            }
+            if (summary->max_ts_ms != 0) {
+                metric["max_ts"] = static_cast<Json::Int64>(summary->max_ts_ms);
+            }
+            metrics_json[metricName(static_cast<Metric>(m))] = std::move(metric);
+        }
+        entry["metrics"] = std::move(metrics_json);
+
+        entry["status_readings"] = static_cast<Json::UInt64>(device.status_readings);
+        entry["on_battery_readings"] = static_cast<Json::UInt64>(device.on_battery_readings);
+        entry["statuses"] = stringArray(device.statuses);
+        entry["transfer_reasons"] = stringArray(device.transfer_reasons);
+        devices_json.append(std::move(entry));
+    }
+    root["devices"] = std::move(devices_json);
+
+    Json::Value events_json(Json::arrayValue);
+    for (const auto& event : power_events) {
+        Json::Value entry;
+        entry["device"] = event.device_identifier;
+        entry["type"] = event.event_type;
+        entry["time"] = static_cast<Json::Int64>(event.timestamp_ms);
+        if (event.battery_level_start) entry["battery_level_start"] = *event.battery_level_start;
+        if (event.battery_level_end) entry["battery_level_end"] = *event.battery_level_end;
+        if (event.load_at_event) entry["load_at_event"] = *event.load_at_event;
+        events_json.append(std::move(entry));
+    }
+    root["power_events"] = std::move(events_json);
+    return root;
+}
+
+std::optional<DailyMetrics> DailyMetrics::fromJson(const Json::Value& json) {
+    if (!json.isObject() || !json["date"].isString()) {
+        return std::nullopt;
+    }
+
+    DailyMetrics metrics;
+    metrics.date = json["date"].asString();
+    metrics.source = json.get("source", "").asString();
+
+    for (const auto& entry : json["devices"]) {
+        DeviceDailyMetrics device;
+        device.device_identifier = entry.get("device", "").asString();
+        device.device_name = entry.get("name", "").asString();
+        device.location = entry.get("location", "").asString();
+        device.readings = entry.get("readings", 0).asUInt64();
+        device.first_ts_ms = entry.get("first", 0).asInt64();
+        device.last_ts_ms = entry.get("last", 0).asInt64();
+
+        const Json::Value& metrics_json = entry["metrics"];
+        if (metrics_json.isObject()) {
+            for (const auto& name : metrics_json.getMemberNames()) {
+                auto metric = findMetric(name);
+                if (!metric) {
+                    continue;  // Metric dropped since the report was cached
+                }
+                const Json::Value& value = metrics_json[name];
+                MetricSummary summary;
+                summary.count = value.get("n", 0).asUInt64();
+                summary.min = value.get("min", 0.0).asDouble();
+                summary.max = value.get("max", 0.0).asDouble();
+                summary.avg = value.get("avg", 0.0).asDouble();
+                summary.stddev = readOptional(value, "stddev");
+                summary.min_ts_ms = value.get("min_ts", 0).asInt64();
+                summary.max_ts_ms = value.get("max_ts", 0).asInt64();
+                device.metrics[static_cast<size_t>(*metric)] = summary;
+            }
+        }
+
+        device.status_readings = entry.get("status_readings", 0).asUInt64();
+        device.on_battery_readings = entry.get("on_battery_readings", 0).asUInt64();
+        device.statuses = readStrings(entry["statuses"]);
+        device.transfer_reasons = readStrings(entry["transfer_reasons"]);
+        metrics.devices.push_back(std::move(device));
+    }
+
+    for (const auto& entry : json["power_events"]) {
+        PowerEventRow event;
+        event.device_identifier = entry.get("device", "").asString();
+        event.event_type = entry.get("type", "").asString();
+        event.timestamp_ms = entry.get("time", 0).asInt64();
+        event.battery_level_start = readOptional(entry, "battery_level_start");
+        event.battery_level_end = readOptional(entry, "battery_level_end");
+        event.load_at_event = readOptional(entry, "load_at_event");
+        metrics.power_events.push_back(std::move(event));
+    }
+    return metrics;
+}
+
+}  // namespace hms_nut
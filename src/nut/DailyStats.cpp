@@ -0,0 +1,343 @@
+#include "nut/DailyStats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+namespace hms_nut {
+
+namespace {
+    int64_t floorDiv(int64_t a, int64_t b) {
+        int64_t q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+
+    /**
+     * Local day containing ts_ms: [start_ms, end_ms) and its date (DST-aware via mktime)
+     */
+    void localDay(int64_t ts_ms, int64_t& start_ms, int64_t& end_ms, std::string& date) {
+        std::time_t t = static_cast<std::time_t>(floorDiv(ts_ms, 1000));
+        std::tm local{};
+        localtime_r(&t, &local);
+
+        char buffer[16];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", &local);
+        date = buffer;
+
+        std::tm start = local;
+        start.tm_hour = 0;
+        start.tm_min = 0;
+        start.tm_sec = 0;
+        start.tm_isdst = -1;
+        std::tm next = start;
+        next.tm_mday += 1;
+        start_ms = static_cast<int64_t>(std::mktime(&start)) * 1000;
+        end_ms = static_cast<int64_t>(std::mktime(&next)) * 1000;
+    }
+
+    void addDistinct(std::vector<std::string>& values, std::string_view value) {
+        if (value.empty() || values.size() >= DailyStats::kMaxDistinct) {
+            return;
+        }
+        if (std::find(values.begin(), values.end(), value) == values.end()) {
+            values.emplace_back(value);
+        }
+    }
+
+    Json::Value stringArray(const std::vector<std::string>& values) {
+        Json::Value array(Json::arrayValue);
+        for (const auto& value : values) {
+            array.append(value);
+        }
+        return array;
+    }
+}
+
+// ── RunningStats ────────────────────────────────────────────────────────────
+
+void RunningStats::add(double value, int64_t ts_ms) {
+    ++count;
+    double delta = value - mean;
+    mean += delta / static_cast<double>(count);
+    m2 += delta * (value - mean);
+    if (value < min) {
+        min = value;
+        min_ts_ms = ts_ms;
+    }
+    if (value > max) {
+        max = value;
+        max_ts_ms = ts_ms;
+    }
+}
+
+void RunningStats::merge(const RunningStats& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    double n_a = static_cast<double>(count);
+    double n_b = static_cast<double>(other.count);
+    double n = n_a + n_b;
+    double delta = other.mean - mean;
+    mean += delta * n_b / n;
+    m2 += other.m2 + delta * delta * n_a * n_b / n;
+    count += other.count;
+    if (other.min < min) {
+        min = other.min;
+        min_ts_ms = other.min_ts_ms;
+    }
+    if (other.max > max) {
+        max = other.max;
+        max_ts_ms = other.max_ts_ms;
+    }
+}
+
+double RunningStats::stddev() const {
+    return std::sqrt(variance());
+}
+
+// ── DailyStats ──────────────────────────────────────────────────────────────
+
+void DailyStats::merge(const DailyStats& other) {
+    if (other.samples == 0) {
+        return;
+    }
+    if (samples == 0) {
+        first_ts_ms = other.first_ts_ms;
+        last_ts_ms = other.last_ts_ms;
+    } else {
+        first_ts_ms = std::min(first_ts_ms, other.first_ts_ms);
+        last_ts_ms = std::max(last_ts_ms, other.last_ts_ms);
+    }
+    samples += other.samples;
+    for (size_t m = 0; m < kMetricCount; ++m) {
+        metrics[m].merge(other.metrics[m]);
+    }
+    status_samples += other.status_samples;
+    on_battery_samples += other.on_battery_samples;
+    for (const auto& status : other.statuses) {
+        addDistinct(statuses, status);
+    }
+    for (const auto& reason : other.transfer_reasons) {
+        addDistinct(transfer_reasons, reason);
+    }
+}
+
+Json::Value DailyStats::toJson() const {
+    Json::Value root;
+    root["date"] = date;
+    root["first"] = static_cast<Json::Int64>(first_ts_ms);
+    root["last"] = static_cast<Json::Int64>(last_ts_ms);
+    root["samples"] = static_cast<Json::UInt64>(samples);
+    root["status_samples"] = static_cast<Json::UInt64>(status_samples);
+    root["on_battery_samples"] = static_cast<Json::UInt64>(on_battery_samples);
+    root["statuses"] = stringArray(statuses);
+    root["transfer_reasons"] = stringArray(transfer_reasons);
+
+    Json::Value metrics_json(Json::objectValue);
+    for (size_t m = 0; m < kMetricCount; ++m) {
+        const RunningStats& stats = metrics[m];
+        if (stats.count == 0) {
+            continue;
+        }
+        Json::Value entry;
+        entry["n"] = static_cast<Json::UInt64>(stats.count);
+        entry["mean"] = stats.mean;
+        entry["m2"] = stats.m2;
+        entry["min"] = stats.min;
+        entry["min_ts"] = static_cast<Json::Int64>(stats.min_ts_ms);
+        entry["max"] = stats.max;
+        entry["max_ts"] = static_cast<Json::Int64>(stats.max_ts_ms);
+        metrics_json[metricName(static_cast<Metric>(m))] = std::move(entry);
+    }
+    root["metrics"] = std::move(metrics_json);
+    return root;
+}
+
+std::optional<DailyStats> DailyStats::fromJson(const Json::Value& json) {
+    if (!json.isObject() || !json["date"].isString()) {
+        return std::nullopt;
+    }
+
+    DailyStats stats;
+    stats.date = json["date"].asString();
+    stats.first_ts_ms = json.get("first", 0).asInt64();
+    stats.last_ts_ms = json.get("last", 0).asInt64();
+    stats.samples = json.get("samples", 0).asUInt64();
+    stats.status_samples = json.get("status_samples", 0).asUInt64();
+    stats.on_battery_samples = json.get("on_battery_samples", 0).asUInt64();
+    for (const auto& status : json["statuses"]) {
+        addDistinct(stats.statuses, status.asString());
+    }
+    for (const auto& reason : json["transfer_reasons"]) {
+        addDistinct(stats.transfer_reasons, reason.asString());
+    }
+
+    const Json::Value& metrics_json = json["metrics"];
+    if (metrics_json.isObject()) {
+        for (const auto& name : metrics_json.getMemberNames()) {
+            auto metric = findMetric(name);
+            if (!metric) {
+                continue;  // Metric dropped since the row was written
+            }
+            const Json::Value& entry = metrics_json[name];
+            RunningStats& target = stats.metrics[static_cast<size_t>(*metric)];
+            target.count = entry.get("n", 0).asUInt64();
+            target.mean = entry.get("mean", 0.0).asDouble();
+            target.m2 = entry.get("m2", 0.0).asDouble();
+            target.min = entry.get("min", 0.0).asDouble();
+            target.min_ts_ms = entry.get("min_ts", 0).asInt64();
+            target.max = entry.get("max", 0.0).asDouble();
+            target.max_ts_ms = entry.get("max_ts", 0).asInt64();
+        }
+    }
+    return stats;
+}
+
+bool isOnBatteryStatus(std::string_view status) {
+    // Space-separated NUT flags: "OL", "OB DISCHRG", "OL CHRG LB", ...
+    size_t pos = 0;
+    while (pos < status.size()) {
+        size_t end = status.find(' ', pos);
+        if (end == std::string_view::npos) {
+            end = status.size();
+        }
+        if (status.substr(pos, end - pos) == "OB") {
+            return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+std::string localDate(int64_t ts_ms) {
+    int64_t start_ms = 0;
+    int64_t end_ms = 0;
+    std::string date;
+    localDay(ts_ms, start_ms, end_ms, date);
+    return date;
+}
+
+int64_t localDayEnd(int64_t ts_ms) {
+    int64_t start_ms = 0;
+    int64_t end_ms = 0;
+    std::string date;
+    localDay(ts_ms, start_ms, end_ms, date);
+    return end_ms;
+}
+
+bool localDayRange(const std::string& date, int64_t& start_ms, int64_t& end_ms) {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    char trailing = 0;
+    if (date.size() != 10 ||
+        std::sscanf(date.c_str(), "%4d-%2d-%2d%c", &year, &month, &day, &trailing) != 3 ||
+        month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+
+    std::tm start{};
+    start.tm_year = year - 1900;
+    start.tm_mon = month - 1;
+    start.tm_mday = day;
+    start.tm_isdst = -1;
+    std::tm next = start;
+    next.tm_mday += 1;
+    start_ms = static_cast<int64_t>(std::mktime(&start)) * 1000;
+    end_ms = static_cast<int64_t>(std::mktime(&next)) * 1000;
+    return true;
+}
+
+// ── DailyAccumulator ────────────────────────────────────────────────────────
+
+void DailyAccumulator::addMetric(Metric metric, double value, int64_t ts_ms) {
+    touch(ts_ms).metrics[static_cast<size_t>(metric)].add(value, ts_ms);
+}
+
+void DailyAccumulator::addStatus(std::string_view status, int64_t ts_ms) {
+    DailyStats& day = touch(ts_ms);
+    ++day.status_samples;
+    if (isOnBatteryStatus(status)) {
+        ++day.on_battery_samples;
+    }
+    addDistinct(day.statuses, status);
+}
+
+void DailyAccumulator::addTransferReason(std::string_view reason, int64_t ts_ms) {
+    addDistinct(touch(ts_ms).transfer_reasons, reason);
+}
+
+void DailyAccumulator::advance(int64_t now_ms) {
+    if (current_.samples > 0 && now_ms >= day_end_ms_) {
+        enter(now_ms);
+    }
+}
+
+void DailyAccumulator::seed(const DailyStats& stats) {
+    if (stats.samples == 0) {
+        return;
+    }
+    if (current_.samples == 0) {
+        enter(stats.first_ts_ms);
+    }
+    if (stats.date == current_.date) {
+        current_.merge(stats);
+    } else if (stats.date == previous_.date) {
+        previous_.merge(stats);
+    }
+}
+
+void DailyAccumulator::takeClosed(std::vector<DailyStats>& out) {
+    if (previous_dirty_) {
+        // Late values changed the last closed day - write it again in full
+        closed_.erase(std::remove_if(closed_.begin(), closed_.end(),
+                                     [&](const DailyStats& day) { return day.date == previous_.date; }),
+                      closed_.end());
+        closed_.push_back(previous_);
+        previous_dirty_ = false;
+    }
+    for (auto& day : closed_) {
+        out.push_back(std::move(day));
+    }
+    closed_.clear();
+}
+
+void DailyAccumulator::enter(int64_t ts_ms) {
+    if (current_.samples > 0) {
+        previous_ = current_;
+        previous_start_ms_ = day_start_ms_;
+        previous_end_ms_ = day_end_ms_;
+        previous_dirty_ = false;
+        closed_.push_back(std::move(current_));
+    }
+    current_ = DailyStats();
+    localDay(ts_ms, day_start_ms_, day_end_ms_, current_.date);
+}
+
+DailyStats& DailyAccumulator::touch(int64_t ts_ms) {
+    bool in_previous = previous_.samples > 0 && ts_ms >= previous_start_ms_ && ts_ms < previous_end_ms_;
+    if (current_.date.empty() || ts_ms >= day_end_ms_ ||
+        (ts_ms < day_start_ms_ && current_.samples == 0 && !in_previous)) {
+        enter(ts_ms);
+    }
+
+    // Replayed after an outage that crossed midnight: the value belongs to the
+    // closed day. Anything older (clock step back) counts in the current day.
+    DailyStats& day = (ts_ms < day_start_ms_ && in_previous) ? previous_ : current_;
+    if (&day == &previous_) {
+        previous_dirty_ = true;
+    }
+
+    if (day.samples == 0 || ts_ms < day.first_ts_ms) {
+        day.first_ts_ms = ts_ms;
+    }
+    ++day.samples;
+    day.last_ts_ms = std::max(day.last_ts_ms, ts_ms);
+    return day;
+}
+
+}  // namespace hms_nut
@@ -0,0 +1,177 @@
+#include "nut/MetricRollup.h"
+#include <algorithm>
+
+namespace hms_nut {
+
+namespace {
+    constexpr std::array<Sensor, kMetricCount> kMetricSensors = {{
+        Sensor::BatteryCharge,
+        Sensor::BatteryVoltage,
+        Sensor::BatteryRuntime,
+        Sensor::InputVoltage,
+        Sensor::OutputVoltage,
+        Sensor::LoadPercentage,
+        Sensor::LoadWatts,
+        Sensor::Temperature,
+    }};
+
+    int64_t floorTo(int64_t ts_ms, int64_t width_ms) {
+        int64_t rem = ts_ms % width_ms;
+        return ts_ms - (rem < 0 ? rem + width_ms : rem);
+    }
+}
+
+Sensor metricSensor(Metric metric) {
+    return kMetricSensors[static_cast<size_t>(metric)];
+}
+
+const char* metricName(Metric metric) {
+    return SensorSchema::get(metricSensor(metric)).id;
+}
+
+std::optional<Metric> findMetric(std::string_view sensor_id) {
+    for (size_t i = 0; i < kMetricCount; ++i) {
+        if (sensor_id == SensorSchema::get(kMetricSensors[i]).id) {
+            return static_cast<Metric>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::vector<Metric>> parseMetricList(std::string_view csv) {
+    std::vector<Metric> metrics;
+    if (csv.empty()) {
+        for (size_t i = 0; i < kMetricCount; ++i) {
+            metrics.push_back(static_cast<Metric>(i));
+        }
+        return metrics;
+    }
+
+    size_t pos = 0;
+    while (true) {
+        size_t comma = csv.find(',', pos);
+        auto metric = findMetric(csv.substr(pos, comma - pos));  // Empty id fails too
+        if (!metric) {
+            return std::nullopt;
+        }
+        if (std::find(metrics.begin(), metrics.end(), *metric) == metrics.end()) {
+            metrics.push_back(*metric);
+        }
+        if (comma == std::string_view::npos) {
+            return metrics;
+        }
+        pos = comma + 1;
+    }
+}
+
+const char* seriesTierName(SeriesTier tier) {
+    switch (tier) {
+        case SeriesTier::Raw: return "raw";
+        case SeriesTier::Minute: return "1m";
+        case SeriesTier::Hour: return "1h";
+        case SeriesTier::Stored: return "stored";
+    }
+    return "unknown";
+}
+
+SeriesTier chooseSeriesTier(const CollectorTierConfig& config, int64_t from_ms, int64_t to_ms,
+                            int64_t now_ms, size_t max_rows) {
+    constexpr int64_t kDayMs = 24 * RollupAccumulator::kHourMs;
+
+    if (config.raw_window_seconds > 0 &&
+        from_ms >= now_ms - static_cast<int64_t>(config.raw_window_seconds) * 1000) {
+        return SeriesTier::Raw;
+    }
+    if (!config.persist_rollups) {
+        return SeriesTier::Stored;
+    }
+
+    int64_t minutes = (to_ms - from_ms) / RollupAccumulator::kMinuteMs;
+    if (from_ms >= now_ms - config.minute_retention_days * kDayMs &&
+        minutes <= static_cast<int64_t>(max_rows)) {
+        return SeriesTier::Minute;
+    }
+    if (from_ms >= now_ms - config.hour_retention_days * kDayMs) {
+        return SeriesTier::Hour;
+    }
+    return SeriesTier::Stored;
+}
+
+void MetricAggregate::add(double value) {
+    ++count;
+    sum += value;
+    min = std::min(min, value);
+    max = std::max(max, value);
+}
+
+void MetricAggregate::merge(const MetricAggregate& other) {
+    count += other.count;
+    sum += other.sum;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+bool RollupBucket::empty() const {
+    return std::all_of(metrics.begin(), metrics.end(),
+                       [](const MetricAggregate& agg) { return agg.count == 0; });
+}
+
+void RollupAccumulator::add(Metric metric, double value, int64_t ts_ms) {
+    int64_t minute_start = floorTo(ts_ms, kMinuteMs);
+
+    // Late values (clock step back) fold into the open bucket
+    if (!minute_open_ || minute_start > minute_.start_ms) {
+        advance(minute_start);
+        minute_ = RollupBucket();
+        minute_.start_ms = minute_start;
+        minute_open_ = true;
+    }
+    minute_.metrics[static_cast<size_t>(metric)].add(value);
+}
+
+void RollupAccumulator::advance(int64_t now_ms) {
+    if (minute_open_ && minute_.start_ms + kMinuteMs <= now_ms) {
+        closeMinute();
+    }
+    if (hour_open_ && hour_.start_ms + kHourMs <= now_ms) {
+        closeHour();
+    }
+}
+
+void RollupAccumulator::takeClosed(std::vector<RollupBucket>& minutes, std::vector<RollupBucket>& hours) {
+    minutes.insert(minutes.end(), closed_minutes_.begin(), closed_minutes_.end());
+    hours.insert(hours.end(), closed_hours_.begin(), closed_hours_.end());
+    closed_minutes_.clear();
+    closed_hours_.clear();
+}
+
+void RollupAccumulator::closeMinute() {
+    minute_open_ = false;
+    if (minute_.empty()) {
+        return;
+    }
+
+    int64_t hour_start = floorTo(minute_.start_ms, kHourMs);
+    if (hour_open_ && hour_.start_ms != hour_start) {
+        closeHour();
+    }
+    if (!hour_open_) {
+        hour_ = RollupBucket();
+        hour_.start_ms = hour_start;
+        hour_open_ = true;
+    }
+    for (size_t i = 0; i < kMetricCount; ++i) {
+        hour_.metrics[i].merge(minute_.metrics[i]);
+    }
+
+    closed_minutes_.push_back(minute_);
+}
+
+void RollupAccumulator::closeHour() {
+    hour_open_ = false;
+    if (!hour_.empty()) {
+        closed_hours_.push_back(hour_);
+    }
+}
+
+}  // namespace hms_nut
@@ -0,0 +1,91 @@
+#include "nut/SampleRing.h"
+#include <algorithm>
+#include <limits>
+
+namespace hms_nut {
+
+SampleRing::SampleRing(size_t capacity, int64_t window_ms)
+    : window_ms_(window_ms),
+      timestamps_(std::max<size_t>(capacity, 1), 0) {
+    for (auto& column : columns_) {
+        column.assign(timestamps_.size(), std::numeric_limits<float>::quiet_NaN());
+    }
+}
+
+void SampleRing::record(Metric metric, float value, int64_t ts_ms) {
+    if (size_ == 0 || ts_ms - timestamp(size_ - 1) >= kRowWindowMs) {
+        pushRow(ts_ms);
+    }
+    columns_[static_cast<size_t>(metric)][physical(size_ - 1)] = value;
+}
+
+size_t SampleRing::lowerBound(int64_t since_ms) const {
+    // Timestamps are non-decreasing in logical order - binary search
+    size_t lo = 0;
+    size_t hi = size_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (timestamp(mid) < since_ms) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void SampleRing::copySince(int64_t since_ms, const std::vector<Metric>& metrics,
+                           SampleSeries& out) const {
+    size_t first = lowerBound(since_ms);
+    size_t count = size_ - first;
+
+    // Logical [first, size_) is physical [begin, cap) + [0, tail) when wrapped
+    size_t cap = timestamps_.size();
+    size_t begin = physical(first);
+    size_t head = std::min(count, cap - begin);
+    size_t tail = count - head;
+
+    auto copy_column = [&](const auto& src, auto& dst) {
+        dst.assign(src.begin() + begin, src.begin() + begin + head);
+        dst.insert(dst.end(), src.begin(), src.begin() + tail);
+    };
+
+    out.metrics = metrics;
+    copy_column(timestamps_, out.timestamps);
+    out.columns.resize(metrics.size());
+    for (size_t k = 0; k < metrics.size(); ++k) {
+        copy_column(columns_[static_cast<size_t>(metrics[k])], out.columns[k]);
+    }
+}
+
+void SampleRing::pushRow(int64_t ts_ms) {
+    // Keep rows ordered even if the wall clock steps back
+    if (size_ > 0) {
+        ts_ms = std::max(ts_ms, timestamp(size_ - 1));
+    }
+
+    // Age out rows that fell out of the window
+    while (window_ms_ > 0 && size_ > 0 && ts_ms - timestamp(0) > window_ms_) {
+        start_ = physical(1);
+        --size_;
+    }
+
+    size_t cap = timestamps_.size();
+    size_t slot;
+    size_t prev = size_ > 0 ? physical(size_ - 1) : cap;
+    if (size_ < cap) {
+        slot = physical(size_);
+        ++size_;
+    } else {
+        // Full - overwrite the oldest
+        slot = start_;
+        start_ = physical(1);
+    }
+
+    timestamps_[slot] = ts_ms;
+    for (auto& column : columns_) {
+        column[slot] = prev < cap ? column[prev] : std::numeric_limits<float>::quiet_NaN();
+    }
+}
+
+}  // namespace hms_nut
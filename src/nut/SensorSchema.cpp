@@ -0,0 +1,131 @@
+#include "nut/SensorSchema.h"
+#include <json/json.h>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+namespace hms_nut {
+
+namespace {
+    // Precision follows what NUT drivers actually report (e.g. battery.voltage "13.65",
+    // input.voltage "121.0"). Integral sensors use 0.
+    //
+    // Publish policy: telemetry that changes every poll goes out at QoS 0, not
+    // retained (a lost sample is replaced by the next poll). Status, power
+    // failure, nominal values and other rarely changing fields use QoS 1 and are
+    // retained, so subscribers get them immediately after (re)connecting.
+    const std::array<SensorInfo, kSensorCount> kSensors = {{
+        // id, kind, precision, name, unit, device_class, state_class, icon, qos, retain
+        {"battery_charge",                   SensorKind::Numeric, 0, "Battery Charge", "%", "battery", "measurement", "", 0, false},
+        {"battery_voltage",                  SensorKind::Numeric, 2, "Battery Voltage", "V", "voltage", "measurement", "", 0, false},
+        {"battery_runtime",                  SensorKind::Numeric, 0, "Battery Runtime", "min", "duration", "measurement", "mdi:timer-outline", 0, false},
+        {"battery_nominal_voltage",          SensorKind::Numeric, 1, "Battery Nominal Voltage", "V", "voltage", "measurement", "", 1, true},
+        {"battery_low_charge_threshold",     SensorKind::Numeric, 0, "Battery Low Charge Threshold", "%", "battery", "measurement", "", 1, true},
+        {"battery_warning_charge_threshold", SensorKind::Numeric, 0, "Battery Warning Charge Threshold", "%", "battery", "measurement", "", 1, true},
+        {"input_voltage",                    SensorKind::Numeric, 1, "Input Voltage", "V", "voltage", "measurement", "", 0, false},
+        {"input_nominal_voltage",            SensorKind::Numeric, 0, "Input Nominal Voltage", "V", "voltage", "measurement", "", 1, true},
+        {"high_voltage_transfer",            SensorKind::Numeric, 0, "High Voltage Transfer", "V", "voltage", "measurement", "", 1, true},
+        {"low_voltage_transfer",             SensorKind::Numeric, 0, "Low Voltage Transfer", "V", "voltage", "measurement", "", 1, true},
+        {"input_sensitivity",                SensorKind::Text,    0, "Input Sensitivity", "", "", "", "mdi:tune", 1, true},
+        {"last_transfer_reason",             SensorKind::Text,    0, "Last Transfer Reason", "", "", "", "mdi:information-outline", 1, true},
+        {"load_percentage",                  SensorKind::Numeric, 1, "Load", "%", "power_factor", "measurement", "mdi:gauge", 0, false},
+        {"load_watts",                       SensorKind::Numeric, 1, "Load Power", "W", "power", "measurement", "", 0, false},
+        {"ups_status",                       SensorKind::Text,    0, "UPS Status", "", "", "", "mdi:information", 1, true},
+        {"power_failure",                    SensorKind::Binary,  0, "Power Failure", "", "power", "", "mdi:power-plug-off", 1, true},
+        {"ups_nominal_power",                SensorKind::Numeric, 0, "Nominal Power", "W", "power", "measurement", "", 1, true},
+        {"beeper_status",                    SensorKind::Text,    0, "Beeper Status", "", "", "", "mdi:volume-high", 1, true},
+        {"self_test_result",                 SensorKind::Text,    0, "Self Test Result", "", "", "", "mdi:clipboard-check", 1, true},
+        {"firmware_version",                 SensorKind::Text,    0, "Firmware Version", "", "", "", "mdi:chip", 1, true},
+        {"driver_name",                      SensorKind::Text,    0, "Driver Name", "", "", "", "mdi:application", 1, true},
+        {"driver_version",                   SensorKind::Text,    0, "Driver Version", "", "", "", "mdi:tag", 1, true},
+        {"driver_state",                     SensorKind::Text,    0, "Driver State", "", "", "", "mdi:state-machine", 1, true},
+        {"temperature",                      SensorKind::Numeric, 1, "Temperature", "°C", "temperature", "measurement", "", 0, false},
+        {"output_voltage",                   SensorKind::Numeric, 1, "Output Voltage", "V", "voltage", "measurement", "", 0, false},
+        {"output_nominal_voltage",           SensorKind::Numeric, 0, "Output Nominal Voltage", "V", "voltage", "measurement", "", 1, true},
+    }};
+
+    std::array<PublishPolicy, kSensorCount> defaultPolicies() {
+        std::array<PublishPolicy, kSensorCount> policies;
+        for (size_t i = 0; i < kSensorCount; ++i) {
+            policies[i] = PublishPolicy{kSensors[i].qos, kSensors[i].retain};
+        }
+        return policies;
+    }
+
+    std::array<PublishPolicy, kSensorCount>& policies() {
+        static std::array<PublishPolicy, kSensorCount> table = defaultPolicies();
+        return table;
+    }
+}
+
+const std::array<SensorInfo, kSensorCount>& SensorSchema::all() {
+    return kSensors;
+}
+
+PublishPolicy SensorSchema::policy(Sensor sensor) {
+    return policies()[static_cast<size_t>(sensor)];
+}
+
+void SensorSchema::setPolicy(Sensor sensor, PublishPolicy policy) {
+    policy.qos = std::clamp(policy.qos, 0, 2);
+    policies()[static_cast<size_t>(sensor)] = policy;
+}
+
+void SensorSchema::resetPolicies() {
+    policies() = defaultPolicies();
+}
+
+bool SensorSchema::applyPolicyOverrides(const std::string& json) {
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    std::istringstream stream(json);
+
+    if (!Json::parseFromStream(builder, stream, &root, &errors) || !root.isObject()) {
+        std::cerr << "❌ SensorSchema: Invalid sensor policy JSON: " << errors << std::endl;
+        return false;
+    }
+
+    bool all_ok = true;
+    for (const auto& id : root.getMemberNames()) {
+        auto sensor = find(id);
+        const Json::Value& entry = root[id];
+        if (!sensor || !entry.isObject()) {
+            std::cerr << "⚠️  SensorSchema: Ignoring policy for unknown sensor: " << id << std::endl;
+            all_ok = false;
+            continue;
+        }
+
+        PublishPolicy current = policy(*sensor);
+        if (entry.isMember("qos") && entry["qos"].isInt()) {
+            current.qos = entry["qos"].asInt();
+        }
+        if (entry.isMember("retain") && entry["retain"].isBool()) {
+            current.retain = entry["retain"].asBool();
+        }
+        setPolicy(*sensor, current);
+
+        std::cout << "📋 SensorSchema: " << id << " -> QoS " << policy(*sensor).qos
+                  << (policy(*sensor).retain ? ", retained" : "") << std::endl;
+    }
+    return all_ok;
+}
+
+int SensorSchema::maxQos() {
+    int max_qos = 0;
+    for (const auto& p : policies()) {
+        max_qos = std::max(max_qos, p.qos);
+    }
+    return max_qos;
+}
+
+std::optional<Sensor> SensorSchema::find(std::string_view id) {
+    for (size_t i = 0; i < kSensorCount; ++i) {
+        if (id == kSensors[i].id) {
+            return static_cast<Sensor>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace hms_nut
@@ -1,4 +1,11 @@
 #include "nut/UpsData.h"
+#include "nut/SensorSchema.h"
+#include "utils/CompactWriter.h"
+#include "utils/NumberParser.h"
+#include <charconv>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
 #include <sstream>
 #include <iomanip>
 #include <cmath>
@@ -7,26 +14,72 @@
 namespace hms_nut {
 
 namespace {
-    // Helper to safely parse double
+    // Helper to safely parse double (no exceptions on invalid input)
     std::optional<double> parseDouble(const std::string& str) {
-        try {
-            size_t pos;
-            double value = std::stod(str, &pos);
-            return (pos > 0) ? std::optional<double>(value) : std::nullopt;
-        } catch (...) {
-            return std::nullopt;
-        }
+        return NumberParser::parseDouble(str).toOptional();
     }
 
-    // Helper to safely parse int
+    // Helper to safely parse int (no exceptions on invalid input)
     std::optional<int> parseInt(const std::string& str) {
-        try {
-            size_t pos;
-            int value = std::stoi(str, &pos);
-            return (pos > 0) ? std::optional<int>(value) : std::nullopt;
-        } catch (...) {
-            return std::nullopt;
+        return NumberParser::parseInt(str).toOptional();
+    }
+
+    // Per-device state topics, built once instead of concatenated for every field on every poll.
+    // Thread-local: each bridge thread keeps its own cache, so lookups never lock.
+    const std::array<std::string, kSensorCount>& stateTopicsFor(const std::string& device_id) {
+        using TopicArray = std::array<std::string, kSensorCount>;
+        thread_local std::unordered_map<std::string, std::unique_ptr<TopicArray>> cache;
+        thread_local const std::string* last_device = nullptr;
+        thread_local const TopicArray* last_topics = nullptr;
+
+        if (last_device && *last_device == device_id) {
+            return *last_topics;
+        }
+
+        auto it = cache.find(device_id);
+        if (it == cache.end()) {
+            auto topics = std::make_unique<TopicArray>();
+            const std::string base_topic = "homeassistant/sensor/" + device_id + "/";
+            for (size_t i = 0; i < kSensorCount; ++i) {
+                (*topics)[i] = base_topic + SensorSchema::all()[i].id + "/state";
+            }
+            it = cache.emplace(device_id, std::move(topics)).first;
+        }
+
+        last_device = &it->first;
+        last_topics = it->second.get();
+        return *last_topics;
+    }
+
+    // Format a number with at most `precision` decimals, trailing zeros trimmed
+    // ("230.000000" from std::to_string becomes "230", 13.65 stays "13.65")
+    std::string_view formatNumber(double value, int precision, char* buffer, size_t size) {
+        auto [ptr, ec] = std::to_chars(buffer, buffer + size, value, std::chars_format::fixed, precision);
+        if (ec != std::errc()) {
+            // Too wide for fixed notation (absurd driver value) - fall back to shortest form
+            auto fallback = std::to_chars(buffer, buffer + size, value);
+            return std::string_view(buffer, fallback.ptr - buffer);
+        }
+
+        if (precision > 0) {
+            while (ptr[-1] == '0') {
+                --ptr;
+            }
+            if (ptr[-1] == '.') {
+                --ptr;
+            }
         }
+
+        std::string_view result(buffer, ptr - buffer);
+        if (result == "-0") {
+            result = "0";
+        }
+        return result;
+    }
+
+    std::string_view formatNumber(int value, int /*precision*/, char* buffer, size_t size) {
+        auto [ptr, ec] = std::to_chars(buffer, buffer + size, value);
+        return ec == std::errc() ? std::string_view(buffer, ptr - buffer) : std::string_view();
     }
 
     // Helper to get string value from map
@@ -241,110 +294,144 @@ std::string UpsData::toJson() const {
 
 std::vector<MqttMessage> UpsData::toMqttMessages() const {
     std::vector<MqttMessage> messages;
-    std::string base_topic = "homeassistant/sensor/" + device_id;
-
-    auto addMessage = [&](const std::string& sensor, const std::string& value) {
-        messages.push_back({
-            base_topic + "/" + sensor + "/state",
-            value,
-            1,  // QoS 1
-            false  // Not retained
-        });
+    toMqttMessages(messages);
+    return messages;
+}
+
+void UpsData::toMqttMessages(std::vector<MqttMessage>& messages) const {
+    const auto& topics = stateTopicsFor(device_id);
+    size_t count = 0;
+    char buffer[32];
+
+    // Reuse existing elements so topic/payload strings keep their capacity across polls
+    auto emit = [&](Sensor sensor, std::string_view value) {
+        if (count == messages.size()) {
+            messages.emplace_back();
+        }
+        MqttMessage& msg = messages[count++];
+        msg.topic.assign(topics[static_cast<size_t>(sensor)]);
+        msg.payload.assign(value.data(), value.size());
+
+        // Per-sensor policy: QoS 0 telemetry, QoS 1 retained status/nominal values
+        PublishPolicy policy = SensorSchema::policy(sensor);
+        msg.qos = policy.qos;
+        msg.retain = policy.retain;
+    };
+
+    auto addNumber = [&](Sensor sensor, const auto& value) {
+        if (value) {
+            emit(sensor, formatNumber(*value, SensorSchema::get(sensor).precision, buffer, sizeof(buffer)));
+        }
+    };
+
+    auto addText = [&](Sensor sensor, const std::optional<std::string>& value) {
+        if (value) {
+            emit(sensor, *value);
+        }
     };
 
     // Battery metrics
-    if (battery_charge) {
-        addMessage("battery_charge", std::to_string(*battery_charge));
-    }
-    if (battery_voltage) {
-        addMessage("battery_voltage", std::to_string(*battery_voltage));
-    }
-    if (battery_runtime) {
-        addMessage("battery_runtime", std::to_string(*battery_runtime));
-    }
-    if (battery_nominal_voltage) {
-        addMessage("battery_nominal_voltage", std::to_string(*battery_nominal_voltage));
-    }
-    if (battery_low_threshold) {
-        addMessage("battery_low_charge_threshold", std::to_string(*battery_low_threshold));
-    }
-    if (battery_warning_threshold) {
-        addMessage("battery_warning_charge_threshold", std::to_string(*battery_warning_threshold));
-    }
+    addNumber(Sensor::BatteryCharge, battery_charge);
+    addNumber(Sensor::BatteryVoltage, battery_voltage);
+    addNumber(Sensor::BatteryRuntime, battery_runtime);
+    addNumber(Sensor::BatteryNominalVoltage, battery_nominal_voltage);
+    addNumber(Sensor::BatteryLowChargeThreshold, battery_low_threshold);
+    addNumber(Sensor::BatteryWarningChargeThreshold, battery_warning_threshold);
 
     // Input metrics
-    if (input_voltage) {
-        addMessage("input_voltage", std::to_string(*input_voltage));
-    }
-    if (input_nominal_voltage) {
-        addMessage("input_nominal_voltage", std::to_string(*input_nominal_voltage));
-    }
-    if (high_voltage_transfer) {
-        addMessage("high_voltage_transfer", std::to_string(*high_voltage_transfer));
-    }
-    if (low_voltage_transfer) {
-        addMessage("low_voltage_transfer", std::to_string(*low_voltage_transfer));
-    }
-    if (input_sensitivity) {
-        addMessage("input_sensitivity", *input_sensitivity);
-    }
-    if (last_transfer_reason) {
-        addMessage("last_transfer_reason", *last_transfer_reason);
-    }
+    addNumber(Sensor::InputVoltage, input_voltage);
+    addNumber(Sensor::InputNominalVoltage, input_nominal_voltage);
+    addNumber(Sensor::HighVoltageTransfer, high_voltage_transfer);
+    addNumber(Sensor::LowVoltageTransfer, low_voltage_transfer);
+    addText(Sensor::InputSensitivity, input_sensitivity);
+    addText(Sensor::LastTransferReason, last_transfer_reason);
 
     // Load & status
-    if (load_percentage) {
-        addMessage("load_percentage", std::to_string(*load_percentage));
-    }
-    if (load_watts) {
-        addMessage("load_watts", std::to_string(*load_watts));
-    }
-    if (ups_status) {
-        addMessage("ups_status", *ups_status);
-    }
+    addNumber(Sensor::LoadPercentage, load_percentage);
+    addNumber(Sensor::LoadWatts, load_watts);
+    addText(Sensor::UpsStatus, ups_status);
     if (power_failure) {
-        addMessage("power_failure", *power_failure ? "1" : "0");
+        emit(Sensor::PowerFailure, *power_failure ? "1" : "0");
     }
 
     // UPS info
-    if (ups_nominal_power) {
-        addMessage("ups_nominal_power", std::to_string(*ups_nominal_power));
-    }
-    if (beeper_status) {
-        addMessage("beeper_status", *beeper_status);
-    }
-    if (self_test_result) {
-        addMessage("self_test_result", *self_test_result);
-    }
-    if (firmware_version) {
-        addMessage("firmware_version", *firmware_version);
-    }
+    addNumber(Sensor::UpsNominalPower, ups_nominal_power);
+    addText(Sensor::BeeperStatus, beeper_status);
+    addText(Sensor::SelfTestResult, self_test_result);
+    addText(Sensor::FirmwareVersion, firmware_version);
 
     // Driver
-    if (driver_name) {
-        addMessage("driver_name", *driver_name);
-    }
-    if (driver_version) {
-        addMessage("driver_version", *driver_version);
-    }
-    if (driver_state) {
-        addMessage("driver_state", *driver_state);
-    }
+    addText(Sensor::DriverName, driver_name);
+    addText(Sensor::DriverVersion, driver_version);
+    addText(Sensor::DriverState, driver_state);
 
     // Temperature
-    if (temperature) {
-        addMessage("temperature", std::to_string(*temperature));
-    }
+    addNumber(Sensor::Temperature, temperature);
 
     // Output voltage
-    if (output_voltage) {
-        addMessage("output_voltage", std::to_string(*output_voltage));
-    }
-    if (output_nominal_voltage) {
-        addMessage("output_nominal_voltage", std::to_string(*output_nominal_voltage));
-    }
+    addNumber(Sensor::OutputVoltage, output_voltage);
+    addNumber(Sensor::OutputNominalVoltage, output_nominal_voltage);
 
-    return messages;
+    messages.resize(count);
+}
+
+void UpsData::encodeSensors(CompactWriter& writer) const {
+    // Same sensor order as toMqttMessages(); visited twice - the binary
+    // formats need the entry count before the first entry
+    auto visit = [this](auto&& field) {
+        field(Sensor::BatteryCharge, battery_charge);
+        field(Sensor::BatteryVoltage, battery_voltage);
+        field(Sensor::BatteryRuntime, battery_runtime);
+        field(Sensor::BatteryNominalVoltage, battery_nominal_voltage);
+        field(Sensor::BatteryLowChargeThreshold, battery_low_threshold);
+        field(Sensor::BatteryWarningChargeThreshold, battery_warning_threshold);
+        field(Sensor::InputVoltage, input_voltage);
+        field(Sensor::InputNominalVoltage, input_nominal_voltage);
+        field(Sensor::HighVoltageTransfer, high_voltage_transfer);
+        field(Sensor::LowVoltageTransfer, low_voltage_transfer);
+        field(Sensor::InputSensitivity, input_sensitivity);
+        field(Sensor::LastTransferReason, last_transfer_reason);
+        field(Sensor::LoadPercentage, load_percentage);
+        field(Sensor::LoadWatts, load_watts);
+        field(Sensor::UpsStatus, ups_status);
+        field(Sensor::PowerFailure, power_failure);
+        field(Sensor::UpsNominalPower, ups_nominal_power);
+        field(Sensor::BeeperStatus, beeper_status);
+        field(Sensor::SelfTestResult, self_test_result);
+        field(Sensor::FirmwareVersion, firmware_version);
+        field(Sensor::DriverName, driver_name);
+        field(Sensor::DriverVersion, driver_version);
+        field(Sensor::DriverState, driver_state);
+        field(Sensor::Temperature, temperature);
+        field(Sensor::OutputVoltage, output_voltage);
+        field(Sensor::OutputNominalVoltage, output_nominal_voltage);
+    };
+
+    size_t present = 0;
+    visit([&present](Sensor, const auto& value) {
+        if (value) {
+            ++present;
+        }
+    });
+
+    writer.beginMap(present);
+    visit([&writer](Sensor sensor, const auto& value) {
+        if (!value) {
+            return;
+        }
+        writer.key(SensorSchema::get(sensor).id);
+        using T = std::decay_t<decltype(*value)>;
+        if constexpr (std::is_same_v<T, std::string>) {
+            writer.string(*value);
+        } else if constexpr (std::is_same_v<T, bool>) {
+            writer.boolean(*value);
+        } else if constexpr (std::is_same_v<T, int>) {
+            writer.integer(*value);
+        } else {
+            writer.number(*value);
+        }
+    });
+    writer.endMap();
 }
 
 }  // namespace hms_nut
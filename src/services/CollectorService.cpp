@@ -1,20 +1,44 @@
 #include "services/CollectorService.h"
 #include "utils/DeviceMapper.h"
+#include "nut/SensorSchema.h"
+#include "utils/NumberParser.h"
+#include "utils/TimeBuckets.h"
+#include "utils/Metrics.h"
 #include <iostream>
-#include <sstream>
 #include <algorithm>
 
 namespace hms_nut {
 
+namespace {
+    struct CollectorMetrics {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        Histogram& save = registry.histogram(
+            "hms_nut_collector_save_seconds", "Time to write one ups_metrics batch");
+        Counter& save_failures = registry.counter(
+            "hms_nut_collector_save_failures_total", "ups_metrics batches that could not be written");
+        Gauge& pending_rollups = registry.gauge(
+            "hms_nut_collector_pending_rollup_rows", "Rollup rows waiting to be written (minute + hour)");
+    };
+
+    CollectorMetrics& metrics() {
+        static CollectorMetrics m;
+        return m;
+    }
+}
+
 CollectorService::CollectorService(std::shared_ptr<MqttClient> mqtt_client,
                                    DatabaseService& db_service,
-                                   int save_interval_seconds)
+                                   int save_interval_seconds,
+                                   size_t max_devices)
     : mqtt_client_(mqtt_client),
       db_service_(db_service),
       save_interval_seconds_(save_interval_seconds),
+      max_devices_(max_devices),
+      slots_(std::make_unique<DeviceSlot[]>(max_devices)),
       running_(false) {
 
-    std::cout << "💾 Collector: Initialized (save interval: " << save_interval_seconds_ << "s)" << std::endl;
+    std::cout << "💾 Collector: Initialized (save interval: " << save_interval_seconds_
+              << "s, device slots: " << max_devices_ << ")" << std::endl;
 }
 
 CollectorService::~CollectorService() {
@@ -28,6 +52,23 @@ void CollectorService::start() {
     }
 
     std::cout << "🚀 Collector: Starting..." << std::endl;
+
+    // Pick up today's stats written before a restart, so the day isn't restarted from zero
+    if (tiers_.daily_stats && db_service_.isConnected()) {
+        int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        std::vector<DailyStatsRow> rows;
+        if (db_service_.queryDailyStats(localDate(now_ms), rows)) {
+            std::unique_lock<std::shared_mutex> lock(index_mutex_);
+            for (auto& row : rows) {
+                restored_daily_[row.device_identifier] = std::move(row.stats);
+            }
+            if (!rows.empty()) {
+                std::cout << "📅 Collector: Restored today's stats for " << rows.size() << " device(s)" << std::endl;
+            }
+        }
+    }
+
     running_ = true;
 
     // Start background saver thread (subscriptions done separately via setupSubscriptions())
@@ -36,23 +77,66 @@ void CollectorService::start() {
     std::cout << "✅ Collector: Started" << std::endl;
 }
 
+void CollectorService::enableAutoDiscovery(DeviceFilterConfig config) {
+    config.always_admit = DeviceMapper::getDeviceIds();
+    device_filter_ = std::make_unique<DeviceFilter>(std::move(config));
+
+    const auto& cfg = device_filter_->getConfig();
+    std::cout << "🔎 Collector: Auto-discovery enabled (" << cfg.allow.size() << " allow, "
+              << cfg.deny.size() << " deny pattern(s)"
+              << (cfg.require_discovery ? ", discovery config required" : "") << ")" << std::endl;
+}
+
+void CollectorService::configureTiers(const CollectorTierConfig& config) {
+    tiers_ = config;
+    std::cout << "📈 Collector: History tiers - raw: ";
+    if (tiers_.raw_window_seconds > 0) {
+        std::cout << tiers_.raw_window_seconds << "s / " << tiers_.raw_capacity << " rows";
+    } else {
+        std::cout << "disabled";
+    }
+    std::cout << ", rollups: ";
+    if (tiers_.persist_rollups) {
+        std::cout << "1m (" << tiers_.minute_retention_days << "d), 1h ("
+                  << tiers_.hour_retention_days << "d)";
+    } else {
+        std::cout << "disabled";
+    }
+    std::cout << ", daily stats: " << (tiers_.daily_stats ? "enabled" : "disabled") << std::endl;
+}
+
 void CollectorService::setupSubscriptions() {
-    // Build MQTT topic patterns from configured device IDs
-    std::vector<std::string> device_ids = DeviceMapper::getDeviceIds();
     std::vector<std::string> topics;
 
-    for (const auto& device_id : device_ids) {
-        std::string topic = "homeassistant/sensor/" + device_id + "/+/state";
-        topics.push_back(topic);
-        std::cout << "   📡 Subscribing to: " << topic << std::endl;
+    if (device_filter_) {
+        // One wildcard instead of one pattern per device - new devices are
+        // picked up without a restart, the filter drops everything else
+        topics.push_back("homeassistant/sensor/+/+/state");
+        std::cout << "   📡 Subscribing to: " << topics.back() << " (auto-discovery)" << std::endl;
+
+        if (device_filter_->getConfig().require_discovery) {
+            std::string config_topic = "homeassistant/sensor/+/+/config";
+            std::cout << "   📡 Subscribing to: " << config_topic << std::endl;
+            mqtt_client_->subscribe(config_topic, [this](const std::string& topic, const std::string&) {
+                onDiscoveryConfig(topic);
+            }, 1);
+        }
+    } else {
+        // Build MQTT topic patterns from configured device IDs
+        for (const auto& device_id : DeviceMapper::getDeviceIds()) {
+            std::string topic = "homeassistant/sensor/" + device_id + "/+/state";
+            topics.push_back(topic);
+            std::cout << "   📡 Subscribing to: " << topic << std::endl;
+        }
     }
 
-    auto callback = [this](const std::string& topic, const std::string& payload) {
-        onMqttMessage(topic, payload);
+    auto callback = [this](const std::string& topic, const std::string& payload, int64_t timestamp_ms) {
+        onMqttMessage(topic, payload, timestamp_ms);
     };
 
-    // Subscribe to all sensor topics
-    if (!mqtt_client_->subscribeMultiple(topics, callback, 1)) {
+    // Subscribe at the highest QoS any sensor is published with - the broker
+    // delivers each message at min(publish QoS, subscription QoS)
+    if (!mqtt_client_->subscribeMultiple(topics, callback, SensorSchema::maxQos())) {
         std::cerr << "⚠️  Collector: MQTT subscription failed" << std::endl;
     } else {
         std::cout << "✅ Collector: Subscribed to " << topics.size() << " device topic(s)" << std::endl;
@@ -65,17 +149,26 @@ void CollectorService::stop() {
     }
 
     std::cout << "🛑 Collector: Stopping..." << std::endl;
-    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(saver_mutex_);
+        running_ = false;
+    }
+    saver_cv_.notify_all();
 
     // Wait for saver thread to finish
     if (saver_thread_.joinable()) {
         saver_thread_.join();
     }
 
-    // Flush remaining data
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    for (const auto& [device_id, data] : device_data_) {
-        saveDeviceData(device_id);
+    // Flush the partial interval into the bucket it belongs to; the next run
+    // overwrites that row (ON CONFLICT) when the boundary is reached
+    auto now = std::chrono::system_clock::now();
+    saveAllDevices(nextBoundary(now, save_interval_seconds_));
+    if (tiers_.persist_rollups) {
+        flushRollups(nextBoundary(now, 3600));  // Close the open minute and hour too
+    }
+    if (tiers_.daily_stats) {
+        flushDailyStats(now);  // Today so far, plus closed days still waiting for the database
     }
 
     std::cout << "✅ Collector: Stopped" << std::endl;
@@ -91,139 +184,470 @@ std::chrono::system_clock::time_point CollectorService::getLastSaveTime() const
 }
 
 int CollectorService::getDeviceCount() const {
-    std::lock_guard<std::mutex> lock(data_mutex_);
-    return device_data_.size();
+    return static_cast<int>(slot_count_.load(std::memory_order_acquire));
+}
+
+std::vector<std::string> CollectorService::getDeviceIds() const {
+    // mqtt_device_id is immutable once the slot is published
+    size_t count = slot_count_.load(std::memory_order_acquire);
+    std::vector<std::string> ids;
+    ids.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        ids.push_back(slots_[i].mqtt_device_id);
+    }
+    return ids;
 }
 
-std::pair<std::string, std::string> CollectorService::parseTopic(const std::string& topic) const {
+CollectorService::DeviceSlot* CollectorService::findSlot(std::string_view device_id) const {
+    std::shared_lock<std::shared_mutex> lock(index_mutex_);
+    auto it = slot_index_.find(device_id);
+    if (it != slot_index_.end()) {
+        return &slots_[it->second];
+    }
+    auto db_it = db_slot_index_.find(device_id);
+    if (db_it != db_slot_index_.end()) {
+        return &slots_[db_it->second];
+    }
+    return nullptr;
+}
+
+bool CollectorService::getHistory(std::string_view device_id, int64_t since_ms,
+                                  const std::vector<Metric>& metrics, SampleSeries& out) const {
+    DeviceSlot* slot = findSlot(device_id);
+    if (!slot) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    if (!slot->raw) {
+        return false;
+    }
+    slot->raw->copySince(since_ms, metrics, out);
+    return true;
+}
+
+void CollectorService::encodeSnapshots(CompactWriter& writer) const {
+    // Slots below slot_count_ are fully constructed and never removed
+    size_t count = slot_count_.load(std::memory_order_acquire);
+
+    writer.beginMap(2);
+    writer.key("count");
+    writer.integer(static_cast<int64_t>(count));
+    writer.key("devices");
+    writer.beginArray(count);
+    for (size_t i = 0; i < count; ++i) {
+        DeviceSlot& slot = slots_[i];
+        writer.beginMap(3);
+        writer.key("device");
+        writer.string(slot.mqtt_device_id);
+        writer.key("identifier");
+        writer.string(slot.device_identifier);
+        writer.key("sensors");
+        {
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            slot.data.encodeSensors(writer);
+        }
+        writer.endMap();
+    }
+    writer.endArray();
+    writer.endMap();
+}
+
+CollectorService::DeviceSlot* CollectorService::findOrCreateSlot(std::string_view mqtt_device_id) {
+    {
+        std::shared_lock<std::shared_mutex> lock(index_mutex_);
+        auto it = slot_index_.find(mqtt_device_id);
+        if (it != slot_index_.end()) {
+            return &slots_[it->second];
+        }
+        // Table full: known rejects (or any ID, once too many were rejected)
+        // must not take the exclusive lock on every sample
+        if (slot_count_.load(std::memory_order_acquire) >= max_devices_ &&
+            (rejected_ids_.size() >= kMaxRejectedIds || rejected_ids_.count(mqtt_device_id) > 0)) {
+            return nullptr;
+        }
+    }
+
+    // First sample from this device - resolve the DB identifier outside the lock
+    std::string mqtt_id(mqtt_device_id);
+    std::string device_identifier = DeviceMapper::getDbIdentifier(mqtt_id);
+
+    std::unique_lock<std::shared_mutex> lock(index_mutex_);
+    auto it = slot_index_.find(mqtt_device_id);
+    if (it != slot_index_.end()) {
+        return &slots_[it->second];  // Another thread created it meanwhile
+    }
+
+    size_t index;
+    auto db_it = db_slot_index_.find(device_identifier);
+    if (db_it != db_slot_index_.end()) {
+        index = db_it->second;
+    } else {
+        index = slot_count_.load(std::memory_order_relaxed);
+        if (index >= max_devices_) {
+            if (!slots_full_logged_.exchange(true)) {
+                std::cerr << "⚠️  Collector: All " << max_devices_ << " device slots in use, ignoring "
+                          << mqtt_id << " and further new devices" << std::endl;
+            }
+            if (rejected_ids_.size() < kMaxRejectedIds) {
+                rejected_ids_.insert(std::move(mqtt_id));
+            }
+            return nullptr;
+        }
+
+        DeviceSlot& slot = slots_[index];
+        {
+            std::lock_guard<std::mutex> slot_lock(slot.mutex);
+            slot.mqtt_device_id = mqtt_id;
+            slot.device_identifier = device_identifier;
+            slot.data.device_id = mqtt_id;
+            slot.data.timestamp = std::chrono::system_clock::now();
+            if (tiers_.raw_window_seconds > 0) {
+                slot.raw = std::make_unique<SampleRing>(
+                    tiers_.raw_capacity, static_cast<int64_t>(tiers_.raw_window_seconds) * 1000);
+            }
+            auto restored = restored_daily_.find(device_identifier);
+            if (restored != restored_daily_.end()) {
+                slot.daily.seed(restored->second);
+                restored_daily_.erase(restored);
+            }
+        }
+        db_slot_index_.emplace(device_identifier, index);
+        slot_count_.store(index + 1, std::memory_order_release);
+
+        std::cout << "📥 Collector: New device detected: " << device_identifier << std::endl;
+    }
+
+    slot_index_.emplace(std::move(mqtt_id), index);
+    return &slots_[index];
+}
+
+std::pair<std::string_view, std::string_view> CollectorService::parseTopic(std::string_view topic) {
     // Topic format: homeassistant/sensor/{device_id}/{sensor_name}/state
     // Example: homeassistant/sensor/apc_ups/battery_charge/state
+    // Views into the topic - with a wildcard subscription this runs for every
+    // sensor on the broker, so no splitting into strings
 
-    std::istringstream ss(topic);
-    std::vector<std::string> parts;
-    std::string part;
+    size_t device_start = topic.find('/', topic.find('/') + 1);  // After "homeassistant/sensor/"
+    if (device_start == std::string_view::npos) {
+        return {};
+    }
+    ++device_start;
 
-    while (std::getline(ss, part, '/')) {
-        parts.push_back(part);
+    size_t sensor_start = topic.find('/', device_start);
+    if (sensor_start == std::string_view::npos) {
+        return {};
     }
+    ++sensor_start;
 
-    if (parts.size() >= 5) {
-        // parts[0] = "homeassistant"
-        // parts[1] = "sensor"
-        // parts[2] = device_id
-        // parts[3] = sensor_name
-        // parts[4] = "state"
-        return {parts[2], parts[3]};
+    size_t sensor_end = topic.find('/', sensor_start);
+    if (sensor_end == std::string_view::npos) {
+        return {};
     }
 
-    return {"", ""};
+    return {topic.substr(device_start, sensor_start - 1 - device_start),
+            topic.substr(sensor_start, sensor_end - sensor_start)};
 }
 
-void CollectorService::onMqttMessage(const std::string& topic, const std::string& payload) {
-    // Parse topic
+void CollectorService::onDiscoveryConfig(const std::string& topic) {
     auto [mqtt_device_id, sensor_name] = parseTopic(topic);
+    if (mqtt_device_id.empty() || !device_filter_) {
+        return;
+    }
 
-    if (mqtt_device_id.empty() || sensor_name.empty()) {
-        return;  // Invalid topic format
+    if (device_filter_->onDiscoveryConfig(mqtt_device_id, sensor_name)) {
+        std::cout << "🔎 Collector: Discovered UPS device " << mqtt_device_id << std::endl;
     }
+}
 
-    // Map to database identifier
-    std::string device_identifier = DeviceMapper::getDbIdentifier(mqtt_device_id);
+void CollectorService::onMqttMessage(const std::string& topic, const std::string& payload,
+                                     int64_t sample_ts_ms) {
+    // Parse topic
+    auto [device_view, sensor_view] = parseTopic(topic);
 
-    // Update in-memory buffer
-    std::lock_guard<std::mutex> lock(data_mutex_);
+    if (device_view.empty() || sensor_view.empty()) {
+        return;  // Invalid topic format
+    }
 
-    // Initialize device data if not exists
-    if (device_data_.find(device_identifier) == device_data_.end()) {
-        device_data_[device_identifier] = UpsData();
-        device_data_[device_identifier].device_id = mqtt_device_id;
-        device_data_[device_identifier].timestamp = std::chrono::system_clock::now();
+    // Fast rejection for unrelated devices on the wildcard subscription
+    if (device_filter_ && !device_filter_->admit(device_view)) {
+        return;
+    }
 
-        // Initialize last save time
-        last_save_times_[device_identifier] = std::chrono::system_clock::now();
+    // Interned slot - only this device's lock is taken
+    DeviceSlot* slot = findOrCreateSlot(device_view);
+    if (!slot) {
+        return;
+    }
 
-        std::cout << "📥 Collector: New device detected: " << device_identifier << std::endl;
+    // History tiers only take the numeric telemetry metrics
+    std::optional<Metric> metric = findMetric(sensor_view);
+    std::optional<double> value;
+    int64_t now_ms = 0;
+    if (metric && (slot->raw || tiers_.persist_rollups || tiers_.daily_stats)) {
+        auto parsed = NumberParser::parseDouble(payload);
+        if (parsed.ok()) {
+            value = parsed.value;
+        }
+    }
+    // Daily stats also keep the status and transfer reason text
+    bool is_status = tiers_.daily_stats && (sensor_view == "ups_status" || sensor_view == "status");
+    bool is_transfer_reason = tiers_.daily_stats &&
+        (sensor_view == "last_transfer_reason" || sensor_view == "input_transfer_reason");
+    if (value || is_status || is_transfer_reason || live_stream_) {
+        now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        // A replayed sample (spooled during an outage) fills the gap at its own time;
+        // a publisher clock ahead of ours is not trusted
+        if (sample_ts_ms > 0 && sample_ts_ms < now_ms) {
+            now_ms = sample_ts_ms;
+        }
     }
 
-    // Update field
-    device_data_[device_identifier].updateFieldFromMqtt(sensor_name, payload);
+    std::string sensor_name(sensor_view);
+    {
+        std::lock_guard<std::mutex> lock(slot->mutex);
+        slot->data.updateFieldFromMqtt(sensor_name, payload);
+        if (value) {
+            if (slot->raw) {
+                slot->raw->record(*metric, static_cast<float>(*value), now_ms);
+            }
+            if (tiers_.persist_rollups) {
+                slot->rollup.add(*metric, *value, now_ms);
+            }
+            if (tiers_.daily_stats) {
+                slot->daily.addMetric(*metric, *value, now_ms);
+            }
+        } else if (is_status) {
+            slot->daily.addStatus(payload, now_ms);
+        } else if (is_transfer_reason) {
+            slot->daily.addTransferReason(payload, now_ms);
+        }
+    }
+
+    // Outside the slot lock - the hub has its own
+    if (live_stream_) {
+        live_stream_->publish(slot->mqtt_device_id, sensor_view, payload, now_ms);
+    }
 
     // Debug logging (occasional)
-    static int msg_counter = 0;
-    if (++msg_counter % 100 == 0) {
-        std::cout << "📥 Collector: Received " << msg_counter << " messages from "
-                  << device_data_.size() << " devices" << std::endl;
+    uint64_t received = messages_received_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (received % 100 == 0) {
+        std::cout << "📥 Collector: Received " << received << " messages from "
+                  << getDeviceCount() << " devices" << std::endl;
     }
 }
 
-bool CollectorService::saveDeviceData(const std::string& device_identifier) {
-    // Must be called with data_mutex_ locked
+bool CollectorService::saveAllDevices(std::chrono::system_clock::time_point bucket) {
+    // Snapshot each slot under its own lock - ingest only waits for one copy
+    size_t count = slot_count_.load(std::memory_order_acquire);
+    std::vector<UpsMetricsRow> rows;
+    rows.reserve(count);
 
-    auto it = device_data_.find(device_identifier);
-    if (it == device_data_.end()) {
-        return false;
-    }
+    for (size_t i = 0; i < count; ++i) {
+        DeviceSlot& slot = slots_[i];
+        UpsMetricsRow row{slot.device_identifier, {}};
+        {
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            row.data = slot.data;
+        }
 
-    const UpsData& data = it->second;
+        // Validate data
+        if (!row.data.isValid()) {
+            std::cerr << "⚠️  Collector: Invalid data for " << slot.device_identifier
+                      << ", skipping save" << std::endl;
+            continue;
+        }
 
-    // Validate data
-    if (!data.isValid()) {
-        std::cerr << "⚠️  Collector: Invalid data for " << device_identifier << ", skipping save" << std::endl;
+        row.data.timestamp = bucket;
+        rows.push_back(std::move(row));
+    }
+
+    if (rows.empty()) {
         return false;
     }
 
-    // Save to database
-    bool success = db_service_.insertUpsMetrics(data, device_identifier);
+    // One transaction for all devices
+    auto save_start = std::chrono::steady_clock::now();
+    bool success = db_service_.insertUpsMetricsBatch(rows);
+    metrics().save.observe(std::chrono::steady_clock::now() - save_start);
+    if (!success) {
+        metrics().save_failures.inc();
+    }
 
     if (success) {
-        // Update last save time
-        last_save_times_[device_identifier] = std::chrono::system_clock::now();
-
         {
             std::lock_guard<std::mutex> status_lock(status_mutex_);
             last_save_time_ = std::chrono::system_clock::now();
         }
 
-        std::cout << "💾 Collector: Saved metrics for " << device_identifier << std::endl;
+        std::cout << "💾 Collector: Saved metrics for " << rows.size() << " device(s)" << std::endl;
     }
 
     return success;
 }
 
+void CollectorService::flushRollups(std::chrono::system_clock::time_point now) {
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    std::vector<RollupBucket> minutes;
+    std::vector<RollupBucket> hours;
+
+    auto appendRows = [](std::vector<RollupRow>& rows, const std::string& device_identifier,
+                         const std::vector<RollupBucket>& buckets) {
+        for (const auto& bucket : buckets) {
+            auto start = std::chrono::system_clock::time_point(std::chrono::milliseconds(bucket.start_ms));
+            for (size_t m = 0; m < kMetricCount; ++m) {
+                const MetricAggregate& agg = bucket.metrics[m];
+                if (agg.count > 0) {
+                    rows.push_back({device_identifier, metricName(static_cast<Metric>(m)), start,
+                                    agg.count, agg.avg(), agg.min, agg.max});
+                }
+            }
+        }
+    };
+
+    size_t count = slot_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        DeviceSlot& slot = slots_[i];
+        minutes.clear();
+        hours.clear();
+        {
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            slot.rollup.advance(now_ms);
+            slot.rollup.takeClosed(minutes, hours);
+        }
+        appendRows(pending_minute_rows_, slot.device_identifier, minutes);
+        appendRows(pending_hour_rows_, slot.device_identifier, hours);
+    }
+
+    // Write each tier; on failure keep the rows (bounded) for the next minute
+    auto write = [this](RollupTier tier, std::vector<RollupRow>& rows) {
+        if (rows.empty()) {
+            return;
+        }
+        if (db_service_.insertRollups(tier, rows)) {
+            rows.clear();
+        } else if (rows.size() > kMaxPendingRollupRows) {
+            size_t excess = rows.size() - kMaxPendingRollupRows;
+            rows.erase(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(excess));
+            std::cerr << "⚠️  Collector: Dropped " << excess << " unsaved "
+                      << DatabaseService::rollupTable(tier) << " rows" << std::endl;
+        }
+    };
+    write(RollupTier::Minute, pending_minute_rows_);
+    write(RollupTier::Hour, pending_hour_rows_);
+    metrics().pending_rollups.set(static_cast<int64_t>(pending_minute_rows_.size() + pending_hour_rows_.size()));
+
+    // Retention once per hour
+    if (now == alignDown(now, 3600)) {
+        db_service_.pruneRollups(RollupTier::Minute, tiers_.minute_retention_days);
+        db_service_.pruneRollups(RollupTier::Hour, tiers_.hour_retention_days);
+    }
+}
+
+bool CollectorService::getDailyStats(const std::string& date, std::vector<DailyStatsRow>& out) const {
+    out.clear();
+    if (!tiers_.daily_stats) {
+        return false;
+    }
+
+    size_t count = slot_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        DeviceSlot& slot = slots_[i];
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        if (slot.daily.current().date == date && slot.daily.current().samples > 0) {
+            out.push_back({slot.device_identifier, slot.daily.current()});
+        } else if (slot.daily.previous().date == date && slot.daily.previous().samples > 0) {
+            out.push_back({slot.device_identifier, slot.daily.previous()});
+        }
+    }
+    return true;
+}
+
+void CollectorService::flushDailyStats(std::chrono::system_clock::time_point now) {
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    std::vector<DailyStats> closed;
+    std::vector<DailyStatsRow> rows;
+
+    size_t count = slot_count_.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        DeviceSlot& slot = slots_[i];
+        closed.clear();
+        std::optional<DailyStats> current;
+        {
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            slot.daily.advance(now_ms);
+            slot.daily.takeClosed(closed);
+            if (slot.daily.current().samples > 0) {
+                current = slot.daily.current();
+            }
+        }
+        for (auto& day : closed) {
+            pending_daily_rows_.push_back({slot.device_identifier, std::move(day)});
+        }
+        if (current) {
+            rows.push_back({slot.device_identifier, std::move(*current)});
+        }
+    }
+
+    // Closed days are final and kept until written; days in progress are re-sent next time
+    rows.insert(rows.begin(), pending_daily_rows_.begin(), pending_daily_rows_.end());
+    if (rows.empty()) {
+        return;
+    }
+    if (db_service_.upsertDailyStats(rows)) {
+        if (!pending_daily_rows_.empty()) {
+            std::cout << "📅 Collector: Saved " << pending_daily_rows_.size() << " closed day(s)" << std::endl;
+        }
+        pending_daily_rows_.clear();
+    } else if (pending_daily_rows_.size() > kMaxPendingDailyRows) {
+        size_t excess = pending_daily_rows_.size() - kMaxPendingDailyRows;
+        pending_daily_rows_.erase(pending_daily_rows_.begin(),
+                                  pending_daily_rows_.begin() + static_cast<std::ptrdiff_t>(excess));
+        std::cerr << "⚠️  Collector: Dropped " << excess << " unsaved ups_daily_stats rows" << std::endl;
+    }
+}
+
 void CollectorService::scheduledSaveLoop() {
     std::cout << "🔄 Collector: Saver thread started" << std::endl;
 
     while (running_) {
-        // Check each device for save interval (do this BEFORE sleeping)
+        // Next wall-clock boundary, waited for on the monotonic clock so an
+        // NTP step during the wait can't stretch or skip it. The boundary is
+        // re-derived from the wall clock every cycle, so drift doesn't build up.
         auto now = std::chrono::system_clock::now();
+        auto boundary = nextBoundary(now, save_interval_seconds_);
+        if (tiers_.persist_rollups) {
+            boundary = std::min(boundary, nextBoundary(now, 60));  // Minute tier cadence
+        }
+        bool midnight = false;
+        if (tiers_.daily_stats) {
+            // Close the day at local midnight, not at the next save
+            auto day_end = std::chrono::system_clock::time_point(std::chrono::milliseconds(
+                localDayEnd(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count())));
+            midnight = day_end <= boundary;
+            boundary = std::min(boundary, day_end);
+        }
+        auto deadline = std::chrono::steady_clock::now() +
+                        (boundary - std::chrono::system_clock::now());
 
         {
-            std::lock_guard<std::mutex> lock(data_mutex_);
-
-            for (const auto& [device_id, data] : device_data_) {
-                // Get last save time
-                auto last_save_it = last_save_times_.find(device_id);
-                if (last_save_it == last_save_times_.end()) {
-                    // First save - trigger immediately instead of waiting
-                    std::cout << "💾 Collector: Triggering initial save for " << device_id << std::endl;
-                    saveDeviceData(device_id);
-                    continue;
-                }
-
-                auto last_save = last_save_it->second;
-                auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - last_save).count();
-
-                if (elapsed >= save_interval_seconds_) {
-                    std::cout << "💾 Collector: Triggering scheduled save for " << device_id
-                              << " (elapsed: " << elapsed << "s)" << std::endl;
-                    saveDeviceData(device_id);
-                }
-            }
+            std::unique_lock<std::mutex> lock(saver_mutex_);
+            saver_cv_.wait_until(lock, deadline, [this] { return !running_; });
+        }
+        if (!running_) {
+            break;
         }
 
-        // Sleep for 1 minute, check every second for shutdown
-        for (int i = 0; i < 60 && running_; ++i) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+        if (tiers_.persist_rollups) {
+            flushRollups(boundary);
+        }
+        bool save = boundary == alignDown(boundary, save_interval_seconds_);
+        if (save) {
+            saveAllDevices(boundary);
+        }
+        if (tiers_.daily_stats && (save || midnight)) {
+            flushDailyStats(boundary);
         }
     }
 
@@ -0,0 +1,177 @@
+#include "services/DailyReportService.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace hms_nut {
+
+namespace {
+    /**
+     * YYYY-MM-DD made of digits and dashes only (safe as a file name)
+     */
+    bool isPlainDate(const std::string& date) {
+        if (date.size() != 10) {
+            return false;
+        }
+        for (size_t i = 0; i < date.size(); ++i) {
+            bool dash = (i == 4 || i == 7);
+            if (dash ? date[i] != '-' : (date[i] < '0' || date[i] > '9')) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+DailyReportService::DailyReportService(Builder builder, std::string cache_dir, size_t max_cached_days)
+    : builder_(std::move(builder)),
+      cache_dir_(std::move(cache_dir)),
+      max_cached_days_(max_cached_days > 0 ? max_cached_days : 1) {
+
+    if (!cache_dir_.empty()) {
+        std::error_code ec;
+        fs::create_directories(cache_dir_, ec);
+        if (ec) {
+            std::cerr << "⚠️  DailyReport: Cannot create " << cache_dir_ << " (" << ec.message()
+                      << "), caching in memory only" << std::endl;
+            cache_dir_.clear();
+        } else {
+            std::cout << "📄 DailyReport: Caching past days in " << cache_dir_ << std::endl;
+        }
+    }
+}
+
+std::shared_ptr<const DailyReport> DailyReportService::get(const std::string& date) {
+    auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    return get(date, localDate(now_ms));
+}
+
+std::shared_ptr<const DailyReport> DailyReportService::get(const std::string& date, const std::string& today) {
+    // YYYY-MM-DD compares chronologically as a string
+    const bool cacheable = isPlainDate(date) && date < today;
+
+    if (cacheable) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = cache_.find(date);
+            if (it != cache_.end()) {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return it->second;
+            }
+        }
+        if (auto report = load(date)) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            remember(date, report);
+            return report;
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+    DailyMetrics metrics;
+    if (!builder_ || !builder_(date, metrics)) {
+        return nullptr;
+    }
+    metrics.date = date;
+
+    auto report = render(std::move(metrics));
+    // An empty past day may still be filled by a late import, so only days with data are kept
+    if (cacheable && !report->metrics.empty()) {
+        store(*report);
+        remember(date, report);
+    }
+    return report;
+}
+
+std::shared_ptr<const DailyReport> DailyReportService::getCached(const std::string& date,
+                                                                 const std::string& today) {
+    if (!isPlainDate(date) || date >= today) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = cache_.find(date);
+    if (it == cache_.end()) {
+        return nullptr;  // Counted by the get() that follows
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return it->second;
+}
+
+size_t DailyReportService::cachedDays() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return cache_.size();
+}
+
+std::shared_ptr<const DailyReport> DailyReportService::render(DailyMetrics metrics) {
+    auto report = std::make_shared<DailyReport>();
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    writer["precision"] = 6;
+    report->json = Json::writeString(writer, metrics.toJson());
+    report->text = metrics.toText();
+    report->metrics = std::move(metrics);
+    return report;
+}
+
+std::shared_ptr<const DailyReport> DailyReportService::load(const std::string& date) const {
+    if (cache_dir_.empty()) {
+        return nullptr;
+    }
+
+    std::ifstream in(fs::path(cache_dir_) / (date + ".json"));
+    if (!in) {
+        return nullptr;
+    }
+
+    Json::CharReaderBuilder builder;
+    Json::Value json;
+    std::string errors;
+    if (!Json::parseFromStream(builder, in, &json, &errors)) {
+        std::cerr << "⚠️  DailyReport: Ignoring unreadable cache file for " << date << std::endl;
+        return nullptr;
+    }
+    auto metrics = DailyMetrics::fromJson(json);
+    if (!metrics || metrics->date != date || metrics->empty()) {
+        return nullptr;
+    }
+    return render(std::move(*metrics));
+}
+
+void DailyReportService::store(const DailyReport& report) const {
+    if (cache_dir_.empty()) {
+        return;
+    }
+
+    fs::path path = fs::path(cache_dir_) / (report.metrics.date + ".json");
+    fs::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        out << report.json;
+        if (!out) {
+            std::cerr << "⚠️  DailyReport: Failed to write " << temp << std::endl;
+            return;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec) {
+        std::cerr << "⚠️  DailyReport: Failed to store " << path << " (" << ec.message() << ")" << std::endl;
+        fs::remove(temp, ec);
+    }
+}
+
+void DailyReportService::remember(const std::string& date, std::shared_ptr<const DailyReport> report) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache_[date] = std::move(report);
+    while (cache_.size() > max_cached_days_) {
+        cache_.erase(cache_.begin());  // Oldest day - the least likely to be asked for again
+    }
+}
+
+}  // namespace hms_nut
@@ -1,5 +1,6 @@
 #include "services/DailySummaryService.h"
 #include "utils/DeviceMapper.h"
+#include "utils/Metrics.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -15,7 +16,10 @@ DailySummaryService::DailySummaryService(std::shared_ptr<MqttClient> mqtt_client
     : mqtt_client_(mqtt_client),
       db_service_(db_service),
       summary_hour_(summary_hour),
-      prompt_file_(prompt_file) {
+      prompt_file_(prompt_file),
+      jobs_([this](const std::string& date, std::string& result, std::string& error) {
+          return runSummary(date, result, error);
+      }) {
 
     if (llm_config.enabled) {
         llm_client_ = std::make_unique<hms::LLMClient>(llm_config);
@@ -63,6 +67,7 @@ void DailySummaryService::start() {
     }
 
     running_ = true;
+    jobs_.start();
     timer_thread_ = std::thread(&DailySummaryService::timerLoop, this);
     std::cout << "🤖 DailySummary: Started (daily at " << summary_hour_ << ":00)" << std::endl;
 }
@@ -72,6 +77,7 @@ void DailySummaryService::stop() {
 
     std::cout << "🤖 DailySummary: Stopping..." << std::endl;
     running_ = false;
+    jobs_.stop();
 
     if (timer_thread_.joinable()) {
         timer_thread_.join();
@@ -159,14 +165,40 @@ void DailySummaryService::timerLoop() {
 }
 
 bool DailySummaryService::generateSummary(const std::string& date) {
+    std::string summary;
+    std::string error;
+    return runSummary(date, summary, error);
+}
+
+SummaryJobQueue::Submission DailySummaryService::submitSummary(const std::string& date) {
+    return jobs_.submit(date);
+}
+
+std::optional<SummaryJob> DailySummaryService::getSummaryJob(const std::string& id) const {
+    return jobs_.get(id);
+}
+
+bool DailySummaryService::runSummary(const std::string& date, std::string& summary, std::string& error) {
     if (!llm_client_) {
+        error = "LLM not configured";
         std::cerr << "⚠️  DailySummary: LLM not configured" << std::endl;
         return false;
     }
 
-    // Query yesterday's metrics from PostgreSQL
-    std::string metrics = db_service_.queryDailyMetrics(date);
+    std::lock_guard<std::mutex> generate_lock(generate_mutex_);
+
+    std::string metrics;
+    if (report_source_) {
+        if (auto report = report_source_(date)) {
+            metrics = report->text;
+            std::cout << "🤖 DailySummary: Using " << report->metrics.source << " report for "
+                      << report->metrics.devices.size() << " device(s)" << std::endl;
+        }
+    } else {
+        metrics = db_service_.queryDailyMetrics(date);
+    }
     if (metrics.empty()) {
+        error = "No metrics data for " + date;
         std::cerr << "⚠️  DailySummary: No metrics data for " << date << std::endl;
         return false;
     }
@@ -178,14 +210,23 @@ bool DailySummaryService::generateSummary(const std::string& date) {
 
     // Call LLM
     std::cout << "🤖 DailySummary: Calling LLM..." << std::endl;
+    static Histogram& llm_seconds = MetricsRegistry::instance().histogram(
+        "hms_nut_llm_call_seconds", "Duration of LLM summary calls",
+        {1.0, 2.5, 5.0, 10.0, 20.0, 30.0, 60.0, 120.0, 300.0});
+    static Counter& llm_failures = MetricsRegistry::instance().counter(
+        "hms_nut_llm_failures_total", "LLM summary calls that failed");
+    auto llm_start = std::chrono::steady_clock::now();
     auto result = llm_client_->generate(prompt);
+    llm_seconds.observe(std::chrono::steady_clock::now() - llm_start);
 
     if (!result) {
+        llm_failures.inc();
+        error = "LLM call failed";
         std::cerr << "❌ DailySummary: LLM call failed" << std::endl;
         return false;
     }
 
-    std::string summary = *result;
+    summary = *result;
     std::cout << "🤖 DailySummary: Got summary (" << summary.size() << " chars)" << std::endl;
 
     // Publish to MQTT
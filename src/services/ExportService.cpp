@@ -0,0 +1,376 @@
+#include "services/ExportService.h"
+#include "utils/CompactWriter.h"
+#include "utils/NumberParser.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace hms_nut {
+
+namespace {
+    void appendCsvField(std::string& out, std::string_view value) {
+        if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+            out.append(value.data(), value.size());
+            return;
+        }
+        out += '"';
+        for (char c : value) {
+            if (c == '"') {
+                out += '"';
+            }
+            out += c;
+        }
+        out += '"';
+    }
+
+    bool isTrue(std::string_view value) {
+        return value == "t" || value == "true" || value == "1";
+    }
+
+    // How often a paced PushExportSink write checks the transport again
+    constexpr std::chrono::milliseconds kPacingInterval{10};
+}
+
+std::optional<ExportFormat> parseExportFormat(std::string_view name) {
+    if (name == "csv") {
+        return ExportFormat::Csv;
+    }
+    if (name == "ndjson") {
+        return ExportFormat::Ndjson;
+    }
+    return std::nullopt;
+}
+
+// ── ExportEncoder ───────────────────────────────────────────────────────────
+
+ExportEncoder::ExportEncoder(ExportFormat format, std::vector<ExportColumn> columns, bool gzip)
+    : format_(format),
+      columns_(std::move(columns)),
+      gzip_(gzip ? std::make_unique<GzipStream>() : nullptr) {
+    if (format_ == ExportFormat::Csv) {
+        for (size_t i = 0; i < columns_.size(); ++i) {
+            if (i > 0) {
+                text_ += ',';
+            }
+            text_ += columns_[i].name;
+        }
+        text_ += '\n';
+    }
+}
+
+void ExportEncoder::row(const std::vector<std::optional<std::string_view>>& values) {
+    size_t count = std::min(values.size(), columns_.size());
+
+    if (format_ == ExportFormat::Csv) {
+        for (size_t i = 0; i < count; ++i) {
+            if (i > 0) {
+                text_ += ',';
+            }
+            if (!values[i]) {
+                continue;
+            }
+            if (columns_[i].kind == ExportColumn::Kind::Boolean) {
+                text_ += isTrue(*values[i]) ? "true" : "false";
+            } else {
+                appendCsvField(text_, *values[i]);
+            }
+        }
+        text_ += '\n';
+        return;
+    }
+
+    // NDJSON: numbers and booleans keep their JSON types
+    size_t present = 0;
+    for (size_t i = 0; i < count; ++i) {
+        present += values[i] ? 1 : 0;
+    }
+    CompactWriter writer(WireFormat::Json, text_);
+    writer.beginMap(present);
+    for (size_t i = 0; i < count; ++i) {
+        if (!values[i]) {
+            continue;
+        }
+        writer.key(columns_[i].name);
+        switch (columns_[i].kind) {
+            case ExportColumn::Kind::Number: {
+                auto parsed = NumberParser::parseDouble(*values[i]);
+                if (parsed.ok()) {
+                    writer.number(parsed.value);
+                } else {
+                    writer.null();
+                }
+                break;
+            }
+            case ExportColumn::Kind::Boolean:
+                writer.boolean(isTrue(*values[i]));
+                break;
+            case ExportColumn::Kind::Text:
+                writer.string(*values[i]);
+                break;
+        }
+    }
+    writer.endMap();
+    text_ += '\n';
+}
+
+void ExportEncoder::error(std::string_view message) {
+    if (format_ == ExportFormat::Csv) {
+        text_ += "# error: ";
+        text_.append(message.data(), message.size());
+    } else {
+        CompactWriter writer(WireFormat::Json, text_);
+        writer.beginMap(1);
+        writer.key("error");
+        writer.string(message);
+        writer.endMap();
+    }
+    text_ += '\n';
+}
+
+void ExportEncoder::takeChunk(std::string& out, bool last) {
+    if (gzip_) {
+        gzip_->write(text_, out);
+        if (last) {
+            gzip_->finish(out);
+        }
+    } else {
+        out.append(text_);
+    }
+    text_.clear();
+}
+
+// ── ExportPipe ──────────────────────────────────────────────────────────────
+
+ExportPipe::ExportPipe(size_t max_bytes)
+    : max_bytes_(std::max<size_t>(max_bytes, 1)) {
+}
+
+bool ExportPipe::write(std::string chunk) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Admitted while under the limit, so one chunk may overshoot it
+    cv_.wait(lock, [this] { return cancelled_ || bytes_ < max_bytes_; });
+    if (cancelled_) {
+        return false;
+    }
+    if (!chunk.empty()) {
+        bytes_ += chunk.size();
+        chunks_.push_back(std::move(chunk));
+        cv_.notify_all();
+    }
+    return true;
+}
+
+void ExportPipe::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    cv_.notify_all();
+}
+
+size_t ExportPipe::read(char* buffer, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return cancelled_ || closed_ || bytes_ > 0; });
+    if (cancelled_) {
+        return 0;
+    }
+
+    size_t copied = 0;
+    while (copied < size && !chunks_.empty()) {
+        const std::string& front = chunks_.front();
+        size_t n = std::min(size - copied, front.size() - offset_);
+        std::memcpy(buffer + copied, front.data() + offset_, n);
+        copied += n;
+        offset_ += n;
+        if (offset_ == front.size()) {
+            chunks_.pop_front();
+            offset_ = 0;
+        }
+    }
+    bytes_ -= copied;
+    cv_.notify_all();
+    return copied;
+}
+
+void ExportPipe::cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    chunks_.clear();
+    bytes_ = 0;
+    offset_ = 0;
+    cv_.notify_all();
+}
+
+// ── PushExportSink ──────────────────────────────────────────────────────────
+
+PushExportSink::PushExportSink(Send send, Close close, Backlog backlog, size_t max_unsent,
+                               std::chrono::milliseconds stall_timeout)
+    : send_(std::move(send)),
+      close_(std::move(close)),
+      backlog_(std::move(backlog)),
+      max_unsent_(std::max<size_t>(max_unsent, 1)),
+      stall_timeout_(stall_timeout) {
+}
+
+bool PushExportSink::write(std::string chunk) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // The transport has no drain notification, so its backlog is polled;
+        // admitted while at or under the mark, so one chunk may overshoot it
+        auto held_since = std::chrono::steady_clock::now();
+        while (!cancelled_ && backlog_ && backlog_() > max_unsent_) {
+            if (std::chrono::steady_clock::now() - held_since >= stall_timeout_) {
+                std::cerr << "⚠️  Export: Client stopped reading, giving up" << std::endl;
+                return false;
+            }
+            cv_.wait_for(lock, kPacingInterval);
+        }
+        if (cancelled_) {
+            return false;
+        }
+    }
+    return chunk.empty() || send_(chunk);
+}
+
+void PushExportSink::close() {
+    if (close_) {
+        close_();
+    }
+}
+
+void PushExportSink::cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    cv_.notify_all();
+}
+
+// ── ExportService ───────────────────────────────────────────────────────────
+
+ExportService::ExportService(RowSource source, std::vector<ExportColumn> columns, ExportConfig config)
+    : source_(std::move(source)),
+      columns_(std::move(columns)),
+      config_(config) {
+}
+
+ExportService::~ExportService() {
+    stop();
+}
+
+std::shared_ptr<ExportPipe> ExportService::begin(ExportRequest request) {
+    auto pipe = std::make_shared<ExportPipe>(config_.buffer_bytes);
+    bool started = begin(std::move(request), [pipe](const ExportRequest&) -> std::shared_ptr<ExportSink> {
+        return pipe;
+    });
+    return started ? pipe : nullptr;
+}
+
+bool ExportService::begin(ExportRequest request, Opener open) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reapWorkers();
+    if (stopped_ || active_.load(std::memory_order_relaxed) >= config_.max_concurrent) {
+        return false;
+    }
+
+    auto job = std::make_shared<Job>();
+    active_.fetch_add(1, std::memory_order_relaxed);
+
+    Worker worker;
+    worker.job = job;
+    worker.thread = std::thread([this, request = std::move(request), open = std::move(open), job] {
+        run(request, open, *job);
+        active_.fetch_sub(1, std::memory_order_relaxed);
+        job->done.store(true, std::memory_order_release);
+    });
+    workers_.push_back(std::move(worker));
+    return true;
+}
+
+void ExportService::stop() {
+    std::list<Worker> workers;
+    std::vector<std::shared_ptr<ExportSink>> sinks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+        workers.swap(workers_);
+        // Workers still opening see stopped_ and cancel their own sink
+        for (const auto& worker : workers) {
+            if (worker.job->sink) {
+                sinks.push_back(worker.job->sink);
+            }
+        }
+    }
+    for (auto& sink : sinks) {
+        sink->cancel();
+    }
+    for (auto& worker : workers) {
+        if (worker.thread.joinable()) {
+            worker.thread.join();
+        }
+    }
+}
+
+void ExportService::reapWorkers() {
+    for (auto it = workers_.begin(); it != workers_.end();) {
+        if (it->job->done.load(std::memory_order_acquire)) {
+            it->thread.join();
+            it = workers_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ExportService::run(const ExportRequest& request, const Opener& open, Job& job) {
+    std::shared_ptr<ExportSink> sink;
+    try {
+        sink = open ? open(request) : nullptr;
+    } catch (const std::exception& e) {
+        std::cerr << "❌ Export: " << request.device_identifier << " failed to start: " << e.what() << std::endl;
+    }
+    if (!sink) {
+        return;  // Answered by the opener (e.g. unknown device)
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job.sink = sink;
+        if (stopped_) {
+            sink->cancel();
+        }
+    }
+
+    std::string chunk;
+    bool reader_gone = false;
+    bool ok = false;
+
+    try {
+        ExportEncoder encoder(request.format, columns_, request.gzip);
+
+        ok = source_(request, config_.batch_rows, [&](const std::vector<std::optional<std::string_view>>& values) {
+            encoder.row(values);
+            if (encoder.buffered() < config_.chunk_bytes) {
+                return true;
+            }
+            chunk.clear();
+            encoder.takeChunk(chunk);
+            if (!sink->write(std::move(chunk))) {
+                reader_gone = true;
+                return false;
+            }
+            return true;
+        });
+
+        if (!reader_gone) {
+            if (!ok) {
+                // The 200 status is already out; leave a marker the consumer can detect
+                encoder.error("export incomplete");
+            }
+            chunk.clear();
+            encoder.takeChunk(chunk, true);
+            sink->write(std::move(chunk));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "❌ Export: " << request.device_identifier << " failed: " << e.what() << std::endl;
+    }
+
+    sink->close();
+}
+
+}  // namespace hms_nut
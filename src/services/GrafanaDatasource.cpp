@@ -0,0 +1,189 @@
+#include "services/GrafanaDatasource.h"
+#include "utils/TimeBuckets.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace hms_nut {
+
+namespace {
+    std::optional<int64_t> parseTime(const Json::Value& value) {
+        // Grafana sends ISO 8601 strings; epoch milliseconds are accepted too
+        if (value.isIntegral()) {
+            return value.asInt64();
+        }
+        if (!value.isString()) {
+            return std::nullopt;
+        }
+        auto parsed = parseUtcTimestamp(value.asString());
+        if (!parsed) {
+            return std::nullopt;
+        }
+        return std::chrono::duration_cast<std::chrono::milliseconds>(parsed->time_since_epoch()).count();
+    }
+
+    bool parseRange(const Json::Value& request, int64_t& from_ms, int64_t& to_ms, std::string& error) {
+        const Json::Value& range = request["range"];
+        auto from = range.isObject() ? parseTime(range["from"]) : std::nullopt;
+        auto to = range.isObject() ? parseTime(range["to"]) : std::nullopt;
+        if (!from || !to || *from >= *to) {
+            error = "range.from and range.to must be ISO 8601 times with from < to";
+            return false;
+        }
+        from_ms = *from;
+        to_ms = *to;
+        return true;
+    }
+
+    std::string describeEvent(const PowerEventRow& event) {
+        std::string text;
+        char buffer[64];
+        if (event.battery_level_start && event.battery_level_end) {
+            std::snprintf(buffer, sizeof(buffer), "Battery %.0f%% -> %.0f%%",
+                          *event.battery_level_start, *event.battery_level_end);
+            text += buffer;
+        } else if (event.battery_level_start) {
+            std::snprintf(buffer, sizeof(buffer), "Battery %.0f%%", *event.battery_level_start);
+            text += buffer;
+        }
+        if (event.load_at_event) {
+            std::snprintf(buffer, sizeof(buffer), "%sload %.0f%%", text.empty() ? "" : ", ",
+                          *event.load_at_event);
+            text += buffer;
+        }
+        return text;
+    }
+}
+
+GrafanaDatasource::GrafanaDatasource(DeviceLister devices, SeriesReader series, EventReader events)
+    : devices_(std::move(devices)),
+      series_(std::move(series)),
+      events_(std::move(events)) {
+}
+
+std::optional<std::pair<std::string, Metric>> GrafanaDatasource::parseTarget(std::string_view target) {
+    size_t dot = target.rfind('.');
+    if (dot == std::string_view::npos || dot == 0) {
+        return std::nullopt;
+    }
+    auto metric = findMetric(target.substr(dot + 1));
+    if (!metric) {
+        return std::nullopt;
+    }
+    return std::make_pair(std::string(target.substr(0, dot)), *metric);
+}
+
+Json::Value GrafanaDatasource::search(const Json::Value& request) const {
+    std::string filter = request.isObject() ? request.get("target", "").asString() : "";
+
+    Json::Value names(Json::arrayValue);
+    for (const auto& device : devices_()) {
+        for (size_t i = 0; i < kMetricCount; ++i) {
+            std::string name = device + "." + metricName(static_cast<Metric>(i));
+            if (filter.empty() || name.find(filter) != std::string::npos) {
+                names.append(name);
+            }
+        }
+    }
+    return names;
+}
+
+GrafanaResult GrafanaDatasource::query(const Json::Value& request, Json::Value& response,
+                                       std::string& error) const {
+    int64_t from_ms = 0;
+    int64_t to_ms = 0;
+    if (!request.isObject() || !parseRange(request, from_ms, to_ms, error)) {
+        return GrafanaResult::BadRequest;
+    }
+
+    size_t max_points = kDefaultPoints;
+    const Json::Value& requested = request["maxDataPoints"];
+    if (requested.isNumeric() && requested.asDouble() > 0) {
+        max_points = static_cast<size_t>(std::min(requested.asDouble(), static_cast<double>(kMaxPoints)));
+    }
+    max_points = std::clamp<size_t>(max_points, 3, kMaxPoints);
+
+    const Json::Value& targets = request["targets"];
+    if (!targets.isArray()) {
+        error = "targets must be an array";
+        return GrafanaResult::BadRequest;
+    }
+
+    response = Json::Value(Json::arrayValue);
+    for (const auto& target : targets) {
+        if (target.get("hide", false).asBool()) {
+            continue;
+        }
+        std::string name = target.get("target", "").asString();
+        if (name.empty()) {
+            continue;  // Panel still being edited
+        }
+        auto parsed = parseTarget(name);
+        if (!parsed) {
+            error = "Unknown target: " + name + " (expected <device>.<metric>)";
+            return GrafanaResult::BadRequest;
+        }
+
+        SeriesRead read = series_(parsed->first, parsed->second, from_ms, to_ms, max_points);
+        switch (read.status) {
+            case SeriesRead::Status::Ok:
+            case SeriesRead::Status::UnknownDevice:  // Empty series, like a device without data
+                break;
+            case SeriesRead::Status::Unavailable:
+                error = "Database not connected";
+                return GrafanaResult::Unavailable;
+            case SeriesRead::Status::Failed:
+                error = "Series query failed for " + name;
+                return GrafanaResult::Failed;
+        }
+
+        Json::Value datapoints(Json::arrayValue);
+        for (const auto& point : read.points) {
+            Json::Value pair(Json::arrayValue);
+            pair.append(point.value);
+            pair.append(static_cast<Json::Int64>(point.timestamp_ms));
+            datapoints.append(std::move(pair));
+        }
+
+        Json::Value series;
+        series["target"] = name;
+        series["datapoints"] = std::move(datapoints);
+        response.append(std::move(series));
+    }
+    return GrafanaResult::Ok;
+}
+
+GrafanaResult GrafanaDatasource::annotations(const Json::Value& request, Json::Value& response,
+                                             std::string& error) const {
+    int64_t from_ms = 0;
+    int64_t to_ms = 0;
+    if (!request.isObject() || !parseRange(request, from_ms, to_ms, error)) {
+        return GrafanaResult::BadRequest;
+    }
+
+    const Json::Value& annotation = request["annotation"];
+    std::string device = annotation.isObject() ? annotation.get("query", "").asString() : "";
+
+    std::vector<PowerEventRow> events;
+    if (!events_(device, from_ms, to_ms, events)) {
+        error = "Power event query failed";
+        return GrafanaResult::Failed;
+    }
+
+    response = Json::Value(Json::arrayValue);
+    for (const auto& event : events) {
+        Json::Value item;
+        item["annotation"] = annotation;  // Grafana matches results to the request by this echo
+        item["time"] = static_cast<Json::Int64>(event.timestamp_ms);
+        item["title"] = event.event_type;
+        item["text"] = describeEvent(event);
+        Json::Value tags(Json::arrayValue);
+        tags.append(event.device_identifier);
+        tags.append(event.event_type);
+        item["tags"] = std::move(tags);
+        response.append(std::move(item));
+    }
+    return GrafanaResult::Ok;
+}
+
+}  // namespace hms_nut
@@ -0,0 +1,357 @@
+#include "services/LiveStreamHub.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace hms_nut {
+
+namespace {
+    const std::string kHeartbeatFrame = ": keepalive\n\n";
+
+    // How often a client held above max_unsent_bytes is probed again
+    constexpr std::chrono::milliseconds kBacklogRecheck{100};
+
+    void appendJsonString(std::string& out, std::string_view text) {
+        static const char* hex = "0123456789abcdef";
+        out += '"';
+        for (char c : text) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        out += "\\u00";
+                        out += hex[(c >> 4) & 0x0f];
+                        out += hex[c & 0x0f];
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        out += '"';
+    }
+
+    std::string buildDelta(std::string_view device, std::string_view sensor,
+                           std::string_view value, int64_t timestamp_ms) {
+        std::string frame;
+        frame.reserve(64 + device.size() + sensor.size() + value.size());
+        frame += "event: state\ndata: {\"device\":";
+        appendJsonString(frame, device);
+        frame += ",\"sensor\":";
+        appendJsonString(frame, sensor);
+        frame += ",\"value\":";
+        appendJsonString(frame, value);
+        frame += ",\"ts\":";
+        frame += std::to_string(timestamp_ms);
+        frame += "}\n\n";
+        return frame;
+    }
+
+    std::string buildResync(uint64_t dropped) {
+        return "event: resync\ndata: {\"dropped\":" + std::to_string(dropped) + "}\n\n";
+    }
+}
+
+LiveStreamHub::LiveStreamHub(LiveStreamConfig config)
+    : config_(std::move(config)) {
+}
+
+LiveStreamHub::~LiveStreamHub() {
+    stop();
+}
+
+void LiveStreamHub::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    sender_ = std::thread(&LiveStreamHub::senderLoop, this);
+}
+
+void LiveStreamHub::stop() {
+    std::map<uint64_t, std::shared_ptr<Client>> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        closing.swap(clients_);
+    }
+    cv_.notify_all();
+
+    if (sender_.joinable()) {
+        sender_.join();
+    }
+    // Sinks (and their streams) are released here, outside the lock
+}
+
+uint64_t LiveStreamHub::addClient(Sink sink, std::string device_filter, Backlog backlog) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_ || clients_.size() >= config_.max_clients) {
+        return 0;
+    }
+
+    auto client = std::make_shared<Client>();
+    client->sink = std::move(sink);
+    client->backlog = std::move(backlog);
+    client->device_filter = std::move(device_filter);
+    client->queue.push_back(std::make_shared<const std::string>(buildSnapshot(client->device_filter)));
+
+    uint64_t id = next_client_id_++;
+    clients_.emplace(id, std::move(client));
+    pending_ = true;
+    cv_.notify_one();
+
+    std::cout << "📡 LiveStream: Client " << id << " subscribed ("
+              << clients_.size() << " connected)" << std::endl;
+    return id;
+}
+
+void LiveStreamHub::removeClient(uint64_t id) {
+    std::shared_ptr<Client> removed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = clients_.find(id);
+        if (it == clients_.end()) {
+            return;
+        }
+        removed = std::move(it->second);
+        clients_.erase(it);
+    }
+}
+
+void LiveStreamHub::publish(std::string_view device, std::string_view sensor,
+                            std::string_view value, int64_t timestamp_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Deltas only - the bridge republishes unchanged values every poll
+    auto dev = last_values_.find(device);
+    if (dev == last_values_.end()) {
+        dev = last_values_.emplace(std::string(device), std::map<std::string, std::string, std::less<>>()).first;
+    }
+    auto last = dev->second.find(sensor);
+    if (last == dev->second.end()) {
+        dev->second.emplace(std::string(sensor), std::string(value));
+    } else if (last->second == value) {
+        return;
+    } else {
+        last->second.assign(value.data(), value.size());
+    }
+
+    if (clients_.empty()) {
+        return;
+    }
+
+    // Serialized once, shared by every client queue
+    Frame frame = std::make_shared<const std::string>(buildDelta(device, sensor, value, timestamp_ms));
+    frames_published_.fetch_add(1, std::memory_order_relaxed);
+
+    bool queued = false;
+    for (auto& [id, client] : clients_) {
+        if (client->device_filter.empty() || client->device_filter == device) {
+            enqueue(*client, frame);
+            queued = true;
+        }
+    }
+    if (queued) {
+        pending_ = true;
+        cv_.notify_one();
+    }
+}
+
+LiveStreamHub::Stats LiveStreamHub::getStats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.clients = clients_.size();
+    }
+    stats.frames_published = frames_published_.load(std::memory_order_relaxed);
+    stats.frames_dropped = frames_dropped_.load(std::memory_order_relaxed);
+    stats.clients_closed = clients_closed_.load(std::memory_order_relaxed);
+    stats.clients_stalled = clients_stalled_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void LiveStreamHub::enqueue(Client& client, const Frame& frame) {
+    if (client.queue.size() >= config_.max_queued_frames) {
+        client.queue.pop_front();
+        ++client.dropped;
+        frames_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    client.queue.push_back(frame);
+}
+
+std::string LiveStreamHub::buildSnapshot(const std::string& device_filter) const {
+    std::string frame = "event: snapshot\ndata: {\"devices\":{";
+    bool first_device = true;
+    for (const auto& [device, sensors] : last_values_) {
+        if (!device_filter.empty() && device != device_filter) {
+            continue;
+        }
+        if (!first_device) {
+            frame += ',';
+        }
+        first_device = false;
+        appendJsonString(frame, device);
+        frame += ":{";
+        bool first_sensor = true;
+        for (const auto& [sensor, value] : sensors) {
+            if (!first_sensor) {
+                frame += ',';
+            }
+            first_sensor = false;
+            appendJsonString(frame, sensor);
+            frame += ':';
+            appendJsonString(frame, value);
+        }
+        frame += '}';
+    }
+    frame += "}}\n\n";
+    return frame;
+}
+
+void LiveStreamHub::senderLoop() {
+    struct Delivery {
+        uint64_t id;
+        std::shared_ptr<Client> client;
+        std::deque<Frame> frames;
+        uint64_t dropped = 0;
+        size_t unsent = 0;     // Bytes the transport still holds for this client
+        bool held = false;     // Above max_unsent_bytes: frames stay queued
+        bool stalled = false;  // Held for stall_timeout: disconnect
+    };
+    const std::chrono::steady_clock::time_point not_held{};
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto next_heartbeat = std::chrono::steady_clock::now() + config_.heartbeat;
+    bool any_held = false;
+
+    while (true) {
+        auto wake = next_heartbeat;
+        if (any_held) {
+            wake = std::min(wake, std::chrono::steady_clock::now() + kBacklogRecheck);
+        }
+        cv_.wait_until(lock, wake, [this] { return !running_ || pending_; });
+        if (!running_) {
+            break;
+        }
+
+        // Idle clients get a keepalive, which also detects closed connections
+        auto now = std::chrono::steady_clock::now();
+        bool heartbeat_due = now >= next_heartbeat;
+        if (heartbeat_due) {
+            next_heartbeat = now + config_.heartbeat;
+        }
+        pending_ = false;
+
+        std::vector<Delivery> batch;
+        for (auto& [id, client] : clients_) {
+            if (client->queue.empty() && !heartbeat_due && client->held_since == not_held) {
+                continue;
+            }
+            Delivery delivery;
+            delivery.id = id;
+            delivery.client = client;
+            batch.push_back(std::move(delivery));
+        }
+
+        // Probe the transports without the lock; a client that has not sent
+        // what it was given keeps its frames queued, where overflow drops the
+        // oldest and leads to a resync once it catches up
+        lock.unlock();
+        for (auto& delivery : batch) {
+            Client& client = *delivery.client;
+            delivery.unsent = client.backlog ? client.backlog() : 0;
+            if (delivery.unsent <= config_.max_unsent_bytes) {
+                client.held_since = not_held;
+                continue;
+            }
+            delivery.held = true;
+            if (client.held_since == not_held) {
+                client.held_since = now;
+            } else if (now - client.held_since >= config_.stall_timeout) {
+                delivery.stalled = true;
+            }
+        }
+        lock.lock();
+
+        any_held = false;
+        for (auto& delivery : batch) {
+            if (delivery.held) {
+                any_held = true;
+                continue;
+            }
+            delivery.frames = std::move(delivery.client->queue);
+            delivery.client->queue.clear();
+            delivery.dropped = delivery.client->dropped;
+            delivery.client->dropped = 0;
+        }
+
+        // Write without the lock - publish() never waits on a client
+        lock.unlock();
+        std::vector<uint64_t> gone;
+        std::vector<uint64_t> stalled;
+        for (auto& delivery : batch) {
+            if (delivery.stalled) {
+                std::cerr << "⚠️  LiveStream: Client " << delivery.id << " stalled with "
+                          << delivery.unsent << " bytes unsent, disconnecting" << std::endl;
+                stalled.push_back(delivery.id);
+                continue;
+            }
+            if (delivery.held) {
+                continue;
+            }
+            bool ok = true;
+            try {
+                if (delivery.dropped > 0) {
+                    ok = delivery.client->sink(buildResync(delivery.dropped));
+                }
+                for (const auto& frame : delivery.frames) {
+                    if (!ok) {
+                        break;
+                    }
+                    ok = delivery.client->sink(*frame);
+                }
+                if (ok && delivery.frames.empty() && heartbeat_due) {
+                    ok = delivery.client->sink(kHeartbeatFrame);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "❌ LiveStream: Write to client " << delivery.id
+                          << " failed: " << e.what() << std::endl;
+                ok = false;
+            }
+            if (!ok) {
+                gone.push_back(delivery.id);
+            }
+        }
+        lock.lock();
+
+        for (uint64_t id : stalled) {
+            if (clients_.erase(id) > 0) {
+                clients_closed_.fetch_add(1, std::memory_order_relaxed);
+                clients_stalled_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        for (uint64_t id : gone) {
+            auto it = clients_.find(id);
+            if (it != clients_.end()) {
+                clients_.erase(it);
+                clients_closed_.fetch_add(1, std::memory_order_relaxed);
+                std::cout << "📡 LiveStream: Client " << id << " disconnected ("
+                          << clients_.size() << " connected)" << std::endl;
+            }
+        }
+
+        // Last references to removed clients go here; release their sinks unlocked
+        lock.unlock();
+        batch.clear();
+        lock.lock();
+    }
+}
+
+}  // namespace hms_nut
@@ -1,10 +1,27 @@
 #include "services/NutBridgeService.h"
-#include "nut/UpsData.h"
+#include "utils/Metrics.h"
 #include <iostream>
 #include <chrono>
 
 namespace hms_nut {
 
+namespace {
+    struct BridgeMetrics {
+        MetricsRegistry& registry = MetricsRegistry::instance();
+        Histogram& poll = registry.histogram(
+            "hms_nut_nut_poll_seconds", "Time to fetch all variables from upsd");
+        Histogram& parse = registry.histogram(
+            "hms_nut_nut_parse_seconds", "Time to convert NUT variables to UpsData");
+        Counter& poll_errors = registry.counter(
+            "hms_nut_nut_poll_errors_total", "Polls that returned no or invalid data");
+    };
+
+    BridgeMetrics& metrics() {
+        static BridgeMetrics m;
+        return m;
+    }
+}
+
 NutBridgeService::NutBridgeService(std::shared_ptr<MqttClient> mqtt_client,
                                    const std::string& nut_host,
                                    int nut_port,
@@ -23,7 +40,7 @@ NutBridgeService::NutBridgeService(std::shared_ptr<MqttClient> mqtt_client,
     nut_client_ = std::make_unique<NutClient>(nut_host, nut_port, ups_name);
 
     // Create discovery publisher
-    discovery_publisher_ = std::make_unique<DiscoveryPublisher>(
+    discovery_publisher_ = std::make_shared<DiscoveryPublisher>(
         mqtt_client_, device_id_, device_name_);
 
     std::cout << "🔌 NUT Bridge: Initialized for " << device_name_
@@ -32,6 +49,10 @@ NutBridgeService::NutBridgeService(std::shared_ptr<MqttClient> mqtt_client,
 
 NutBridgeService::~NutBridgeService() {
     stop();
+
+    if (discovery_scheduler_) {
+        discovery_scheduler_->unregisterPublisher(discovery_publisher_);
+    }
 }
 
 void NutBridgeService::start() {
@@ -74,14 +95,14 @@ std::chrono::system_clock::time_point NutBridgeService::getLastPollTime() const
     return last_poll_time_;
 }
 
-bool NutBridgeService::republishDiscovery() {
+bool NutBridgeService::republishDiscovery(bool force) {
     if (!mqtt_client_ || !mqtt_client_->isConnected()) {
         std::cerr << "⚠️  NUT Bridge: Cannot republish - MQTT not connected" << std::endl;
         return false;
     }
 
     std::cout << "🔄 NUT Bridge: Republishing discovery messages..." << std::endl;
-    bool result = discovery_publisher_->publishAll();
+    bool result = discovery_publisher_->publishAll(force);
 
     if (result) {
         std::cout << "✅ NUT Bridge: Discovery messages republished successfully" << std::endl;
@@ -92,17 +113,37 @@ bool NutBridgeService::republishDiscovery() {
     return result;
 }
 
+void NutBridgeService::setDiscoveryScheduler(std::shared_ptr<DiscoveryScheduler> scheduler, int priority) {
+    if (discovery_scheduler_) {
+        discovery_scheduler_->unregisterPublisher(discovery_publisher_);
+    }
+
+    discovery_scheduler_ = std::move(scheduler);
+    if (discovery_scheduler_) {
+        discovery_scheduler_->registerPublisher(discovery_publisher_, priority);
+    }
+}
+
 void NutBridgeService::setupSubscriptions() {
     // Subscribe to Home Assistant status to republish discovery on HA restart
     if (mqtt_client_ && mqtt_client_->isConnected()) {
         mqtt_client_->subscribe("homeassistant/status",
             [this](const std::string& topic, const std::string& payload) {
                 if (payload == "online") {
-                    std::cout << "🏠 Home Assistant restarted, republishing discovery..." << std::endl;
-                    republishDiscovery();
+                    if (discovery_scheduler_) {
+                        // Paced on the scheduler thread - never block MQTT dispatch
+                        std::cout << "🏠 Home Assistant restarted, scheduling discovery republish..." << std::endl;
+                        discovery_scheduler_->requestRepublish();
+                    } else {
+                        std::cout << "🏠 Home Assistant restarted, republishing discovery..." << std::endl;
+                        republishDiscovery();
+                    }
                 }
             }, 1);
         std::cout << "✅ Subscribed to homeassistant/status" << std::endl;
+
+        // Learn which discovery configs the broker already retains
+        discovery_publisher_->enableRetainedTracking();
     }
 }
 
@@ -148,18 +189,26 @@ void NutBridgeService::runLoop() {
 }
 
 bool NutBridgeService::pollAndPublish() {
+    BridgeMetrics& m = metrics();
+
     // Get all variables from NUT server
+    auto poll_start = std::chrono::steady_clock::now();
     auto variables = nut_client_->getAllVariables();
+    auto parse_start = std::chrono::steady_clock::now();
+    m.poll.observe(parse_start - poll_start);
 
     if (variables.empty()) {
+        m.poll_errors.inc();
         std::cerr << "❌ NUT Bridge: No variables retrieved from NUT server" << std::endl;
         return false;
     }
 
     // Convert to UpsData
     UpsData ups_data = UpsData::fromNutVariables(device_id_, variables);
+    m.parse.observe(std::chrono::steady_clock::now() - parse_start);
 
     if (!ups_data.isValid()) {
+        m.poll_errors.inc();
         std::cerr << "⚠️  NUT Bridge: Invalid UPS data received" << std::endl;
         return false;
     }
@@ -181,12 +230,12 @@ bool NutBridgeService::pollAndPublish() {
         }
     }
 
-    // Convert to MQTT messages
-    auto mqtt_messages = ups_data.toMqttMessages();
+    // Convert to MQTT messages (reuses the buffer from the previous poll)
+    ups_data.toMqttMessages(mqtt_messages_);
 
     // Publish all messages
     bool all_success = true;
-    for (const auto& msg : mqtt_messages) {
+    for (const auto& msg : mqtt_messages_) {
         if (!mqtt_client_->publish(msg.topic, msg.payload, msg.qos, msg.retain)) {
             all_success = false;
             std::cerr << "⚠️  NUT Bridge: Failed to publish: " << msg.topic << std::endl;
@@ -196,7 +245,7 @@ bool NutBridgeService::pollAndPublish() {
     if (all_success) {
         static int log_counter = 0;
         if (++log_counter % 10 == 0) {  // Log every 10th poll
-            std::cout << "📤 NUT Bridge: Published " << mqtt_messages.size()
+            std::cout << "📤 NUT Bridge: Published " << mqtt_messages_.size()
                       << " metrics (" << log_counter << " polls)" << std::endl;
         }
     }
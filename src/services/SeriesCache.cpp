@@ -0,0 +1,72 @@
+#include "services/SeriesCache.h"
+
+namespace hms_nut {
+
+namespace {
+    int64_t roundUp(int64_t value, int64_t width) {
+        int64_t rem = value % width;
+        if (rem == 0) {
+            return value;
+        }
+        return rem > 0 ? value + (width - rem) : value - rem;
+    }
+}
+
+SeriesCache::SeriesCache(std::chrono::milliseconds ttl, size_t max_entries)
+    : ttl_(ttl),
+      max_entries_(max_entries > 0 ? max_entries : 1) {
+}
+
+std::pair<int64_t, int64_t> SeriesCache::alignRange(SeriesTier tier, int64_t from_ms, int64_t to_ms) {
+    int64_t width = 0;
+    if (tier == SeriesTier::Minute) {
+        width = 60 * 1000LL;
+    } else if (tier == SeriesTier::Hour) {
+        width = 3600 * 1000LL;
+    } else {
+        return {from_ms, to_ms};
+    }
+    // Buckets start on multiples of the width: bucket >= from <=> bucket >= roundUp(from)
+    return {roundUp(from_ms, width), roundUp(to_ms, width)};
+}
+
+std::optional<SeriesRead> SeriesCache::get(const Key& key, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it == entries_.end() || now >= it->second.expires) {
+        if (it != entries_.end()) {
+            lru_.erase(it->second.lru);
+            entries_.erase(it);
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return it->second.read;
+}
+
+void SeriesCache::put(const Key& key, SeriesRead read, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        it->second.read = std::move(read);
+        it->second.expires = now + ttl_;
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        return;
+    }
+
+    while (entries_.size() >= max_entries_) {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+    lru_.push_front(key);
+    entries_.emplace(key, Entry{std::move(read), now + ttl_, lru_.begin()});
+}
+
+size_t SeriesCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+}  // namespace hms_nut
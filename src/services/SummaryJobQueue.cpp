@@ -0,0 +1,161 @@
+#include "services/SummaryJobQueue.h"
+#include <iostream>
+#include <sstream>
+
+namespace hms_nut {
+
+namespace {
+    std::string makeIdPrefix() {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        std::ostringstream oss;
+        oss << std::hex << seconds;
+        return oss.str();
+    }
+}
+
+const char* SummaryJob::stateName(State state) {
+    switch (state) {
+        case State::Queued: return "queued";
+        case State::Running: return "running";
+        case State::Succeeded: return "succeeded";
+        case State::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+SummaryJobQueue::SummaryJobQueue(Runner runner, size_t max_pending, size_t max_finished)
+    : runner_(std::move(runner)),
+      max_pending_(max_pending),
+      max_finished_(max_finished),
+      id_prefix_(makeIdPrefix()) {
+}
+
+SummaryJobQueue::~SummaryJobQueue() {
+    stop();
+}
+
+void SummaryJobQueue::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    worker_ = std::thread(&SummaryJobQueue::workerLoop, this);
+}
+
+void SummaryJobQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+
+        auto now = std::chrono::system_clock::now();
+        for (const auto& id : pending_) {
+            SummaryJob& job = jobs_[id];
+            job.state = SummaryJob::State::Failed;
+            job.error = "cancelled (service stopping)";
+            job.finished = now;
+            active_by_date_.erase(job.date);
+            finished_.push_back(id);
+        }
+        pending_.clear();
+    }
+    cv_.notify_all();
+
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+SummaryJobQueue::Submission SummaryJobQueue::submit(const std::string& date) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Submission submission;
+
+    auto active = active_by_date_.find(date);
+    if (active != active_by_date_.end()) {
+        submission.job = jobs_.at(active->second);
+        submission.deduplicated = true;
+        return submission;
+    }
+
+    if (!running_ || pending_.size() >= max_pending_) {
+        return submission;
+    }
+
+    SummaryJob job;
+    job.id = id_prefix_ + "-" + std::to_string(next_id_++);
+    job.date = date;
+    job.created = std::chrono::system_clock::now();
+
+    active_by_date_[date] = job.id;
+    pending_.push_back(job.id);
+    submission.job = job;
+    jobs_.emplace(job.id, std::move(job));
+
+    cv_.notify_one();
+    return submission;
+}
+
+std::optional<SummaryJob> SummaryJobQueue::get(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void SummaryJobQueue::trimFinished() {
+    while (finished_.size() > max_finished_) {
+        jobs_.erase(finished_.front());
+        finished_.pop_front();
+    }
+}
+
+void SummaryJobQueue::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        cv_.wait(lock, [this] { return !running_ || !pending_.empty(); });
+        if (!running_) {
+            break;
+        }
+
+        std::string id = pending_.front();
+        pending_.pop_front();
+        SummaryJob& job = jobs_.at(id);
+        job.state = SummaryJob::State::Running;
+        job.started = std::chrono::system_clock::now();
+        std::string date = job.date;
+
+        // Run without the lock - submit()/get() stay responsive meanwhile.
+        // The job entry can't be trimmed while it isn't in finished_.
+        lock.unlock();
+        std::string result;
+        std::string error;
+        bool ok = false;
+        try {
+            ok = runner_(date, result, error);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        lock.lock();
+
+        SummaryJob& done = jobs_.at(id);
+        done.state = ok ? SummaryJob::State::Succeeded : SummaryJob::State::Failed;
+        done.result = std::move(result);
+        done.error = ok ? std::string() : (error.empty() ? "summary generation failed" : std::move(error));
+        done.finished = std::chrono::system_clock::now();
+        active_by_date_.erase(date);
+        finished_.push_back(id);
+        trimFinished();
+
+        std::cout << "🤖 SummaryJobs: Job " << id << " for " << date << " "
+                  << SummaryJob::stateName(done.state) << std::endl;
+    }
+}
+
+}  // namespace hms_nut
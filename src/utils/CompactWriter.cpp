@@ -0,0 +1,339 @@
+#include "utils/CompactWriter.h"
+#include "utils/NumberParser.h"
+#include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+namespace hms_nut {
+
+namespace {
+    std::string_view trim(std::string_view text) {
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+            text.remove_prefix(1);
+        }
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        return a.size() == b.size() &&
+               std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                   return std::tolower(static_cast<unsigned char>(x)) ==
+                          std::tolower(static_cast<unsigned char>(y));
+               });
+    }
+
+    std::optional<WireFormat> formatForMediaType(std::string_view type) {
+        if (equalsIgnoreCase(type, "application/json") || equalsIgnoreCase(type, "application/*") ||
+            equalsIgnoreCase(type, "*/*")) {
+            return WireFormat::Json;
+        }
+        if (equalsIgnoreCase(type, "application/cbor")) {
+            return WireFormat::Cbor;
+        }
+        if (equalsIgnoreCase(type, "application/msgpack") || equalsIgnoreCase(type, "application/x-msgpack") ||
+            equalsIgnoreCase(type, "application/vnd.msgpack")) {
+            return WireFormat::MessagePack;
+        }
+        return std::nullopt;
+    }
+
+    // MessagePack length prefixes for str/array/map: fix, 16-bit, 32-bit
+    void msgpackLength(std::string& out, size_t length, uint8_t fix_base, size_t fix_max,
+                       uint8_t code16, uint8_t code32) {
+        if (length <= fix_max) {
+            out += static_cast<char>(fix_base | length);
+        } else if (length <= 0xffff) {
+            out += static_cast<char>(code16);
+            out += static_cast<char>(length >> 8);
+            out += static_cast<char>(length);
+        } else {
+            out += static_cast<char>(code32);
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                out += static_cast<char>(length >> shift);
+            }
+        }
+    }
+}
+
+std::optional<WireFormat> negotiateWireFormat(std::string_view accept) {
+    accept = trim(accept);
+    if (accept.empty()) {
+        return WireFormat::Json;
+    }
+
+    std::optional<WireFormat> best;
+    double best_q = 0.0;
+    while (!accept.empty()) {
+        size_t comma = accept.find(',');
+        std::string_view item = accept.substr(0, comma);
+        accept = comma == std::string_view::npos ? std::string_view() : accept.substr(comma + 1);
+
+        size_t semicolon = item.find(';');
+        std::string_view type = trim(item.substr(0, semicolon));
+        double q = 1.0;
+        while (semicolon != std::string_view::npos) {
+            item = item.substr(semicolon + 1);
+            semicolon = item.find(';');
+            std::string_view param = trim(item.substr(0, semicolon));
+            if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                auto parsed = NumberParser::parseDouble(param.substr(2));
+                q = parsed.ok() ? std::clamp(parsed.value, 0.0, 1.0) : 0.0;
+            }
+        }
+
+        auto format = formatForMediaType(type);
+        if (format && q > best_q) {
+            best = format;
+            best_q = q;
+        }
+    }
+    return best;
+}
+
+const char* wireFormatContentType(WireFormat format) {
+    switch (format) {
+        case WireFormat::Json: return "application/json";
+        case WireFormat::Cbor: return "application/cbor";
+        case WireFormat::MessagePack: return "application/msgpack";
+    }
+    return "application/octet-stream";
+}
+
+CompactWriter::CompactWriter(WireFormat format, std::string& out)
+    : format_(format), out_(out) {
+}
+
+void CompactWriter::separate() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (!first_.empty()) {
+        if (!first_.back()) {
+            out_ += ',';
+        }
+        first_.back() = false;
+    }
+}
+
+void CompactWriter::appendBigEndian(uint64_t value, int bytes) {
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        out_ += static_cast<char>((value >> shift) & 0xff);
+    }
+}
+
+void CompactWriter::cborHead(uint8_t major, uint64_t value) {
+    uint8_t type = static_cast<uint8_t>(major << 5);
+    if (value < 24) {
+        out_ += static_cast<char>(type | value);
+    } else if (value <= 0xff) {
+        out_ += static_cast<char>(type | 24);
+        appendBigEndian(value, 1);
+    } else if (value <= 0xffff) {
+        out_ += static_cast<char>(type | 25);
+        appendBigEndian(value, 2);
+    } else if (value <= 0xffffffffULL) {
+        out_ += static_cast<char>(type | 26);
+        appendBigEndian(value, 4);
+    } else {
+        out_ += static_cast<char>(type | 27);
+        appendBigEndian(value, 8);
+    }
+}
+
+void CompactWriter::beginMap(size_t entries) {
+    switch (format_) {
+        case WireFormat::Json:
+            separate();
+            out_ += '{';
+            first_.push_back(true);
+            break;
+        case WireFormat::Cbor:
+            cborHead(5, entries);
+            break;
+        case WireFormat::MessagePack:
+            msgpackLength(out_, entries, 0x80, 15, 0xde, 0xdf);
+            break;
+    }
+}
+
+void CompactWriter::endMap() {
+    if (format_ == WireFormat::Json) {
+        out_ += '}';
+        first_.pop_back();
+    }
+}
+
+void CompactWriter::beginArray(size_t entries) {
+    switch (format_) {
+        case WireFormat::Json:
+            separate();
+            out_ += '[';
+            first_.push_back(true);
+            break;
+        case WireFormat::Cbor:
+            cborHead(4, entries);
+            break;
+        case WireFormat::MessagePack:
+            msgpackLength(out_, entries, 0x90, 15, 0xdc, 0xdd);
+            break;
+    }
+}
+
+void CompactWriter::endArray() {
+    if (format_ == WireFormat::Json) {
+        out_ += ']';
+        first_.pop_back();
+    }
+}
+
+void CompactWriter::key(std::string_view name) {
+    string(name);
+    if (format_ == WireFormat::Json) {
+        out_ += ':';
+        after_key_ = true;
+    }
+}
+
+void CompactWriter::string(std::string_view value) {
+    switch (format_) {
+        case WireFormat::Json: {
+            static const char* hex = "0123456789abcdef";
+            separate();
+            out_ += '"';
+            for (char c : value) {
+                switch (c) {
+                    case '"': out_ += "\\\""; break;
+                    case '\\': out_ += "\\\\"; break;
+                    case '\n': out_ += "\\n"; break;
+                    case '\r': out_ += "\\r"; break;
+                    case '\t': out_ += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            out_ += "\\u00";
+                            out_ += hex[(c >> 4) & 0x0f];
+                            out_ += hex[c & 0x0f];
+                        } else {
+                            out_ += c;
+                        }
+                }
+            }
+            out_ += '"';
+            break;
+        }
+        case WireFormat::Cbor:
+            cborHead(3, value.size());
+            out_.append(value.data(), value.size());
+            break;
+        case WireFormat::MessagePack:
+            if (value.size() > 31 && value.size() <= 0xff) {
+                out_ += static_cast<char>(0xd9);
+                out_ += static_cast<char>(value.size());
+            } else {
+                msgpackLength(out_, value.size(), 0xa0, 31, 0xda, 0xdb);
+            }
+            out_.append(value.data(), value.size());
+            break;
+    }
+}
+
+void CompactWriter::integer(int64_t value) {
+    switch (format_) {
+        case WireFormat::Json: {
+            separate();
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out_.append(buffer, result.ptr);
+            break;
+        }
+        case WireFormat::Cbor:
+            if (value >= 0) {
+                cborHead(0, static_cast<uint64_t>(value));
+            } else {
+                cborHead(1, static_cast<uint64_t>(-(value + 1)));
+            }
+            break;
+        case WireFormat::MessagePack:
+            if (value >= 0 && value < 128) {
+                out_ += static_cast<char>(value);  // positive fixint
+            } else if (value < 0 && value >= -32) {
+                out_ += static_cast<char>(value);  // negative fixint
+            } else if (value >= INT16_MIN && value <= INT16_MAX) {
+                out_ += static_cast<char>(0xd1);
+                appendBigEndian(static_cast<uint64_t>(value), 2);
+            } else if (value >= INT32_MIN && value <= INT32_MAX) {
+                out_ += static_cast<char>(0xd2);
+                appendBigEndian(static_cast<uint64_t>(value), 4);
+            } else {
+                out_ += static_cast<char>(0xd3);
+                appendBigEndian(static_cast<uint64_t>(value), 8);
+            }
+            break;
+    }
+}
+
+void CompactWriter::number(double value) {
+    if (!std::isfinite(value)) {
+        null();
+        return;
+    }
+
+    if (format_ == WireFormat::Json) {
+        separate();
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out_.append(buffer, result.ptr);
+        return;
+    }
+
+    // Binary formats: single precision when it round-trips exactly
+    float single = static_cast<float>(value);
+    if (static_cast<double>(single) == value) {
+        uint32_t bits;
+        std::memcpy(&bits, &single, sizeof(bits));
+        out_ += static_cast<char>(format_ == WireFormat::Cbor ? 0xfa : 0xca);
+        appendBigEndian(bits, 4);
+    } else {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        out_ += static_cast<char>(format_ == WireFormat::Cbor ? 0xfb : 0xcb);
+        appendBigEndian(bits, 8);
+    }
+}
+
+void CompactWriter::boolean(bool value) {
+    switch (format_) {
+        case WireFormat::Json:
+            separate();
+            out_ += value ? "true" : "false";
+            break;
+        case WireFormat::Cbor:
+            out_ += static_cast<char>(value ? 0xf5 : 0xf4);
+            break;
+        case WireFormat::MessagePack:
+            out_ += static_cast<char>(value ? 0xc3 : 0xc2);
+            break;
+    }
+}
+
+void CompactWriter::null() {
+    switch (format_) {
+        case WireFormat::Json:
+            separate();
+            out_ += "null";
+            break;
+        case WireFormat::Cbor:
+            out_ += static_cast<char>(0xf6);
+            break;
+        case WireFormat::MessagePack:
+            out_ += static_cast<char>(0xc0);
+            break;
+    }
+}
+
+}  // namespace hms_nut
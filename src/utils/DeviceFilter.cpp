@@ -0,0 +1,135 @@
+#include "utils/DeviceFilter.h"
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+
+namespace hms_nut {
+
+std::vector<std::string> DeviceFilterConfig::parsePatterns(const std::string& csv) {
+    std::vector<std::string> patterns;
+    std::istringstream ss(csv);
+    std::string pattern;
+
+    while (std::getline(ss, pattern, ',')) {
+        pattern.erase(0, pattern.find_first_not_of(" \t"));
+        pattern.erase(pattern.find_last_not_of(" \t") + 1);
+        if (!pattern.empty()) {
+            patterns.push_back(pattern);
+        }
+    }
+    return patterns;
+}
+
+DeviceFilter::DeviceFilter(DeviceFilterConfig config)
+    : config_(std::move(config)) {
+}
+
+DeviceFilter::Decision DeviceFilter::evaluate(std::string_view device_id) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = cache_.find(device_id);
+        if (it != cache_.end()) {
+            return it->second;
+        }
+    }
+
+    // First message from this device - run the patterns once
+    Decision decision = decide(device_id);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (decision == Decision::Pending && discovered_.find(device_id) != discovered_.end()) {
+        decision = Decision::Admit;  // Discovery config arrived while deciding
+    }
+    if (cache_.size() >= kMaxCachedDecisions) {
+        cache_.clear();
+    }
+    cache_.emplace(std::string(device_id), decision);
+    return decision;
+}
+
+bool DeviceFilter::admit(std::string_view device_id) {
+    if (evaluate(device_id) == Decision::Admit) {
+        return true;
+    }
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool DeviceFilter::onDiscoveryConfig(std::string_view device_id, std::string_view sensor_id) {
+    if (!config_.require_discovery || !isUpsMarkerSensor(sensor_id)) {
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (!discovered_.emplace(std::string(device_id)).second) {
+        return false;
+    }
+
+    // Re-decide on the next message; only a pending device changes outcome
+    auto it = cache_.find(device_id);
+    bool was_pending = it == cache_.end() || it->second == Decision::Pending;
+    if (it != cache_.end()) {
+        cache_.erase(it);
+    }
+    lock.unlock();
+
+    return was_pending && evaluate(device_id) == Decision::Admit;
+}
+
+bool DeviceFilter::isUpsMarkerSensor(std::string_view sensor_id) {
+    // Published by the NUT bridge and by the ESP32 monitors, and specific
+    // enough that unrelated batteries (phones, sensors) don't match
+    return sensor_id == "ups_status" || sensor_id == "battery_runtime";
+}
+
+bool DeviceFilter::globMatch(std::string_view pattern, std::string_view text) {
+    size_t p = 0, t = 0;
+    size_t star = std::string_view::npos, resume = 0;
+
+    while (t < text.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+            ++p;
+            ++t;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            star = p++;
+            resume = t;
+        } else if (star != std::string_view::npos) {
+            // Let the last '*' absorb one more character and retry
+            p = star + 1;
+            t = ++resume;
+        } else {
+            return false;
+        }
+    }
+
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+DeviceFilter::Decision DeviceFilter::decide(std::string_view device_id) const {
+    auto matches = [device_id](const std::string& pattern) {
+        return globMatch(pattern, device_id);
+    };
+
+    if (std::find(config_.always_admit.begin(), config_.always_admit.end(), device_id) !=
+        config_.always_admit.end()) {
+        return Decision::Admit;
+    }
+    if (std::any_of(config_.deny.begin(), config_.deny.end(), matches)) {
+        return Decision::Reject;
+    }
+    if (!config_.allow.empty() && std::none_of(config_.allow.begin(), config_.allow.end(), matches)) {
+        return Decision::Reject;
+    }
+    if (config_.require_discovery) {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (discovered_.find(device_id) == discovered_.end()) {
+            return Decision::Pending;
+        }
+    }
+    return Decision::Admit;
+}
+
+}  // namespace hms_nut
@@ -0,0 +1,59 @@
+#include "utils/GzipStream.h"
+#include <zlib.h>
+#include <stdexcept>
+
+namespace hms_nut {
+
+struct GzipStream::State {
+    z_stream stream{};
+};
+
+namespace {
+    constexpr int kGzipWindowBits = 15 + 16;  // +16: gzip header/trailer instead of zlib
+    constexpr size_t kChunk = 16 * 1024;
+
+    void deflateInto(z_stream& stream, int flush, std::string& out) {
+        char buffer[kChunk];
+        do {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer);
+            stream.avail_out = kChunk;
+            int rc = deflate(&stream, flush);
+            if (rc == Z_STREAM_ERROR) {
+                throw std::runtime_error("gzip: deflate failed");
+            }
+            out.append(buffer, kChunk - stream.avail_out);
+        } while (stream.avail_out == 0);
+    }
+}
+
+GzipStream::GzipStream(int level)
+    : state_(std::make_unique<State>()) {
+    if (deflateInit2(&state_->stream, level, Z_DEFLATED, kGzipWindowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw std::runtime_error("gzip: deflateInit2 failed");
+    }
+}
+
+GzipStream::~GzipStream() {
+    deflateEnd(&state_->stream);
+}
+
+void GzipStream::write(std::string_view input, std::string& out) {
+    if (finished_ || input.empty()) {
+        return;
+    }
+    state_->stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    state_->stream.avail_in = static_cast<uInt>(input.size());
+    deflateInto(state_->stream, Z_NO_FLUSH, out);
+}
+
+void GzipStream::finish(std::string& out) {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+    state_->stream.next_in = nullptr;
+    state_->stream.avail_in = 0;
+    deflateInto(state_->stream, Z_FINISH, out);
+}
+
+}  // namespace hms_nut
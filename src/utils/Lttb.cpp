@@ -0,0 +1,136 @@
+#include "utils/Lttb.h"
+#include <algorithm>
+#include <cmath>
+
+namespace hms_nut {
+
+LttbDownsampler::LttbDownsampler(int64_t from_ms, int64_t to_ms, size_t threshold)
+    : from_ms_(from_ms),
+      threshold_(std::max<size_t>(threshold, 3)),
+      bucket_width_(std::max<double>(static_cast<double>(to_ms - from_ms), 1.0) /
+                    static_cast<double>(std::max<size_t>(threshold, 3) - 2)) {
+    pending_.reserve(threshold_ + 1);
+}
+
+void LttbDownsampler::add(int64_t timestamp_ms, double value) {
+    ++input_count_;
+    Point point{timestamp_ms, value};
+
+    if (!streaming_) {
+        pending_.push_back(point);
+        if (pending_.size() <= threshold_) {
+            return;
+        }
+        // Too many to pass through - replay what was buffered
+        streaming_ = true;
+        for (const auto& buffered : pending_) {
+            stream(buffered);
+        }
+        pending_.clear();
+        pending_.shrink_to_fit();
+        return;
+    }
+    stream(point);
+}
+
+std::vector<LttbDownsampler::Point> LttbDownsampler::finish() {
+    if (!streaming_) {
+        return std::move(pending_);
+    }
+
+    if (!current_.empty()) {
+        select(current_, next_.empty() ? held_ : average(next_));
+    }
+    if (!next_.empty()) {
+        select(next_, held_);
+    }
+    if (have_held_) {
+        out_.push_back(held_);
+    }
+    current_.clear();
+    next_.clear();
+    have_held_ = false;
+    return std::move(out_);
+}
+
+void LttbDownsampler::stream(const Point& point) {
+    if (out_.empty()) {
+        out_.push_back(point);  // First point is always kept
+        return;
+    }
+    // Hold the newest point back: whichever arrives last is kept as-is
+    if (have_held_) {
+        place(held_);
+    }
+    held_ = point;
+    have_held_ = true;
+}
+
+void LttbDownsampler::place(const Point& point) {
+    size_t index = bucketIndex(point.timestamp_ms);
+
+    if (current_.empty()) {
+        current_.push_back(point);
+        current_index_ = index;
+        return;
+    }
+    if (index <= current_index_ && next_.empty()) {
+        current_.push_back(point);
+        return;
+    }
+    if (next_.empty() || index <= next_index_) {
+        if (next_.empty()) {
+            next_index_ = index;
+        }
+        next_.push_back(point);
+        return;
+    }
+
+    // A third bucket started: the current one can be decided now
+    select(current_, average(next_));
+    current_.swap(next_);
+    current_index_ = next_index_;
+    next_.clear();
+    next_.push_back(point);
+    next_index_ = index;
+}
+
+size_t LttbDownsampler::bucketIndex(int64_t timestamp_ms) const {
+    double offset = static_cast<double>(timestamp_ms - from_ms_) / bucket_width_;
+    if (offset <= 0.0) {
+        return 0;
+    }
+    return std::min(static_cast<size_t>(offset), threshold_ - 3);
+}
+
+LttbDownsampler::Point LttbDownsampler::average(const std::vector<Point>& bucket) {
+    double t = 0.0;
+    double v = 0.0;
+    for (const auto& point : bucket) {
+        t += static_cast<double>(point.timestamp_ms);
+        v += point.value;
+    }
+    double n = static_cast<double>(bucket.size());
+    return {static_cast<int64_t>(t / n), v / n};
+}
+
+void LttbDownsampler::select(const std::vector<Point>& bucket, const Point& next) {
+    const Point& a = out_.back();
+    // Times relative to the kept point keep the products well inside double precision
+    double next_t = static_cast<double>(next.timestamp_ms - a.timestamp_ms);
+    double next_dv = next.value - a.value;
+
+    const Point* best = &bucket.front();
+    double best_area = -1.0;
+    for (const auto& point : bucket) {
+        double t = static_cast<double>(point.timestamp_ms - a.timestamp_ms);
+        double area = std::fabs(next_t * (point.value - a.value) - t * next_dv);
+        if (area > best_area) {
+            best_area = area;
+            best = &point;
+        }
+    }
+    out_.push_back(*best);
+}
+
+}  // namespace hms_nut
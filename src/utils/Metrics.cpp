@@ -0,0 +1,211 @@
+#include "utils/Metrics.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace hms_nut {
+
+namespace {
+    void appendNumber(std::string& out, double value) {
+        if (std::isnan(value)) {
+            out += "NaN";
+            return;
+        }
+        if (std::isinf(value)) {
+            out += value > 0 ? "+Inf" : "-Inf";
+            return;
+        }
+        char buf[32];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, ec == std::errc() ? end : buf);
+    }
+
+    void appendNumber(std::string& out, uint64_t value) {
+        char buf[24];
+        auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, ec == std::errc() ? end : buf);
+    }
+
+    void appendSample(std::string& out, const std::string& name, const char* suffix,
+                      const std::string& labels, const std::string& extra_label) {
+        out += name;
+        out += suffix;
+        if (!labels.empty() || !extra_label.empty()) {
+            out += '{';
+            out += labels;
+            if (!labels.empty() && !extra_label.empty()) {
+                out += ',';
+            }
+            out += extra_label;
+            out += '}';
+        }
+        out += ' ';
+    }
+}
+
+Histogram::Histogram(const std::vector<double>& bounds_seconds)
+    : bounds_seconds_(bounds_seconds),
+      buckets_(new std::atomic<uint64_t>[bounds_seconds.size() + 1]) {
+    bounds_ns_.reserve(bounds_seconds_.size());
+    for (double bound : bounds_seconds_) {
+        bounds_ns_.push_back(static_cast<int64_t>(std::llround(bound * 1e9)));
+    }
+    for (size_t i = 0; i <= bounds_seconds_.size(); ++i) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::observe(std::chrono::nanoseconds duration) {
+    int64_t ns = std::max<int64_t>(duration.count(), 0);
+    size_t i = 0;
+    while (i < bounds_ns_.size() && ns > bounds_ns_[i]) {
+        ++i;
+    }
+    buckets_[i].fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(static_cast<uint64_t>(ns), std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    // Buckets are read one by one; a concurrent observe() may land in only
+    // some of them, which scrapers tolerate
+    Snapshot snap;
+    snap.cumulative.reserve(bounds_ns_.size() + 1);
+    for (size_t i = 0; i <= bounds_ns_.size(); ++i) {
+        snap.count += buckets_[i].load(std::memory_order_relaxed);
+        snap.cumulative.push_back(snap.count);
+    }
+    snap.sum_seconds = static_cast<double>(sum_ns_.load(std::memory_order_relaxed)) / 1e9;
+    return snap;
+}
+
+const std::vector<double>& Histogram::latencyBounds() {
+    static const std::vector<double> bounds = {
+        0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+        0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+    };
+    return bounds;
+}
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+MetricsRegistry::Series& MetricsRegistry::series(const std::string& name, const std::string& help,
+                                                 Type type, const std::string& labels) {
+    auto [it, inserted] = families_.try_emplace(name);
+    Family& family = it->second;
+    if (inserted) {
+        family.type = type;
+        family.help = help;
+    } else if (family.type != type) {
+        throw std::logic_error("Metric " + name + " registered with another type");
+    }
+
+    for (auto& existing : family.series) {
+        if (existing->labels == labels) {
+            return *existing;
+        }
+    }
+    family.series.push_back(std::make_unique<Series>());
+    family.series.back()->labels = labels;
+    return *family.series.back();
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help,
+                                  const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& s = series(name, help, Type::Counter, labels);
+    if (!s.counter) {
+        s.counter = std::make_unique<Counter>();
+    }
+    return *s.counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help,
+                              const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& s = series(name, help, Type::Gauge, labels);
+    if (!s.gauge) {
+        s.gauge = std::make_unique<Gauge>();
+    }
+    return *s.gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                      const std::vector<double>& bounds_seconds,
+                                      const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& s = series(name, help, Type::Histogram, labels);
+    if (!s.histogram) {
+        s.histogram = std::make_unique<Histogram>(bounds_seconds);
+    }
+    return *s.histogram;
+}
+
+void MetricsRegistry::counterCallback(const std::string& name, const std::string& help,
+                                      std::function<double()> read, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    series(name, help, Type::Counter, labels).read = std::move(read);
+}
+
+void MetricsRegistry::gaugeCallback(const std::string& name, const std::string& help,
+                                    std::function<double()> read, const std::string& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    series(name, help, Type::Gauge, labels).read = std::move(read);
+}
+
+std::string MetricsRegistry::render() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string out;
+    out.reserve(families_.size() * 256);
+
+    for (const auto& [name, family] : families_) {
+        out += "# HELP " + name + " " + family.help + "\n";
+        out += "# TYPE " + name + " ";
+        out += family.type == Type::Counter ? "counter\n" : family.type == Type::Gauge ? "gauge\n" : "histogram\n";
+
+        for (const auto& s : family.series) {
+            if (s->histogram) {
+                auto snap = s->histogram->snapshot();
+                const auto& bounds = s->histogram->bounds();
+                for (size_t i = 0; i < snap.cumulative.size(); ++i) {
+                    std::string le = "le=\"";
+                    if (i < bounds.size()) {
+                        appendNumber(le, bounds[i]);
+                    } else {
+                        le += "+Inf";
+                    }
+                    le += '"';
+                    appendSample(out, name, "_bucket", s->labels, le);
+                    appendNumber(out, snap.cumulative[i]);
+                    out += '\n';
+                }
+                appendSample(out, name, "_sum", s->labels, "");
+                appendNumber(out, snap.sum_seconds);
+                out += '\n';
+                appendSample(out, name, "_count", s->labels, "");
+                appendNumber(out, snap.count);
+                out += '\n';
+                continue;
+            }
+
+            appendSample(out, name, "", s->labels, "");
+            if (s->counter) {
+                appendNumber(out, s->counter->value());
+            } else if (s->gauge) {
+                appendNumber(out, static_cast<double>(s->gauge->value()));
+            } else if (s->read) {
+                appendNumber(out, s->read());
+            } else {
+                appendNumber(out, 0.0);
+            }
+            out += '\n';
+        }
+    }
+
+    return out;
+}
+
+}  // namespace hms_nut
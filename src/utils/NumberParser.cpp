@@ -0,0 +1,69 @@
+#include "utils/NumberParser.h"
+#include <charconv>
+#include <system_error>
+
+namespace hms_nut {
+
+namespace {
+    // Skip leading whitespace and a '+' sign (from_chars rejects both)
+    std::string_view trimForParse(std::string_view str) {
+        size_t start = 0;
+        while (start < str.size() &&
+               (str[start] == ' ' || str[start] == '\t' || str[start] == '\n' || str[start] == '\r')) {
+            ++start;
+        }
+        str.remove_prefix(start);
+
+        if (str.size() > 1 && str[0] == '+' && str[1] != '-' && str[1] != '+') {
+            str.remove_prefix(1);
+        }
+        return str;
+    }
+
+    template <typename T, typename... Args>
+    ParseResult<T> fromChars(std::string_view str, Args... args) {
+        ParseResult<T> result;
+
+        str = trimForParse(str);
+        if (str.empty()) {
+            result.error = ParseError::Empty;
+            return result;
+        }
+
+        auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), result.value, args...);
+
+        if (ec == std::errc::invalid_argument) {
+            result.error = ParseError::Invalid;
+        } else if (ec == std::errc::result_out_of_range) {
+            result.error = ParseError::OutOfRange;
+        }
+
+        return result;
+    }
+}
+
+ParseResult<double> NumberParser::parseDouble(std::string_view str) {
+    auto result = fromChars<double>(str, std::chars_format::general);
+
+    // A "nan" payload is as unusable as "unavailable" - reject it
+    if (result.ok() && result.value != result.value) {
+        result.error = ParseError::Invalid;
+    }
+    return result;
+}
+
+ParseResult<int> NumberParser::parseInt(std::string_view str) {
+    return fromChars<int>(str, 10);
+}
+
+const char* NumberParser::errorName(ParseError error) {
+    switch (error) {
+        case ParseError::None: return "none";
+        case ParseError::Empty: return "empty";
+        case ParseError::Invalid: return "invalid";
+        case ParseError::OutOfRange: return "out_of_range";
+    }
+    return "unknown";
+}
+
+}  // namespace hms_nut
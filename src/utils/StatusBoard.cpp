@@ -0,0 +1,81 @@
+#include "utils/StatusBoard.h"
+#include <algorithm>
+#include <iostream>
+
+namespace hms_nut {
+
+StatusBoard::~StatusBoard() {
+    stop();
+}
+
+void StatusBoard::addComponent(const std::string& name, Sampler sampler) {
+    samplers_.emplace_back(name, std::move(sampler));
+}
+
+void StatusBoard::start(std::chrono::milliseconds interval) {
+    if (running_) {
+        return;
+    }
+
+    interval_ = std::max(interval, std::chrono::milliseconds(100));
+    refresh();
+
+    running_ = true;
+    thread_ = std::thread(&StatusBoard::refreshLoop, this);
+    std::cout << "🩺 StatusBoard: Refreshing " << samplers_.size() << " components every "
+              << interval_.count() << " ms" << std::endl;
+}
+
+void StatusBoard::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void StatusBoard::refresh() {
+    auto next = std::make_shared<StatusSnapshot>();
+    next->components.reserve(samplers_.size());
+
+    for (const auto& [name, sampler] : samplers_) {
+        ComponentStatus status;
+        try {
+            status = sampler();
+        } catch (const std::exception& e) {
+            status.state = "error";
+            status.healthy = false;
+            status.details = Json::Value(Json::objectValue);
+            std::cerr << "❌ StatusBoard: " << name << " status failed: " << e.what() << std::endl;
+        }
+        next->healthy = next->healthy && status.healthy;
+        next->components.emplace_back(name, std::move(status));
+    }
+
+    next->taken = std::chrono::system_clock::now();
+    next->taken_steady = std::chrono::steady_clock::now();
+    std::atomic_store(&snapshot_, std::shared_ptr<const StatusSnapshot>(std::move(next)));
+}
+
+void StatusBoard::refreshLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        if (cv_.wait_for(lock, interval_, [this] { return !running_; })) {
+            break;
+        }
+
+        // Samplers may block on service locks - never hold our own meanwhile
+        lock.unlock();
+        refresh();
+        lock.lock();
+    }
+}
+
+}  // namespace hms_nut
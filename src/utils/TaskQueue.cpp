@@ -0,0 +1,89 @@
+#include "utils/TaskQueue.h"
+#include <iostream>
+
+namespace hms_nut {
+
+TaskQueue::TaskQueue(std::string name, size_t workers, size_t max_pending)
+    : name_(std::move(name)),
+      workers_count_(workers > 0 ? workers : 1),
+      max_pending_(max_pending) {
+}
+
+TaskQueue::~TaskQueue() {
+    stop();
+}
+
+void TaskQueue::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    for (size_t i = 0; i < workers_count_; ++i) {
+        workers_.emplace_back(&TaskQueue::workerLoop, this);
+    }
+}
+
+void TaskQueue::stop() {
+    std::deque<Task> discarded;
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        discarded.swap(tasks_);
+        workers.swap(workers_);
+    }
+    cv_.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    if (!discarded.empty()) {
+        std::cout << "⚠️  " << name_ << ": Discarded " << discarded.size() << " queued task(s)" << std::endl;
+    }
+}
+
+bool TaskQueue::submit(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_ || tasks_.size() >= max_pending_) {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+size_t TaskQueue::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+void TaskQueue::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return !running_ || !tasks_.empty(); });
+        if (!running_) {
+            break;
+        }
+
+        Task task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lock.unlock();
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "❌ " << name_ << ": Task failed: " << e.what() << std::endl;
+        }
+        task = nullptr;  // Release captures before taking the lock again
+        lock.lock();
+    }
+}
+
+}  // namespace hms_nut
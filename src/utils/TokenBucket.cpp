@@ -0,0 +1,49 @@
+#include "utils/TokenBucket.h"
+#include <algorithm>
+
+namespace hms_nut {
+
+TokenBucket::TokenBucket(double rate, double capacity, Clock::time_point now)
+    : rate_(std::max(rate, 0.001)),
+      capacity_(std::max(capacity, 1.0)),
+      tokens_(capacity_),
+      last_refill_(now) {
+}
+
+void TokenBucket::refill(Clock::time_point now) {
+    if (now <= last_refill_) {
+        return;
+    }
+
+    double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+    tokens_ = std::min(capacity_, tokens_ + elapsed * rate_);
+    last_refill_ = now;
+}
+
+bool TokenBucket::tryAcquire(Clock::time_point now) {
+    refill(now);
+
+    if (tokens_ >= 1.0) {
+        tokens_ -= 1.0;
+        return true;
+    }
+    return false;
+}
+
+TokenBucket::Clock::duration TokenBucket::timeUntilAvailable(Clock::time_point now) {
+    refill(now);
+
+    if (tokens_ >= 1.0) {
+        return Clock::duration::zero();
+    }
+
+    auto wait = std::chrono::duration<double>((1.0 - tokens_) / rate_);
+    return std::chrono::duration_cast<Clock::duration>(wait) + Clock::duration(1);
+}
+
+void TokenBucket::setRate(double rate, Clock::time_point now) {
+    refill(now);
+    rate_ = std::max(rate, 0.001);
+}
+
+}  // namespace hms_nut
@@ -0,0 +1,101 @@
+/**
+ * Benchmark: NumberParser (std::from_chars) vs legacy std::stod/std::stoi + try/catch
+ *
+ * Not registered with ctest. Run manually:
+ *   ./bench_number_parser [iterations]
+ *
+ * Input mix models real traffic: mostly valid NUT/ESP32 values plus the
+ * invalid payloads ESP32 firmware sends while a sensor is unavailable.
+ */
+#include "utils/NumberParser.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace hms_nut;
+
+namespace {
+    // Pre-NumberParser implementation (UpsData.cpp <= 1.2.0)
+    std::optional<double> legacyParseDouble(const std::string& str) {
+        try {
+            size_t pos;
+            double value = std::stod(str, &pos);
+            return (pos > 0) ? std::optional<double>(value) : std::nullopt;
+        } catch (...) {
+            return std::nullopt;
+        }
+    }
+
+    std::optional<int> legacyParseInt(const std::string& str) {
+        try {
+            size_t pos;
+            int value = std::stoi(str, &pos);
+            return (pos > 0) ? std::optional<int>(value) : std::nullopt;
+        } catch (...) {
+            return std::nullopt;
+        }
+    }
+
+    template <typename Fn>
+    double runNsPerOp(const std::vector<std::string>& inputs, long iterations, Fn&& fn) {
+        volatile double sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; ++i) {
+            for (const auto& input : inputs) {
+                sink = sink + fn(input);
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        return ns / (static_cast<double>(iterations) * inputs.size());
+    }
+
+    void report(const char* name, const std::vector<std::string>& inputs, long iterations) {
+        double legacy_d = runNsPerOp(inputs, iterations, [](const std::string& s) {
+            return legacyParseDouble(s).value_or(0.0);
+        });
+        double fast_d = runNsPerOp(inputs, iterations, [](const std::string& s) {
+            return NumberParser::parseDouble(s).toOptional().value_or(0.0);
+        });
+        double legacy_i = runNsPerOp(inputs, iterations, [](const std::string& s) {
+            return static_cast<double>(legacyParseInt(s).value_or(0));
+        });
+        double fast_i = runNsPerOp(inputs, iterations, [](const std::string& s) {
+            return static_cast<double>(NumberParser::parseInt(s).toOptional().value_or(0));
+        });
+
+        std::cout << name << "\n"
+                  << "  double: legacy " << legacy_d << " ns/op, from_chars " << fast_d
+                  << " ns/op (" << legacy_d / fast_d << "x)\n"
+                  << "  int:    legacy " << legacy_i << " ns/op, from_chars " << fast_i
+                  << " ns/op (" << legacy_i / fast_i << "x)\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? std::atol(argv[1]) : 200000;
+
+    const std::vector<std::string> valid = {
+        "100", "13.7", "2400", "121.0", "25", "230.5", "27.0", "0", "1500", "13.50"
+    };
+    const std::vector<std::string> invalid = {
+        "unavailable", "", "unknown", "OL", "none"
+    };
+
+    // Realistic mix: ~80% valid, ~20% invalid
+    std::vector<std::string> mixed;
+    for (int i = 0; i < 4; ++i) {
+        mixed.insert(mixed.end(), valid.begin(), valid.end());
+    }
+    mixed.insert(mixed.end(), invalid.begin(), invalid.end());
+    mixed.insert(mixed.end(), invalid.begin(), invalid.end());
+
+    std::cout << "NumberParser benchmark (" << iterations << " iterations per set)\n";
+    report("valid only", valid, iterations);
+    report("invalid only", invalid, iterations);
+    report("mixed (80/20)", mixed, iterations / 4);
+    return 0;
+}
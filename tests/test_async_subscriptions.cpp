@@ -295,6 +295,126 @@ TEST_F(AsyncSubscriptionTest, ServiceStartupSequenceNonBlocking) {
     mqtt_client->disconnect();
 }
 
+/**
+ * Test 7: Concurrent publishers and state readers
+ *
+ * isConnected() and publish() must not serialize on a connection mutex:
+ * state reads stay fast while several threads publish.
+ */
+TEST_F(AsyncSubscriptionTest, ConcurrentPublishLockFreeState) {
+    auto mqtt_client = std::make_shared<MqttClient>(client_id_ + "_publish");
+
+    std::string broker = std::getenv("MQTT_BROKER") ? std::getenv("MQTT_BROKER") : "192.168.2.15";
+    std::string url = "tcp://" + broker + ":1883";
+    std::string user = std::getenv("MQTT_USER") ? std::getenv("MQTT_USER") : "aamat";
+    std::string pass = std::getenv("MQTT_PASSWORD") ? std::getenv("MQTT_PASSWORD") : "exploracion";
+
+    ASSERT_TRUE(mqtt_client->connect(url, user, pass));
+    EXPECT_EQ(mqtt_client->getConnectionState(), ConnectionState::Connected);
+
+    std::atomic<bool> publishing{true};
+    std::atomic<int> failed{0};
+    std::atomic<long> state_reads{0};
+
+    std::thread reader([&]() {
+        while (publishing) {
+            if (mqtt_client->isConnected()) {
+                state_reads++;
+            }
+        }
+    });
+
+    std::vector<std::thread> publishers;
+    for (int t = 0; t < 4; t++) {
+        publishers.emplace_back([&, t]() {
+            for (int i = 0; i < 500; i++) {
+                std::string topic = "test/async/publish/" + std::to_string(t) + "/" + std::to_string(i % 10);
+                if (!mqtt_client->publish(topic, std::to_string(i), 0, false)) {
+                    failed++;
+                }
+            }
+        });
+    }
+
+    for (auto& t : publishers) {
+        t.join();
+    }
+    publishing = false;
+    reader.join();
+
+    EXPECT_EQ(failed, 0);
+    EXPECT_GT(state_reads, 0);
+    EXPECT_TRUE(mqtt_client->flush(std::chrono::seconds(5))) << "Queue should drain";
+
+    auto stats = mqtt_client->getQueueStats();
+    EXPECT_EQ(stats.direct + stats.enqueued + stats.coalesced, 2000u);
+
+    mqtt_client->disconnect();
+    EXPECT_EQ(mqtt_client->getConnectionState(), ConnectionState::Disconnected);
+}
+
+/**
+ * Test: Split sessions keep subscriptions working on their own connection
+ *
+ * Messages published on the publish session must reach callbacks registered
+ * on the subscriber session, even while a publish burst is in progress.
+ */
+TEST_F(AsyncSubscriptionTest, SplitSessionsDeliverDuringPublishBurst) {
+    auto mqtt_client = std::make_shared<MqttClient>(client_id_ + "_split");
+    mqtt_client->setSplitSessions(true);
+
+    std::string broker = std::getenv("MQTT_BROKER") ? std::getenv("MQTT_BROKER") : "192.168.2.15";
+    std::string url = "tcp://" + broker + ":1883";
+    std::string user = std::getenv("MQTT_USER") ? std::getenv("MQTT_USER") : "aamat";
+    std::string pass = std::getenv("MQTT_PASSWORD") ? std::getenv("MQTT_PASSWORD") : "exploracion";
+
+    ASSERT_TRUE(mqtt_client->connect(url, user, pass));
+    EXPECT_TRUE(mqtt_client->hasSplitSessions());
+    EXPECT_TRUE(mqtt_client->isSubscriberConnected());
+
+    std::atomic<int> received{0};
+    ASSERT_TRUE(mqtt_client->subscribe("test/async/split/probe",
+        [&received](const std::string& topic, const std::string& payload) {
+            received++;
+        }, 1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    // Discovery-sized burst on the publish session
+    std::string big_payload(2048, 'x');
+    for (int i = 0; i < 500; i++) {
+        mqtt_client->publish("test/async/split/burst/" + std::to_string(i), big_payload, 1, false);
+    }
+    mqtt_client->publish("test/async/split/probe", "ping", 1, false);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (received == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_GT(received, 0) << "Probe should arrive on the subscriber session";
+
+    mqtt_client->disconnect();
+    EXPECT_FALSE(mqtt_client->isSubscriberConnected());
+}
+
+/**
+ * Test: Wildcard matching used to dispatch inbound messages (no broker needed)
+ */
+TEST_F(AsyncSubscriptionTest, TopicMatchesWildcards) {
+    EXPECT_TRUE(MqttClient::topicMatches("homeassistant/sensor/ups/battery_charge/state",
+                                         "homeassistant/sensor/+/+/state"));
+    EXPECT_FALSE(MqttClient::topicMatches("homeassistant/sensor/ups/battery_charge/config",
+                                          "homeassistant/sensor/+/+/state"));
+    EXPECT_FALSE(MqttClient::topicMatches("homeassistant/sensor/ups/state",
+                                          "homeassistant/sensor/+/+/state"));
+    EXPECT_TRUE(MqttClient::topicMatches("homeassistant/status", "homeassistant/status"));
+    EXPECT_FALSE(MqttClient::topicMatches("homeassistant/status/x", "homeassistant/status"));
+    EXPECT_TRUE(MqttClient::topicMatches("test/a/b/c", "test/#"));
+    EXPECT_TRUE(MqttClient::topicMatches("test", "test/#"));
+    EXPECT_TRUE(MqttClient::topicMatches("anything/at/all", "#"));
+    EXPECT_FALSE(MqttClient::topicMatches("other/a", "test/#"));
+    EXPECT_TRUE(MqttClient::topicMatches("a//c", "a/+/c"));
+}
+
 /**
  * Main function for running tests
  */
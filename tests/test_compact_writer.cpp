@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include "utils/CompactWriter.h"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace hms_nut;
+
+namespace {
+    std::vector<uint8_t> bytes(const std::string& data) {
+        return std::vector<uint8_t>(data.begin(), data.end());
+    }
+
+    // {"n": [1, -2, 1.5], "s": "ok", "b": true, "z": null}
+    void writeSample(CompactWriter& writer) {
+        writer.beginMap(4);
+        writer.key("n");
+        writer.beginArray(3);
+        writer.integer(1);
+        writer.integer(-2);
+        writer.number(1.5);
+        writer.endArray();
+        writer.key("s");
+        writer.string("ok");
+        writer.key("b");
+        writer.boolean(true);
+        writer.key("z");
+        writer.null();
+        writer.endMap();
+    }
+}
+
+TEST(CompactWriterTest, Json) {
+    std::string out;
+    CompactWriter writer(WireFormat::Json, out);
+    writeSample(writer);
+    EXPECT_EQ(out, R"({"n":[1,-2,1.5],"s":"ok","b":true,"z":null})");
+}
+
+TEST(CompactWriterTest, JsonEscapesAndNonFinite) {
+    std::string out;
+    CompactWriter writer(WireFormat::Json, out);
+    writer.beginArray(3);
+    writer.string("a\"b\\c\n\x01");
+    writer.number(std::numeric_limits<double>::quiet_NaN());
+    writer.number(121.4);
+    writer.endArray();
+    EXPECT_EQ(out, R"(["a\"b\\c\n\u0001",null,121.4])");
+}
+
+TEST(CompactWriterTest, Cbor) {
+    std::string out;
+    CompactWriter writer(WireFormat::Cbor, out);
+    writeSample(writer);
+    std::vector<uint8_t> expected = {
+        0xa4,                                     // map(4)
+        0x61, 'n', 0x83, 0x01, 0x21,              // "n": [1, -2,
+        0xfa, 0x3f, 0xc0, 0x00, 0x00,             //   1.5 (float32)]
+        0x61, 's', 0x62, 'o', 'k',
+        0x61, 'b', 0xf5,
+        0x61, 'z', 0xf6,
+    };
+    EXPECT_EQ(bytes(out), expected);
+}
+
+TEST(CompactWriterTest, CborWideValues) {
+    std::string out;
+    CompactWriter writer(WireFormat::Cbor, out);
+    writer.integer(1000);
+    writer.integer(-500);
+    writer.number(1.1);  // Not exact in float32
+    std::vector<uint8_t> expected = {
+        0x19, 0x03, 0xe8,
+        0x39, 0x01, 0xf3,
+        0xfb, 0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a,
+    };
+    EXPECT_EQ(bytes(out), expected);
+}
+
+TEST(CompactWriterTest, MessagePack) {
+    std::string out;
+    CompactWriter writer(WireFormat::MessagePack, out);
+    writeSample(writer);
+    std::vector<uint8_t> expected = {
+        0x84,                                     // fixmap(4)
+        0xa1, 'n', 0x93, 0x01, 0xfe,              // "n": [1, -2,
+        0xca, 0x3f, 0xc0, 0x00, 0x00,             //   1.5 (float32)]
+        0xa1, 's', 0xa2, 'o', 'k',
+        0xa1, 'b', 0xc3,
+        0xa1, 'z', 0xc0,
+    };
+    EXPECT_EQ(bytes(out), expected);
+}
+
+TEST(CompactWriterTest, MessagePackLengths) {
+    std::string out;
+    CompactWriter writer(WireFormat::MessagePack, out);
+    writer.string(std::string(40, 'x'));
+    ASSERT_EQ(out.size(), 42u);
+    EXPECT_EQ(static_cast<uint8_t>(out[0]), 0xd9);  // str8
+    EXPECT_EQ(static_cast<uint8_t>(out[1]), 40);
+
+    out.clear();
+    writer.beginArray(20);
+    EXPECT_EQ(bytes(out), (std::vector<uint8_t>{0xdc, 0x00, 0x14}));  // array16
+
+    out.clear();
+    writer.integer(300);
+    EXPECT_EQ(bytes(out), (std::vector<uint8_t>{0xd1, 0x01, 0x2c}));  // int16
+}
+
+TEST(CompactWriterTest, NegotiateWireFormat) {
+    EXPECT_EQ(negotiateWireFormat(""), WireFormat::Json);
+    EXPECT_EQ(negotiateWireFormat("*/*"), WireFormat::Json);
+    EXPECT_EQ(negotiateWireFormat("application/cbor"), WireFormat::Cbor);
+    EXPECT_EQ(negotiateWireFormat("application/x-msgpack"), WireFormat::MessagePack);
+    EXPECT_EQ(negotiateWireFormat("Application/MsgPack"), WireFormat::MessagePack);
+
+    // q-values, then header order
+    EXPECT_EQ(negotiateWireFormat("application/json;q=0.5, application/cbor"), WireFormat::Cbor);
+    EXPECT_EQ(negotiateWireFormat("application/msgpack, application/cbor"), WireFormat::MessagePack);
+    EXPECT_EQ(negotiateWireFormat("text/html, application/cbor;q=0.9, */*;q=0.1"), WireFormat::Cbor);
+
+    EXPECT_FALSE(negotiateWireFormat("text/html"));
+    EXPECT_FALSE(negotiateWireFormat("application/cbor;q=0"));
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
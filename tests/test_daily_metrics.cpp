@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+#include "nut/DailyMetrics.h"
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+using namespace hms_nut;
+
+namespace {
+    // 2026-03-13 00:00:00 UTC
+    constexpr int64_t kDay = 1773360000000LL;
+    constexpr int64_t kHourMs = 3600 * 1000LL;
+
+    DailyStatsRow statsRow() {
+        DailyAccumulator daily;
+        daily.addMetric(Metric::InputVoltage, 118.0, kDay + 3 * kHourMs);
+        daily.addMetric(Metric::InputVoltage, 124.0, kDay + 18 * kHourMs);
+        daily.addMetric(Metric::InputVoltage, 121.0, kDay + 20 * kHourMs);
+        daily.addMetric(Metric::LoadPercentage, 24.0, kDay + 3 * kHourMs);
+        daily.addMetric(Metric::LoadWatts, 150.0, kDay + 12 * kHourMs + 30 * 60 * 1000);
+        daily.addStatus("OL", kDay + 3 * kHourMs);
+        daily.addStatus("OB DISCHRG", kDay + 4 * kHourMs);
+        daily.addTransferReason("input voltage out of range", kDay + 4 * kHourMs);
+        return {"apc_bx", daily.current()};
+    }
+}
+
+TEST(DailyMetricsTest, FromDailyStats) {
+    DailyMetrics metrics = DailyMetrics::fromDailyStats("2026-03-13", {statsRow()});
+
+    EXPECT_EQ(metrics.date, "2026-03-13");
+    EXPECT_EQ(metrics.source, "daily_stats");
+    ASSERT_EQ(metrics.devices.size(), 1u);
+
+    const DeviceDailyMetrics& device = metrics.devices[0];
+    EXPECT_EQ(device.device_identifier, "apc_bx");
+    EXPECT_EQ(device.readings, 8u);
+    EXPECT_EQ(device.status_readings, 2u);
+    EXPECT_EQ(device.on_battery_readings, 1u);
+
+    const auto& input = device.metric(Metric::InputVoltage);
+    ASSERT_TRUE(input.has_value());
+    EXPECT_EQ(input->count, 3u);
+    EXPECT_DOUBLE_EQ(input->min, 118.0);
+    EXPECT_DOUBLE_EQ(input->max, 124.0);
+    EXPECT_DOUBLE_EQ(input->avg, 121.0);
+    ASSERT_TRUE(input->stddev.has_value());
+    EXPECT_DOUBLE_EQ(*input->stddev, 3.0);
+    EXPECT_EQ(input->min_ts_ms, kDay + 3 * kHourMs);
+    EXPECT_EQ(input->max_ts_ms, kDay + 18 * kHourMs);
+
+    EXPECT_FALSE(device.metric(Metric::Temperature).has_value());
+    ASSERT_TRUE(device.metric(Metric::LoadWatts).has_value());
+    EXPECT_FALSE(device.metric(Metric::LoadWatts)->stddev.has_value());  // One value
+}
+
+TEST(DailyMetricsTest, TextReport) {
+    DailyMetrics metrics = DailyMetrics::fromDailyStats("2026-03-13", {statsRow()});
+    metrics.power_events.push_back({"apc_bx", "outage_start", kDay + 4 * kHourMs, 100.0, 87.0, 24.0});
+
+    std::string text = metrics.toText();
+    EXPECT_EQ(text.rfind("UPS Energy Report for 2026-03-13\n", 0), 0u);
+    EXPECT_NE(text.find("Device: apc_bx\n"), std::string::npos);
+    EXPECT_NE(text.find("  Readings: 8\n"), std::string::npos);
+    EXPECT_NE(text.find("  Input Voltage: 118.0V (at 03:00) - 124.0V (at 18:00) (avg 121.0V, stddev 3.0V)\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("  Load: 24.0% avg (150.0W avg, 150.0W peak at 12:30)\n"), std::string::npos);
+    EXPECT_NE(text.find("  Power Failures: 1 of 2 status readings on battery\n"), std::string::npos);
+    EXPECT_NE(text.find("  UPS Status(es): OL, OB DISCHRG\n"), std::string::npos);
+    EXPECT_NE(text.find("  Transfer Reasons: input voltage out of range\n"), std::string::npos);
+    EXPECT_NE(text.find("Power Events:\n  - 04:00:00: apc_bx - outage_start (battery: 100.0% -> 87.0%)\n"),
+              std::string::npos);
+    EXPECT_EQ(text.find("Temperature"), std::string::npos);
+}
+
+TEST(DailyMetricsTest, TextReportFromAggregate) {
+    // ups_metrics aggregate: device name known, extreme times not
+    DailyMetrics metrics;
+    metrics.date = "2026-03-13";
+    metrics.source = "ups_metrics";
+    DeviceDailyMetrics device;
+    device.device_identifier = "apc_bx";
+    device.device_name = "APC Back-UPS";
+    device.readings = 24;
+    MetricSummary input;
+    input.count = 24;
+    input.min = 118.0;
+    input.max = 124.0;
+    input.avg = 121.04;
+    device.metrics[static_cast<size_t>(Metric::InputVoltage)] = input;
+    metrics.devices.push_back(device);
+
+    std::string text = metrics.toText();
+    EXPECT_NE(text.find("Device: APC Back-UPS (apc_bx)\n"), std::string::npos);
+    EXPECT_NE(text.find("  Input Voltage: 118.0V - 124.0V (avg 121.0V)\n"), std::string::npos);
+    EXPECT_EQ(text.find("Time range"), std::string::npos);
+}
+
+TEST(DailyMetricsTest, EmptyDayText) {
+    DailyMetrics metrics;
+    metrics.date = "2020-01-01";
+    EXPECT_TRUE(metrics.empty());
+    EXPECT_EQ(metrics.toText(), "No UPS metrics data found for 2020-01-01.");
+}
+
+TEST(DailyMetricsTest, JsonRoundTrip) {
+    DailyMetrics metrics = DailyMetrics::fromDailyStats("2026-03-13", {statsRow()});
+    metrics.power_events.push_back({"apc_bx", "outage_start", kDay + 4 * kHourMs, 100.0, std::nullopt, 24.0});
+
+    Json::Value json = metrics.toJson();
+    EXPECT_EQ(json["devices"][0]["device"].asString(), "apc_bx");
+    EXPECT_DOUBLE_EQ(json["devices"][0]["metrics"]["input_voltage"]["avg"].asDouble(), 121.0);
+    EXPECT_FALSE(json["devices"][0]["metrics"].isMember("temperature"));
+    EXPECT_FALSE(json["power_events"][0].isMember("battery_level_end"));
+
+    auto parsed = DailyMetrics::fromJson(json);
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->toText(), metrics.toText());
+    EXPECT_EQ(parsed->source, "daily_stats");
+    ASSERT_EQ(parsed->power_events.size(), 1u);
+    EXPECT_FALSE(parsed->power_events[0].battery_level_end.has_value());
+    EXPECT_EQ(parsed->power_events[0].load_at_event, std::optional<double>(24.0));
+
+    EXPECT_FALSE(DailyMetrics::fromJson(Json::Value("x")).has_value());
+}
+
+int main(int argc, char **argv) {
+    setenv("TZ", "UTC", 1);  // Report times are local time
+    tzset();
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
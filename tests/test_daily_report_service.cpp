@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include "services/DailyReportService.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace hms_nut;
+namespace fs = std::filesystem;
+
+class DailyReportServiceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = fs::temp_directory_path() /
+               ("hms_nut_reports_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        fs::remove_all(dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    /**
+     * Builder returning one device per date, counting calls
+     */
+    DailyReportService::Builder builder() {
+        return [this](const std::string& date, DailyMetrics& out) {
+            ++builds_;
+            if (fail_) {
+                return false;
+            }
+            out.date = date;
+            out.source = "ups_metrics";
+            if (!empty_) {
+                DeviceDailyMetrics device;
+                device.device_identifier = "apc_bx";
+                device.readings = 24;
+                MetricSummary load;
+                load.count = 24;
+                load.avg = 31.5;
+                device.metrics[static_cast<size_t>(Metric::LoadPercentage)] = load;
+                out.devices.push_back(device);
+            }
+            return true;
+        };
+    }
+
+    fs::path dir_;
+    int builds_ = 0;
+    bool fail_ = false;
+    bool empty_ = false;
+};
+
+TEST_F(DailyReportServiceTest, PastDayIsBuiltOnce) {
+    DailyReportService reports(builder());
+
+    auto first = reports.get("2026-03-13", "2026-03-14");
+    auto second = reports.get("2026-03-13", "2026-03-14");
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first, second);  // Same pre-rendered report
+    EXPECT_EQ(builds_, 1);
+    EXPECT_EQ(reports.getHits(), 1u);
+    EXPECT_EQ(reports.getMisses(), 1u);
+
+    EXPECT_EQ(first->text, first->metrics.toText());
+    EXPECT_NE(first->json.find("\"load_percentage\""), std::string::npos);
+    EXPECT_EQ(first->json.find('\n'), std::string::npos);
+}
+
+TEST_F(DailyReportServiceTest, GetCachedNeverBuilds) {
+    DailyReportService reports(builder(), dir_.string());
+
+    EXPECT_EQ(reports.getCached("2026-03-13", "2026-03-14"), nullptr);
+    EXPECT_EQ(builds_, 0);
+
+    auto built = reports.get("2026-03-13", "2026-03-14");
+    EXPECT_EQ(reports.getCached("2026-03-13", "2026-03-14"), built);
+    EXPECT_EQ(reports.getCached("2026-03-14", "2026-03-14"), nullptr);  // Today is never cached
+    EXPECT_EQ(builds_, 1);
+    EXPECT_EQ(reports.getHits(), 1u);
+    EXPECT_EQ(reports.getMisses(), 1u);
+}
+
+TEST_F(DailyReportServiceTest, TodayIsRebuilt) {
+    DailyReportService reports(builder());
+
+    reports.get("2026-03-14", "2026-03-14");
+    reports.get("2026-03-14", "2026-03-14");
+    EXPECT_EQ(builds_, 2);
+    EXPECT_EQ(reports.cachedDays(), 0u);
+}
+
+TEST_F(DailyReportServiceTest, EmptyAndFailedDaysAreNotCached) {
+    DailyReportService reports(builder(), dir_.string());
+
+    empty_ = true;
+    auto empty = reports.get("2026-03-13", "2026-03-14");
+    ASSERT_NE(empty, nullptr);
+    EXPECT_TRUE(empty->metrics.empty());
+
+    empty_ = false;
+    fail_ = true;
+    EXPECT_EQ(reports.get("2026-03-13", "2026-03-14"), nullptr);
+
+    fail_ = false;
+    auto filled = reports.get("2026-03-13", "2026-03-14");
+    ASSERT_NE(filled, nullptr);
+    EXPECT_FALSE(filled->metrics.empty());
+    EXPECT_EQ(builds_, 3);
+    EXPECT_EQ(reports.cachedDays(), 1u);
+}
+
+TEST_F(DailyReportServiceTest, DiskCacheSurvivesRestart) {
+    std::string json;
+    {
+        DailyReportService reports(builder(), dir_.string());
+        json = reports.get("2026-03-13", "2026-03-14")->json;
+    }
+    EXPECT_TRUE(fs::exists(dir_ / "2026-03-13.json"));
+    EXPECT_FALSE(fs::exists(dir_ / "2026-03-13.json.tmp"));
+
+    DailyReportService restarted(builder(), dir_.string());
+    auto report = restarted.get("2026-03-13", "2026-03-14");
+    ASSERT_NE(report, nullptr);
+    EXPECT_EQ(report->json, json);
+    EXPECT_EQ(builds_, 1);
+    EXPECT_EQ(restarted.getHits(), 1u);
+}
+
+TEST_F(DailyReportServiceTest, UnreadableCacheFileIsRebuilt) {
+    fs::create_directories(dir_);
+    std::ofstream(dir_ / "2026-03-13.json") << "{not json";
+
+    DailyReportService reports(builder(), dir_.string());
+    auto report = reports.get("2026-03-13", "2026-03-14");
+    ASSERT_NE(report, nullptr);
+    EXPECT_EQ(builds_, 1);
+    EXPECT_FALSE(report->metrics.empty());
+}
+
+TEST_F(DailyReportServiceTest, EvictsOldestDay) {
+    DailyReportService reports(builder(), "", 2);
+
+    reports.get("2026-03-11", "2026-03-14");
+    reports.get("2026-03-12", "2026-03-14");
+    reports.get("2026-03-13", "2026-03-14");
+    EXPECT_EQ(reports.cachedDays(), 2u);
+
+    reports.get("2026-03-13", "2026-03-14");
+    EXPECT_EQ(builds_, 3);
+    reports.get("2026-03-11", "2026-03-14");
+    EXPECT_EQ(builds_, 4);
+}
+
+TEST_F(DailyReportServiceTest, MalformedDateIsNeverCached) {
+    DailyReportService reports(builder(), dir_.string());
+
+    reports.get("../escape", "2026-03-14");
+    reports.get("../escape", "2026-03-14");
+    EXPECT_EQ(builds_, 2);
+    EXPECT_EQ(reports.cachedDays(), 0u);
+    EXPECT_TRUE(fs::is_empty(dir_));
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+#include "nut/DailyStats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+using namespace hms_nut;
+
+namespace {
+    // 2026-03-13 00:00:00 UTC
+    constexpr int64_t kDay = 1773360000000LL;
+    constexpr int64_t kHourMs = 3600 * 1000LL;
+
+    std::vector<double> voltages() {
+        std::vector<double> values;
+        for (int i = 0; i < 1000; ++i) {
+            values.push_back(120.0 + std::sin(i * 0.1) * 3.0 + (i % 7) * 0.01);
+        }
+        return values;
+    }
+}
+
+TEST(DailyStatsTest, RunningStatsMatchesTwoPass) {
+    auto values = voltages();
+    RunningStats stats;
+    for (size_t i = 0; i < values.size(); ++i) {
+        stats.add(values[i], static_cast<int64_t>(i));
+    }
+
+    double sum = 0.0;
+    for (double v : values) sum += v;
+    double mean = sum / values.size();
+    double squares = 0.0;
+    for (double v : values) squares += (v - mean) * (v - mean);
+
+    EXPECT_EQ(stats.count, values.size());
+    EXPECT_NEAR(stats.mean, mean, 1e-9);
+    EXPECT_NEAR(stats.variance(), squares / (values.size() - 1), 1e-9);
+
+    auto min_it = std::min_element(values.begin(), values.end());
+    auto max_it = std::max_element(values.begin(), values.end());
+    EXPECT_EQ(stats.min, *min_it);
+    EXPECT_EQ(stats.min_ts_ms, min_it - values.begin());
+    EXPECT_EQ(stats.max, *max_it);
+    EXPECT_EQ(stats.max_ts_ms, max_it - values.begin());
+}
+
+TEST(DailyStatsTest, MergeEqualsSequential) {
+    auto values = voltages();
+    RunningStats all, first, second;
+    for (size_t i = 0; i < values.size(); ++i) {
+        all.add(values[i], static_cast<int64_t>(i));
+        (i < 300 ? first : second).add(values[i], static_cast<int64_t>(i));
+    }
+    first.merge(second);
+
+    EXPECT_EQ(first.count, all.count);
+    EXPECT_NEAR(first.mean, all.mean, 1e-9);
+    EXPECT_NEAR(first.variance(), all.variance(), 1e-9);
+    EXPECT_EQ(first.min_ts_ms, all.min_ts_ms);
+    EXPECT_EQ(first.max_ts_ms, all.max_ts_ms);
+
+    RunningStats empty;
+    empty.merge(all);
+    EXPECT_EQ(empty.count, all.count);
+    EXPECT_EQ(empty.mean, all.mean);
+}
+
+TEST(DailyStatsTest, OnBatteryFlag) {
+    EXPECT_TRUE(isOnBatteryStatus("OB"));
+    EXPECT_TRUE(isOnBatteryStatus("OB DISCHRG"));
+    EXPECT_TRUE(isOnBatteryStatus("LB OB"));
+    EXPECT_FALSE(isOnBatteryStatus("OL"));
+    EXPECT_FALSE(isOnBatteryStatus("OL CHRG"));
+    EXPECT_FALSE(isOnBatteryStatus("OBX"));
+    EXPECT_FALSE(isOnBatteryStatus(""));
+}
+
+TEST(DailyStatsTest, AccumulatesStatusAndReasons) {
+    DailyAccumulator acc;
+    acc.addStatus("OL", kDay + 1000);
+    acc.addStatus("OB DISCHRG", kDay + 2000);
+    acc.addStatus("OB DISCHRG", kDay + 3000);
+    acc.addStatus("OL CHRG", kDay + 4000);
+    acc.addTransferReason("input voltage out of range", kDay + 2000);
+    acc.addTransferReason("input voltage out of range", kDay + 5000);
+    acc.addMetric(Metric::InputVoltage, 118.0, kDay + 2000);
+
+    const DailyStats& day = acc.current();
+    EXPECT_EQ(day.date, "2026-03-13");
+    EXPECT_EQ(day.samples, 7u);
+    EXPECT_EQ(day.status_samples, 4u);
+    EXPECT_EQ(day.on_battery_samples, 2u);
+    EXPECT_EQ(day.statuses, (std::vector<std::string>{"OL", "OB DISCHRG", "OL CHRG"}));
+    EXPECT_EQ(day.transfer_reasons, (std::vector<std::string>{"input voltage out of range"}));
+    EXPECT_EQ(day.first_ts_ms, kDay + 1000);
+    EXPECT_EQ(day.last_ts_ms, kDay + 5000);
+    EXPECT_EQ(day.metric(Metric::InputVoltage).count, 1u);
+
+    for (int i = 0; i < 40; ++i) {
+        acc.addStatus("S" + std::to_string(i), kDay + 6000);
+    }
+    EXPECT_EQ(acc.current().statuses.size(), DailyStats::kMaxDistinct);
+}
+
+TEST(DailyStatsTest, RollsOverAtMidnight) {
+    DailyAccumulator acc;
+    acc.addMetric(Metric::LoadPercentage, 20.0, kDay + 23 * kHourMs);
+    acc.addMetric(Metric::LoadPercentage, 30.0, kDay + 24 * kHourMs + 1);
+
+    std::vector<DailyStats> closed;
+    acc.takeClosed(closed);
+    ASSERT_EQ(closed.size(), 1u);
+    EXPECT_EQ(closed[0].date, "2026-03-13");
+    EXPECT_EQ(closed[0].metric(Metric::LoadPercentage).mean, 20.0);
+    EXPECT_EQ(acc.previous().date, "2026-03-13");
+    EXPECT_EQ(acc.current().date, "2026-03-14");
+    EXPECT_EQ(acc.current().metric(Metric::LoadPercentage).mean, 30.0);
+
+    closed.clear();
+    acc.takeClosed(closed);
+    EXPECT_TRUE(closed.empty());
+}
+
+TEST(DailyStatsTest, ReplayedValuesFillTheirOwnDay) {
+    // Outage from 22:00 across midnight; the saver closed the day meanwhile
+    DailyAccumulator acc;
+    acc.addMetric(Metric::LoadPercentage, 20.0, kDay + 21 * kHourMs);
+    acc.advance(kDay + 24 * kHourMs + kHourMs);
+    std::vector<DailyStats> closed;
+    acc.takeClosed(closed);
+    ASSERT_EQ(closed.size(), 1u);
+
+    // Spool replay delivers the outage at its original times
+    acc.addMetric(Metric::LoadPercentage, 40.0, kDay + 23 * kHourMs);
+    acc.addStatus("OB DISCHRG", kDay + 23 * kHourMs);
+    acc.addMetric(Metric::LoadPercentage, 30.0, kDay + 24 * kHourMs + 1);
+
+    EXPECT_EQ(acc.previous().metric(Metric::LoadPercentage).count, 2u);
+    EXPECT_EQ(acc.previous().metric(Metric::LoadPercentage).max, 40.0);
+    EXPECT_EQ(acc.previous().on_battery_samples, 1u);
+    EXPECT_EQ(acc.previous().last_ts_ms, kDay + 23 * kHourMs);
+    EXPECT_EQ(acc.current().date, "2026-03-14");
+    EXPECT_EQ(acc.current().metric(Metric::LoadPercentage).count, 1u);
+
+    // The updated day is handed out again, complete
+    closed.clear();
+    acc.takeClosed(closed);
+    ASSERT_EQ(closed.size(), 1u);
+    EXPECT_EQ(closed[0].date, "2026-03-13");
+    EXPECT_EQ(closed[0].samples, 3u);
+
+    closed.clear();
+    acc.takeClosed(closed);
+    EXPECT_TRUE(closed.empty());
+}
+
+TEST(DailyStatsTest, OlderValueCountsInCurrentDay) {
+    // Older than the last closed day (clock step back) - nothing to attach it to
+    DailyAccumulator acc;
+    acc.addMetric(Metric::LoadPercentage, 20.0, kDay + 23 * kHourMs);
+    acc.addMetric(Metric::LoadPercentage, 30.0, kDay + 24 * kHourMs + 1);
+    acc.addMetric(Metric::LoadPercentage, 25.0, kDay - kHourMs);
+
+    EXPECT_EQ(acc.previous().samples, 1u);
+    EXPECT_EQ(acc.current().date, "2026-03-14");
+    EXPECT_EQ(acc.current().samples, 2u);
+}
+
+TEST(DailyStatsTest, AdvanceClosesIdleDay) {
+    DailyAccumulator acc;
+    acc.addMetric(Metric::BatteryCharge, 100.0, kDay + kHourMs);
+    acc.advance(kDay + 12 * kHourMs);
+
+    std::vector<DailyStats> closed;
+    acc.takeClosed(closed);
+    EXPECT_TRUE(closed.empty());
+
+    acc.advance(kDay + 24 * kHourMs);
+    acc.takeClosed(closed);
+    ASSERT_EQ(closed.size(), 1u);
+    EXPECT_EQ(acc.current().samples, 0u);
+    EXPECT_EQ(acc.previous().samples, 1u);
+
+    // An empty day is not closed again
+    acc.advance(kDay + 48 * kHourMs);
+    closed.clear();
+    acc.takeClosed(closed);
+    EXPECT_TRUE(closed.empty());
+}
+
+TEST(DailyStatsTest, JsonRoundTripAndSeed) {
+    DailyAccumulator before_restart;
+    before_restart.addMetric(Metric::InputVoltage, 118.0, kDay + kHourMs);
+    before_restart.addMetric(Metric::InputVoltage, 122.0, kDay + 2 * kHourMs);
+    before_restart.addStatus("OB", kDay + 2 * kHourMs);
+    before_restart.addTransferReason("blackout", kDay + 2 * kHourMs);
+
+    auto restored = DailyStats::fromJson(before_restart.current().toJson());
+    ASSERT_TRUE(restored);
+    EXPECT_EQ(restored->date, "2026-03-13");
+    EXPECT_EQ(restored->samples, 4u);
+    EXPECT_EQ(restored->on_battery_samples, 1u);
+    EXPECT_EQ(restored->transfer_reasons, std::vector<std::string>{"blackout"});
+    EXPECT_EQ(restored->metric(Metric::InputVoltage).count, 2u);
+    EXPECT_EQ(restored->metric(Metric::InputVoltage).max_ts_ms, kDay + 2 * kHourMs);
+    EXPECT_EQ(restored->metric(Metric::LoadWatts).count, 0u);
+
+    DailyAccumulator after_restart;
+    after_restart.seed(*restored);
+    after_restart.addMetric(Metric::InputVoltage, 120.0, kDay + 3 * kHourMs);
+
+    const RunningStats& voltage = after_restart.current().metric(Metric::InputVoltage);
+    EXPECT_EQ(voltage.count, 3u);
+    EXPECT_DOUBLE_EQ(voltage.mean, 120.0);
+    EXPECT_DOUBLE_EQ(voltage.variance(), 4.0);
+    EXPECT_EQ(after_restart.current().first_ts_ms, kDay + kHourMs);
+    EXPECT_EQ(after_restart.current().samples, 5u);
+
+    EXPECT_FALSE(DailyStats::fromJson(Json::Value("not an object")));
+}
+
+TEST(DailyStatsTest, LocalDayBoundaries) {
+    EXPECT_EQ(localDate(kDay), "2026-03-13");
+    EXPECT_EQ(localDate(kDay - 1), "2026-03-12");
+    EXPECT_EQ(localDayEnd(kDay), kDay + 24 * kHourMs);
+    EXPECT_EQ(localDayEnd(kDay - 1), kDay);
+
+    int64_t start_ms = 0;
+    int64_t end_ms = 0;
+    ASSERT_TRUE(localDayRange("2026-03-13", start_ms, end_ms));
+    EXPECT_EQ(start_ms, kDay);
+    EXPECT_EQ(end_ms, kDay + 24 * kHourMs);
+    EXPECT_FALSE(localDayRange("2026-13-01", start_ms, end_ms));
+    EXPECT_FALSE(localDayRange("2026-03-13x", start_ms, end_ms));
+    EXPECT_FALSE(localDayRange("../../etc", start_ms, end_ms));
+}
+
+int main(int argc, char **argv) {
+    setenv("TZ", "UTC", 1);  // Day boundaries are local time
+    tzset();
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,8 +1,10 @@
 #include <gtest/gtest.h>
 #include <curl/curl.h>
 #include <json/json.h>
+#include <chrono>
 #include <string>
 #include <sstream>
+#include <thread>
 
 // E2E tests for DailySummaryService (needs running HMS-NUT at localhost:8891)
 
@@ -81,16 +83,54 @@ TEST_F(DailySummaryE2ETest, ManualSummaryTrigger) {
     auto [code, body] = httpPost("http://localhost:8891/summary?date=2026-03-13");
     if (code == 0) GTEST_SKIP() << "HMS-NUT service not running";
 
+    // Accepted immediately, generated on the job worker
+    EXPECT_EQ(code, 202);
     auto json = parseJson(body);
     EXPECT_TRUE(json["success"].asBool());
     EXPECT_EQ(json["date"].asString(), "2026-03-13");
-    EXPECT_FALSE(json["summary"].asString().empty());
-
-    std::string summary = json["summary"].asString();
+    std::string job_id = json["job_id"].asString();
+    ASSERT_FALSE(job_id.empty());
+
+    Json::Value job;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(120);
+    do {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        auto [job_code, job_body] = httpGet("http://localhost:8891/summary/jobs/" + job_id);
+        ASSERT_EQ(job_code, 200);
+        job = parseJson(job_body);
+    } while (job["status"].asString() != "succeeded" && job["status"].asString() != "failed" &&
+             std::chrono::steady_clock::now() < deadline);
+
+    ASSERT_EQ(job["status"].asString(), "succeeded") << job["message"].asString();
+    std::string summary = job["summary"].asString();
     EXPECT_GT(summary.size(), 50u);
     EXPECT_LT(summary.size(), 5000u);
 }
 
+TEST_F(DailySummaryE2ETest, ConcurrentRequestsForSameDateShareJob) {
+    auto [code, body] = httpPost("http://localhost:8891/summary?date=2026-03-12");
+    if (code == 0) GTEST_SKIP() << "HMS-NUT service not running";
+    auto [code2, body2] = httpPost("http://localhost:8891/summary?date=2026-03-12");
+
+    auto first = parseJson(body);
+    auto second = parseJson(body2);
+    EXPECT_EQ(code2, 202);
+    if (second["deduplicated"].asBool()) {
+        EXPECT_EQ(first["job_id"].asString(), second["job_id"].asString());
+    } else {
+        // Only a new job if the first one had already finished (e.g. no data for the date)
+        auto [job_code, job_body] = httpGet("http://localhost:8891/summary/jobs/" + first["job_id"].asString());
+        std::string status = parseJson(job_body)["status"].asString();
+        EXPECT_TRUE(status == "succeeded" || status == "failed") << status;
+    }
+}
+
+TEST_F(DailySummaryE2ETest, UnknownJobReturns404) {
+    auto [code, body] = httpGet("http://localhost:8891/summary/jobs/no-such-job");
+    if (code == 0) GTEST_SKIP() << "HMS-NUT service not running";
+    EXPECT_EQ(code, 404);
+}
+
 TEST_F(DailySummaryE2ETest, ManualSummaryDefaultsToYesterday) {
     auto [code, body] = httpPost("http://localhost:8891/summary");
     if (code == 0) GTEST_SKIP() << "HMS-NUT service not running";
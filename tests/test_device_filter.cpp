@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "utils/DeviceFilter.h"
+#include <string>
+
+using namespace hms_nut;
+
+using Decision = DeviceFilter::Decision;
+
+TEST(DeviceFilterTest, GlobMatch) {
+    EXPECT_TRUE(DeviceFilter::globMatch("*", "anything"));
+    EXPECT_TRUE(DeviceFilter::globMatch("*ups*", "esp32_ups_rack"));
+    EXPECT_TRUE(DeviceFilter::globMatch("esp32_?", "esp32_1"));
+    EXPECT_TRUE(DeviceFilter::globMatch("a*b*c", "axxbyyc"));
+    EXPECT_TRUE(DeviceFilter::globMatch("apc_ups", "apc_ups"));
+    EXPECT_FALSE(DeviceFilter::globMatch("apc_ups", "apc_ups2"));
+    EXPECT_FALSE(DeviceFilter::globMatch("esp32_?", "esp32_10"));
+    EXPECT_FALSE(DeviceFilter::globMatch("*ups", "ups_rack"));
+    EXPECT_FALSE(DeviceFilter::globMatch("", "x"));
+}
+
+TEST(DeviceFilterTest, ParsePatterns) {
+    auto patterns = DeviceFilterConfig::parsePatterns(" *ups* , esp32_*,, ");
+    ASSERT_EQ(patterns.size(), 2u);
+    EXPECT_EQ(patterns[0], "*ups*");
+    EXPECT_EQ(patterns[1], "esp32_*");
+    EXPECT_TRUE(DeviceFilterConfig::parsePatterns("").empty());
+}
+
+TEST(DeviceFilterTest, EmptyConfigAdmitsAll) {
+    DeviceFilter filter(DeviceFilterConfig{});
+    EXPECT_EQ(filter.evaluate("kitchen_thermometer"), Decision::Admit);
+}
+
+TEST(DeviceFilterTest, DenyBeatsAllow) {
+    DeviceFilterConfig config;
+    config.allow = {"*ups*"};
+    config.deny = {"test_*"};
+    DeviceFilter filter(config);
+
+    EXPECT_EQ(filter.evaluate("rack_ups"), Decision::Admit);
+    EXPECT_EQ(filter.evaluate("test_ups"), Decision::Reject);
+    EXPECT_EQ(filter.evaluate("phone_battery"), Decision::Reject);
+}
+
+TEST(DeviceFilterTest, ConfiguredDevicesAlwaysAdmitted) {
+    DeviceFilterConfig config;
+    config.always_admit = {"test_bench"};
+    config.deny = {"test_*"};
+    config.require_discovery = true;
+    DeviceFilter filter(config);
+
+    EXPECT_EQ(filter.evaluate("test_bench"), Decision::Admit);
+}
+
+TEST(DeviceFilterTest, RejectionsAreCachedAndCounted) {
+    DeviceFilterConfig config;
+    config.allow = {"*ups*"};
+    DeviceFilter filter(config);
+
+    for (int i = 0; i < 100; i++) {
+        EXPECT_FALSE(filter.admit("living_room_temperature"));
+    }
+    EXPECT_TRUE(filter.admit("rack_ups"));
+    EXPECT_EQ(filter.getRejectedCount(), 100u);
+}
+
+TEST(DeviceFilterTest, DiscoveryConfigAdmitsPendingDevice) {
+    DeviceFilterConfig config;
+    config.require_discovery = true;
+    DeviceFilter filter(config);
+
+    EXPECT_EQ(filter.evaluate("esp32_ups"), Decision::Pending);
+    EXPECT_FALSE(filter.admit("esp32_ups"));
+
+    // Configs for non-UPS sensors don't count
+    EXPECT_FALSE(filter.onDiscoveryConfig("esp32_ups", "wifi_signal"));
+    EXPECT_EQ(filter.evaluate("esp32_ups"), Decision::Pending);
+
+    EXPECT_TRUE(filter.onDiscoveryConfig("esp32_ups", "ups_status"));
+    EXPECT_EQ(filter.evaluate("esp32_ups"), Decision::Admit);
+
+    // Second config for the same device is not a new admission
+    EXPECT_FALSE(filter.onDiscoveryConfig("esp32_ups", "battery_runtime"));
+}
+
+TEST(DeviceFilterTest, DiscoveryConfigDoesNotOverrideDeny) {
+    DeviceFilterConfig config;
+    config.deny = {"test_*"};
+    config.require_discovery = true;
+    DeviceFilter filter(config);
+
+    EXPECT_FALSE(filter.onDiscoveryConfig("test_ups", "ups_status"));
+    EXPECT_EQ(filter.evaluate("test_ups"), Decision::Reject);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
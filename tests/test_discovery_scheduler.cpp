@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include "mqtt/DiscoveryScheduler.h"
+#include "utils/TokenBucket.h"
+#include <chrono>
+#include <thread>
+
+using namespace hms_nut;
+using namespace std::chrono_literals;
+
+// ── TokenBucket ─────────────────────────────────────────────────────────────
+
+class TokenBucketTest : public ::testing::Test {
+protected:
+    TokenBucket::Clock::time_point t0_ = TokenBucket::Clock::now();
+};
+
+TEST_F(TokenBucketTest, BurstThenEmpty) {
+    TokenBucket bucket(10.0, 3, t0_);
+
+    EXPECT_TRUE(bucket.tryAcquire(t0_));
+    EXPECT_TRUE(bucket.tryAcquire(t0_));
+    EXPECT_TRUE(bucket.tryAcquire(t0_));
+    EXPECT_FALSE(bucket.tryAcquire(t0_));
+}
+
+TEST_F(TokenBucketTest, RefillsAtRate) {
+    TokenBucket bucket(10.0, 1, t0_);
+    EXPECT_TRUE(bucket.tryAcquire(t0_));
+    EXPECT_FALSE(bucket.tryAcquire(t0_ + 50ms));
+
+    // 10/s -> one token every 100 ms
+    EXPECT_TRUE(bucket.tryAcquire(t0_ + 101ms));
+    EXPECT_FALSE(bucket.tryAcquire(t0_ + 101ms));
+}
+
+TEST_F(TokenBucketTest, TimeUntilAvailable) {
+    TokenBucket bucket(4.0, 1, t0_);
+    EXPECT_EQ(bucket.timeUntilAvailable(t0_), TokenBucket::Clock::duration::zero());
+
+    ASSERT_TRUE(bucket.tryAcquire(t0_));
+    auto wait = bucket.timeUntilAvailable(t0_);
+    EXPECT_GE(wait, 249ms);
+    EXPECT_LE(wait, 251ms);
+}
+
+TEST_F(TokenBucketTest, CapacityCapsAccrual) {
+    TokenBucket bucket(100.0, 2, t0_);
+    ASSERT_TRUE(bucket.tryAcquire(t0_));
+    ASSERT_TRUE(bucket.tryAcquire(t0_));
+
+    // An hour idle still only allows a burst of 2
+    auto later = t0_ + 1h;
+    EXPECT_TRUE(bucket.tryAcquire(later));
+    EXPECT_TRUE(bucket.tryAcquire(later));
+    EXPECT_FALSE(bucket.tryAcquire(later));
+}
+
+// ── DiscoveryScheduler ──────────────────────────────────────────────────────
+
+class DiscoverySchedulerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        mqtt_client_ = std::make_shared<MqttClient>("test_discovery_scheduler");
+    }
+
+    std::shared_ptr<MqttClient> mqtt_client_;
+};
+
+TEST_F(DiscoverySchedulerTest, TracksRegisteredDevices) {
+    DiscoveryScheduler scheduler(mqtt_client_);
+    auto a = std::make_shared<DiscoveryPublisher>(mqtt_client_, "ups_a", "UPS A");
+    auto b = std::make_shared<DiscoveryPublisher>(mqtt_client_, "ups_b", "UPS B");
+
+    scheduler.registerPublisher(a, 1);
+    scheduler.registerPublisher(b, 0);
+    EXPECT_EQ(scheduler.getProgress().devices, 2u);
+
+    scheduler.unregisterPublisher(a);
+    EXPECT_EQ(scheduler.getProgress().devices, 1u);
+}
+
+TEST_F(DiscoverySchedulerTest, RequestDoesNotBlockCaller) {
+    DiscoveryScheduler scheduler(mqtt_client_);
+    scheduler.registerPublisher(std::make_shared<DiscoveryPublisher>(mqtt_client_, "ups_a", "UPS A"));
+    scheduler.start();
+
+    auto start = std::chrono::steady_clock::now();
+    scheduler.requestRepublish();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_LT(elapsed, 10ms);
+
+    scheduler.stop();
+}
+
+TEST_F(DiscoverySchedulerTest, AbortsWhenMqttDisconnected) {
+    DiscoveryScheduler scheduler(mqtt_client_);
+    scheduler.registerPublisher(std::make_shared<DiscoveryPublisher>(mqtt_client_, "ups_a", "UPS A"));
+    scheduler.start();
+
+    scheduler.requestRepublish();
+
+    // Worker picks up the request and gives up immediately (not connected)
+    for (int i = 0; i < 100 && scheduler.getProgress().runs_aborted == 0; ++i) {
+        std::this_thread::sleep_for(10ms);
+    }
+
+    auto progress = scheduler.getProgress();
+    EXPECT_EQ(progress.runs_started, 1u);
+    EXPECT_EQ(progress.runs_aborted, 1u);
+    EXPECT_EQ(progress.total, 26u);
+    EXPECT_EQ(progress.published, 0u);
+    EXPECT_FALSE(progress.in_progress);
+
+    scheduler.stop();
+}
+
+TEST_F(DiscoverySchedulerTest, MaxRateBelowMinRateWins) {
+    DiscoverySchedulerConfig config;
+    config.min_rate = 5.0;
+    config.max_rate = 2.0;
+    DiscoveryScheduler scheduler(mqtt_client_, config);
+    scheduler.registerPublisher(std::make_shared<DiscoveryPublisher>(mqtt_client_, "ups_a", "UPS A"));
+    scheduler.start();
+
+    scheduler.requestRepublish();
+    for (int i = 0; i < 100 && scheduler.getProgress().runs_aborted == 0; ++i) {
+        std::this_thread::sleep_for(10ms);
+    }
+
+    EXPECT_DOUBLE_EQ(scheduler.getProgress().rate, 2.0);
+
+    scheduler.stop();
+}
+
+TEST_F(DiscoverySchedulerTest, CoalescesPendingRequests) {
+    DiscoveryScheduler scheduler(mqtt_client_);
+
+    // Not started: first request stays pending, the rest merge into it
+    scheduler.requestRepublish();
+    scheduler.requestRepublish();
+    scheduler.requestRepublish();
+
+    EXPECT_EQ(scheduler.getProgress().requests_coalesced, 2u);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
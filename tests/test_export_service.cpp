@@ -0,0 +1,286 @@
+#include <gtest/gtest.h>
+#include "services/ExportService.h"
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace hms_nut;
+using namespace std::chrono_literals;
+
+namespace {
+    using Kind = ExportColumn::Kind;
+    using Values = std::vector<std::optional<std::string_view>>;
+
+    const std::vector<ExportColumn> kColumns = {
+        {"timestamp", Kind::Text},
+        {"input_voltage", Kind::Number},
+        {"ups_status", Kind::Text},
+        {"power_failure", Kind::Boolean},
+    };
+
+    std::string encode(ExportFormat format, const std::vector<Values>& rows, bool gzip = false) {
+        ExportEncoder encoder(format, kColumns, gzip);
+        for (const auto& row : rows) {
+            encoder.row(row);
+        }
+        std::string out;
+        encoder.takeChunk(out, true);
+        return out;
+    }
+
+    std::string gunzip(const std::string& data) {
+        z_stream stream{};
+        EXPECT_EQ(inflateInit2(&stream, 15 + 16), Z_OK);
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        std::string out;
+        char buffer[4096];
+        int rc = Z_OK;
+        while (rc == Z_OK) {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer);
+            stream.avail_out = sizeof(buffer);
+            rc = inflate(&stream, Z_NO_FLUSH);
+            out.append(buffer, sizeof(buffer) - stream.avail_out);
+        }
+        EXPECT_EQ(rc, Z_STREAM_END);
+        inflateEnd(&stream);
+        return out;
+    }
+
+    std::string drain(ExportPipe& pipe) {
+        std::string out;
+        char buffer[1000];
+        while (size_t n = pipe.read(buffer, sizeof(buffer))) {
+            out.append(buffer, n);
+        }
+        return out;
+    }
+
+    // Fake cursor: `rows` rows with increasing timestamps
+    ExportService::RowSource countingSource(int rows, std::atomic<int>* produced = nullptr) {
+        return [rows, produced](const ExportRequest&, size_t, const ExportRowCallback& on_row) {
+            for (int i = 0; i < rows; ++i) {
+                std::string ts = std::to_string(i);
+                if (produced) {
+                    ++*produced;
+                }
+                if (!on_row({ts, "230.5", "OL", "f"})) {
+                    break;
+                }
+            }
+            return true;
+        };
+    }
+}
+
+TEST(ExportServiceTest, ParseFormat) {
+    EXPECT_EQ(parseExportFormat("csv"), ExportFormat::Csv);
+    EXPECT_EQ(parseExportFormat("ndjson"), ExportFormat::Ndjson);
+    EXPECT_FALSE(parseExportFormat("xml"));
+}
+
+TEST(ExportServiceTest, CsvQuotesAndNulls) {
+    std::string out = encode(ExportFormat::Csv, {
+        {"2026-03-14T10:00:00Z", "230.50", "OL", "f"},
+        {"2026-03-14T11:00:00Z", std::nullopt, "OB, \"LB\"", "t"},
+    });
+    EXPECT_EQ(out,
+              "timestamp,input_voltage,ups_status,power_failure\n"
+              "2026-03-14T10:00:00Z,230.50,OL,false\n"
+              "2026-03-14T11:00:00Z,,\"OB, \"\"LB\"\"\",true\n");
+}
+
+TEST(ExportServiceTest, NdjsonTypesAndNulls) {
+    std::string out = encode(ExportFormat::Ndjson, {
+        {"2026-03-14T10:00:00Z", "230.50", "OL", "f"},
+        {"2026-03-14T11:00:00Z", std::nullopt, std::nullopt, "t"},
+    });
+    EXPECT_EQ(out,
+              "{\"timestamp\":\"2026-03-14T10:00:00Z\",\"input_voltage\":230.5,\"ups_status\":\"OL\","
+              "\"power_failure\":false}\n"
+              "{\"timestamp\":\"2026-03-14T11:00:00Z\",\"power_failure\":true}\n");
+}
+
+TEST(ExportServiceTest, GzipRoundTrip) {
+    std::vector<Values> rows(500, Values{"2026-03-14T10:00:00Z", "230.50", "OL", "f"});
+    std::string plain = encode(ExportFormat::Csv, rows);
+    std::string compressed = encode(ExportFormat::Csv, rows, true);
+    EXPECT_LT(compressed.size(), plain.size() / 10);
+    EXPECT_EQ(gunzip(compressed), plain);
+}
+
+TEST(ExportServiceTest, PipeBlocksWriterWhenFull) {
+    ExportPipe pipe(10);
+    ASSERT_TRUE(pipe.write("0123456789"));
+
+    std::atomic<bool> second_written{false};
+    std::thread writer([&] {
+        pipe.write("abc");
+        second_written = true;
+        pipe.close();
+    });
+    std::this_thread::sleep_for(50ms);
+    EXPECT_FALSE(second_written);
+
+    char buffer[4];
+    ASSERT_EQ(pipe.read(buffer, sizeof(buffer)), 4u);
+    EXPECT_EQ(std::string(buffer, 4), "0123");
+    EXPECT_EQ(drain(pipe), "456789abc");
+    writer.join();
+    EXPECT_TRUE(second_written);
+}
+
+TEST(ExportServiceTest, StreamsEverythingThroughSmallBuffer) {
+    ExportConfig config;
+    config.buffer_bytes = 256;
+    config.chunk_bytes = 64;
+    ExportService service(countingSource(5000), kColumns, config);
+
+    auto pipe = service.begin({"apc_bx", {}, {}, ExportFormat::Csv, false});
+    ASSERT_NE(pipe, nullptr);
+    std::string out = drain(*pipe);
+
+    size_t lines = std::count(out.begin(), out.end(), '\n');
+    EXPECT_EQ(lines, 5001u);  // Header + rows
+    EXPECT_NE(out.find("\n4999,230.5,OL,false\n"), std::string::npos);
+}
+
+TEST(ExportServiceTest, CancelStopsProducer) {
+    std::atomic<int> produced{0};
+    ExportConfig config;
+    config.buffer_bytes = 128;
+    config.chunk_bytes = 32;
+    ExportService service(countingSource(1000000, &produced), kColumns, config);
+
+    auto pipe = service.begin({"apc_bx", {}, {}, ExportFormat::Ndjson, false});
+    ASSERT_NE(pipe, nullptr);
+    char buffer[64];
+    pipe->read(buffer, sizeof(buffer));
+    pipe->cancel();
+
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (service.active() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(5ms);
+    }
+    EXPECT_EQ(service.active(), 0u);
+    EXPECT_LT(produced.load(), 1000);  // Stopped by backpressure, not by running out
+}
+
+TEST(ExportServiceTest, LimitsConcurrencyAndMarksFailures) {
+    ExportConfig config;
+    config.max_concurrent = 1;
+    std::atomic<bool> release{false};
+    ExportService service([&release](const ExportRequest&, size_t, const ExportRowCallback& on_row) {
+        while (!release) {
+            std::this_thread::sleep_for(1ms);
+        }
+        on_row({"2026-03-14T10:00:00Z", "230.5", "OL", "f"});
+        return false;  // Cursor broke mid-export
+    }, kColumns, config);
+
+    auto first = service.begin({"apc_bx", {}, {}, ExportFormat::Ndjson, false});
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(service.begin({"apc_bx", {}, {}, ExportFormat::Ndjson, false}), nullptr);
+    release = true;
+
+    std::string out = drain(*first);
+    EXPECT_NE(out.find("{\"error\":\"export incomplete\"}\n"), std::string::npos);
+
+    // Slot is free again once the worker finished
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (service.active() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(5ms);
+    }
+    auto next = service.begin({"apc_bx", {}, {}, ExportFormat::Csv, false});
+    ASSERT_NE(next, nullptr);
+    EXPECT_NE(drain(*next).find("# error: export incomplete\n"), std::string::npos);
+
+    service.stop();
+    EXPECT_EQ(service.begin({"apc_bx", {}, {}, ExportFormat::Csv, false}), nullptr);
+}
+
+TEST(ExportServiceTest, PushSinkWaitsForTransportBacklog) {
+    std::atomic<size_t> unsent{1000};
+    std::string sent;
+    std::atomic<bool> written{false};
+    PushExportSink sink(
+        [&](const std::string& chunk) {
+            sent += chunk;
+            return true;
+        },
+        nullptr, [&] { return unsent.load(); }, 100, 10s);
+
+    std::thread writer([&] {
+        written = sink.write("abc");
+    });
+    std::this_thread::sleep_for(50ms);
+    EXPECT_FALSE(written);
+    EXPECT_TRUE(sent.empty());
+
+    unsent = 0;
+    writer.join();
+    EXPECT_TRUE(written);
+    EXPECT_EQ(sent, "abc");
+}
+
+TEST(ExportServiceTest, PushSinkGivesUpOnStalledClientOrCancel) {
+    PushExportSink stalled([](const std::string&) { return true; }, nullptr,
+                           [] { return size_t{4096}; }, 100, 50ms);
+    EXPECT_FALSE(stalled.write("abc"));
+
+    PushExportSink cancelled([](const std::string&) { return true; }, nullptr,
+                             [] { return size_t{4096}; }, 100, 10s);
+    std::thread writer([&] {
+        EXPECT_FALSE(cancelled.write("abc"));
+    });
+    std::this_thread::sleep_for(20ms);
+    cancelled.cancel();
+    writer.join();
+}
+
+TEST(ExportServiceTest, OpenerRunsOnWorker) {
+    std::atomic<int> produced{0};
+    ExportService service(countingSource(100, &produced), kColumns);
+    auto waitIdle = [&service] {
+        auto deadline = std::chrono::steady_clock::now() + 2s;
+        while (service.active() > 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(5ms);
+        }
+    };
+
+    // Declined (e.g. unknown device): nothing is produced
+    std::thread::id caller = std::this_thread::get_id();
+    std::thread::id opener_thread;
+    ASSERT_TRUE(service.begin({"apc_bx", {}, {}, ExportFormat::Csv, false},
+                              [&](const ExportRequest&) -> std::shared_ptr<ExportSink> {
+                                  opener_thread = std::this_thread::get_id();
+                                  return nullptr;
+                              }));
+    waitIdle();
+    EXPECT_NE(opener_thread, caller);
+    EXPECT_EQ(produced.load(), 0);
+
+    std::string out;
+    std::atomic<bool> closed{false};
+    ASSERT_TRUE(service.begin({"apc_bx", {}, {}, ExportFormat::Csv, false},
+                              [&](const ExportRequest&) -> std::shared_ptr<ExportSink> {
+                                  return std::make_shared<PushExportSink>(
+                                      [&out](const std::string& chunk) {
+                                          out += chunk;
+                                          return true;
+                                      },
+                                      [&closed] { closed = true; }, nullptr, 1024, 10s);
+                              }));
+    waitIdle();
+    EXPECT_TRUE(closed);
+    EXPECT_EQ(std::count(out.begin(), out.end(), '\n'), 101);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "services/GrafanaDatasource.h"
+#include <vector>
+
+using namespace hms_nut;
+
+namespace {
+    Json::Value parse(const std::string& text) {
+        Json::Value value;
+        Json::CharReaderBuilder builder;
+        std::string errors;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        EXPECT_TRUE(reader->parse(text.data(), text.data() + text.size(), &value, &errors)) << errors;
+        return value;
+    }
+
+    struct SeriesCall {
+        std::string device;
+        Metric metric;
+        int64_t from_ms;
+        int64_t to_ms;
+        size_t max_points;
+    };
+
+    // 2026-03-14T10:00:00.000Z .. 2026-03-14T11:00:00.000Z
+    constexpr int64_t kFrom = 1773482400000LL;
+    constexpr int64_t kTo = 1773486000000LL;
+    const char* kRange = R"("range": {"from": "2026-03-14T10:00:00.000Z", "to": "2026-03-14T11:00:00.000Z"})";
+
+    class GrafanaDatasourceTest : public ::testing::Test {
+    protected:
+        GrafanaDatasource datasource{
+            [] { return std::vector<std::string>{"apc_bx", "cyberpower"}; },
+            [this](const std::string& device, Metric metric, int64_t from_ms, int64_t to_ms, size_t max_points) {
+                calls.push_back({device, metric, from_ms, to_ms, max_points});
+                return next_read;
+            },
+            [this](const std::string& device, int64_t from_ms, int64_t to_ms, std::vector<PowerEventRow>& out) {
+                event_device = device;
+                EXPECT_EQ(from_ms, kFrom);
+                EXPECT_EQ(to_ms, kTo);
+                out = events;
+                return events_ok;
+            }};
+
+        std::vector<SeriesCall> calls;
+        SeriesRead next_read;
+        std::vector<PowerEventRow> events;
+        bool events_ok = true;
+        std::string event_device;
+    };
+}
+
+TEST_F(GrafanaDatasourceTest, ParseTarget) {
+    auto target = GrafanaDatasource::parseTarget("apc.bx.input_voltage");
+    ASSERT_TRUE(target);
+    EXPECT_EQ(target->first, "apc.bx");
+    EXPECT_EQ(target->second, Metric::InputVoltage);
+
+    EXPECT_FALSE(GrafanaDatasource::parseTarget("apc_bx.ups_status"));
+    EXPECT_FALSE(GrafanaDatasource::parseTarget("input_voltage"));
+    EXPECT_FALSE(GrafanaDatasource::parseTarget(".input_voltage"));
+}
+
+TEST_F(GrafanaDatasourceTest, SearchFiltersTargets) {
+    Json::Value all = datasource.search(parse(R"({"target": ""})"));
+    EXPECT_EQ(all.size(), 2 * kMetricCount);
+    EXPECT_EQ(all[0].asString(), "apc_bx.battery_charge");
+
+    Json::Value some = datasource.search(parse(R"({"target": "cyberpower.load"})"));
+    ASSERT_EQ(some.size(), 2u);
+    EXPECT_EQ(some[0].asString(), "cyberpower.load_percentage");
+    EXPECT_EQ(some[1].asString(), "cyberpower.load_watts");
+}
+
+TEST_F(GrafanaDatasourceTest, QueryReturnsDatapoints) {
+    next_read.points = {{kFrom, 120.5}, {kFrom + 60000, 121.0}};
+
+    Json::Value response;
+    std::string error;
+    auto result = datasource.query(parse(std::string("{") + kRange + R"(, "maxDataPoints": 800,
+        "targets": [{"target": "apc_bx.input_voltage", "refId": "A"},
+                    {"target": "apc_bx.load_percentage", "refId": "B", "hide": true}]})"),
+        response, error);
+
+    ASSERT_EQ(result, GrafanaResult::Ok) << error;
+    ASSERT_EQ(calls.size(), 1u);
+    EXPECT_EQ(calls[0].device, "apc_bx");
+    EXPECT_EQ(calls[0].metric, Metric::InputVoltage);
+    EXPECT_EQ(calls[0].from_ms, kFrom);
+    EXPECT_EQ(calls[0].to_ms, kTo);
+    EXPECT_EQ(calls[0].max_points, 800u);
+
+    ASSERT_EQ(response.size(), 1u);
+    EXPECT_EQ(response[0]["target"].asString(), "apc_bx.input_voltage");
+    ASSERT_EQ(response[0]["datapoints"].size(), 2u);
+    EXPECT_DOUBLE_EQ(response[0]["datapoints"][0][0].asDouble(), 120.5);
+    EXPECT_EQ(response[0]["datapoints"][1][1].asInt64(), kFrom + 60000);
+}
+
+TEST_F(GrafanaDatasourceTest, QueryErrors) {
+    Json::Value response;
+    std::string error;
+
+    EXPECT_EQ(datasource.query(parse(R"({"targets": []})"), response, error), GrafanaResult::BadRequest);
+    EXPECT_EQ(datasource.query(parse(std::string("{") + kRange + R"(, "targets": [{"target": "apc_bx.nope"}]})"),
+                               response, error),
+              GrafanaResult::BadRequest);
+    EXPECT_NE(error.find("apc_bx.nope"), std::string::npos);
+
+    // Unknown device: empty series rather than a failed panel
+    next_read.status = SeriesRead::Status::UnknownDevice;
+    EXPECT_EQ(datasource.query(parse(std::string("{") + kRange + R"(, "targets": [{"target": "ghost.input_voltage"}]})"),
+                               response, error),
+              GrafanaResult::Ok);
+    EXPECT_EQ(response[0]["datapoints"].size(), 0u);
+
+    next_read.status = SeriesRead::Status::Unavailable;
+    EXPECT_EQ(datasource.query(parse(std::string("{") + kRange + R"(, "targets": [{"target": "apc_bx.input_voltage"}]})"),
+                               response, error),
+              GrafanaResult::Unavailable);
+}
+
+TEST_F(GrafanaDatasourceTest, QueryClampsMaxDataPoints) {
+    Json::Value response;
+    std::string error;
+    datasource.query(parse(std::string("{") + kRange + R"(, "maxDataPoints": 1000000,
+        "targets": [{"target": "apc_bx.input_voltage"}]})"), response, error);
+    datasource.query(parse(std::string("{") + kRange + R"(, "targets": [{"target": "apc_bx.input_voltage"}]})"),
+                     response, error);
+    ASSERT_EQ(calls.size(), 2u);
+    EXPECT_EQ(calls[0].max_points, GrafanaDatasource::kMaxPoints);
+    EXPECT_EQ(calls[1].max_points, GrafanaDatasource::kDefaultPoints);
+}
+
+TEST_F(GrafanaDatasourceTest, AnnotationsFromPowerEvents) {
+    PowerEventRow start;
+    start.device_identifier = "apc_bx";
+    start.event_type = "outage_start";
+    start.timestamp_ms = kFrom + 1000;
+    start.battery_level_start = 100.0;
+    start.battery_level_end = 87.0;
+    start.load_at_event = 24.0;
+    events = {start};
+
+    Json::Value response;
+    std::string error;
+    auto result = datasource.annotations(parse(std::string("{") + kRange +
+        R"(, "annotation": {"name": "Outages", "query": "apc_bx", "enable": true}})"), response, error);
+
+    ASSERT_EQ(result, GrafanaResult::Ok) << error;
+    EXPECT_EQ(event_device, "apc_bx");
+    ASSERT_EQ(response.size(), 1u);
+    EXPECT_EQ(response[0]["time"].asInt64(), kFrom + 1000);
+    EXPECT_EQ(response[0]["title"].asString(), "outage_start");
+    EXPECT_EQ(response[0]["text"].asString(), "Battery 100% -> 87%, load 24%");
+    EXPECT_EQ(response[0]["annotation"]["name"].asString(), "Outages");
+    EXPECT_EQ(response[0]["tags"][1].asString(), "outage_start");
+
+    events_ok = false;
+    EXPECT_EQ(datasource.annotations(parse(std::string("{") + kRange + "}"), response, error),
+              GrafanaResult::Failed);
+    EXPECT_EQ(event_device, "");
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
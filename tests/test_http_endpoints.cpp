@@ -206,6 +206,17 @@ TEST_F(HTTPEndpointTest, InvalidEndpointReturns404) {
     std::cout << "✅ Invalid endpoint returns 404" << std::endl;
 }
 
+// Test: History for an unknown device returns 404, bad fields 400
+TEST_F(HTTPEndpointTest, HistoryEndpointValidatesRequest) {
+    auto [code, response] = HttpClient::get(base_url + "/devices/no_such_ups/history");
+    EXPECT_TRUE(code == 404 || code == 503) << "Unknown device should return 404 (503 if raw tier disabled)";
+
+    auto [bad_code, bad_response] = HttpClient::get(base_url + "/devices/no_such_ups/history?since=abc");
+    EXPECT_TRUE(bad_code == 400 || bad_code == 503) << "Invalid since should return 400";
+
+    std::cout << "✅ History endpoint validates requests" << std::endl;
+}
+
 int main(int argc, char **argv) {
     curl_global_init(CURL_GLOBAL_DEFAULT);
     testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,248 @@
+#include <gtest/gtest.h>
+#include "services/LiveStreamHub.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace hms_nut;
+using namespace std::chrono_literals;
+
+namespace {
+    // Records frames written to one client
+    class Recorder {
+    public:
+        LiveStreamHub::Sink sink(bool accept = true) {
+            return [this, accept](const std::string& frame) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                frames_.push_back(frame);
+                cv_.notify_all();
+                return accept;
+            };
+        }
+        bool waitFor(size_t count, std::chrono::milliseconds timeout = 2s) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            return cv_.wait_for(lock, timeout, [&] { return frames_.size() >= count; });
+        }
+        std::vector<std::string> frames() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return frames_;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::vector<std::string> frames_;
+    };
+
+    bool contains(const std::string& text, const std::string& part) {
+        return text.find(part) != std::string::npos;
+    }
+}
+
+TEST(LiveStreamHubTest, SnapshotThenDeltas) {
+    LiveStreamHub hub;
+    hub.start();
+    hub.publish("apc_bx", "input_voltage", "230", 1000);
+
+    Recorder client;
+    ASSERT_NE(hub.addClient(client.sink()), 0u);
+    ASSERT_TRUE(client.waitFor(1));
+    EXPECT_EQ(client.frames()[0],
+              "event: snapshot\ndata: {\"devices\":{\"apc_bx\":{\"input_voltage\":\"230\"}}}\n\n");
+
+    hub.publish("apc_bx", "input_voltage", "231", 2000);
+    ASSERT_TRUE(client.waitFor(2));
+    EXPECT_EQ(client.frames()[1],
+              "event: state\ndata: {\"device\":\"apc_bx\",\"sensor\":\"input_voltage\","
+              "\"value\":\"231\",\"ts\":2000}\n\n");
+}
+
+TEST(LiveStreamHubTest, UnchangedValuesNotBroadcast) {
+    LiveStreamHub hub;
+    hub.start();
+    Recorder client;
+    hub.addClient(client.sink());
+
+    hub.publish("apc_bx", "ups_status", "OL", 1);
+    hub.publish("apc_bx", "ups_status", "OL", 2);
+    hub.publish("apc_bx", "ups_status", "OB", 3);
+    ASSERT_TRUE(client.waitFor(3));
+    std::this_thread::sleep_for(50ms);
+
+    auto frames = client.frames();
+    ASSERT_EQ(frames.size(), 3u);  // snapshot + OL + OB
+    EXPECT_TRUE(contains(frames[1], "\"OL\""));
+    EXPECT_TRUE(contains(frames[2], "\"OB\""));
+    EXPECT_EQ(hub.getStats().frames_published, 2u);
+}
+
+TEST(LiveStreamHubTest, DeviceFilterAndSharedFrame) {
+    LiveStreamHub hub;
+    hub.start();
+    Recorder all;
+    Recorder only_cp;
+    hub.addClient(all.sink());
+    hub.addClient(only_cp.sink(), "cp1500");
+
+    hub.publish("apc_bx", "battery_charge", "100", 1);
+    hub.publish("cp1500", "battery_charge", "97", 2);
+    ASSERT_TRUE(all.waitFor(3));
+    ASSERT_TRUE(only_cp.waitFor(2));
+    std::this_thread::sleep_for(50ms);
+
+    EXPECT_EQ(all.frames().size(), 3u);
+    auto cp_frames = only_cp.frames();
+    ASSERT_EQ(cp_frames.size(), 2u);
+    EXPECT_TRUE(contains(cp_frames[1], "\"cp1500\""));
+    EXPECT_EQ(cp_frames[1], all.frames()[2]);
+    EXPECT_EQ(hub.getStats().frames_published, 2u);  // Serialized once per delta
+}
+
+TEST(LiveStreamHubTest, SlowClientDropsOldestAndResyncs) {
+    LiveStreamConfig config;
+    config.max_queued_frames = 4;
+    LiveStreamHub hub(config);
+    hub.start();
+
+    // First write blocks until released, so later deltas pile up in the queue
+    std::mutex gate_mutex;
+    std::condition_variable gate_cv;
+    bool gate_open = false;
+    std::atomic<bool> blocked{false};
+    Recorder slow;
+    auto record = slow.sink();
+    hub.addClient([&](const std::string& frame) {
+        if (!blocked.exchange(true)) {
+            std::unique_lock<std::mutex> lock(gate_mutex);
+            gate_cv.wait(lock, [&] { return gate_open; });
+        }
+        return record(frame);
+    });
+    while (!blocked) {
+        std::this_thread::sleep_for(1ms);
+    }
+
+    for (int i = 0; i < 10; ++i) {
+        hub.publish("apc_bx", "load", std::to_string(i), i);
+    }
+    {
+        std::lock_guard<std::mutex> lock(gate_mutex);
+        gate_open = true;
+    }
+    gate_cv.notify_all();
+
+    ASSERT_TRUE(slow.waitFor(6));  // snapshot + resync + 4 newest
+    auto frames = slow.frames();
+    EXPECT_EQ(frames[1], "event: resync\ndata: {\"dropped\":6}\n\n");
+    EXPECT_TRUE(contains(frames[2], "\"value\":\"6\""));
+    EXPECT_TRUE(contains(frames[5], "\"value\":\"9\""));
+    EXPECT_EQ(hub.getStats().frames_dropped, 6u);
+}
+
+TEST(LiveStreamHubTest, UnsentBacklogHoldsClientUntilDrained) {
+    LiveStreamConfig config;
+    config.max_queued_frames = 4;
+    config.max_unsent_bytes = 100;
+    LiveStreamHub hub(config);
+    hub.start();
+
+    // Writes never block; the "socket" holds whatever the test has not drained
+    std::atomic<size_t> unsent{0};
+    Recorder slow;
+    auto record = slow.sink();
+    hub.addClient(
+        [&](const std::string& frame) {
+            unsent += frame.size();
+            return record(frame);
+        },
+        "",
+        [&] { return unsent.load(); });
+    ASSERT_TRUE(slow.waitFor(1));
+
+    unsent = 1000;
+    for (int i = 0; i < 10; ++i) {
+        hub.publish("apc_bx", "load", std::to_string(i), i);
+    }
+    std::this_thread::sleep_for(300ms);
+    EXPECT_EQ(slow.frames().size(), 1u);  // Nothing handed over while above the mark
+
+    unsent = 0;
+    ASSERT_TRUE(slow.waitFor(6));  // snapshot + resync + 4 newest
+    auto frames = slow.frames();
+    EXPECT_EQ(frames[1], "event: resync\ndata: {\"dropped\":6}\n\n");
+    EXPECT_TRUE(contains(frames[2], "\"value\":\"6\""));
+    EXPECT_TRUE(contains(frames[5], "\"value\":\"9\""));
+    EXPECT_EQ(hub.getStats().frames_dropped, 6u);
+    EXPECT_EQ(hub.getStats().clients, 1u);
+}
+
+TEST(LiveStreamHubTest, StalledClientDisconnected) {
+    LiveStreamConfig config;
+    config.max_unsent_bytes = 100;
+    config.stall_timeout = 200ms;
+    LiveStreamHub hub(config);
+    hub.start();
+
+    Recorder stuck;
+    Recorder healthy;
+    hub.addClient(stuck.sink(), "", [] { return size_t{4096}; });
+    hub.addClient(healthy.sink());
+    hub.publish("apc_bx", "load", "30", 1);
+    ASSERT_TRUE(healthy.waitFor(2));
+
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (hub.getStats().clients > 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(5ms);
+    }
+    auto stats = hub.getStats();
+    EXPECT_EQ(stats.clients, 1u);
+    EXPECT_EQ(stats.clients_stalled, 1u);
+    EXPECT_EQ(stats.clients_closed, 1u);
+    EXPECT_TRUE(stuck.frames().empty());  // Held from the snapshot on
+}
+
+TEST(LiveStreamHubTest, ClosedClientRemovedAndLimitEnforced) {
+    LiveStreamConfig config;
+    config.max_clients = 1;
+    LiveStreamHub hub(config);
+    hub.start();
+
+    Recorder gone;
+    ASSERT_NE(hub.addClient(gone.sink(false)), 0u);
+    Recorder refused;
+    ASSERT_TRUE(gone.waitFor(1));
+
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (hub.getStats().clients > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(5ms);
+    }
+    EXPECT_EQ(hub.getStats().clients, 0u);
+    EXPECT_EQ(hub.getStats().clients_closed, 1u);
+
+    Recorder first;
+    EXPECT_NE(hub.addClient(first.sink()), 0u);
+    EXPECT_EQ(hub.addClient(refused.sink()), 0u);
+
+    hub.stop();
+    EXPECT_EQ(hub.addClient(refused.sink()), 0u);
+}
+
+TEST(LiveStreamHubTest, EscapesJson) {
+    LiveStreamHub hub;
+    hub.start();
+    Recorder client;
+    hub.addClient(client.sink());
+
+    hub.publish("apc_bx", "ups_model", "Back-UPS \"BX\"\n", 1);
+    ASSERT_TRUE(client.waitFor(2));
+    EXPECT_TRUE(contains(client.frames()[1], "\"value\":\"Back-UPS \\\"BX\\\"\\n\""));
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
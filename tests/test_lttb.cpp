@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "utils/Lttb.h"
+#include <cmath>
+#include <vector>
+
+using namespace hms_nut;
+
+namespace {
+    std::vector<LttbDownsampler::Point> run(LttbDownsampler& lttb, int count,
+                                            double (*shape)(int) = [](int) { return 120.0; }) {
+        for (int i = 0; i < count; ++i) {
+            lttb.add(i * 1000, shape(i));
+        }
+        return lttb.finish();
+    }
+}
+
+TEST(LttbTest, ShortSeriesPassThrough) {
+    LttbDownsampler lttb(0, 10000, 10);
+    auto out = run(lttb, 10, [](int i) { return static_cast<double>(i); });
+    ASSERT_EQ(out.size(), 10u);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(out[i].timestamp_ms, i * 1000);
+        EXPECT_EQ(out[i].value, i);
+    }
+}
+
+TEST(LttbTest, NeverExceedsThresholdAndKeepsEnds) {
+    for (size_t threshold : {3u, 4u, 50u, 500u}) {
+        LttbDownsampler lttb(0, 100000 * 1000LL, threshold);
+        auto out = run(lttb, 100000, [](int i) { return std::sin(i / 500.0) * 10.0 + 120.0; });
+
+        EXPECT_LE(out.size(), threshold);
+        EXPECT_GE(out.size(), std::min<size_t>(threshold, 3));
+        EXPECT_EQ(out.front().timestamp_ms, 0);
+        EXPECT_EQ(out.back().timestamp_ms, 99999 * 1000LL);
+        EXPECT_EQ(lttb.inputCount(), 100000u);
+        for (size_t i = 1; i < out.size(); ++i) {
+            EXPECT_LT(out[i - 1].timestamp_ms, out[i].timestamp_ms);
+        }
+    }
+}
+
+TEST(LttbTest, KeepsSpikesInFlatSeries) {
+    LttbDownsampler lttb(0, 10000 * 1000LL, 20);
+    auto out = run(lttb, 10000, [](int i) {
+        if (i == 3333) return 90.0;   // Brownout dip
+        if (i == 7777) return 140.0;  // Surge
+        return 120.0;
+    });
+
+    bool dip = false;
+    bool surge = false;
+    for (const auto& point : out) {
+        dip |= point.value == 90.0 && point.timestamp_ms == 3333 * 1000LL;
+        surge |= point.value == 140.0 && point.timestamp_ms == 7777 * 1000LL;
+    }
+    EXPECT_TRUE(dip);
+    EXPECT_TRUE(surge);
+}
+
+TEST(LttbTest, GapsLeaveBucketsEmpty) {
+    // Data only at both ends of the range - empty middle buckets are skipped
+    LttbDownsampler lttb(0, 1000000, 12);
+    for (int i = 0; i < 50; ++i) {
+        lttb.add(i, 1.0);
+    }
+    for (int i = 0; i < 50; ++i) {
+        lttb.add(999000 + i, 2.0);
+    }
+    auto out = lttb.finish();
+    EXPECT_LE(out.size(), 4u);  // first, one per occupied bucket, last
+    EXPECT_EQ(out.front().timestamp_ms, 0);
+    EXPECT_EQ(out.back().timestamp_ms, 999049);
+}
+
+TEST(LttbTest, EmptyInput) {
+    LttbDownsampler lttb(0, 1000, 10);
+    EXPECT_TRUE(lttb.finish().empty());
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include "nut/MetricRollup.h"
+#include <vector>
+
+using namespace hms_nut;
+
+namespace {
+    // 2026-03-14 10:00:00 UTC
+    constexpr int64_t kHour = 1773482400000LL;
+    constexpr int64_t kMin = RollupAccumulator::kMinuteMs;
+}
+
+TEST(MetricRollupTest, MetricNamesMatchSensorIds) {
+    EXPECT_STREQ(metricName(Metric::InputVoltage), "input_voltage");
+    EXPECT_EQ(findMetric("load_watts"), Metric::LoadWatts);
+    EXPECT_FALSE(findMetric("ups_status").has_value());
+    for (size_t i = 0; i < kMetricCount; ++i) {
+        auto metric = static_cast<Metric>(i);
+        EXPECT_EQ(findMetric(metricName(metric)), metric);
+    }
+}
+
+TEST(MetricRollupTest, AggregateMerge) {
+    MetricAggregate a;
+    a.add(230.0);
+    a.add(232.0);
+    MetricAggregate b;
+    b.add(228.0);
+    a.merge(b);
+
+    EXPECT_EQ(a.count, 3u);
+    EXPECT_DOUBLE_EQ(a.avg(), 230.0);
+    EXPECT_DOUBLE_EQ(a.min, 228.0);
+    EXPECT_DOUBLE_EQ(a.max, 232.0);
+}
+
+TEST(MetricRollupTest, MinuteClosesOnNextMinute) {
+    RollupAccumulator acc;
+    acc.add(Metric::InputVoltage, 230.0, kHour + 5000);
+    acc.add(Metric::InputVoltage, 232.0, kHour + 35000);
+    acc.add(Metric::InputVoltage, 240.0, kHour + kMin + 1000);
+
+    std::vector<RollupBucket> minutes, hours;
+    acc.takeClosed(minutes, hours);
+    ASSERT_EQ(minutes.size(), 1u);
+    EXPECT_TRUE(hours.empty());
+    EXPECT_EQ(minutes[0].start_ms, kHour);
+
+    const auto& voltage = minutes[0].metrics[static_cast<size_t>(Metric::InputVoltage)];
+    EXPECT_EQ(voltage.count, 2u);
+    EXPECT_DOUBLE_EQ(voltage.avg(), 231.0);
+    EXPECT_EQ(minutes[0].metrics[static_cast<size_t>(Metric::LoadWatts)].count, 0u);
+}
+
+TEST(MetricRollupTest, AdvanceClosesIdleBuckets) {
+    RollupAccumulator acc;
+    acc.add(Metric::LoadWatts, 100.0, kHour + 10 * kMin);
+
+    std::vector<RollupBucket> minutes, hours;
+    acc.advance(kHour + 10 * kMin + 30000);  // Minute still open
+    acc.takeClosed(minutes, hours);
+    EXPECT_TRUE(minutes.empty());
+
+    acc.advance(kHour + 11 * kMin);
+    acc.takeClosed(minutes, hours);
+    ASSERT_EQ(minutes.size(), 1u);
+    EXPECT_TRUE(hours.empty());  // Hour still open
+
+    acc.advance(kHour + 60 * kMin);
+    acc.takeClosed(minutes, hours);
+    ASSERT_EQ(hours.size(), 1u);
+    EXPECT_EQ(hours[0].start_ms, kHour);
+    EXPECT_EQ(hours[0].metrics[static_cast<size_t>(Metric::LoadWatts)].count, 1u);
+}
+
+TEST(MetricRollupTest, HourMergesMinutes) {
+    RollupAccumulator acc;
+    for (int m = 0; m < 60; ++m) {
+        acc.add(Metric::BatteryCharge, 100.0 - m, kHour + m * kMin);
+        acc.add(Metric::BatteryCharge, 100.0 - m, kHour + m * kMin + 30000);
+    }
+    acc.add(Metric::BatteryCharge, 50.0, kHour + 60 * kMin + 1000);
+
+    std::vector<RollupBucket> minutes, hours;
+    acc.takeClosed(minutes, hours);
+    EXPECT_EQ(minutes.size(), 60u);
+    ASSERT_EQ(hours.size(), 1u);
+
+    const auto& charge = hours[0].metrics[static_cast<size_t>(Metric::BatteryCharge)];
+    EXPECT_EQ(charge.count, 120u);
+    EXPECT_DOUBLE_EQ(charge.min, 41.0);
+    EXPECT_DOUBLE_EQ(charge.max, 100.0);
+}
+
+TEST(MetricRollupTest, GapSkipsEmptyBuckets) {
+    RollupAccumulator acc;
+    acc.add(Metric::Temperature, 25.0, kHour);
+    acc.add(Metric::Temperature, 26.0, kHour + 3 * 60 * kMin);  // 3 h later
+
+    std::vector<RollupBucket> minutes, hours;
+    acc.takeClosed(minutes, hours);
+    EXPECT_EQ(minutes.size(), 1u);
+    ASSERT_EQ(hours.size(), 1u);
+    EXPECT_EQ(hours[0].start_ms, kHour);
+}
+
+TEST(MetricRollupTest, ParseMetricList) {
+    auto all = parseMetricList("");
+    ASSERT_TRUE(all);
+    EXPECT_EQ(all->size(), kMetricCount);
+
+    auto some = parseMetricList("load_percentage,input_voltage,load_percentage");
+    ASSERT_TRUE(some);
+    ASSERT_EQ(some->size(), 2u);
+    EXPECT_EQ((*some)[0], Metric::LoadPercentage);
+    EXPECT_EQ((*some)[1], Metric::InputVoltage);
+
+    EXPECT_FALSE(parseMetricList("input_voltage,ups_status"));
+    EXPECT_FALSE(parseMetricList("input_voltage,"));
+}
+
+TEST(MetricRollupTest, ChooseSeriesTier) {
+    const int64_t now = kHour;
+    const int64_t hour = RollupAccumulator::kHourMs;
+    const int64_t day = 24 * hour;
+
+    CollectorTierConfig config;  // 1h raw window, rollups off
+    EXPECT_EQ(chooseSeriesTier(config, now - 30 * kMin, now, now), SeriesTier::Raw);
+    EXPECT_EQ(chooseSeriesTier(config, now - 2 * hour, now, now), SeriesTier::Stored);
+
+    config.persist_rollups = true;
+    config.minute_retention_days = 14;
+    config.hour_retention_days = 365;
+    EXPECT_EQ(chooseSeriesTier(config, now - 2 * hour, now, now), SeriesTier::Minute);
+    // Within minute retention, but too many minutes for one read
+    EXPECT_EQ(chooseSeriesTier(config, now - 13 * day, now, now, 1440), SeriesTier::Hour);
+    EXPECT_EQ(chooseSeriesTier(config, now - 30 * day, now, now), SeriesTier::Hour);
+    EXPECT_EQ(chooseSeriesTier(config, now - 400 * day, now, now), SeriesTier::Stored);
+
+    config.raw_window_seconds = 0;
+    EXPECT_EQ(chooseSeriesTier(config, now - 30 * kMin, now, now), SeriesTier::Minute);
+    EXPECT_STREQ(seriesTierName(SeriesTier::Hour), "1h");
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
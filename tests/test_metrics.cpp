@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "utils/Metrics.h"
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace hms_nut;
+using namespace std::chrono_literals;
+
+TEST(MetricsTest, CounterAndGauge) {
+    Counter counter;
+    counter.inc();
+    counter.inc(4);
+    EXPECT_EQ(counter.value(), 5u);
+
+    Gauge gauge;
+    gauge.set(10);
+    gauge.add(-3);
+    EXPECT_EQ(gauge.value(), 7);
+}
+
+TEST(MetricsTest, HistogramBuckets) {
+    Histogram histogram({0.001, 0.01, 0.1});
+    histogram.observe(500us);   // <= 1 ms
+    histogram.observe(1ms);     // Upper bound is inclusive
+    histogram.observe(50ms);    // <= 100 ms
+    histogram.observe(2s);      // +Inf
+
+    auto snap = histogram.snapshot();
+    ASSERT_EQ(snap.cumulative.size(), 4u);
+    EXPECT_EQ(snap.cumulative[0], 2u);
+    EXPECT_EQ(snap.cumulative[1], 2u);
+    EXPECT_EQ(snap.cumulative[2], 3u);
+    EXPECT_EQ(snap.cumulative[3], 4u);
+    EXPECT_EQ(snap.count, 4u);
+    EXPECT_NEAR(snap.sum_seconds, 2.0515, 1e-9);
+}
+
+TEST(MetricsTest, ConcurrentCounting) {
+    Counter counter;
+    Histogram histogram(Histogram::latencyBounds());
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10000; ++i) {
+                counter.inc();
+                histogram.observe(std::chrono::microseconds(i % 300));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(counter.value(), 40000u);
+    EXPECT_EQ(histogram.snapshot().count, 40000u);
+}
+
+TEST(MetricsTest, RegistryReturnsSameSeries) {
+    auto& registry = MetricsRegistry::instance();
+    Counter& a = registry.counter("test_same_total", "Same series");
+    Counter& b = registry.counter("test_same_total", "Same series");
+    Counter& labelled = registry.counter("test_same_total", "Same series", "kind=\"x\"");
+    EXPECT_EQ(&a, &b);
+    EXPECT_NE(&a, &labelled);
+
+    EXPECT_THROW(registry.gauge("test_same_total", "Wrong type"), std::logic_error);
+}
+
+TEST(MetricsTest, RenderTextFormat) {
+    auto& registry = MetricsRegistry::instance();
+    registry.counter("test_render_total", "Rendered counter", "tier=\"1m\"").inc(3);
+    registry.gaugeCallback("test_render_depth", "Rendered callback", [] { return 42.0; });
+    registry.histogram("test_render_seconds", "Rendered histogram", {0.5}, "op=\"x\"").observe(100ms);
+
+    std::string text = registry.render();
+
+    EXPECT_NE(text.find("# HELP test_render_total Rendered counter\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_render_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("test_render_total{tier=\"1m\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_render_depth gauge\n"), std::string::npos);
+    EXPECT_NE(text.find("test_render_depth 42\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_render_seconds histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("test_render_seconds_bucket{op=\"x\",le=\"0.5\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_render_seconds_bucket{op=\"x\",le=\"+Inf\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_render_seconds_sum{op=\"x\"} 0.1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_render_seconds_count{op=\"x\"} 1\n"), std::string::npos);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "utils/NumberParser.h"
+#include <string>
+
+using namespace hms_nut;
+
+class NumberParserTest : public ::testing::Test {};
+
+TEST_F(NumberParserTest, ParseDoubleValid) {
+    auto result = NumberParser::parseDouble("13.7");
+    ASSERT_TRUE(result.ok());
+    EXPECT_DOUBLE_EQ(result.value, 13.7);
+
+    EXPECT_DOUBLE_EQ(NumberParser::parseDouble("-4.25").value, -4.25);
+    EXPECT_DOUBLE_EQ(NumberParser::parseDouble("1e2").value, 100.0);
+}
+
+TEST_F(NumberParserTest, ParseDoubleAcceptsStodShapes) {
+    // Leading whitespace, '+' sign and trailing units were accepted by std::stod
+    EXPECT_DOUBLE_EQ(NumberParser::parseDouble("  121.0").value, 121.0);
+    EXPECT_DOUBLE_EQ(NumberParser::parseDouble("+230").value, 230.0);
+    EXPECT_DOUBLE_EQ(NumberParser::parseDouble("13.7 V").value, 13.7);
+}
+
+TEST_F(NumberParserTest, ParseDoubleEmpty) {
+    EXPECT_EQ(NumberParser::parseDouble("").error, ParseError::Empty);
+    EXPECT_EQ(NumberParser::parseDouble("   ").error, ParseError::Empty);
+}
+
+TEST_F(NumberParserTest, ParseDoubleInvalid) {
+    EXPECT_EQ(NumberParser::parseDouble("unavailable").error, ParseError::Invalid);
+    EXPECT_EQ(NumberParser::parseDouble("unknown").error, ParseError::Invalid);
+    EXPECT_EQ(NumberParser::parseDouble("nan").error, ParseError::Invalid);
+    EXPECT_EQ(NumberParser::parseDouble("+").error, ParseError::Invalid);
+    EXPECT_FALSE(NumberParser::parseDouble("OL").toOptional().has_value());
+}
+
+TEST_F(NumberParserTest, ParseDoubleOutOfRange) {
+    EXPECT_EQ(NumberParser::parseDouble("1e999").error, ParseError::OutOfRange);
+}
+
+TEST_F(NumberParserTest, ParseIntValid) {
+    auto result = NumberParser::parseInt("2400");
+    ASSERT_TRUE(result.ok());
+    EXPECT_EQ(result.value, 2400);
+    EXPECT_EQ(NumberParser::parseInt("-5").value, -5);
+}
+
+TEST_F(NumberParserTest, ParseIntTruncatesFraction) {
+    // ESP32 firmware publishes integers as "2400.0"
+    EXPECT_EQ(NumberParser::parseInt("2400.0").value, 2400);
+}
+
+TEST_F(NumberParserTest, ParseIntErrors) {
+    EXPECT_EQ(NumberParser::parseInt("").error, ParseError::Empty);
+    EXPECT_EQ(NumberParser::parseInt("unavailable").error, ParseError::Invalid);
+    EXPECT_EQ(NumberParser::parseInt("99999999999").error, ParseError::OutOfRange);
+}
+
+TEST_F(NumberParserTest, ErrorNames) {
+    EXPECT_STREQ(NumberParser::errorName(ParseError::None), "none");
+    EXPECT_STREQ(NumberParser::errorName(ParseError::Invalid), "invalid");
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
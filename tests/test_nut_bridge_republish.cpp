@@ -151,6 +151,43 @@ TEST_F(NutBridgeRepublishTest, RepublishIndependentOfRunningState) {
     EXPECT_FALSE(result);
 }
 
+// Test: Discovery payloads are rendered once per device, one per sensor
+TEST_F(NutBridgeRepublishTest, DiscoveryMessagesPreRendered) {
+    DiscoveryPublisher publisher(mqtt_client_, "test_device", "Test UPS Device");
+
+    const auto& messages = publisher.getMessages();
+    ASSERT_EQ(messages.size(), 26u);
+    EXPECT_EQ(messages[0].topic, "homeassistant/sensor/test_device/battery_charge/config");
+    EXPECT_NE(messages[0].payload.find("\"unique_id\":\"test_device_battery_charge\""), std::string::npos);
+
+    bool found_binary = false;
+    for (const auto& msg : messages) {
+        if (msg.topic == "homeassistant/binary_sensor/test_device/power_failure/config") {
+            found_binary = true;
+            EXPECT_NE(msg.payload.find("\"payload_on\":\"1\""), std::string::npos);
+        }
+        // Compact JSON (no indentation)
+        EXPECT_EQ(msg.payload.find('\n'), std::string::npos);
+    }
+    EXPECT_TRUE(found_binary);
+
+    // Same device renders identical content (stable hashes for deduplication)
+    DiscoveryPublisher again(mqtt_client_, "test_device", "Test UPS Device");
+    EXPECT_EQ(again.getMessages()[5].hash, messages[5].hash);
+
+    DiscoveryPublisher other(mqtt_client_, "other_device", "Other UPS");
+    EXPECT_NE(other.getMessages()[5].hash, messages[5].hash);
+}
+
+// Test: Nothing is considered retained on the broker before tracking has seen it
+TEST_F(NutBridgeRepublishTest, DiscoveryNotHeldByBrokerWithoutTracking) {
+    DiscoveryPublisher publisher(mqtt_client_, "test_device", "Test UPS Device");
+
+    for (const auto& msg : publisher.getMessages()) {
+        EXPECT_FALSE(publisher.isHeldByBroker(msg));
+    }
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include "mqtt/OfflineSpool.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace hms_nut;
+namespace fs = std::filesystem;
+
+class OfflineSpoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = fs::temp_directory_path() /
+               ("hms_nut_spool_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed()) +
+                "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        fs::remove_all(dir_);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir_);
+    }
+
+    OfflineSpoolConfig config(size_t segment_bytes = 1024 * 1024, size_t max_bytes = 64 * 1024 * 1024) {
+        OfflineSpoolConfig c;
+        c.directory = dir_.string();
+        c.segment_bytes = segment_bytes;
+        c.max_bytes = max_bytes;
+        return c;
+    }
+
+    static QueuedMessage state(const std::string& topic, const std::string& payload) {
+        return QueuedMessage{topic, payload, 1, false};
+    }
+
+    static QueuedMessage retained(const std::string& topic, const std::string& payload) {
+        return QueuedMessage{topic, payload, 1, true};
+    }
+
+    std::vector<SpoolRecord> drain(OfflineSpool& spool) {
+        std::vector<SpoolRecord> records;
+        while (auto record = spool.next()) {
+            records.push_back(*record);
+        }
+        return records;
+    }
+
+    size_t segmentFiles() {
+        size_t count = 0;
+        if (fs::exists(dir_)) {
+            for (const auto& entry : fs::directory_iterator(dir_)) {
+                count += entry.path().extension() == ".seg";
+            }
+        }
+        return count;
+    }
+
+    fs::path dir_;
+};
+
+TEST_F(OfflineSpoolTest, ReplaysTelemetryInOrder) {
+    OfflineSpool spool(config());
+    ASSERT_TRUE(spool.open());
+
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(spool.append(state("ups/battery_charge/state", std::to_string(90 + i)), 1000 + i));
+    }
+    EXPECT_EQ(spool.getStats().pending, 5u);
+
+    auto records = drain(spool);
+    ASSERT_EQ(records.size(), 5u);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(records[i].message.payload, std::to_string(90 + i));
+        EXPECT_EQ(records[i].timestamp_ms, 1000 + i);
+        EXPECT_EQ(records[i].message.qos, 1);
+        EXPECT_FALSE(records[i].message.retain);
+    }
+    EXPECT_TRUE(spool.empty());
+    EXPECT_EQ(segmentFiles(), 0u);  // Fully replayed segments are deleted
+}
+
+TEST_F(OfflineSpoolTest, CompactsRetainedToLatest) {
+    OfflineSpool spool(config());
+    ASSERT_TRUE(spool.open());
+
+    spool.append(retained("ha/config", "v1"), 1);
+    spool.append(state("ups/load/state", "10"), 2);
+    spool.append(retained("ha/config", "v2"), 3);
+    spool.append(state("ups/load/state", "11"), 4);
+
+    auto records = drain(spool);
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].message.payload, "10");
+    EXPECT_EQ(records[1].message.payload, "v2");
+    EXPECT_TRUE(records[1].message.retain);
+    EXPECT_EQ(records[2].message.payload, "11");
+    EXPECT_EQ(spool.getStats().compacted, 1u);
+}
+
+TEST_F(OfflineSpoolTest, RetainedStateKeepsHistory) {
+    OfflineSpool spool(config());
+    ASSERT_TRUE(spool.open());
+
+    // OL -> OB -> OL during an outage must all reach the collector
+    spool.append(retained("ups/ups_status/state", "OL"), 1);
+    spool.append(retained("ups/ups_status/state", "OB"), 2);
+    spool.append(retained("ups/ups_status/state", "OL"), 3);
+
+    auto records = drain(spool);
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[1].message.payload, "OB");
+    EXPECT_EQ(spool.getStats().compacted, 0u);
+}
+
+TEST_F(OfflineSpoolTest, InterleavedAppendAndReplay) {
+    OfflineSpool spool(config());
+    ASSERT_TRUE(spool.open());
+
+    spool.append(state("a", "1"), 1);
+    EXPECT_EQ(spool.next()->message.payload, "1");
+    EXPECT_FALSE(spool.next().has_value());
+
+    // Appending after a full drain starts a new segment
+    spool.append(state("a", "2"), 2);
+    spool.append(state("a", "3"), 3);
+    EXPECT_EQ(spool.next()->message.payload, "2");
+    spool.append(state("a", "4"), 4);
+    EXPECT_EQ(spool.next()->message.payload, "3");
+    EXPECT_EQ(spool.next()->message.payload, "4");
+    EXPECT_TRUE(spool.empty());
+}
+
+TEST_F(OfflineSpoolTest, RollsSegments) {
+    OfflineSpool spool(config(4096));
+    ASSERT_TRUE(spool.open());
+
+    std::string payload(500, 'x');
+    for (int i = 0; i < 40; ++i) {
+        spool.append(state("t/" + std::to_string(i), payload), i);
+    }
+    EXPECT_GT(spool.getStats().segments, 1u);
+    EXPECT_EQ(segmentFiles(), spool.getStats().segments);
+    EXPECT_EQ(drain(spool).size(), 40u);
+    EXPECT_EQ(segmentFiles(), 0u);
+}
+
+TEST_F(OfflineSpoolTest, SizeCapDropsOldestSegments) {
+    OfflineSpool spool(config(4096, 16384));
+    ASSERT_TRUE(spool.open());
+
+    std::string payload(500, 'x');
+    for (int i = 0; i < 200; ++i) {
+        spool.append(state("t", std::to_string(i) + payload), i);
+        ASSERT_LE(spool.getStats().bytes, 16384u + 4096u);
+    }
+
+    auto stats = spool.getStats();
+    EXPECT_GT(stats.dropped, 0u);
+    EXPECT_EQ(stats.pending + stats.dropped, 200u);
+
+    // Newest data survives
+    auto records = drain(spool);
+    ASSERT_FALSE(records.empty());
+    EXPECT_EQ(records.back().message.payload.substr(0, 3), "199");
+}
+
+TEST_F(OfflineSpoolTest, SurvivesRestart) {
+    {
+        OfflineSpool spool(config());
+        ASSERT_TRUE(spool.open());
+        spool.append(state("a", "1"), 1);
+        spool.append(retained("ha/cfg/config", "old"), 2);
+        spool.append(retained("ha/cfg/config", "new"), 3);
+        spool.append(state("a", "2"), 4);
+        EXPECT_EQ(spool.next()->message.payload, "1");
+    }
+
+    // Replay restarts from the beginning of the unfinished segment
+    OfflineSpool reopened(config());
+    ASSERT_TRUE(reopened.open());
+    auto records = drain(reopened);
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0].message.payload, "1");
+    EXPECT_EQ(records[1].message.payload, "new");
+    EXPECT_EQ(records[2].message.payload, "2");
+
+    // New appends continue after the recovered sequence numbers
+    reopened.append(retained("ha/cfg/config", "newer"), 5);
+    EXPECT_EQ(reopened.next()->message.payload, "newer");
+}
+
+TEST_F(OfflineSpoolTest, TruncatesTornTail) {
+    {
+        OfflineSpool spool(config());
+        ASSERT_TRUE(spool.open());
+        spool.append(state("a", "1"), 1);
+        spool.append(state("a", "2"), 2);
+    }
+
+    // Simulate a crash mid-write: half a record at the end
+    fs::path segment;
+    for (const auto& entry : fs::directory_iterator(dir_)) {
+        segment = entry.path();
+    }
+    {
+        std::ofstream out(segment, std::ios::binary | std::ios::app);
+        out.write("\x40\x00\x00\x00\x12\x34", 6);
+    }
+
+    OfflineSpool reopened(config());
+    ASSERT_TRUE(reopened.open());
+    EXPECT_EQ(reopened.getStats().pending, 2u);
+    EXPECT_EQ(reopened.getStats().errors, 1u);
+
+    auto records = drain(reopened);
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[1].message.payload, "2");
+}
+
+TEST_F(OfflineSpoolTest, RejectsUnwritableDirectory) {
+    OfflineSpoolConfig c;
+    c.directory = "/proc/hms_nut_spool_test";
+    OfflineSpool spool(c);
+    EXPECT_FALSE(spool.open());
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "mqtt/PublishQueue.h"
+#include <string>
+
+using namespace hms_nut;
+
+class PublishQueueTest : public ::testing::Test {
+protected:
+    static QueuedMessage state(const std::string& topic, const std::string& payload) {
+        return QueuedMessage{topic, payload, 1, false};
+    }
+
+    static QueuedMessage retained(const std::string& topic, const std::string& payload) {
+        return QueuedMessage{topic, payload, 1, true};
+    }
+};
+
+TEST_F(PublishQueueTest, FifoWithinLane) {
+    PublishQueue queue;
+    queue.push(state("a", "1"));
+    queue.push(state("b", "2"));
+    queue.push(state("c", "3"));
+
+    EXPECT_EQ(queue.pop()->topic, "a");
+    EXPECT_EQ(queue.pop()->topic, "b");
+    EXPECT_EQ(queue.pop()->topic, "c");
+    EXPECT_FALSE(queue.pop().has_value());
+}
+
+TEST_F(PublishQueueTest, RetainedDrainFirst) {
+    PublishQueue queue;
+    queue.push(state("state/1", "1"));
+    queue.push(retained("config/1", "{}"));
+    queue.push(state("state/2", "2"));
+
+    EXPECT_EQ(queue.pop()->topic, "config/1");
+    EXPECT_EQ(queue.pop()->topic, "state/1");
+    EXPECT_EQ(queue.pop()->topic, "state/2");
+}
+
+TEST_F(PublishQueueTest, CoalescesPerTopicKeepingPosition) {
+    PublishQueue queue;
+    EXPECT_EQ(queue.push(state("a", "1")), PublishQueue::PushResult::Queued);
+    queue.push(state("b", "1"));
+    EXPECT_EQ(queue.push(state("a", "22")), PublishQueue::PushResult::Coalesced);
+
+    EXPECT_EQ(queue.size(), 2u);
+    EXPECT_EQ(queue.bytes(), 2u + 1u + 1u + 1u);  // "a"+"22" + "b"+"1"
+
+    auto first = queue.pop();
+    EXPECT_EQ(first->topic, "a");
+    EXPECT_EQ(first->payload, "22");
+
+    auto stats = queue.getStats();
+    EXPECT_EQ(stats.enqueued, 2u);
+    EXPECT_EQ(stats.coalesced, 1u);
+}
+
+TEST_F(PublishQueueTest, RetainFlagChangeMovesLane) {
+    PublishQueue queue;
+    queue.push(state("x", "1"));
+    queue.push(state("topic", "old"));
+    queue.push(retained("topic", "new"));
+
+    EXPECT_EQ(queue.size(), 2u);
+    auto first = queue.pop();
+    EXPECT_EQ(first->topic, "topic");
+    EXPECT_EQ(first->payload, "new");
+    EXPECT_TRUE(first->retain);
+}
+
+TEST_F(PublishQueueTest, DropOldestEvictsStateFirst) {
+    PublishQueueConfig config;
+    config.max_messages = 3;
+    PublishQueue queue(config);
+
+    queue.push(retained("config/1", "{}"));
+    queue.push(state("s1", "1"));
+    queue.push(state("s2", "2"));
+    EXPECT_EQ(queue.push(state("s3", "3")), PublishQueue::PushResult::Queued);
+
+    EXPECT_EQ(queue.size(), 3u);
+    EXPECT_EQ(queue.getStats().dropped, 1u);
+    EXPECT_EQ(queue.pop()->topic, "config/1");
+    EXPECT_EQ(queue.pop()->topic, "s2");
+    EXPECT_EQ(queue.pop()->topic, "s3");
+}
+
+TEST_F(PublishQueueTest, StateNeverEvictsRetained) {
+    PublishQueueConfig config;
+    config.max_messages = 2;
+    PublishQueue queue(config);
+
+    queue.push(retained("config/1", "{}"));
+    queue.push(retained("config/2", "{}"));
+    EXPECT_EQ(queue.push(state("s1", "1")), PublishQueue::PushResult::Dropped);
+    EXPECT_EQ(queue.getStats().priority_depth, 2u);
+}
+
+TEST_F(PublishQueueTest, DropNewestRejectsIncoming) {
+    PublishQueueConfig config;
+    config.max_messages = 2;
+    config.overflow = OverflowPolicy::DropNewest;
+    PublishQueue queue(config);
+
+    queue.push(state("s1", "1"));
+    queue.push(state("s2", "2"));
+    EXPECT_EQ(queue.push(state("s3", "3")), PublishQueue::PushResult::Dropped);
+    EXPECT_EQ(queue.pop()->topic, "s1");
+
+    // Coalescing still works when full
+    queue.push(state("s3", "3"));
+    EXPECT_EQ(queue.push(state("s3", "4")), PublishQueue::PushResult::Coalesced);
+}
+
+TEST_F(PublishQueueTest, DropNewestStillAdmitsRetainedOverState) {
+    PublishQueueConfig config;
+    config.max_messages = 2;
+    config.overflow = OverflowPolicy::DropNewest;
+    PublishQueue queue(config);
+
+    queue.push(state("s1", "1"));
+    queue.push(state("s2", "2"));
+    EXPECT_EQ(queue.push(retained("config/1", "{}")), PublishQueue::PushResult::Queued);
+    EXPECT_EQ(queue.pop()->topic, "config/1");
+    EXPECT_EQ(queue.pop()->topic, "s2");
+}
+
+TEST_F(PublishQueueTest, ByteCapBoundsMemory) {
+    PublishQueueConfig config;
+    config.max_bytes = 100;
+    PublishQueue queue(config);
+
+    std::string payload(20, 'x');
+    for (int i = 0; i < 1000; ++i) {
+        queue.push(state("t" + std::to_string(i), payload));
+        ASSERT_LE(queue.bytes(), config.max_bytes);
+    }
+    EXPECT_GT(queue.getStats().dropped, 0u);
+
+    // Larger than the whole budget can never be queued
+    EXPECT_EQ(queue.push(state("big", std::string(200, 'x'))), PublishQueue::PushResult::Dropped);
+}
+
+TEST_F(PublishQueueTest, ClearResetsDepthKeepsCounters) {
+    PublishQueue queue;
+    queue.push(state("a", "1"));
+    queue.push(retained("b", "2"));
+    queue.clear();
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.bytes(), 0u);
+    EXPECT_EQ(queue.getStats().enqueued, 2u);
+}
+
+TEST_F(PublishQueueTest, ParseOverflowPolicy) {
+    EXPECT_EQ(PublishQueueConfig::parseOverflowPolicy("drop_newest"), OverflowPolicy::DropNewest);
+    EXPECT_EQ(PublishQueueConfig::parseOverflowPolicy("drop_oldest"), OverflowPolicy::DropOldest);
+    EXPECT_EQ(PublishQueueConfig::parseOverflowPolicy("bogus"), OverflowPolicy::DropOldest);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "nut/SampleRing.h"
+#include <cmath>
+
+using namespace hms_nut;
+
+namespace {
+    constexpr int64_t kStart = 1773482400000LL;
+}
+
+TEST(SampleRingTest, MergesValuesOfOnePoll) {
+    SampleRing ring(10, 0);
+    ring.record(Metric::BatteryCharge, 100.0f, kStart);
+    ring.record(Metric::InputVoltage, 230.0f, kStart + 5);
+    ring.record(Metric::LoadWatts, 120.0f, kStart + 12);
+
+    ASSERT_EQ(ring.size(), 1u);
+    EXPECT_EQ(ring.timestamp(0), kStart);
+    EXPECT_FLOAT_EQ(ring.value(0, Metric::InputVoltage), 230.0f);
+    EXPECT_TRUE(std::isnan(ring.value(0, Metric::Temperature)));
+}
+
+TEST(SampleRingTest, NewRowCarriesForward) {
+    SampleRing ring(10, 0);
+    ring.record(Metric::BatteryCharge, 100.0f, kStart);
+    ring.record(Metric::InputVoltage, 230.0f, kStart);
+    ring.record(Metric::InputVoltage, 228.0f, kStart + 60000);
+
+    ASSERT_EQ(ring.size(), 2u);
+    EXPECT_FLOAT_EQ(ring.value(1, Metric::InputVoltage), 228.0f);
+    EXPECT_FLOAT_EQ(ring.value(1, Metric::BatteryCharge), 100.0f);
+}
+
+TEST(SampleRingTest, OverwritesOldestWhenFull) {
+    SampleRing ring(3, 0);
+    for (int i = 0; i < 5; ++i) {
+        ring.record(Metric::LoadPercentage, static_cast<float>(i), kStart + i * 60000);
+    }
+
+    ASSERT_EQ(ring.size(), 3u);
+    EXPECT_EQ(ring.timestamp(0), kStart + 2 * 60000);
+    EXPECT_FLOAT_EQ(ring.value(0, Metric::LoadPercentage), 2.0f);
+    EXPECT_FLOAT_EQ(ring.value(2, Metric::LoadPercentage), 4.0f);
+}
+
+TEST(SampleRingTest, AgesOutRowsBeyondWindow) {
+    SampleRing ring(100, 5 * 60000);
+    for (int i = 0; i < 10; ++i) {
+        ring.record(Metric::LoadPercentage, static_cast<float>(i), kStart + i * 60000);
+    }
+
+    // Newest at +9 min, window 5 min -> rows +4 .. +9
+    ASSERT_EQ(ring.size(), 6u);
+    EXPECT_EQ(ring.timestamp(0), kStart + 4 * 60000);
+}
+
+TEST(SampleRingTest, LowerBound) {
+    SampleRing ring(4, 0);
+    for (int i = 0; i < 6; ++i) {
+        ring.record(Metric::LoadPercentage, static_cast<float>(i), kStart + i * 10000);
+    }
+
+    // Rows at +20s .. +50s (wrapped)
+    EXPECT_EQ(ring.lowerBound(0), 0u);
+    EXPECT_EQ(ring.lowerBound(kStart + 30000), 1u);
+    EXPECT_EQ(ring.lowerBound(kStart + 30001), 2u);
+    EXPECT_EQ(ring.lowerBound(kStart + 99000), 4u);
+}
+
+TEST(SampleRingTest, CopySinceAcrossWrap) {
+    SampleRing ring(4, 0);
+    for (int i = 0; i < 6; ++i) {
+        ring.record(Metric::InputVoltage, 220.0f + i, kStart + i * 60000);
+    }
+    ring.record(Metric::LoadWatts, 90.0f, kStart + 5 * 60000);
+
+    // Rows 2..5 are live; the ring has wrapped
+    SampleSeries series;
+    ring.copySince(kStart + 3 * 60000, {Metric::LoadWatts, Metric::InputVoltage}, series);
+
+    ASSERT_EQ(series.timestamps.size(), 3u);
+    EXPECT_EQ(series.timestamps.front(), kStart + 3 * 60000);
+    EXPECT_EQ(series.timestamps.back(), kStart + 5 * 60000);
+    ASSERT_EQ(series.columns.size(), 2u);
+    EXPECT_TRUE(std::isnan(series.columns[0][0]));
+    EXPECT_FLOAT_EQ(series.columns[0][2], 90.0f);
+    EXPECT_FLOAT_EQ(series.columns[1][0], 223.0f);
+    EXPECT_FLOAT_EQ(series.columns[1][2], 225.0f);
+
+    ring.copySince(kStart + 10 * 60000, {Metric::InputVoltage}, series);
+    EXPECT_TRUE(series.timestamps.empty());
+    ASSERT_EQ(series.columns.size(), 1u);
+    EXPECT_TRUE(series.columns[0].empty());
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
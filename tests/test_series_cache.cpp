@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "services/SeriesCache.h"
+#include <chrono>
+#include <string>
+
+using namespace hms_nut;
+using namespace std::chrono_literals;
+
+namespace {
+    constexpr int64_t kMinuteMs = 60 * 1000LL;
+    constexpr int64_t kHourMs = 60 * kMinuteMs;
+
+    SeriesCache::Key key(const std::string& device, int64_t from_ms, int64_t to_ms) {
+        SeriesCache::Key k;
+        k.tier = SeriesTier::Minute;
+        k.device = device;
+        k.metric = Metric::InputVoltage;
+        k.from_ms = from_ms;
+        k.to_ms = to_ms;
+        k.max_points = 500;
+        return k;
+    }
+
+    SeriesRead read(double value) {
+        SeriesRead r;
+        r.tier = SeriesTier::Minute;
+        r.source_points = 1;
+        r.points.push_back({1000, value});
+        return r;
+    }
+}
+
+TEST(SeriesCacheTest, AlignRangeRoundsUpToBuckets) {
+    // Every refresh inside one minute selects the same minute buckets
+    auto [from, to] = SeriesCache::alignRange(SeriesTier::Minute, 10 * kMinuteMs + 1, 20 * kMinuteMs + 59999);
+    EXPECT_EQ(from, 11 * kMinuteMs);
+    EXPECT_EQ(to, 21 * kMinuteMs);
+
+    auto exact = SeriesCache::alignRange(SeriesTier::Hour, 2 * kHourMs, 5 * kHourMs);
+    EXPECT_EQ(exact, std::make_pair(2 * kHourMs, 5 * kHourMs));
+    EXPECT_EQ(SeriesCache::alignRange(SeriesTier::Hour, kHourMs + 1, 2 * kHourMs).first, 2 * kHourMs);
+
+    auto raw = SeriesCache::alignRange(SeriesTier::Raw, 12345, 67890);
+    EXPECT_EQ(raw, std::make_pair(int64_t{12345}, int64_t{67890}));
+}
+
+TEST(SeriesCacheTest, HitUntilExpired) {
+    SeriesCache cache(30s);
+    auto now = SeriesCache::Clock::now();
+
+    EXPECT_FALSE(cache.get(key("apc_bx", 0, kHourMs), now).has_value());
+    cache.put(key("apc_bx", 0, kHourMs), read(230.0), now);
+
+    auto hit = cache.get(key("apc_bx", 0, kHourMs), now + 10s);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_DOUBLE_EQ(hit->points[0].value, 230.0);
+    EXPECT_FALSE(cache.get(key("cp1500", 0, kHourMs), now).has_value());
+
+    EXPECT_FALSE(cache.get(key("apc_bx", 0, kHourMs), now + 30s).has_value());
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(cache.getHits(), 1u);
+    EXPECT_EQ(cache.getMisses(), 3u);
+}
+
+TEST(SeriesCacheTest, EvictsLeastRecentlyUsed) {
+    SeriesCache cache(30s, 2);
+    auto now = SeriesCache::Clock::now();
+
+    cache.put(key("a", 0, kHourMs), read(1.0), now);
+    cache.put(key("b", 0, kHourMs), read(2.0), now);
+    ASSERT_TRUE(cache.get(key("a", 0, kHourMs), now).has_value());  // "b" is now oldest
+    cache.put(key("c", 0, kHourMs), read(3.0), now);
+
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_TRUE(cache.get(key("a", 0, kHourMs), now).has_value());
+    EXPECT_FALSE(cache.get(key("b", 0, kHourMs), now).has_value());
+    EXPECT_TRUE(cache.get(key("c", 0, kHourMs), now).has_value());
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "utils/StatusBoard.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace hms_nut;
+using namespace std::chrono_literals;
+
+TEST(StatusBoardTest, NoSnapshotBeforeRefresh) {
+    StatusBoard board;
+    board.addComponent("mqtt", [] { return ComponentStatus{"connected", true, {}}; });
+    EXPECT_EQ(board.snapshot(), nullptr);
+}
+
+TEST(StatusBoardTest, AggregatesComponents) {
+    StatusBoard board;
+    bool db_up = true;
+    board.addComponent("mqtt", [] { return ComponentStatus{"connected", true, {}}; });
+    board.addComponent("database", [&] {
+        return ComponentStatus{db_up ? "connected" : "disconnected", db_up, {}};
+    });
+    board.addComponent("daily_summary", [] { return ComponentStatus{"disabled", true, {}}; });
+
+    board.refresh();
+    auto first = board.snapshot();
+    ASSERT_NE(first, nullptr);
+    EXPECT_TRUE(first->healthy);
+    ASSERT_EQ(first->components.size(), 3u);
+    EXPECT_EQ(first->components[1].first, "database");
+    EXPECT_EQ(first->components[1].second.state, "connected");
+
+    db_up = false;
+    board.refresh();
+    auto second = board.snapshot();
+    EXPECT_FALSE(second->healthy);
+    EXPECT_EQ(second->components[1].second.state, "disconnected");
+
+    // Readers keep the snapshot they loaded
+    EXPECT_TRUE(first->healthy);
+}
+
+TEST(StatusBoardTest, ThrowingSamplerIsUnhealthy) {
+    StatusBoard board;
+    board.addComponent("collector", []() -> ComponentStatus { throw std::runtime_error("boom"); });
+    board.refresh();
+
+    auto snapshot = board.snapshot();
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_FALSE(snapshot->healthy);
+    EXPECT_EQ(snapshot->components[0].second.state, "error");
+}
+
+TEST(StatusBoardTest, BlockedSamplerDoesNotBlockReaders) {
+    StatusBoard board;
+    std::mutex service_lock;  // Stands in for a lock held by a slow DB insert
+    std::atomic<int> samples{0};
+    board.addComponent("database", [&] {
+        std::lock_guard<std::mutex> lock(service_lock);
+        ++samples;
+        return ComponentStatus{"connected", true, {}};
+    });
+
+    board.start(100ms);
+    auto initial = board.snapshot();
+    ASSERT_NE(initial, nullptr);
+
+    {
+        std::lock_guard<std::mutex> hold(service_lock);
+        std::this_thread::sleep_for(300ms);  // Refresh thread is now stuck in the sampler
+
+        auto reader = std::async(std::launch::async, [&] { return board.snapshot(); });
+        ASSERT_EQ(reader.wait_for(50ms), std::future_status::ready);
+        EXPECT_NE(reader.get(), nullptr);
+    }
+
+    board.stop();
+    EXPECT_GE(samples.load(), 2);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
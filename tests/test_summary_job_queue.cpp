@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include "services/SummaryJobQueue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace hms_nut;
+using namespace std::chrono_literals;
+
+namespace {
+    // Blocks runs until released, so tests can observe queued/running states
+    class Gate {
+    public:
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++waiting_;
+            cv_.notify_all();
+            cv_.wait(lock, [this] { return open_; });
+        }
+        void open() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_ = true;
+            cv_.notify_all();
+        }
+        bool waitForRunner(std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            return cv_.wait_for(lock, timeout, [this] { return waiting_ > 0; });
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        bool open_ = false;
+        int waiting_ = 0;
+    };
+
+    SummaryJob waitDone(const SummaryJobQueue& queue, const std::string& id) {
+        auto deadline = std::chrono::steady_clock::now() + 2s;
+        while (std::chrono::steady_clock::now() < deadline) {
+            auto job = queue.get(id);
+            if (job && job->done()) {
+                return *job;
+            }
+            std::this_thread::sleep_for(5ms);
+        }
+        ADD_FAILURE() << "job " << id << " did not finish";
+        return {};
+    }
+}
+
+TEST(SummaryJobQueueTest, RunsJobAndKeepsResult) {
+    SummaryJobQueue queue([](const std::string& date, std::string& result, std::string&) {
+        result = "summary for " + date;
+        return true;
+    });
+    queue.start();
+
+    auto submission = queue.submit("2026-03-13");
+    ASSERT_TRUE(submission.job);
+    EXPECT_FALSE(submission.deduplicated);
+    EXPECT_EQ(submission.job->state, SummaryJob::State::Queued);
+
+    SummaryJob job = waitDone(queue, submission.job->id);
+    EXPECT_EQ(job.state, SummaryJob::State::Succeeded);
+    EXPECT_EQ(job.result, "summary for 2026-03-13");
+    EXPECT_EQ(job.date, "2026-03-13");
+}
+
+TEST(SummaryJobQueueTest, SameDateJoinsActiveJob) {
+    Gate gate;
+    std::atomic<int> runs{0};
+    SummaryJobQueue queue([&](const std::string&, std::string& result, std::string&) {
+        ++runs;
+        gate.wait();
+        result = "done";
+        return true;
+    });
+    queue.start();
+
+    auto first = queue.submit("2026-03-13");
+    ASSERT_TRUE(gate.waitForRunner(2s));
+    EXPECT_EQ(queue.get(first.job->id)->state, SummaryJob::State::Running);
+
+    auto second = queue.submit("2026-03-13");
+    EXPECT_TRUE(second.deduplicated);
+    EXPECT_EQ(second.job->id, first.job->id);
+
+    auto other = queue.submit("2026-03-12");
+    EXPECT_FALSE(other.deduplicated);
+    EXPECT_NE(other.job->id, first.job->id);
+
+    gate.open();
+    waitDone(queue, first.job->id);
+    waitDone(queue, other.job->id);
+    EXPECT_EQ(runs.load(), 2);
+
+    // Finished jobs don't absorb new requests
+    auto again = queue.submit("2026-03-13");
+    EXPECT_FALSE(again.deduplicated);
+    EXPECT_NE(again.job->id, first.job->id);
+}
+
+TEST(SummaryJobQueueTest, FailureAndExceptionRecorded) {
+    SummaryJobQueue queue([](const std::string& date, std::string&, std::string& error) -> bool {
+        if (date == "throw") {
+            throw std::runtime_error("llm exploded");
+        }
+        error = "No metrics data for " + date;
+        return false;
+    });
+    queue.start();
+
+    SummaryJob failed = waitDone(queue, queue.submit("2026-01-01").job->id);
+    EXPECT_EQ(failed.state, SummaryJob::State::Failed);
+    EXPECT_EQ(failed.error, "No metrics data for 2026-01-01");
+
+    SummaryJob thrown = waitDone(queue, queue.submit("throw").job->id);
+    EXPECT_EQ(thrown.state, SummaryJob::State::Failed);
+    EXPECT_EQ(thrown.error, "llm exploded");
+}
+
+TEST(SummaryJobQueueTest, RefusesWhenFullAndCancelsOnStop) {
+    Gate gate;
+    SummaryJobQueue queue([&](const std::string&, std::string&, std::string&) {
+        gate.wait();
+        return true;
+    }, 1);
+    queue.start();
+
+    auto running = queue.submit("2026-03-01");
+    ASSERT_TRUE(gate.waitForRunner(2s));
+    auto queued = queue.submit("2026-03-02");
+    ASSERT_TRUE(queued.job);
+    EXPECT_FALSE(queue.submit("2026-03-03").job);  // max_pending = 1
+
+    std::thread stopper([&] { queue.stop(); });
+    std::this_thread::sleep_for(50ms);
+    gate.open();
+    stopper.join();
+
+    EXPECT_EQ(queue.get(running.job->id)->state, SummaryJob::State::Succeeded);
+    auto cancelled = queue.get(queued.job->id);
+    EXPECT_EQ(cancelled->state, SummaryJob::State::Failed);
+    EXPECT_FALSE(queue.submit("2026-03-04").job);  // Stopped
+}
+
+TEST(SummaryJobQueueTest, TrimsOldFinishedJobs) {
+    SummaryJobQueue queue([](const std::string&, std::string&, std::string&) { return true; }, 16, 2);
+    queue.start();
+
+    std::string first = queue.submit("2026-01-01").job->id;
+    waitDone(queue, first);
+    waitDone(queue, queue.submit("2026-01-02").job->id);
+    waitDone(queue, queue.submit("2026-01-03").job->id);
+
+    EXPECT_FALSE(queue.get(first));
+    EXPECT_FALSE(queue.get("no-such-job"));
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
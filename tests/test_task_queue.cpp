@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include "utils/TaskQueue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace hms_nut;
+using namespace std::chrono_literals;
+
+namespace {
+    bool waitUntil(const std::function<bool()>& done, std::chrono::milliseconds timeout = 2s) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!done()) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
+}
+
+TEST(TaskQueueTest, RunsTasksOffTheCallerThread) {
+    TaskQueue queue("test", 2);
+    queue.start();
+
+    std::atomic<int> ran{0};
+    std::atomic<bool> on_caller{false};
+    auto caller = std::this_thread::get_id();
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(queue.submit([&] {
+            on_caller = on_caller || std::this_thread::get_id() == caller;
+            ++ran;
+        }));
+    }
+    EXPECT_TRUE(waitUntil([&] { return ran == 10; }));
+    EXPECT_FALSE(on_caller);
+}
+
+TEST(TaskQueueTest, RefusesBeyondMaxPending) {
+    TaskQueue queue("test", 1, 2);
+    queue.start();
+
+    // Occupy the single worker
+    std::mutex gate_mutex;
+    std::condition_variable gate_cv;
+    bool gate_open = false;
+    std::atomic<bool> started{false};
+    ASSERT_TRUE(queue.submit([&] {
+        started = true;
+        std::unique_lock<std::mutex> lock(gate_mutex);
+        gate_cv.wait(lock, [&] { return gate_open; });
+    }));
+    ASSERT_TRUE(waitUntil([&] { return started.load(); }));
+
+    std::atomic<int> ran{0};
+    EXPECT_TRUE(queue.submit([&] { ++ran; }));
+    EXPECT_TRUE(queue.submit([&] { ++ran; }));
+    EXPECT_FALSE(queue.submit([&] { ++ran; }));
+    EXPECT_EQ(queue.pending(), 2u);
+
+    {
+        std::lock_guard<std::mutex> lock(gate_mutex);
+        gate_open = true;
+    }
+    gate_cv.notify_all();
+    EXPECT_TRUE(waitUntil([&] { return ran == 2; }));
+    EXPECT_EQ(queue.pending(), 0u);
+}
+
+TEST(TaskQueueTest, FailingTaskDoesNotStopWorker) {
+    TaskQueue queue("test", 1);
+    queue.start();
+
+    std::atomic<bool> ran{false};
+    ASSERT_TRUE(queue.submit([] { throw std::runtime_error("boom"); }));
+    ASSERT_TRUE(queue.submit([&] { ran = true; }));
+    EXPECT_TRUE(waitUntil([&] { return ran.load(); }));
+}
+
+TEST(TaskQueueTest, StoppedQueueRefuses) {
+    TaskQueue queue("test");
+    EXPECT_FALSE(queue.submit([] {}));  // Not started
+
+    queue.start();
+    queue.stop();
+    EXPECT_FALSE(queue.submit([] {}));
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
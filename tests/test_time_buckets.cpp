@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include "utils/TimeBuckets.h"
+
+using namespace hms_nut;
+using namespace std::chrono;
+
+namespace {
+    system_clock::time_point at(int64_t secs, int64_t millis = 0) {
+        return system_clock::time_point(seconds(secs) + milliseconds(millis));
+    }
+}
+
+// 2026-03-14 10:37:25 UTC
+constexpr int64_t kSample = 1773484645;
+constexpr int64_t kHourStart = kSample - (kSample % 3600);
+
+TEST(TimeBucketsTest, AlignDownToHour) {
+    EXPECT_EQ(alignDown(at(kSample, 900), 3600), at(kHourStart));
+    EXPECT_EQ(alignDown(at(kHourStart), 3600), at(kHourStart));
+}
+
+TEST(TimeBucketsTest, AlignDownToMinute) {
+    EXPECT_EQ(alignDown(at(kSample), 60), at(kSample - 25));
+}
+
+TEST(TimeBucketsTest, NextBoundaryIsStrictlyAfter) {
+    EXPECT_EQ(nextBoundary(at(kSample), 3600), at(kHourStart + 3600));
+    // Exactly on a boundary -> the following one
+    EXPECT_EQ(nextBoundary(at(kHourStart), 3600), at(kHourStart + 3600));
+}
+
+TEST(TimeBucketsTest, NonPositiveIntervalIsOneSecond) {
+    EXPECT_EQ(alignDown(at(kSample, 500), 0), at(kSample));
+    EXPECT_EQ(nextBoundary(at(kSample, 500), -5), at(kSample + 1));
+}
+
+TEST(TimeBucketsTest, PreEpochRoundsDown) {
+    EXPECT_EQ(alignDown(at(-30), 60), at(-60));
+}
+
+TEST(TimeBucketsTest, ParseUtcTimestamp) {
+    EXPECT_EQ(parseUtcTimestamp("1773482400000"), at(1773482400));
+    EXPECT_EQ(parseUtcTimestamp("2026-03-14"), at(1773446400));
+    EXPECT_EQ(parseUtcTimestamp("2026-03-14T10:00:00Z"), at(1773482400));
+    EXPECT_EQ(parseUtcTimestamp("2026-03-14T10:00:00"), at(1773482400));
+    EXPECT_EQ(parseUtcTimestamp("1969-12-31"), at(-86400));
+    EXPECT_EQ(parseUtcTimestamp("2026-03-14T10:00:00.866Z"), at(1773482400) + std::chrono::milliseconds(866));
+    EXPECT_EQ(parseUtcTimestamp("2026-03-14T10:00:00.5"), at(1773482400) + std::chrono::milliseconds(500));
+
+    EXPECT_FALSE(parseUtcTimestamp(""));
+    EXPECT_FALSE(parseUtcTimestamp("yesterday"));
+    EXPECT_FALSE(parseUtcTimestamp("2026-13-01"));
+    EXPECT_FALSE(parseUtcTimestamp("2026-03-14T10:00"));
+    EXPECT_FALSE(parseUtcTimestamp("2026-03-14 10:00:00"));
+    EXPECT_FALSE(parseUtcTimestamp("2026-03-14T10:00:00.Z"));
+    EXPECT_FALSE(parseUtcTimestamp("2026-03-14T10:00:00.8x6Z"));
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "mqtt/TopicAliasTable.h"
+#include <string>
+
+using namespace hms_nut;
+
+using Use = TopicAliasTable::Use;
+
+TEST(TopicAliasTableTest, DisabledWithoutCapacity) {
+    TopicAliasTable table;
+    auto lookup = table.lookup("homeassistant/sensor/ups/input_voltage/state");
+    EXPECT_EQ(lookup.use, Use::None);
+    EXPECT_EQ(table.size(), 0u);
+}
+
+TEST(TopicAliasTableTest, EstablishThenAlias) {
+    TopicAliasTable table(10);
+    const std::string topic = "homeassistant/sensor/ups/input_voltage/state";
+
+    auto first = table.lookup(topic);
+    EXPECT_EQ(first.use, Use::Establish);
+    EXPECT_EQ(first.alias, 1);
+
+    // Not yet handed to the client - others must send the full topic
+    EXPECT_EQ(table.lookup(topic).use, Use::None);
+
+    table.markEstablished(topic, first);
+    auto later = table.lookup(topic);
+    EXPECT_EQ(later.use, Use::Alias);
+    EXPECT_EQ(later.alias, 1);
+}
+
+TEST(TopicAliasTableTest, DistinctAliasesUpToCapacity) {
+    TopicAliasTable table(2);
+
+    auto a = table.lookup("a/state");
+    auto b = table.lookup("b/state");
+    auto c = table.lookup("c/state");
+
+    EXPECT_EQ(a.alias, 1);
+    EXPECT_EQ(b.alias, 2);
+    EXPECT_EQ(c.use, Use::None);  // Broker maximum reached
+    EXPECT_EQ(table.size(), 2u);
+}
+
+TEST(TopicAliasTableTest, FailedEstablishRetries) {
+    TopicAliasTable table(5);
+    auto first = table.lookup("a/state");
+    table.markFailed("a/state", first);
+
+    auto retry = table.lookup("a/state");
+    EXPECT_EQ(retry.use, Use::Establish);
+    EXPECT_EQ(retry.alias, first.alias);
+}
+
+TEST(TopicAliasTableTest, ResetOnReconnect) {
+    TopicAliasTable table(5);
+    auto first = table.lookup("a/state");
+    table.markEstablished("a/state", first);
+    ASSERT_EQ(table.lookup("a/state").use, Use::Alias);
+
+    table.reset(3);
+    EXPECT_EQ(table.capacity(), 3);
+    auto again = table.lookup("a/state");
+    EXPECT_EQ(again.use, Use::Establish);
+
+    // Completion from the previous connection must not establish the new alias
+    table.markEstablished("a/state", first);
+    EXPECT_EQ(table.lookup("a/state").use, Use::None);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
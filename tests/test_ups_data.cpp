@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "nut/UpsData.h"
+#include "nut/SensorSchema.h"
+#include "utils/CompactWriter.h"
 #include <map>
 #include <string>
 
@@ -103,13 +105,165 @@ TEST_F(UpsDataTest, ToMqttMessages) {
             found_battery_charge = true;
             // Payload should contain "100" (formatting may vary)
             EXPECT_NE(msg.payload.find("100"), std::string::npos);
-            EXPECT_EQ(msg.qos, 1);
+            EXPECT_EQ(msg.qos, 0);  // High-rate telemetry
+            EXPECT_FALSE(msg.retain);
             break;
         }
     }
     EXPECT_TRUE(found_battery_charge);
 }
 
+TEST_F(UpsDataTest, ToMqttMessagesCompactPayloads) {
+    UpsData data;
+    data.device_id = "apc_ups";
+    data.input_voltage = 230.0;
+    data.battery_voltage = 13.65;
+    data.battery_runtime = 2400;
+    data.load_percentage = 12.5;
+    data.power_failure = false;
+
+    auto messages = data.toMqttMessages();
+
+    std::map<std::string, std::string> payloads;
+    for (const auto& msg : messages) {
+        payloads[msg.topic] = msg.payload;
+    }
+
+    // std::to_string used to emit "230.000000"
+    EXPECT_EQ(payloads["homeassistant/sensor/apc_ups/input_voltage/state"], "230");
+    EXPECT_EQ(payloads["homeassistant/sensor/apc_ups/battery_voltage/state"], "13.65");
+    EXPECT_EQ(payloads["homeassistant/sensor/apc_ups/battery_runtime/state"], "2400");
+    EXPECT_EQ(payloads["homeassistant/sensor/apc_ups/load_percentage/state"], "12.5");
+    EXPECT_EQ(payloads["homeassistant/sensor/apc_ups/power_failure/state"], "0");
+}
+
+TEST_F(UpsDataTest, ToMqttMessagesRoundsToSchemaPrecision) {
+    UpsData data;
+    data.device_id = "apc_ups";
+    data.battery_charge = 99.6;   // precision 0
+    data.input_voltage = 121.04;  // precision 1
+
+    auto messages = data.toMqttMessages();
+
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[0].payload, "100");
+    EXPECT_EQ(messages[1].payload, "121");
+}
+
+TEST_F(UpsDataTest, ToMqttMessagesReusesBuffer) {
+    UpsData data;
+    data.device_id = "apc_ups";
+    data.battery_charge = 100.0;
+    data.input_voltage = 121.0;
+    data.ups_status = "OL";
+
+    std::vector<MqttMessage> buffer;
+    data.toMqttMessages(buffer);
+    ASSERT_EQ(buffer.size(), 3u);
+    const char* topic_storage = buffer[0].topic.data();
+
+    // Second poll: same shape, elements are reused in place
+    data.battery_charge = 99.0;
+    data.toMqttMessages(buffer);
+    ASSERT_EQ(buffer.size(), 3u);
+    EXPECT_EQ(buffer[0].topic.data(), topic_storage);
+    EXPECT_EQ(buffer[0].payload, "99");
+
+    // Fewer fields shrink the buffer
+    data.ups_status.reset();
+    data.toMqttMessages(buffer);
+    EXPECT_EQ(buffer.size(), 2u);
+}
+
+TEST_F(UpsDataTest, EncodeSensorsWritesNativeValues) {
+    UpsData data;
+    data.device_id = "apc_ups";
+    data.battery_charge = 100.0;
+    data.battery_runtime = 2400;
+    data.input_voltage = 121.5;
+    data.ups_status = "OL";
+    data.power_failure = false;
+
+    std::string json;
+    CompactWriter writer(WireFormat::Json, json);
+    data.encodeSensors(writer);
+    EXPECT_EQ(json, "{\"battery_charge\":100,\"battery_runtime\":2400,\"input_voltage\":121.5,"
+                    "\"ups_status\":\"OL\",\"power_failure\":false}");
+
+    // Binary formats carry the entry count up front
+    std::string cbor;
+    CompactWriter cbor_writer(WireFormat::Cbor, cbor);
+    data.encodeSensors(cbor_writer);
+    ASSERT_FALSE(cbor.empty());
+    EXPECT_EQ(static_cast<uint8_t>(cbor[0]), 0xa5);  // map(5)
+
+    std::string empty;
+    CompactWriter empty_writer(WireFormat::Json, empty);
+    UpsData{}.encodeSensors(empty_writer);
+    EXPECT_EQ(empty, "{}");
+}
+
+TEST_F(UpsDataTest, ToMqttMessagesPerDeviceTopics) {
+    UpsData a;
+    a.device_id = "ups_a";
+    a.battery_charge = 50.0;
+    UpsData b;
+    b.device_id = "ups_b";
+    b.battery_charge = 60.0;
+
+    EXPECT_EQ(a.toMqttMessages()[0].topic, "homeassistant/sensor/ups_a/battery_charge/state");
+    EXPECT_EQ(b.toMqttMessages()[0].topic, "homeassistant/sensor/ups_b/battery_charge/state");
+    EXPECT_EQ(a.toMqttMessages()[0].topic, "homeassistant/sensor/ups_a/battery_charge/state");
+}
+
+TEST_F(UpsDataTest, ToMqttMessagesFollowsPublishPolicy) {
+    UpsData data;
+    data.device_id = "apc_ups";
+    data.input_voltage = 230.0;
+    data.ups_status = "OL";
+    data.power_failure = false;
+    data.input_nominal_voltage = 230;
+
+    std::map<std::string, MqttMessage> by_topic;
+    for (const auto& msg : data.toMqttMessages()) {
+        by_topic[msg.topic] = msg;
+    }
+
+    const auto& voltage = by_topic["homeassistant/sensor/apc_ups/input_voltage/state"];
+    EXPECT_EQ(voltage.qos, 0);
+    EXPECT_FALSE(voltage.retain);
+
+    for (const char* id : {"ups_status", "power_failure", "input_nominal_voltage"}) {
+        const auto& msg = by_topic[std::string("homeassistant/sensor/apc_ups/") + id + "/state"];
+        EXPECT_EQ(msg.qos, 1) << id;
+        EXPECT_TRUE(msg.retain) << id;
+    }
+}
+
+TEST_F(UpsDataTest, PublishPolicyOverrides) {
+    ASSERT_TRUE(SensorSchema::applyPolicyOverrides(R"({"input_voltage": {"qos": 1, "retain": true}, "ups_status": {"qos": 0}})"));
+
+    EXPECT_EQ(SensorSchema::policy(Sensor::InputVoltage).qos, 1);
+    EXPECT_TRUE(SensorSchema::policy(Sensor::InputVoltage).retain);
+    EXPECT_EQ(SensorSchema::policy(Sensor::UpsStatus).qos, 0);
+    EXPECT_TRUE(SensorSchema::policy(Sensor::UpsStatus).retain);  // Unspecified field kept
+
+    UpsData data;
+    data.device_id = "apc_ups";
+    data.input_voltage = 230.0;
+    auto messages = data.toMqttMessages();
+    ASSERT_EQ(messages.size(), 1u);
+    EXPECT_EQ(messages[0].qos, 1);
+    EXPECT_TRUE(messages[0].retain);
+
+    EXPECT_FALSE(SensorSchema::applyPolicyOverrides(R"({"no_such_sensor": {"qos": 1}})"));
+    EXPECT_FALSE(SensorSchema::applyPolicyOverrides("not json"));
+
+    SensorSchema::resetPolicies();
+    EXPECT_EQ(SensorSchema::policy(Sensor::InputVoltage).qos, 0);
+    EXPECT_EQ(SensorSchema::maxQos(), 1);
+}
+
 TEST_F(UpsDataTest, ToJson) {
     UpsData data;
     data.device_id = "test_ups";